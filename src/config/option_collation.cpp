@@ -25,6 +25,7 @@
 #include "utils/mappable_algorithms.hpp"
 #include "utils/string_utils.hpp"
 #include "utils/repeat_finder.hpp"
+#include "utils/tandem_repeat_index.hpp"
 #include "utils/append.hpp"
 #include "utils/maths.hpp"
 #include "basics/phred.hpp"
@@ -42,6 +43,7 @@
 #include "io/pedigree/pedigree_reader.hpp"
 #include "io/variant/vcf_reader.hpp"
 #include "io/variant/vcf_writer.hpp"
+#include "io/variant/source_candidate_store.hpp"
 #include "exceptions/user_error.hpp"
 #include "exceptions/program_error.hpp"
 #include "exceptions/system_error.hpp"
@@ -49,6 +51,7 @@
 #include "core/csr/filters/threshold_filter_factory.hpp"
 #include "core/csr/filters/training_filter_factory.hpp"
 #include "core/csr/filters/random_forest_filter_factory.hpp"
+#include "core/csr/filters/unsupervised_clustering_filter_factory.hpp"
 
 namespace octopus { namespace options {
 
@@ -71,6 +74,11 @@ bool is_run_command(const OptionMap& options)
     return !is_set("help", options) && !is_set("version", options);
 }
 
+bool is_build_repeat_index_command(const OptionMap& options)
+{
+    return options.at("build-repeat-index").as<bool>();
+}
+
 bool is_debug_mode(const OptionMap& options)
 {
     return is_set("debug", options);
@@ -263,6 +271,11 @@ MemoryFootprint get_target_read_buffer_size(const OptionMap& options)
     return options.at("target-read-buffer-memory").as<MemoryFootprint>();
 }
 
+std::size_t get_max_buffered_output_calls(const OptionMap& options)
+{
+    return as_unsigned("max-buffered-output-calls", options);
+}
+
 boost::optional<fs::path> get_debug_log_file_name(const OptionMap& options)
 {
     if (is_debug_mode(options)) {
@@ -291,6 +304,39 @@ bool is_very_fast_mode(const OptionMap& options)
     return options.at("very-fast").as<bool>();
 }
 
+class MissingRepeatIndex : public MissingFileError
+{
+    std::string do_where() const override
+    {
+        return "make_repeat_index";
+    }
+    std::string do_help() const override
+    {
+        return "build the index first with --build-repeat-index";
+    }
+public:
+    MissingRepeatIndex(fs::path p) : MissingFileError {std::move(p), "tandem repeat index"} {};
+};
+
+std::shared_ptr<const TandemRepeatIndex> make_repeat_index(const OptionMap& options, const ReferenceGenome& reference)
+{
+    if (!is_set("repeat-index", options)) return nullptr;
+    const auto index_path = resolve_path(options.at("repeat-index").as<fs::path>(), options);
+    if (is_build_repeat_index_command(options)) {
+        logging::InfoLogger info_log {};
+        stream(info_log) << "Building tandem repeat index " << index_path;
+        const auto num_threads = get_num_threads(options);
+        const auto max_threads = num_threads ? *num_threads : std::max(std::thread::hardware_concurrency(), 1u);
+        constexpr unsigned max_indexed_period {20}; // the largest period searched by any repeat consumer
+        build_tandem_repeat_index(reference, index_path, max_indexed_period, max_threads);
+    } else if (!fs::exists(index_path)) {
+        MissingRepeatIndex e {index_path};
+        e.set_location_specified("the command line option --repeat-index");
+        throw e;
+    }
+    return std::make_shared<const TandemRepeatIndex>(index_path, reference);
+}
+
 ReferenceGenome make_reference(const OptionMap& options)
 {
     const fs::path input_path {options.at("reference").as<fs::path>()};
@@ -317,14 +363,18 @@ ReferenceGenome make_reference(const OptionMap& options)
             warned = true;
         }
     }
-    try {
-        return octopus::make_reference(std::move(resolved_path), ref_cache_size, is_threading_allowed(options));
-    } catch (MissingFileError& e) {
-        e.set_location_specified("the command line option --reference");
-        throw;
-    } catch (...) {
-        throw;
-    }
+    auto result = [&] () {
+        try {
+            return octopus::make_reference(std::move(resolved_path), ref_cache_size, is_threading_allowed(options));
+        } catch (MissingFileError& e) {
+            e.set_location_specified("the command line option --reference");
+            throw;
+        } catch (...) {
+            throw;
+        }
+    }();
+    result.set_repeat_index(make_repeat_index(options, result));
+    return result;
 }
 
 InputRegionMap make_search_regions(const std::vector<GenomicRegion>& regions)
@@ -726,7 +776,10 @@ ReadManager make_read_manager(const OptionMap& options)
 {
     auto read_paths = get_read_paths(options);
     const auto max_open_files = as_unsigned("max-open-read-files", options);
-    return ReadManager {std::move(read_paths), max_open_files};
+    const auto num_threads = get_num_threads(options);
+    const auto max_threads = num_threads ? *num_threads : std::max(std::thread::hardware_concurrency(), 1u);
+    const auto max_index_cache_memory = options.at("max-read-index-cache-memory").as<MemoryFootprint>();
+    return ReadManager {std::move(read_paths), max_open_files, max_threads, max_index_cache_memory.bytes()};
 }
 
 bool denovo_candidate_variant_discovery_enabled(const OptionMap& options)
@@ -862,6 +915,14 @@ bool use_same_read_profile_for_all_samples(const OptionMap& options)
     return options.at("use-same-read-profile-for-all-samples").as<bool>();
 }
 
+boost::optional<fs::path> get_read_profile_cache_directory(const OptionMap& options)
+{
+    if (is_set("read-profile-cache", options)) {
+        return resolve_path(options.at("read-profile-cache").as<fs::path>(), options);
+    }
+    return boost::none;
+}
+
 auto make_read_filterer(const OptionMap& options)
 {
     using std::make_unique;
@@ -971,7 +1032,9 @@ boost::optional<readpipe::Downsampler> make_downsampler(const OptionMap& options
     return boost::none;
 }
 
-ReadPipe make_read_pipe(ReadManager& read_manager, const ReferenceGenome& reference, std::vector<SampleName> samples, const OptionMap& options)
+namespace {
+
+ReadPipe make_read_pipe_helper(ReadManager& read_manager, const ReferenceGenome& reference, std::vector<SampleName> samples, const OptionMap& options)
 {
     auto transformers = make_read_transformers(reference, options);
     if (transformers.second.num_transforms() > 0) {
@@ -989,6 +1052,21 @@ ReadPipe make_read_pipe(ReadManager& read_manager, const ReferenceGenome& refere
     }
 }
 
+unsigned get_max_read_fetch_threads(const OptionMap& options)
+{
+    const auto num_threads = get_num_threads(options);
+    return num_threads ? *num_threads : std::thread::hardware_concurrency();
+}
+
+} // namespace
+
+ReadPipe make_read_pipe(ReadManager& read_manager, const ReferenceGenome& reference, std::vector<SampleName> samples, const OptionMap& options)
+{
+    auto result = make_read_pipe_helper(read_manager, reference, std::move(samples), options);
+    result.set_max_fetch_threads(get_max_read_fetch_threads(options));
+    return result;
+}
+
 auto get_default_germline_inclusion_predicate(const OptionMap& options)
 {
     return coretools::KnownCopyNumberInclusionPredicate {static_cast<unsigned>(options.at("organism-ploidy").as<int>())};
@@ -1199,6 +1277,48 @@ auto get_assembler_cycle_tolerance(const OptionMap& options)
     }
 }
 
+bool is_writable_directory(const fs::path& directory)
+{
+    const auto probe = directory / fs::unique_path(".octopus-%%%%-%%%%-%%%%");
+    std::ofstream file {probe.string()};
+    if (!file) return false;
+    file.close();
+    boost::system::error_code ec {};
+    fs::remove(probe, ec);
+    return true;
+}
+
+fs::path get_source_candidate_store_path(const fs::path& source_path, const OptionMap& options)
+{
+    if (is_set("source-candidate-store-directory", options)) {
+        const auto directory = resolve_path(options.at("source-candidate-store-directory").as<fs::path>(), options);
+        fs::create_directories(directory);
+        return make_source_candidate_store_path(source_path, directory);
+    }
+    auto result = make_source_candidate_store_path(source_path);
+    if (is_up_to_date(result, source_path)) return result;
+    auto source_directory = source_path.parent_path();
+    if (source_directory.empty()) source_directory = ".";
+    if (!is_writable_directory(source_directory)) {
+        result = make_source_candidate_store_path(source_path, fs::temp_directory_path());
+        logging::WarningLogger warn_log {};
+        stream(warn_log) << "Cannot write a source candidate store next to " << source_path
+                         << ", using " << result << " instead (set --source-candidate-store-directory to choose)";
+    }
+    return result;
+}
+
+std::shared_ptr<const SourceCandidateStore> make_source_candidate_store(const fs::path& source_path, const OptionMap& options)
+{
+    const auto store_path = get_source_candidate_store_path(source_path, options);
+    if (!is_up_to_date(store_path, source_path)) {
+        logging::InfoLogger info_log {};
+        stream(info_log) << "Building source candidate store " << store_path;
+        build_source_candidate_store(source_path, store_path);
+    }
+    return std::make_shared<const SourceCandidateStore>(store_path);
+}
+
 auto make_variant_generator_builder(const OptionMap& options, const boost::optional<const ReadSetProfile&> read_profile)
 {
     using namespace coretools;
@@ -1294,7 +1414,11 @@ auto make_variant_generator_builder(const OptionMap& options, const boost::optio
                 vcf_options.min_quality = options.at("min-source-candidate-quality").as<Phred<double>>().score();
             }
             vcf_options.extract_filtered = options.at("use-filtered-source-candidates").as<bool>();
-            result.add_vcf_extractor(std::move(source_path), vcf_options);
+            if (options.at("store-source-candidates").as<bool>()) {
+                result.add_vcf_extractor(make_source_candidate_store(source_path, options), vcf_options);
+            } else {
+                result.add_vcf_extractor(std::move(source_path), vcf_options);
+            }
         }
     }
     if (is_set("regenotype", options)) {
@@ -2189,6 +2313,11 @@ CallerFactory make_caller_factory(const ReferenceGenome& reference, ReadPipe& re
     const auto target_working_memory = get_target_working_memory(options);
     if (target_working_memory) vc_builder.set_target_memory_footprint(*target_working_memory);
     vc_builder.set_execution_policy(get_thread_execution_policy(options));
+    // All callers share one pool sized by the task concurrency, so nested parallelism in candidate
+    // generation and the genotype models is bounded by the number of calling threads
+    const auto num_threads = get_num_threads(options);
+    const auto max_threads = num_threads ? *num_threads : std::max(std::thread::hardware_concurrency(), 1u);
+    if (max_threads > 1) vc_builder.set_thread_pool(std::make_shared<ThreadPool>(max_threads));
     auto bad_region_detector = make_bad_region_detector(options, read_profile);
     if (bad_region_detector) {
         vc_builder.set_bad_region_detector(std::move(*bad_region_detector));
@@ -2252,6 +2381,17 @@ bool is_random_forest_filtering(const OptionMap& options)
     return is_set("forest-model", options) || is_set("somatic-forest-model", options);
 }
 
+bool is_clustering_filtering(const OptionMap& options)
+{
+    return is_set("clustering-filter", options);
+}
+
+std::set<std::string> get_clustering_filter_measures(const OptionMap& options)
+{
+    const auto measures = options.at("clustering-filter").as<std::vector<std::string>>();
+    return {std::cbegin(measures), std::cend(measures)};
+}
+
 auto get_caller_type(const OptionMap& options, const std::vector<SampleName>& samples)
 {
     return get_caller_type(options, samples, get_pedigree(options, samples));
@@ -2287,6 +2427,8 @@ make_call_filter_factory(const ReferenceGenome& reference, ReadPipe& read_pipe,
                 forest_options.use_somatic_forest_for_refcalls = !options.at("use-germline-forest-for-somatic-normals").as<bool>();
             }
             result = std::make_unique<RandomForestFilterFactory>(std::move(forest_files), std::move(forest_types), *temp_directory, forest_options);
+        } else if (is_clustering_filtering(options)) {
+            result = std::make_unique<UnsupervisedClusteringFilterFactory>(get_clustering_filter_measures(options), *temp_directory);
         } else {
             if (is_filter_training_mode(options)) {
                 result = std::make_unique<TrainingFilterFactory>(get_requested_measure_annotations(options));
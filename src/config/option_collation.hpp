@@ -29,6 +29,8 @@ namespace octopus { namespace options {
 
 bool is_run_command(const OptionMap& options);
 
+bool is_build_repeat_index_command(const OptionMap& options);
+
 bool is_debug_mode(const OptionMap& options);
 bool is_trace_mode(const OptionMap& options);
 
@@ -39,6 +41,8 @@ boost::optional<unsigned> get_num_threads(const OptionMap& options);
 
 MemoryFootprint get_target_read_buffer_size(const OptionMap& options);
 
+std::size_t get_max_buffered_output_calls(const OptionMap& options);
+
 ReferenceGenome make_reference(const OptionMap& options);
 
 InputRegionMap get_search_regions(const OptionMap& options, const ReferenceGenome& reference);
@@ -55,6 +59,8 @@ boost::optional<AlignedRead::NucleotideSequence::size_type> max_read_length(cons
 
 bool use_same_read_profile_for_all_samples(const OptionMap& options);
 
+boost::optional<fs::path> get_read_profile_cache_directory(const OptionMap& options);
+
 ReadPipe make_read_pipe(ReadManager& read_manager, const ReferenceGenome& reference, std::vector<SampleName> samples, const OptionMap& options);
 
 bool call_sites_only(const OptionMap& options);
@@ -91,7 +91,16 @@ OptionMap parse_options(const int argc, const char** argv)
     ("max-open-read-files",
      po::value<int>()->default_value(250),
      "Limits the number of read files that are open simultaneously")
+    
+    ("max-read-index-cache-memory",
+     po::value<MemoryFootprint>()->default_value(*parse_footprint("1GB"), "1GB"),
+     "Maximum memory for cached read file headers and indices, which avoids reloading them when read files are reopened")
 
+    ("max-buffered-output-calls",
+     po::value<int>()->default_value(100000),
+     "Maximum number of calls from out-of-order tasks held in memory when streaming multi-threaded output,"
+     " beyond which they are spilled to temporary files. If 0, all calls are written to temporary files and merged at the end")
+    
     ("temp-directory-prefix",
      po::value<fs::path>()->default_value("octopus-temp"),
      "File name prefix of temporary directory for calling")
@@ -100,6 +109,14 @@ OptionMap parse_options(const int argc, const char** argv)
      po::value<fs::path>()->required(),
      "Indexed FASTA format reference genome file to be analysed")
     
+    ("repeat-index",
+     po::value<fs::path>(),
+     "Tandem repeat index for the reference, built with --build-repeat-index")
+    
+    ("build-repeat-index",
+     po::bool_switch()->default_value(false),
+     "Build the tandem repeat index given by --repeat-index for the reference and exit")
+    
     ("reads,I",
      po::value<std::vector<fs::path>>()->multitoken(),
      "Indexed BAM/CRAM files to be analysed")
@@ -327,6 +344,10 @@ OptionMap parse_options(const int argc, const char** argv)
     ("use-same-read-profile-for-all-samples",
      po::bool_switch()->default_value(false),
      "Use the same read profile for all samples, rather than generating one per sample")
+    
+    ("read-profile-cache",
+     po::value<fs::path>(),
+     "Directory where input read profiles are cached and reused by later runs on the same read files")
     ;
     
     po::options_description variant_discovery("Variant discovery");
@@ -367,6 +388,15 @@ OptionMap parse_options(const int argc, const char** argv)
      po::bool_switch()->default_value(false),
      "Use variants from source VCF records that have been filtered")
     
+    ("store-source-candidates",
+     po::bool_switch()->default_value(false),
+     "Compact each source candidate file into a memory-mapped store (<file>.octsc), rebuilt when older than the file, and fetch candidates from the store")
+    
+    ("source-candidate-store-directory",
+     po::value<fs::path>(),
+     "Directory where source candidate stores are written, rather than next to each source candidate file"
+     " (or the system temporary directory if the source candidate file directory is not writable)")
+    
     ("min-pileup-base-quality",
      po::value<int>()->default_value(20),
      "Only bases with quality above this value are considered for candidate generation")
@@ -769,6 +799,11 @@ OptionMap parse_options(const int argc, const char** argv)
     ("use-germline-forest-for-somatic-normals",
      po::bool_switch()->default_value(false),
      "Use the germline forest model for evaluating somatic variant normal sample genotypes rather than the somatic forest model")
+    
+    ("clustering-filter",
+     po::value<std::vector<std::string>>()->multitoken()
+     ->implicit_value(std::vector<std::string> {"QUAL", "MQ", "MP", "AF", "SB", "BQ", "DP"}, "QUAL MQ MP AF SB BQ DP"),
+     "Filter calls assigned to the minority cluster by unsupervised clustering of the given measures, rather than with filter expressions")
     ;
     
     po::options_description all("Octopus command line options");
@@ -1152,7 +1187,8 @@ void validate(const OptionMap& vm)
         "min-mapping-quality", "good-base-quality", "min-good-bases", "min-read-length",
         "max-read-length", "min-base-quality", "max-variant-size",
         "num-fallback-kmers", "max-assemble-region-overlap", "assembler-mask-base-quality",
-        "min-kmer-prune", "max-bubbles", "max-holdout-depth", "max-copy-loss", "max-copy-gain"
+        "min-kmer-prune", "max-bubbles", "max-holdout-depth", "max-copy-loss", "max-copy-gain",
+        "max-buffered-output-calls"
     };
     const std::vector<std::string> strictly_positive_int_options {
         "max-open-read-files", "downsample-above", "downsample-target", "min-supporting-reads",
@@ -1169,6 +1205,8 @@ void validate(const OptionMap& vm)
     };
     conflicting_options(vm, "maternal-sample", "normal-sample");
     conflicting_options(vm, "paternal-sample", "normal-sample");
+    conflicting_options(vm, "clustering-filter", "forest-model");
+    conflicting_options(vm, "clustering-filter", "somatic-forest-model");
     for (const auto& option : positive_int_options) {
         check_positive(option, vm);
     }
@@ -1178,7 +1216,11 @@ void validate(const OptionMap& vm)
     for (const auto& option : probability_options) {
         check_probability(option, vm);
     }
-    check_reads_present(vm);
+    option_dependency(vm, "build-repeat-index", "repeat-index");
+    option_dependency(vm, "source-candidate-store-directory", "store-source-candidates");
+    if (!vm.at("build-repeat-index").as<bool>()) {
+        check_reads_present(vm);
+    }
     check_region_files_consistent(vm);
     check_trio_consistent(vm);
     validate_caller(vm);
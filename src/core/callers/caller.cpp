@@ -154,6 +154,7 @@ std::deque<VcfRecord> Caller::call(const GenomicRegion& call_region, ProgressMet
         add_reads(reads, candidate_generator_);
         if (!refcalls_requested() && all_empty(reads)) {
             if (debug_log_) stream(*debug_log_) << "Stopping early as no reads found in call region " << call_region;
+            reset();
             return {};
         }
         if (debug_log_) stream(*debug_log_) << "Using " << count_reads(reads) << " reads in call region " << call_region;
@@ -202,6 +203,12 @@ std::vector<VcfRecord> Caller::regenotype(const std::vector<Variant>& variants,
     return {}; // TODO
 }
 
+void Caller::reset() const noexcept
+{
+    candidate_generator_.clear();
+    likelihood_model_.clear_caches();
+}
+
 auto assign_and_realign(const std::vector<AlignedRead>& reads, const Genotype<Haplotype>& genotype)
 {
     auto result = compute_haplotype_support(genotype, reads, {AssignmentConfig::AmbiguousAction::first});
@@ -532,6 +539,12 @@ ExecutionPolicy Caller::exucution_policy() const noexcept
     return parameters_.execution_policy;
 }
 
+boost::optional<ThreadPool&> Caller::thread_pool() const noexcept
+{
+    if (parameters_.thread_pool) return *parameters_.thread_pool;
+    return boost::none;
+}
+
 Caller::GeneratorStatus
 Caller::generate_active_haplotypes(const GenomicRegion& call_region,
                                    HaplotypeGenerator& haplotype_generator,
@@ -31,6 +31,7 @@
 #include "io/reference/reference_genome.hpp"
 #include "readpipe/read_pipe.hpp"
 #include "utils/memory_footprint.hpp"
+#include "utils/thread_pool.hpp"
 #include "logging/progress_meter.hpp"
 #include "logging/logging.hpp"
 
@@ -71,6 +72,7 @@ public:
         bool protect_reference_haplotype;
         boost::optional<MemoryFootprint> target_max_memory;
         ExecutionPolicy execution_policy;
+        std::shared_ptr<ThreadPool> thread_pool;
         ReadLinkageType read_linkage;
         bool try_early_phase_detection;
     };
@@ -99,6 +101,10 @@ public:
     
     std::vector<VcfRecord> regenotype(const std::vector<Variant>& variants, ProgressMeter& progress_meter) const;
     
+    // Discards any state left over from a previous call, including candidate generator and likelihood
+    // model caches, so the caller can be reused for a new region. Internal buffers are kept.
+    void reset() const noexcept;
+    
 protected:
     using HaplotypeBlock = HaplotypeGenerator::HaplotypeBlock;
     
@@ -131,7 +137,7 @@ private:
     std::reference_wrapper<const ReadPipe> read_pipe_;
     mutable VariantGenerator candidate_generator_;
     HaplotypeGenerator::Builder haplotype_generator_builder_;
-    HaplotypeLikelihoodModel likelihood_model_;
+    mutable HaplotypeLikelihoodModel likelihood_model_;
     Phaser phaser_;
     boost::optional<BadRegionDetector> bad_region_detector_;
     Parameters parameters_;
@@ -150,6 +156,8 @@ protected:
     
     boost::optional<MemoryFootprint> target_max_memory() const noexcept;
     ExecutionPolicy exucution_policy() const noexcept;
+    // Workers shared by all callers, for use when the execution policy is par
+    boost::optional<ThreadPool&> thread_pool() const noexcept;
 
 private:
     virtual std::unique_ptr<Latents>
@@ -135,6 +135,13 @@ CallerBuilder& CallerBuilder::set_execution_policy(ExecutionPolicy policy) noexc
     return *this;
 }
 
+CallerBuilder& CallerBuilder::set_thread_pool(std::shared_ptr<ThreadPool> workers)
+{
+    components_.variant_generator_builder.set_thread_pool(workers);
+    params_.general.thread_pool = std::move(workers);
+    return *this;
+}
+
 CallerBuilder& CallerBuilder::set_read_linkage(ReadLinkageType linkage) noexcept
 {
     params_.general.read_linkage = linkage;
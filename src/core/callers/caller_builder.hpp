@@ -55,6 +55,8 @@ public:
     CallerBuilder& set_reference_haplotype_protection(bool b) noexcept;
     CallerBuilder& set_target_memory_footprint(MemoryFootprint memory) noexcept;
     CallerBuilder& set_execution_policy(ExecutionPolicy policy) noexcept;
+    // Shared by the candidate generators and models of all built callers
+    CallerBuilder& set_thread_pool(std::shared_ptr<ThreadPool> workers);
     CallerBuilder& set_read_linkage(ReadLinkageType linkage) noexcept;
     CallerBuilder& set_bad_region_detector(BadRegionDetector detector) noexcept;
     
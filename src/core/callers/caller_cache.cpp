@@ -0,0 +1,65 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "caller_cache.hpp"
+
+#include <utility>
+
+#include "caller_factory.hpp"
+
+namespace octopus {
+
+CallerCache::CallerCache(const CallerFactory& factory, const std::size_t max_idle_per_contig)
+: factory_ {factory}
+, max_idle_per_contig_ {max_idle_per_contig}
+, idle_ {}
+, stats_ {}
+, mutex_ {}
+{}
+
+std::unique_ptr<const Caller> CallerCache::acquire(const ContigName& contig)
+{
+    // CallerFactory::make is not thread-safe so callers are also made under the lock
+    std::lock_guard<std::mutex> lock {mutex_};
+    const auto itr = idle_.find(contig);
+    if (itr != std::end(idle_) && !itr->second.empty()) {
+        auto result = std::move(itr->second.back());
+        itr->second.pop_back();
+        ++stats_.num_reused;
+        return result;
+    }
+    ++stats_.num_made;
+    return factory_.get().make(contig);
+}
+
+void CallerCache::release(const ContigName& contig, std::unique_ptr<const Caller> caller)
+{
+    if (!caller) return;
+    caller->reset();
+    std::lock_guard<std::mutex> lock {mutex_};
+    auto& callers = idle_[contig];
+    if (callers.size() < max_idle_per_contig_) {
+        callers.push_back(std::move(caller));
+    }
+}
+
+void CallerCache::evict(const ContigName& contig)
+{
+    CallerStack evicted {};
+    {
+        std::lock_guard<std::mutex> lock {mutex_};
+        const auto itr = idle_.find(contig);
+        if (itr == std::end(idle_)) return;
+        evicted = std::move(itr->second);
+        idle_.erase(itr);
+    }
+    // evicted callers are destroyed outside the lock
+}
+
+CallerCache::Stats CallerCache::stats() const
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    return stats_;
+}
+
+} // namespace octopus
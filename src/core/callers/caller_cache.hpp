@@ -0,0 +1,70 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef caller_cache_hpp
+#define caller_cache_hpp
+
+#include <unordered_map>
+#include <vector>
+#include <memory>
+#include <mutex>
+#include <cstddef>
+
+#include "basics/genomic_region.hpp"
+#include "caller.hpp"
+
+namespace octopus {
+
+class CallerFactory;
+
+/*
+ CallerCache keeps idle Callers so they can be reused by later tasks on the same contig rather
+ than being rebuilt for every task. Callers are checked out with acquire and handed back with
+ release, which resets them but keeps their internal buffers. At most max_idle_per_contig idle
+ callers are retained per contig, which should normally be the number of worker threads.
+ 
+ acquire, release, and evict may be called concurrently.
+ */
+class CallerCache
+{
+public:
+    using ContigName = GenomicRegion::ContigName;
+    
+    struct Stats
+    {
+        std::size_t num_made = 0, num_reused = 0;
+    };
+    
+    CallerCache() = delete;
+    
+    CallerCache(const CallerFactory& factory, std::size_t max_idle_per_contig);
+    
+    CallerCache(const CallerCache&)            = delete;
+    CallerCache& operator=(const CallerCache&) = delete;
+    CallerCache(CallerCache&&)                 = delete;
+    CallerCache& operator=(CallerCache&&)      = delete;
+    
+    ~CallerCache() = default;
+    
+    std::unique_ptr<const Caller> acquire(const ContigName& contig);
+    
+    void release(const ContigName& contig, std::unique_ptr<const Caller> caller);
+    
+    // Drops all idle callers for the contig, e.g. once all its tasks are finished
+    void evict(const ContigName& contig);
+    
+    Stats stats() const;
+    
+private:
+    using CallerStack = std::vector<std::unique_ptr<const Caller>>;
+    
+    std::reference_wrapper<const CallerFactory> factory_;
+    std::size_t max_idle_per_contig_;
+    std::unordered_map<ContigName, CallerStack> idle_;
+    Stats stats_;
+    mutable std::mutex mutex_;
+};
+
+} // namespace octopus
+
+#endif
@@ -474,7 +474,9 @@ void CancerCaller::generate_cancer_genotypes_with_no_normal(Latents& latents, co
         const auto max_germline_haplotype_bases = max_num_elements(max_germline_genotype_bases, parameters_.ploidy);
         const auto top_haplotypes = copy_greatest_probability_values(latents.indexed_haplotypes_, germline_model_haplotype_posteriors,
                                                                      max_germline_haplotype_bases);
-        auto germline_bases = generate_all_genotypes(top_haplotypes, parameters_.ploidy);
+        MappableBlock<Genotype<IndexedHaplotype<>>> germline_bases {mapped_region(top_haplotypes)};
+        germline_bases.reserve(num_genotypes(top_haplotypes.size(), parameters_.ploidy));
+        for_each_genotype(top_haplotypes, parameters_.ploidy, [&] (auto&& genotype) { germline_bases.push_back(std::move(genotype)); });
         latents.cancer_genotypes_.push_back(generate_all_cancer_genotypes(germline_bases, latents.indexed_haplotypes_, 1));
         if (latents.cancer_genotypes_.size() > 2 * max_allowed_cancer_genotypes) {
             if (!latents.cancer_genotype_prior_model_->mutation_model().is_primed()) {
@@ -371,6 +371,7 @@ CellCaller::infer_latents(const HaplotypeBlock& haplotypes, const HaplotypeLikel
     model::SingleCellModel::AlgorithmParameters config {};
     config.max_genotype_combinations = *parameters_.max_genotype_combinations;
     config.execution_policy = this->exucution_policy();
+    config.workers = this->thread_pool();
     if (parameters_.max_vb_seeds) config.max_seeds = *parameters_.max_vb_seeds;
     CoalescentPopulationPriorModel population_prior_model {{Haplotype {mapped_region(haplotypes), reference_}, {}}};
     population_prior_model.prime(haplotypes);
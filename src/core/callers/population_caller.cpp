@@ -743,7 +743,11 @@ PopulationCaller::infer_latents_with_joint_model(const HaplotypeBlock& haplotype
 {
     const auto indexed_haplotypes = index(haplotypes);
     const auto prior_model = make_joint_prior_model(haplotypes);
-    const model::PopulationModel model {*prior_model, {parameters_.max_genotype_combinations}, debug_log_};
+    model::PopulationModel::Options model_options {};
+    model_options.max_genotype_combinations = parameters_.max_genotype_combinations;
+    model_options.execution_policy = this->exucution_policy();
+    model_options.workers = this->thread_pool();
+    const model::PopulationModel model {*prior_model, model_options, debug_log_};
     prior_model->prime(haplotypes);
     if (unique_ploidies_.size() == 1) {
         auto genotypes = generate_all_genotypes(indexed_haplotypes, parameters_.ploidies.front());
@@ -401,11 +401,10 @@ TrioCaller::infer_latents(const HaplotypeBlock& haplotypes,
     germline_prior_model->prime(haplotypes);
     DeNovoModel denovo_model {parameters_.denovo_model_params, haplotypes.size(), DeNovoModel::CachingStrategy::none};
     denovo_model.prime(haplotypes);
-    const model::TrioModel model {
-        parameters_.trio, *germline_prior_model, denovo_model,
-        TrioModel::Options {parameters_.max_genotype_combinations},
-        debug_log_
-    };
+    TrioModel::Options model_options {parameters_.max_genotype_combinations};
+    model_options.execution_policy = this->exucution_policy();
+    model_options.workers = this->thread_pool();
+    const model::TrioModel model {parameters_.trio, *germline_prior_model, denovo_model, model_options, debug_log_};
     auto maternal_genotypes = generate_all_genotypes(indexed_haplotypes, parameters_.maternal_ploidy);
     if (parameters_.maternal_ploidy == parameters_.paternal_ploidy) {
         auto latents = model.evaluate(maternal_genotypes, haplotype_likelihoods);
@@ -464,9 +463,10 @@ TrioCaller::calculate_model_posterior(const HaplotypeBlock& haplotypes,
         germline_prior_model->prime(haplotypes);
         denovo_model.prime(haplotypes);
         if (debug_log_) *debug_log_ << "Calculating model posterior";
-        const model::TrioModel model {parameters_.trio, *germline_prior_model, denovo_model,
-                                      TrioModel::Options {parameters_.max_genotype_combinations},
-                                      debug_log_};
+        TrioModel::Options model_options {parameters_.max_genotype_combinations};
+        model_options.execution_policy = this->exucution_policy();
+        model_options.workers = this->thread_pool();
+        const model::TrioModel model {parameters_.trio, *germline_prior_model, denovo_model, model_options, debug_log_};
         const auto inferences = model.evaluate(genotypes, haplotype_likelihoods);
         return octopus::calculate_model_posterior(latents.model_latents.log_evidence, inferences.log_evidence);
     } else {
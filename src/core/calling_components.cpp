@@ -9,10 +9,12 @@
 #include <algorithm>
 #include <functional>
 #include <exception>
+#include <thread>
 
 #include "config/config.hpp"
 #include "config/option_collation.hpp"
 #include "utils/map_utils.hpp"
+#include "utils/read_profile_cache.hpp"
 #include "logging/logging.hpp"
 #include "exceptions/user_error.hpp"
 
@@ -202,6 +204,11 @@ bool GenomeCallingComponents::sites_only() const noexcept
     return components_.sites_only;
 }
 
+std::size_t GenomeCallingComponents::max_buffered_output_calls() const noexcept
+{
+    return components_.max_buffered_output_calls;
+}
+
 const PloidyMap& GenomeCallingComponents::ploidies() const noexcept
 {
     return components_.ploidies;
@@ -411,6 +418,29 @@ bool includes(const std::vector<unsigned>& values, const unsigned value) noexcep
     return std::find(std::cbegin(values), std::cend(values), value) != std::cend(values);
 }
 
+unsigned get_max_profiling_threads(const options::OptionMap& options)
+{
+    if (!is_multithreaded_run(options)) return 1;
+    const auto num_threads = options::get_num_threads(options);
+    return num_threads ? *num_threads : std::max(std::thread::hardware_concurrency(), 1u);
+}
+
+boost::optional<ReadSetProfile>
+load_or_profile_reads(const std::vector<SampleName>& samples,
+                      const ReferenceGenome& reference,
+                      const InputRegionMap& input_regions,
+                      const ReadManager& source,
+                      const ReadSetProfileConfig& config,
+                      const options::OptionMap& options)
+{
+    const auto cache_directory = options::get_read_profile_cache_directory(options);
+    if (cache_directory) {
+        return profile_reads(samples, reference, input_regions, source, ReadProfileCache {*cache_directory}, config);
+    } else {
+        return profile_reads(samples, reference, input_regions, source, config);
+    }
+}
+
 auto profile_reads_helper(const std::vector<SampleName>& samples,
                           const ReferenceGenome& reference,
                           const InputRegionMap& input_regions,
@@ -420,8 +450,9 @@ auto profile_reads_helper(const std::vector<SampleName>& samples,
 {
     ReadSetProfileConfig config {};
     config.fragment_size = options::max_read_length(options);
+    config.max_threads = get_max_profiling_threads(options);
     if (samples.size() == 1) {
-        auto result = profile_reads(samples, reference, input_regions, source, config);
+        auto result = load_or_profile_reads(samples, reference, input_regions, source, config, options);
         if (result) result->depth_stats.sample.clear(); // no need to keep this duplicate info
         return result;
     } else if (options::use_same_read_profile_for_all_samples(options)) {
@@ -438,11 +469,11 @@ auto profile_reads_helper(const std::vector<SampleName>& samples,
             }
             if (include_sample) profile_samples.push_back(sample);
         }
-        auto result = profile_reads(profile_samples, reference, input_regions, source, config);
+        auto result = load_or_profile_reads(profile_samples, reference, input_regions, source, config, options);
         if (result) result->depth_stats.sample.clear();
         return result;
     } else {
-        return profile_reads(samples, reference, input_regions, source, config);
+        return load_or_profile_reads(samples, reference, input_regions, source, config, options);
     }
 }
 
@@ -591,6 +622,7 @@ GenomeCallingComponents::Components::Components(ReferenceGenome&& reference, Rea
 , progress_meter {regions}
 , pedigree {options::get_pedigree(options, samples)}
 , sites_only {options::call_sites_only(options)}
+, max_buffered_output_calls {options::get_max_buffered_output_calls(options)}
 , filter_request {}
 , bamout {options::bamout_request(options)}
 , bamout_config {}
@@ -803,4 +835,17 @@ ContigCallingComponents::ContigCallingComponents(const GenomicRegion::ContigName
 , progress_meter {genome_components.progress_meter()}
 {}
 
+ContigCallingComponents::ContigCallingComponents(const GenomicRegion::ContigName& contig,
+                                                 std::unique_ptr<const Caller> caller,
+                                                 GenomeCallingComponents& genome_components)
+: reference {genome_components.reference()}
+, read_manager {genome_components.read_manager()}
+, regions {genome_components.search_regions().at(contig)}
+, samples {genome_components.samples()}
+, caller {std::move(caller)}
+, read_buffer_size {genome_components.read_buffer_size()}
+, output {genome_components.output()}
+, progress_meter {genome_components.progress_meter()}
+{}
+
 } // namespace octopus
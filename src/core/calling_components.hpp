@@ -73,6 +73,7 @@ public:
     const ReadPipe& filter_read_pipe() const noexcept;
     ProgressMeter& progress_meter() noexcept;
     bool sites_only() const noexcept;
+    std::size_t max_buffered_output_calls() const noexcept;
     const PloidyMap& ploidies() const noexcept;
     boost::optional<Pedigree> pedigree() const;
     boost::optional<Path> filter_request() const;
@@ -117,6 +118,7 @@ private:
         ProgressMeter progress_meter;
         boost::optional<Pedigree> pedigree;
         bool sites_only;
+        std::size_t max_buffered_output_calls;
         boost::optional<Path> filter_request;
         boost::optional<Path> bamout;
         BAMRealigner::Config bamout_config;
@@ -164,6 +166,9 @@ struct ContigCallingComponents
     ContigCallingComponents(const GenomicRegion::ContigName& contig, VcfWriter& output,
                             GenomeCallingComponents& genome_components);
     
+    ContigCallingComponents(const GenomicRegion::ContigName& contig, std::unique_ptr<const Caller> caller,
+                            GenomeCallingComponents& genome_components);
+    
     ContigCallingComponents(const ContigCallingComponents&)            = delete;
     ContigCallingComponents& operator=(const ContigCallingComponents&) = delete;
     ContigCallingComponents(ContigCallingComponents&&)                 = default;
@@ -0,0 +1,19 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "contig_completion_tracker.hpp"
+
+#include <utility>
+
+namespace octopus {
+
+ContigCompletionTracker::ContigCompletionTracker(std::vector<ContigName> contigs)
+: unfinished_ {std::move(contigs)}
+{}
+
+bool ContigCompletionTracker::all_finished() const noexcept
+{
+    return unfinished_.empty();
+}
+
+} // namespace octopus
@@ -0,0 +1,60 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef contig_completion_tracker_hpp
+#define contig_completion_tracker_hpp
+
+#include <vector>
+#include <iterator>
+#include <algorithm>
+
+#include "basics/genomic_region.hpp"
+
+namespace octopus {
+
+/*
+ ContigCompletionTracker records which contigs have not yet been reported as finished. Contigs are
+ re-checked on every call to pop_finished rather than only when one of their own tasks completes,
+ so contigs with no tasks, or whose last task completes before the task maker marks them finished,
+ are still reported.
+ */
+class ContigCompletionTracker
+{
+public:
+    using ContigName = GenomicRegion::ContigName;
+    
+    ContigCompletionTracker() = default;
+    
+    ContigCompletionTracker(std::vector<ContigName> contigs);
+    
+    ContigCompletionTracker(const ContigCompletionTracker&)            = default;
+    ContigCompletionTracker& operator=(const ContigCompletionTracker&) = default;
+    ContigCompletionTracker(ContigCompletionTracker&&)                 = default;
+    ContigCompletionTracker& operator=(ContigCompletionTracker&&)      = default;
+    
+    ~ContigCompletionTracker() = default;
+    
+    bool all_finished() const noexcept;
+    
+    // Returns the unreported contigs satisfying is_finished, in the original order, and forgets them
+    template <typename UnaryPredicate>
+    std::vector<ContigName> pop_finished(UnaryPredicate is_finished);
+    
+private:
+    std::vector<ContigName> unfinished_;
+};
+
+template <typename UnaryPredicate>
+std::vector<ContigCompletionTracker::ContigName> ContigCompletionTracker::pop_finished(UnaryPredicate is_finished)
+{
+    std::vector<ContigName> result {};
+    const auto itr = std::stable_partition(std::begin(unfinished_), std::end(unfinished_),
+                                           [&] (const auto& contig) { return !is_finished(contig); });
+    result.assign(std::make_move_iterator(itr), std::make_move_iterator(std::end(unfinished_)));
+    unfinished_.erase(itr, std::end(unfinished_));
+    return result;
+}
+
+} // namespace octopus
+
+#endif
@@ -130,6 +130,26 @@ decltype(auto) get_value(const FacetWrapper& facet)
     return detail::get_value(boost::get<typename F::ResultType>(facet.get()));
 }
 
+// A typed reference to the value of facet F, for looking up a facet once rather than for every call
+template <typename F>
+class FacetHandle
+{
+public:
+    using ValueType = typename F::ResultType::type;
+    
+    FacetHandle() = delete;
+    
+    template <typename FacetMap>
+    FacetHandle(const FacetMap& facets, const std::string& name) : value_ {&get_value<F>(facets.at(name))} {}
+    
+    const ValueType& get() const noexcept { return *value_; }
+    const ValueType& operator*() const noexcept { return *value_; }
+    const ValueType* operator->() const noexcept { return value_; }
+    
+private:
+    const ValueType* value_;
+};
+
 } // namespace csr
 } // namespace octopus
 
@@ -0,0 +1,381 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "call_clusterer.hpp"
+
+#include <utility>
+#include <functional>
+#include <iterator>
+#include <algorithm>
+#include <future>
+#include <random>
+#include <limits>
+#include <cmath>
+#include <cassert>
+
+#include <boost/filesystem/operations.hpp>
+
+#include "exceptions/unwritable_file_error.hpp"
+
+namespace octopus { namespace csr {
+
+class UnwritableClusteringData : public UnwritableFileError
+{
+    std::string do_where() const override { return "CallClusterer"; }
+public:
+    UnwritableClusteringData(boost::filesystem::path file) : UnwritableFileError {std::move(file)} {}
+};
+
+CallClusterer::CallClusterer(const std::size_t num_features, Path spill_path, Options options,
+                             boost::optional<ThreadPool&> workers)
+: num_features_ {num_features}
+, spill_path_ {std::move(spill_path)}
+, options_ {options}
+, workers_ {workers}
+, num_rows_ {0}
+, buffer_ {}
+, summaries_(num_features)
+, spill_file_ {}
+, num_spilled_rows_ {0}
+, spilled_ {}
+, labels_ {}
+, separation_ {0}
+{
+    options_.max_buffered_rows = std::max(options_.max_buffered_rows, std::size_t {1});
+    options_.batch_size = std::max(options_.batch_size, std::size_t {1});
+}
+
+CallClusterer::~CallClusterer()
+{
+    try {
+        remove_spill_file();
+    } catch (...) {}
+}
+
+std::size_t CallClusterer::num_features() const noexcept
+{
+    return num_features_;
+}
+
+std::size_t CallClusterer::num_rows() const noexcept
+{
+    return num_rows_;
+}
+
+std::size_t CallClusterer::num_spilled_rows() const noexcept
+{
+    return num_spilled_rows_;
+}
+
+namespace {
+
+float to_float(const double value) noexcept
+{
+    return std::isfinite(value) ? static_cast<float>(value) : std::numeric_limits<float>::quiet_NaN();
+}
+
+} // namespace
+
+void CallClusterer::add_row(const std::vector<double>& values)
+{
+    assert(values.size() == num_features_);
+    if (buffer_.size() >= options_.max_buffered_rows * num_features_) spill();
+    for (std::size_t i {0}; i < num_features_; ++i) {
+        const auto value = values[i];
+        if (std::isfinite(value)) {
+            auto& summary = summaries_[i];
+            ++summary.count;
+            const auto delta = value - summary.mean;
+            summary.mean += delta / summary.count;
+            summary.m2 += delta * (value - summary.mean);
+        }
+        buffer_.push_back(to_float(value));
+    }
+    ++num_rows_;
+}
+
+void CallClusterer::spill()
+{
+    if (buffer_.empty()) return;
+    if (!spill_file_.is_open()) {
+        spill_file_.open(spill_path_.string(), std::ios::binary | std::ios::trunc);
+        if (!spill_file_) throw UnwritableClusteringData {spill_path_};
+    }
+    spill_file_.write(reinterpret_cast<const char*>(buffer_.data()), buffer_.size() * sizeof(float));
+    if (!spill_file_) throw UnwritableClusteringData {spill_path_};
+    num_spilled_rows_ += buffer_.size() / num_features_;
+    buffer_.clear();
+}
+
+const float* CallClusterer::get_data()
+{
+    if (num_spilled_rows_ == 0) return buffer_.data();
+    if (!spilled_.is_open()) {
+        spill();
+        spill_file_.close();
+        buffer_.clear();
+        buffer_.shrink_to_fit();
+        spilled_.open(spill_path_.string());
+    }
+    return reinterpret_cast<const float*>(spilled_.data());
+}
+
+void CallClusterer::remove_spill_file()
+{
+    if (spilled_.is_open()) spilled_.close();
+    if (spill_file_.is_open()) spill_file_.close();
+    if (num_spilled_rows_ > 0) {
+        boost::filesystem::remove(spill_path_);
+    }
+}
+
+CallClusterer::Features CallClusterer::get_active_features() const
+{
+    Features result {};
+    for (std::size_t i {0}; i < summaries_.size(); ++i) {
+        const auto& summary = summaries_[i];
+        if (summary.count > 1) {
+            const auto variance = summary.m2 / summary.count;
+            if (variance > 0 && std::isfinite(variance)) {
+                result.indices.push_back(i);
+                result.means.push_back(summary.mean);
+                result.inverse_sds.push_back(1.0 / std::sqrt(variance));
+            }
+        }
+    }
+    return result;
+}
+
+bool CallClusterer::standardise(const float* data, const std::size_t row, const Features& features,
+                                double* result) const noexcept
+{
+    const auto values = data + row * num_features_;
+    bool any_observed {false};
+    for (std::size_t i {0}; i < features.indices.size(); ++i) {
+        const auto value = values[features.indices[i]];
+        if (std::isnan(value)) {
+            result[i] = 0; // impute the mean
+        } else {
+            result[i] = (value - features.means[i]) * features.inverse_sds[i];
+            any_observed = true;
+        }
+    }
+    return any_observed;
+}
+
+namespace {
+
+constexpr std::size_t minChunkSize {4096};
+
+double squared_distance(const double* point, const std::vector<double>& centroid) noexcept
+{
+    double result {0};
+    for (std::size_t i {0}; i < centroid.size(); ++i) {
+        const auto d = point[i] - centroid[i];
+        result += d * d;
+    }
+    return result;
+}
+
+double dot(const double* lhs, const double* rhs, const std::size_t n) noexcept
+{
+    double result {0};
+    for (std::size_t i {0}; i < n; ++i) result += lhs[i] * rhs[i];
+    return result;
+}
+
+template <typename Centroids>
+std::uint8_t nearest(const double* point, const Centroids& centroids) noexcept
+{
+    return squared_distance(point, centroids[0]) <= squared_distance(point, centroids[1]) ? 0 : 1;
+}
+
+} // namespace
+
+template <typename F>
+void CallClusterer::for_each_chunk(const std::size_t num_rows, const std::size_t chunk_size, F f) const
+{
+    if (workers_ && workers_->size() > 1 && num_rows > chunk_size) {
+        std::vector<std::future<void>> chunks {};
+        chunks.reserve(num_rows / chunk_size + 1);
+        for (std::size_t first {0}; first < num_rows; first += chunk_size) {
+            chunks.push_back(workers_->push(f, first, std::min(first + chunk_size, num_rows)));
+        }
+        for (auto& chunk : chunks) chunk.get();
+    } else {
+        f(0, num_rows);
+    }
+}
+
+std::array<CallClusterer::Centroid, 2>
+CallClusterer::initialise_centroids(const float* data, const Features& features) const
+{
+    // Seed with the sampled point nearest the mean, then k-means++ for the second centroid
+    const auto num_dimensions = features.indices.size();
+    std::mt19937_64 generator {42};
+    std::uniform_int_distribution<std::size_t> row_dist {0, num_rows_ - 1};
+    const auto sample_size = std::min(options_.batch_size, num_rows_);
+    std::vector<double> points(sample_size * num_dimensions);
+    std::size_t num_points {0};
+    for (std::size_t i {0}; i < sample_size; ++i) {
+        if (standardise(data, row_dist(generator), features, points.data() + num_points * num_dimensions)) ++num_points;
+    }
+    std::array<Centroid, 2> result {};
+    if (num_points == 0) return result;
+    const Centroid origin(num_dimensions, 0.0);
+    std::vector<double> distances(num_points);
+    for (std::size_t i {0}; i < num_points; ++i) {
+        distances[i] = squared_distance(points.data() + i * num_dimensions, origin);
+    }
+    const auto first = std::distance(std::cbegin(distances), std::min_element(std::cbegin(distances), std::cend(distances)));
+    const auto first_point = std::next(std::cbegin(points), first * num_dimensions);
+    result[0].assign(first_point, std::next(first_point, num_dimensions));
+    for (std::size_t i {0}; i < num_points; ++i) {
+        distances[i] = squared_distance(points.data() + i * num_dimensions, result[0]);
+    }
+    if (std::all_of(std::cbegin(distances), std::cend(distances), [] (auto d) { return d == 0; })) return result;
+    std::discrete_distribution<std::size_t> point_dist {std::cbegin(distances), std::cend(distances)};
+    const auto second_point = std::next(std::cbegin(points), point_dist(generator) * num_dimensions);
+    result[1].assign(second_point, std::next(second_point, num_dimensions));
+    return result;
+}
+
+std::array<CallClusterer::Centroid, 2>
+CallClusterer::find_centroids(const float* data, const Features& features) const
+{
+    auto result = initialise_centroids(data, features);
+    if (result[1].empty()) return result;
+    const auto num_dimensions = features.indices.size();
+    const auto batch_size = std::min(options_.batch_size, num_rows_);
+    std::mt19937_64 generator {1729};
+    std::uniform_int_distribution<std::size_t> row_dist {0, num_rows_ - 1};
+    std::vector<std::size_t> batch(batch_size);
+    std::vector<double> points(batch_size * num_dimensions);
+    std::vector<std::int8_t> assignments(batch_size);
+    std::array<std::size_t, 2> counts {0, 0};
+    for (unsigned iteration {0}; iteration < options_.max_iterations; ++iteration) {
+        std::generate(std::begin(batch), std::end(batch), [&] () { return row_dist(generator); });
+        for_each_chunk(batch_size, minChunkSize, [&] (const std::size_t first, const std::size_t last) {
+            for (auto i = first; i < last; ++i) {
+                const auto point = points.data() + i * num_dimensions;
+                assignments[i] = standardise(data, batch[i], features, point) ? nearest(point, result) : -1;
+            }
+        });
+        const auto previous = result;
+        for (std::size_t i {0}; i < batch_size; ++i) {
+            if (assignments[i] < 0) continue;
+            auto& centroid = result[assignments[i]];
+            const auto learning_rate = 1.0 / ++counts[assignments[i]];
+            const auto point = points.data() + i * num_dimensions;
+            for (std::size_t j {0}; j < num_dimensions; ++j) {
+                centroid[j] += learning_rate * (point[j] - centroid[j]);
+            }
+        }
+        const auto shift = squared_distance(previous[0].data(), result[0]) + squared_distance(previous[1].data(), result[1]);
+        if (shift < options_.tolerance * options_.tolerance) break;
+    }
+    return result;
+}
+
+std::array<CallClusterer::ClusterSummary, 2>
+CallClusterer::assign(const float* data, const Features& features, const std::array<Centroid, 2>& centroids)
+{
+    const auto num_dimensions = features.indices.size();
+    const auto num_workers = workers_ ? workers_->size() : std::size_t {1};
+    const auto chunk_size = std::max(minChunkSize, num_rows_ / (4 * std::max(num_workers, std::size_t {1})) + 1);
+    // Unit vector along the centroid axis, used to measure each cluster's spread towards the other
+    Centroid axis(num_dimensions);
+    std::transform(std::cbegin(centroids[1]), std::cend(centroids[1]), std::cbegin(centroids[0]), std::begin(axis), std::minus<> {});
+    const auto axis_length = std::sqrt(dot(axis.data(), axis.data(), num_dimensions));
+    if (axis_length > 0) for (auto& x : axis) x /= axis_length;
+    const std::array<double, 2> centroid_projections {dot(centroids[0].data(), axis.data(), num_dimensions),
+                                                      dot(centroids[1].data(), axis.data(), num_dimensions)};
+    std::vector<std::array<ClusterSummary, 2>> chunk_summaries(num_rows_ / chunk_size + 1);
+    labels_.resize(num_rows_);
+    for_each_chunk(num_rows_, chunk_size, [&] (const std::size_t first, const std::size_t last) {
+        Centroid point(num_dimensions);
+        auto& summaries = chunk_summaries[first / chunk_size];
+        for (auto row = first; row < last; ++row) {
+            if (standardise(data, row, features, point.data())) {
+                const auto cluster = nearest(point.data(), centroids);
+                labels_[row] = static_cast<Label>(cluster);
+                const auto deviation = dot(point.data(), axis.data(), num_dimensions) - centroid_projections[cluster];
+                ++summaries[cluster].count;
+                summaries[cluster].squared_deviation += deviation * deviation;
+            } else {
+                labels_[row] = Label::unclustered;
+            }
+        }
+    });
+    std::array<ClusterSummary, 2> result {};
+    for (const auto& summaries : chunk_summaries) {
+        for (int k {0}; k < 2; ++k) {
+            result[k].count += summaries[k].count;
+            result[k].squared_deviation += summaries[k].squared_deviation;
+        }
+    }
+    return result;
+}
+
+namespace {
+
+template <typename Summaries>
+double ashmans_d(const double distance, const Summaries& summaries) noexcept
+{
+    if (summaries[0].count == 0 || summaries[1].count == 0) return 0;
+    const auto variance0 = summaries[0].squared_deviation / summaries[0].count;
+    const auto variance1 = summaries[1].squared_deviation / summaries[1].count;
+    const auto pooled_variance = (variance0 + variance1) / 2;
+    if (pooled_variance <= 0) return std::numeric_limits<double>::infinity();
+    return distance / std::sqrt(pooled_variance);
+}
+
+} // namespace
+
+std::array<std::size_t, 2> CallClusterer::cluster()
+{
+    labels_.assign(num_rows_, Label::majority);
+    separation_ = 0;
+    std::array<std::size_t, 2> result {num_rows_, 0};
+    const auto features = get_active_features();
+    if (num_rows_ > 1 && !features.indices.empty()) {
+        const auto data = get_data();
+        const auto centroids = find_centroids(data, features);
+        if (!centroids[1].empty()) {
+            const auto summaries = assign(data, features, centroids);
+            result = {summaries[0].count, summaries[1].count};
+            separation_ = ashmans_d(std::sqrt(squared_distance(centroids[0].data(), centroids[1])), summaries);
+            if (separation_ < options_.min_separation) {
+                for (auto& label : labels_) {
+                    if (label != Label::unclustered) label = Label::majority;
+                }
+                result = {result[0] + result[1], 0};
+            } else if (result[0] < result[1]) {
+                for (auto& label : labels_) {
+                    if (label != Label::unclustered) {
+                        label = label == Label::majority ? Label::minority : Label::majority;
+                    }
+                }
+                std::swap(result[0], result[1]);
+            }
+        }
+    }
+    buffer_.clear();
+    buffer_.shrink_to_fit();
+    remove_spill_file();
+    return result;
+}
+
+CallClusterer::Label CallClusterer::label(const std::size_t row) const noexcept
+{
+    assert(row < labels_.size());
+    return labels_[row];
+}
+
+double CallClusterer::separation() const noexcept
+{
+    return separation_;
+}
+
+} // namespace csr
+} // namespace octopus
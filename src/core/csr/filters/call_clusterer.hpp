@@ -0,0 +1,132 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef call_clusterer_hpp
+#define call_clusterer_hpp
+
+#include <vector>
+#include <array>
+#include <fstream>
+#include <cstddef>
+#include <cstdint>
+
+#include <boost/optional.hpp>
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "utils/thread_pool.hpp"
+
+namespace octopus { namespace csr {
+
+/*
+ CallClusterer splits rows of features (one row per sample call) into two clusters with mini-batch
+ k-means over the standardised features, and labels the rows in the smaller cluster as the minority.
+ Rows are streamed into a float matrix; once the matrix grows beyond max_buffered_rows it is spilled
+ to a binary file at spill_path, which is memory mapped for clustering, so memory use is bounded for
+ any number of rows.
+
+ Missing feature values (NaN) are imputed with the feature mean, and features that are constant or
+ unobserved are ignored. Rows with no observed features are left unclustered.
+
+ k-means splits any data in two, including calls that form a single population. So a minority is
+ only reported when the clusters are separated along the axis through their centroids by at least
+ min_separation, measured with Ashman's D (the centroid distance over the root mean within-cluster
+ variance). Splitting a single normal population gives D of about 2.7; otherwise all rows are
+ labelled majority.
+ */
+class CallClusterer
+{
+public:
+    using Path = boost::filesystem::path;
+
+    enum class Label : std::uint8_t { majority, minority, unclustered };
+
+    struct Options
+    {
+        std::size_t max_buffered_rows = 1'000'000;
+        std::size_t batch_size = 10'000;
+        unsigned max_iterations = 100;
+        double tolerance = 1e-4;
+        double min_separation = 4.0;
+    };
+
+    CallClusterer() = delete;
+
+    CallClusterer(std::size_t num_features, Path spill_path, Options options,
+                  boost::optional<ThreadPool&> workers = boost::none);
+
+    CallClusterer(const CallClusterer&)            = delete;
+    CallClusterer& operator=(const CallClusterer&) = delete;
+    CallClusterer(CallClusterer&&)                 = delete;
+    CallClusterer& operator=(CallClusterer&&)      = delete;
+
+    ~CallClusterer();
+
+    std::size_t num_features() const noexcept;
+    std::size_t num_rows() const noexcept;
+    std::size_t num_spilled_rows() const noexcept;
+
+    // values must have num_features() elements; NaN marks a missing value
+    void add_row(const std::vector<double>& values);
+
+    // Clusters all added rows and returns the number of rows in the majority and minority clusters.
+    // The feature matrix is released.
+    std::array<std::size_t, 2> cluster();
+
+    Label label(std::size_t row) const noexcept;
+
+    // The separation of the clusters found by the last call to cluster(), or 0 if none were found
+    double separation() const noexcept;
+
+private:
+    using Centroid = std::vector<double>;
+
+    // Running mean and sum of squared deviations (Welford), which unlike raw sums of squares does not
+    // lose the variance of features with large means to cancellation
+    struct FeatureSummary
+    {
+        std::size_t count = 0;
+        double mean = 0, m2 = 0;
+    };
+    // The features used for clustering, with the location and scale used to standardise them
+    struct Features
+    {
+        std::vector<std::size_t> indices;
+        std::vector<double> means, inverse_sds;
+    };
+    // Size and spread along the centroid axis of each cluster
+    struct ClusterSummary
+    {
+        std::size_t count = 0;
+        double squared_deviation = 0;
+    };
+
+    std::size_t num_features_;
+    Path spill_path_;
+    Options options_;
+    boost::optional<ThreadPool&> workers_;
+
+    std::size_t num_rows_;
+    std::vector<float> buffer_;
+    std::vector<FeatureSummary> summaries_;
+    std::ofstream spill_file_;
+    std::size_t num_spilled_rows_;
+    boost::iostreams::mapped_file_source spilled_;
+    std::vector<Label> labels_;
+    double separation_;
+
+    void spill();
+    const float* get_data();
+    Features get_active_features() const;
+    bool standardise(const float* data, std::size_t row, const Features& features, double* result) const noexcept;
+    std::array<Centroid, 2> initialise_centroids(const float* data, const Features& features) const;
+    std::array<Centroid, 2> find_centroids(const float* data, const Features& features) const;
+    std::array<ClusterSummary, 2> assign(const float* data, const Features& features, const std::array<Centroid, 2>& centroids);
+    template <typename F> void for_each_chunk(std::size_t num_rows, std::size_t chunk_size, F f) const;
+    void remove_spill_file();
+};
+
+} // namespace csr
+} // namespace octopus
+
+#endif
@@ -96,12 +96,26 @@ void DoublePassVariantCallFilter::record(const VcfRecord& call, const std::size_
 void DoublePassVariantCallFilter::record(const CallBlock& block, const std::size_t record_idx, const VcfHeader& dest_header,
                                          const SampleList& samples, OptionalVcfWriter& annotated_vcf) const
 {
-    record(block, measure(block), record_idx, dest_header, samples, annotated_vcf);
+    if (!annotated_vcf && can_record_columns()) {
+        record(block, measure_columns(block, samples.size()), record_idx, samples);
+    } else {
+        record(block, measure(block), record_idx, dest_header, samples, annotated_vcf);
+    }
 }
 
 void DoublePassVariantCallFilter::record(const std::vector<CallBlock>& blocks, std::size_t record_idx, const VcfHeader& dest_header,
                                          const SampleList& samples, OptionalVcfWriter& annotated_vcf) const
 {
+    if (!annotated_vcf && can_record_columns()) {
+        const auto columns = measure_columns(blocks, samples.size());
+        assert(columns.size() == blocks.size());
+        for (auto tup : boost::combine(blocks, columns)) {
+            const auto& block = tup.get<0>();
+            record(block, tup.get<1>(), record_idx, samples);
+            record_idx += block.size();
+        }
+        return;
+    }
     const auto measures = measure(blocks);
     assert(measures.size() == blocks.size());
     for (auto tup : boost::combine(blocks, measures)) {
@@ -134,6 +148,15 @@ void DoublePassVariantCallFilter::record(const CallBlock& block, const MeasureBl
     }
 }
 
+void DoublePassVariantCallFilter::record(const CallBlock& block, const MeasureColumns& columns, const std::size_t record_idx,
+                                         const SampleList& samples) const
+{
+    record_columns(record_idx, block.size(), samples.size(), columns);
+    for (const auto& call : block) {
+        log_progress(mapped_region(call));
+    }
+}
+
 void DoublePassVariantCallFilter::log_filter_pass_start(Log& log) const
 {
     log << "CSR: Starting filtering pass";
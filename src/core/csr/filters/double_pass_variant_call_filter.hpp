@@ -54,6 +54,11 @@ private:
     virtual void log_registration_pass(Log& log) const;
     virtual void prepare_for_registration(const SampleList& samples) const {};
     virtual void record(std::size_t call_idx, std::size_t sample_idx, MeasureVector measures) const = 0;
+    // Filters that can record a whole block of calls from measure columns, rather than a boxed
+    // MeasureVector per call and sample, should override these
+    virtual bool can_record_columns() const noexcept { return false; }
+    virtual void record_columns(std::size_t first_call_idx, std::size_t num_calls, std::size_t num_samples,
+                                const MeasureColumns& columns) const {};
     virtual void prepare_for_classification(boost::optional<Log>& log) const = 0;
     virtual void log_filter_pass_start(Log& log) const;
     virtual Classification classify(std::size_t call_idx, std::size_t sample_idx) const = 0;
@@ -71,6 +76,7 @@ private:
                 const SampleList& samples, OptionalVcfWriter& annotated_vcf) const;
     void record(const CallBlock& block, const MeasureBlock& measures, std::size_t record_idx, const VcfHeader& dest_header,
                 const SampleList& samples, OptionalVcfWriter& annotated_vcf) const;
+    void record(const CallBlock& block, const MeasureColumns& columns, std::size_t record_idx, const SampleList& samples) const;
     void make_filter_pass(const VcfReader& source, const SampleList& samples, VcfWriter& dest) const;
     std::vector<Classification> classify(std::size_t call_idx, const SampleList& samples) const;
     void filter(const VcfRecord& call, std::size_t idx, const SampleList& samples, VcfWriter& dest) const;
@@ -189,6 +189,11 @@ std::int8_t RandomForestFilter::choose_forest(const MeasureVector& measures) con
     return chooser_(chooser_measures);
 }
 
+bool RandomForestFilter::is_forest(const std::int8_t forest_idx) const noexcept
+{
+    return forest_idx >= 0 && static_cast<std::size_t>(forest_idx) < data_buffer_.size();
+}
+
 template <typename T>
 static void write_line(const std::vector<T>& data, std::ostream& out)
 {
@@ -266,6 +271,16 @@ auto cast_to_double(const Measure::ResultType& value)
     return vis.result;
 }
 
+double get_double(const MeasureColumn& column, const std::size_t row, const std::size_t col) noexcept
+{
+    if (column.is_missing(row, col)) return -1;
+    auto result = column.get(row, col);
+    if (maths::is_subnormal(result)) {
+        result = 0;
+    }
+    return result;
+}
+
 class NanMeasure : public ProgramError
 {
     std::string do_where() const override { return "RandomForestFilter"; }
@@ -291,14 +306,49 @@ void RandomForestFilter::record(const std::size_t call_idx, std::size_t sample_i
 {
     assert(!measures.empty());
     const auto forest_idx = choose_forest(measures);
-    const auto num_forests = static_cast<std::remove_const_t<decltype(forest_idx)>>(data_buffer_.size());
-    if (forest_idx >= 0 && forest_idx < num_forests) {
+    if (is_forest(forest_idx)) {
         auto& buffer = data_buffer_[forest_idx][sample_idx];
         const auto& info = forest_measure_info_[forest_idx];
         const auto first_measure = std::next(std::cbegin(measures), info.start_index);
         buffer.reserve(info.number);
         std::transform(first_measure, std::next(first_measure, info.number),
                        std::back_inserter(buffer), cast_to_double);
+    }
+    record(call_idx, sample_idx, forest_idx);
+}
+
+void RandomForestFilter::record_columns(const std::size_t first_call_idx, const std::size_t num_calls, const std::size_t num_samples,
+                                        const MeasureColumns& columns) const
+{
+    assert(columns.size() == measures_.size());
+    const auto first_chooser_measure = measures_.size() - num_chooser_measures_;
+    MeasureVector chooser_measures(num_chooser_measures_);
+    for (std::size_t row {0}; row < num_calls; ++row) {
+        for (std::size_t sample_idx {0}; sample_idx < num_samples; ++sample_idx) {
+            for (std::size_t i {0}; i < num_chooser_measures_; ++i) {
+                const auto measure_idx = first_chooser_measure + i;
+                const auto col = get_sample_column(measures_[measure_idx], sample_idx);
+                chooser_measures[i] = get_result(columns[measure_idx], row, col);
+            }
+            const auto forest_idx = chooser_(chooser_measures);
+            if (is_forest(forest_idx)) {
+                auto& buffer = data_buffer_[forest_idx][sample_idx];
+                const auto& info = forest_measure_info_[forest_idx];
+                buffer.reserve(info.number);
+                for (auto measure_idx = info.start_index; measure_idx < info.start_index + info.number; ++measure_idx) {
+                    const auto col = get_sample_column(measures_[measure_idx], sample_idx);
+                    buffer.push_back(get_double(columns[measure_idx], row, col));
+                }
+            }
+            record(first_call_idx + row, sample_idx, forest_idx);
+        }
+    }
+}
+
+void RandomForestFilter::record(const std::size_t call_idx, const std::size_t sample_idx, const std::int8_t forest_idx) const
+{
+    if (is_forest(forest_idx)) {
+        auto& buffer = data_buffer_[forest_idx][sample_idx];
         buffer.push_back(0); // dummy TP value
         check_nan(buffer);
         write_line(buffer, data_[forest_idx][sample_idx].handle);
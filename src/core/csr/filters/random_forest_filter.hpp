@@ -114,8 +114,13 @@ private:
     std::unique_ptr<ranger::Forest> make_forest() const;
     boost::optional<std::string> genotype_quality_name() const override;
     std::int8_t choose_forest(const MeasureVector& measures) const;
+    bool is_forest(std::int8_t forest_idx) const noexcept;
     void prepare_for_registration(const SampleList& samples) const override;
     void record(std::size_t call_idx, std::size_t sample_idx, MeasureVector measures) const override;
+    bool can_record_columns() const noexcept override { return true; }
+    void record_columns(std::size_t first_call_idx, std::size_t num_calls, std::size_t num_samples,
+                        const MeasureColumns& columns) const override;
+    void record(std::size_t call_idx, std::size_t sample_idx, std::int8_t forest_idx) const;
     void close_data_files() const;
     void prepare_for_classification(boost::optional<Log>& log) const override;
     std::size_t get_forest_choice(std::size_t call_idx, std::size_t sample_idx) const;
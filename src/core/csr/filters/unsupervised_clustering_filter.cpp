@@ -4,18 +4,30 @@
 #include "unsupervised_clustering_filter.hpp"
 
 #include <utility>
-#include <iterator>
-#include <algorithm>
-#include <numeric>
+#include <limits>
+#include <cassert>
+
+#include <boost/variant.hpp>
+#include <boost/any.hpp>
+#include <boost/filesystem/operations.hpp>
 
 namespace octopus { namespace csr {
 
+const std::string UnsupervisedClusteringFilter::filter_name_ {"CLU"};
+
 UnsupervisedClusteringFilter::UnsupervisedClusteringFilter(FacetFactory facet_factory,
                                                            std::vector<MeasureWrapper> measures,
                                                            OutputOptions output_config,
                                                            ConcurrencyPolicy threading,
+                                                           Path temp_directory,
+                                                           Options options,
                                                            boost::optional<ProgressMeter&> progress)
-: DoublePassVariantCallFilter {std::move(facet_factory), std::move(measures), std::move(output_config), threading, "/tmp", progress}
+: DoublePassVariantCallFilter {std::move(facet_factory), std::move(measures), std::move(output_config), threading,
+                               std::move(temp_directory), progress}
+, options_ {options}
+, num_samples_ {0}
+, clusterer_ {}
+, row_ {}
 {}
 
 std::string UnsupervisedClusteringFilter::do_name() const
@@ -25,76 +37,93 @@ std::string UnsupervisedClusteringFilter::do_name() const
 
 void UnsupervisedClusteringFilter::annotate(VcfHeader::Builder& header) const
 {
-    // TODO
+    header.add_filter(filter_name_, "Assigned to the minority cluster by unsupervised clustering");
 }
 
-void UnsupervisedClusteringFilter::record(const std::size_t call_idx, std::size_t sample_idx, MeasureVector measures) const
+void UnsupervisedClusteringFilter::prepare_for_registration(const SampleList& samples) const
 {
-    if (data_.size() == call_idx) {
-        data_.push_back(std::move(measures));
-    } else if (call_idx > data_.size()) {
-        data_.resize(call_idx + 1);
-        data_.back() = std::move(measures);
-    } else {
-        data_[call_idx] = std::move(measures);
-    }
+    num_samples_ = samples.size();
+    clusterer_.reset();
+    const auto spill_path = temp_directory() / boost::filesystem::unique_path("octopus_clustering_temp_%%%%-%%%%-%%%%.dat");
+    boost::optional<ThreadPool&> workers {};
+    if (is_multithreaded()) workers = thread_pool();
+    clusterer_ = std::make_unique<CallClusterer>(measures_.size(), spill_path, options_, workers);
+    row_.resize(measures_.size());
 }
 
-void UnsupervisedClusteringFilter::prepare_for_classification(boost::optional<Log>& log) const
+namespace {
+
+constexpr double missingValue {std::numeric_limits<double>::quiet_NaN()};
+
+struct FeatureVisitor : public boost::static_visitor<double>
 {
-    if (log) {
-        stream(*log) << "CSR: clustering " << data_.size() << " records";
-    }
-    remove_missing_features();
-    const auto num_calls = data_.size();
-    // TODO
-    data_.clear();
-    data_.shrink_to_fit();
-    classifications_.resize(num_calls);
-}
+    template <typename T>
+    double operator()(const T& value) const noexcept { return static_cast<double>(value); }
+    template <typename T>
+    double operator()(const boost::optional<T>& value) const noexcept { return value ? (*this)(*value) : missingValue; }
+    template <typename T>
+    double operator()(const std::vector<T>&) const noexcept { return missingValue; }
+    double operator()(const boost::any&) const noexcept { return missingValue; }
+};
 
-VariantCallFilter::Classification UnsupervisedClusteringFilter::classify(std::size_t call_idx, std::size_t sample_idx) const
+double get_feature(const Measure::ResultType& value) noexcept
 {
-    return classifications_[call_idx];
+    return boost::apply_visitor(FeatureVisitor {}, value);
 }
 
-bool UnsupervisedClusteringFilter::all_missing(const MeasureVector& measures) const noexcept
+} // namespace
+
+void UnsupervisedClusteringFilter::record(const std::size_t call_idx, const std::size_t sample_idx, MeasureVector measures) const
 {
-    return std::all_of(std::cbegin(measures), std::cend(measures),
-                       [] (const auto& measure) noexcept { return is_missing(measure); });
+    assert(call_idx * num_samples_ + sample_idx == clusterer_->num_rows());
+    assert(measures.size() == row_.size());
+    for (std::size_t i {0}; i < measures.size(); ++i) {
+        row_[i] = get_feature(measures[i]);
+    }
+    clusterer_->add_row(row_);
 }
 
-void UnsupervisedClusteringFilter::remove_missing_features() const
+void UnsupervisedClusteringFilter::record_columns(const std::size_t first_call_idx, const std::size_t num_calls, const std::size_t num_samples,
+                                                  const MeasureColumns& columns) const
 {
-    if (!data_.empty()) {
-        const auto num_dimensions = data_.front().size();
-        std::vector<std::size_t> missing_columns(num_dimensions);
-        std::iota(std::begin(missing_columns), std::end(missing_columns), 0);
-        for (const auto& point : data_) {
-            for (auto itr = std::cbegin(missing_columns); itr != std::cend(missing_columns);) {
-                assert(*itr < point.size());
-                if (is_missing(point[*itr])) {
-                    ++itr;
-                } else {
-                    itr = missing_columns.erase(itr);
-                }
+    assert(columns.size() == row_.size());
+    assert(first_call_idx * num_samples == clusterer_->num_rows());
+    for (std::size_t call_idx {0}; call_idx < num_calls; ++call_idx) {
+        for (std::size_t sample_idx {0}; sample_idx < num_samples; ++sample_idx) {
+            for (std::size_t i {0}; i < columns.size(); ++i) {
+                const auto col = get_sample_column(measures_[i], sample_idx);
+                row_[i] = columns[i].is_missing(call_idx, col) ? missingValue : columns[i].get(call_idx, col);
             }
-            if (missing_columns.empty()) break;
+            clusterer_->add_row(row_);
         }
-        if (!missing_columns.empty()) {
-            if (missing_columns.size() != num_dimensions) {
-                assert(std::is_sorted(std::cbegin(missing_columns), std::cend(missing_columns)));
-                for (auto& point : data_) {
-                    std::for_each(std::crbegin(missing_columns), std::crend(missing_columns),
-                                  [&point] (auto idx) { point.erase(std::next(std::cbegin(point), idx)); });
-        
-                }
-            } else {
-                data_.clear();
-                data_.shrink_to_fit();
-            }
+    }
+}
+
+void UnsupervisedClusteringFilter::prepare_for_classification(boost::optional<Log>& log) const
+{
+    if (log) {
+        stream(*log) << "CSR: clustering " << clusterer_->num_rows() << " sample calls";
+        if (clusterer_->num_spilled_rows() > 0) {
+            stream(*log) << "CSR: " << clusterer_->num_spilled_rows() << " sample calls spilled to the temp directory";
         }
     }
+    const auto counts = clusterer_->cluster();
+    if (log) {
+        stream(*log) << "CSR: clustered " << counts[0] << " passing and " << counts[1] << " filtered sample calls"
+                     << " (cluster separation " << clusterer_->separation() << ")";
+    }
+}
+
+VariantCallFilter::Classification UnsupervisedClusteringFilter::classify(const std::size_t call_idx, const std::size_t sample_idx) const
+{
+    Classification result {};
+    if (clusterer_->label(call_idx * num_samples_ + sample_idx) == CallClusterer::Label::minority) {
+        result.category = Classification::Category::soft_filtered;
+        result.reasons.push_back(filter_name_);
+    } else {
+        result.category = Classification::Category::unfiltered;
+    }
+    return result;
 }
 
 } // namespace csr
@@ -5,45 +5,60 @@
 #define unsupervised_clustering_filter_hpp
 
 #include <vector>
-#include <deque>
+#include <memory>
 #include <cstddef>
 
 #include <boost/optional.hpp>
 
 #include "double_pass_variant_call_filter.hpp"
+#include "call_clusterer.hpp"
 
 namespace octopus { namespace csr {
 
+/*
+ UnsupervisedClusteringFilter splits the sample calls into two clusters with a CallClusterer over the
+ filter measures, and soft filters the calls in the smaller cluster.
+ */
 class UnsupervisedClusteringFilter : public DoublePassVariantCallFilter
 {
 public:
+    using Options = CallClusterer::Options;
+
     UnsupervisedClusteringFilter() = delete;
-    
+
     UnsupervisedClusteringFilter(FacetFactory facet_factory,
                                  std::vector<MeasureWrapper> measures,
                                  OutputOptions output_config,
                                  ConcurrencyPolicy threading,
+                                 Path temp_directory,
+                                 Options options,
                                  boost::optional<ProgressMeter&> progress = boost::none);
-    
+
     UnsupervisedClusteringFilter(const UnsupervisedClusteringFilter&)            = delete;
     UnsupervisedClusteringFilter& operator=(const UnsupervisedClusteringFilter&) = delete;
     UnsupervisedClusteringFilter(UnsupervisedClusteringFilter&&)                 = delete;
     UnsupervisedClusteringFilter& operator=(UnsupervisedClusteringFilter&&)      = delete;
-    
+
     virtual ~UnsupervisedClusteringFilter() override = default;
-    
+
 private:
-    mutable std::deque<MeasureVector> data_;
-    mutable std::vector<Classification> classifications_;
-    
+    Options options_;
+
+    mutable std::size_t num_samples_;
+    mutable std::unique_ptr<CallClusterer> clusterer_;
+    mutable std::vector<double> row_;
+
+    const static std::string filter_name_;
+
     std::string do_name() const override;
     void annotate(VcfHeader::Builder& header) const override;
+    void prepare_for_registration(const SampleList& samples) const override;
     void record(std::size_t call_idx, std::size_t sample_idx, MeasureVector measures) const override;
+    bool can_record_columns() const noexcept override { return true; }
+    void record_columns(std::size_t first_call_idx, std::size_t num_calls, std::size_t num_samples,
+                        const MeasureColumns& columns) const override;
     void prepare_for_classification(boost::optional<Log>& log) const override;
     Classification classify(std::size_t call_idx, std::size_t sample_idx) const override;
-    
-    bool all_missing(const MeasureVector& measures) const noexcept;
-    void remove_missing_features() const;
 };
 
 } // namespace csr
@@ -22,8 +22,12 @@ std::vector<MeasureWrapper> parse_measures(const std::set<std::string>& measure_
 
 } // namespace
 
-UnsupervisedClusteringFilterFactory::UnsupervisedClusteringFilterFactory(const std::set<std::string>& measure_names)
+UnsupervisedClusteringFilterFactory::UnsupervisedClusteringFilterFactory(const std::set<std::string>& measure_names,
+                                                                         Path temp_directory,
+                                                                         Options options)
 : measures_ {parse_measures(measure_names)}
+, temp_directory_ {std::move(temp_directory)}
+, options_ {options}
 {}
 
 std::unique_ptr<VariantCallFilterFactory> UnsupervisedClusteringFilterFactory::do_clone() const
@@ -36,7 +40,8 @@ std::unique_ptr<VariantCallFilter> UnsupervisedClusteringFilterFactory::do_make(
                                                                                 boost::optional<ProgressMeter&> progress,
                                                                                 VariantCallFilter::ConcurrencyPolicy threading) const
 {
-    return std::make_unique<UnsupervisedClusteringFilter>(std::move(facet_factory), measures_, output_config, threading, progress);
+    return std::make_unique<UnsupervisedClusteringFilter>(std::move(facet_factory), measures_, output_config, threading,
+                                                          temp_directory_, options_, progress);
 }
 
 } // namespace csr
@@ -24,9 +24,14 @@ class FacetFactory;
 class UnsupervisedClusteringFilterFactory : public VariantCallFilterFactory
 {
 public:
+    using Path = UnsupervisedClusteringFilter::Path;
+    using Options = UnsupervisedClusteringFilter::Options;
+    
     UnsupervisedClusteringFilterFactory() = default;
     
-    UnsupervisedClusteringFilterFactory(const std::set<std::string>& measure_names);
+    UnsupervisedClusteringFilterFactory(const std::set<std::string>& measure_names,
+                                        Path temp_directory,
+                                        Options options = Options {});
     
     UnsupervisedClusteringFilterFactory(const UnsupervisedClusteringFilterFactory&)            = default;
     UnsupervisedClusteringFilterFactory& operator=(const UnsupervisedClusteringFilterFactory&) = default;
@@ -37,6 +42,8 @@ public:
 
 private:
     std::vector<MeasureWrapper> measures_;
+    Path temp_directory_;
+    Options options_;
     
     std::unique_ptr<VariantCallFilterFactory> do_clone() const override;
     std::unique_ptr<VariantCallFilter> do_make(FacetFactory facet_factory,
@@ -288,6 +288,31 @@ std::vector<VariantCallFilter::MeasureBlock> VariantCallFilter::measure(const st
     return result;
 }
 
+VariantCallFilter::MeasureColumns VariantCallFilter::measure_columns(const CallBlock& block, const std::size_t num_samples) const
+{
+    const auto facets = compute_facets(block);
+    return measure_columns(block, facets, num_samples);
+}
+
+std::vector<VariantCallFilter::MeasureColumns>
+VariantCallFilter::measure_columns(const std::vector<CallBlock>& blocks, const std::size_t num_samples) const
+{
+    std::vector<MeasureColumns> result {};
+    result.reserve(blocks.size());
+    if (is_multithreaded()) {
+        const auto facets = compute_facets(blocks);
+        transform(std::cbegin(blocks), std::cend(blocks), std::cbegin(facets), std::back_inserter(result),
+                  [this, num_samples] (const auto& block, const auto& block_facets) {
+                      return this->measure_columns(block, block_facets, num_samples);
+                  }, workers_);
+    } else {
+        for (const CallBlock& block : blocks) {
+            result.push_back(measure_columns(block, num_samples));
+        }
+    }
+    return result;
+}
+
 void VariantCallFilter::write(const VcfRecord& call, const Classification& classification, VcfWriter& dest) const
 {
     if (!is_hard_filtered(classification)) {
@@ -562,6 +587,29 @@ VariantCallFilter::MeasureVector VariantCallFilter::measure(const VcfRecord& cal
     return result;
 }
 
+VariantCallFilter::MeasureColumns
+VariantCallFilter::measure_columns(const CallBlock& block, const Measure::FacetMap& facets, const std::size_t num_samples) const
+{
+    if (debug_log_ && !block.empty()) {
+        stream(*debug_log_) << "Measuring block " << encompassing_region(block) << " containing " << block.size() << " calls";
+    }
+    MeasureColumns result(measures_.size());
+    for (std::size_t measure_idx {0}; measure_idx < measures_.size(); ++measure_idx) {
+        const auto& measure = measures_[measure_idx];
+        if (!duplicate_measures_.empty()) {
+            const auto first_itr = std::find(std::cbegin(measures_), std::next(std::cbegin(measures_), measure_idx), measure);
+            const auto first_idx = static_cast<std::size_t>(std::distance(std::cbegin(measures_), first_itr));
+            if (first_idx < measure_idx) {
+                result[measure_idx] = result[first_idx];
+                continue;
+            }
+        }
+        reset_column(measure, block.size(), num_samples, result[measure_idx]);
+        measure(block, facets, result[measure_idx]);
+    }
+    return result;
+}
+
 void VariantCallFilter::pass(const SampleName& sample, VcfRecord::Builder& call) const
 {
     call.set_passed(sample);
@@ -591,6 +639,11 @@ bool VariantCallFilter::is_multithreaded() const noexcept
     return !workers_.empty();
 }
 
+ThreadPool& VariantCallFilter::thread_pool() const noexcept
+{
+    return workers_;
+}
+
 unsigned VariantCallFilter::max_concurrent_blocks() const noexcept
 {
     if (is_multithreaded()) {
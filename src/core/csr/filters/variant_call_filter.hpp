@@ -75,6 +75,7 @@ protected:
     using VcfIterator   = VcfReader::RecordIterator;
     using CallBlock     = std::vector<VcfRecord>;
     using MeasureBlock  = std::vector<MeasureVector>;
+    using MeasureColumns = std::vector<MeasureColumn>;
     
     struct Classification
     {
@@ -97,6 +98,8 @@ protected:
     MeasureVector measure(const VcfRecord& call) const;
     MeasureBlock measure(const CallBlock& block) const;
     std::vector<MeasureBlock> measure(const std::vector<CallBlock>& blocks) const;
+    MeasureColumns measure_columns(const CallBlock& block, std::size_t num_samples) const;
+    std::vector<MeasureColumns> measure_columns(const std::vector<CallBlock>& blocks, std::size_t num_samples) const;
     void write(const VcfRecord& call, const Classification& classification, VcfWriter& dest) const;
     void write(const VcfRecord& call, const Classification& classification,
                const SampleList& samples, const ClassificationList& sample_classifications,
@@ -105,6 +108,8 @@ protected:
     void annotate(VcfRecord::Builder& call, const MeasureVector& measures, const VcfHeader& header) const;
     Phred<double> compute_joint_quality(const std::vector<Phred<double>>& qualities) const;
     std::vector<std::string> compute_reason_union(const ClassificationList& sample_classifications) const;
+    bool is_multithreaded() const noexcept;
+    ThreadPool& thread_pool() const noexcept;
     
 private:
     using FacetNameSet = std::vector<std::string>;
@@ -130,6 +135,7 @@ private:
     std::vector<Measure::FacetMap> compute_facets(const std::vector<CallBlock>& blocks) const;
     MeasureBlock measure(const CallBlock& block, const Measure::FacetMap& facets) const;
     MeasureVector measure(const VcfRecord& call, const Measure::FacetMap& facets) const;
+    MeasureColumns measure_columns(const CallBlock& block, const Measure::FacetMap& facets, std::size_t num_samples) const;
     VcfRecord::Builder construct_template(const VcfRecord& call) const;
     bool is_requested_annotation(const MeasureWrapper& measure) const noexcept;
     bool is_hard_filtered(const Classification& classification) const noexcept;
@@ -140,7 +146,6 @@ private:
     void pass(VcfRecord::Builder& call) const;
     void fail(const SampleName& sample, VcfRecord::Builder& call, std::vector<std::string> reasons) const;
     void fail(VcfRecord::Builder& call, std::vector<std::string> reasons) const;
-    bool is_multithreaded() const noexcept;
     unsigned max_concurrent_blocks() const noexcept;
 };
 
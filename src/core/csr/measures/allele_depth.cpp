@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <cstdint>
 
 #include <boost/variant.hpp>
 
@@ -70,6 +71,17 @@ auto min_support_count(const std::vector<Allele>& alleles, const AlleleSupportMa
     return *std::min_element(std::cbegin(counts), std::cend(counts));
 }
 
+boost::optional<int>
+evaluate_sample(const VcfRecord& call, const VcfRecord::SampleName& sample,
+                const Facet::AlleleMap& alleles, const AlleleSupportMap& support)
+{
+    if (is_evaluable(call, sample)) {
+        return min_support_count(get_alt(alleles, call, sample), support);
+    } else {
+        return boost::none;
+    }
+}
+
 } // namespace
 
 Measure::ResultType AlleleDepth::do_evaluate(const VcfRecord& call, const FacetMap& facets) const
@@ -80,15 +92,26 @@ Measure::ResultType AlleleDepth::do_evaluate(const VcfRecord& call, const FacetM
     std::vector<boost::optional<int>> result {};
     result.reserve(samples.size());
     for (const auto& sample : samples) {
-        boost::optional<int> sample_result {};
-        if (is_evaluable(call, sample)) {
-            sample_result = min_support_count(get_alt(alleles, call, sample), assignments.at(sample));
-        }
-        result.push_back(sample_result);
+        result.push_back(evaluate_sample(call, sample, alleles, assignments.at(sample)));
     }
     return result;
 }
 
+void AlleleDepth::do_evaluate_block(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const
+{
+    const FacetHandle<Samples> samples {facets, "Samples"};
+    const FacetHandle<Alleles> alleles {facets, "Alleles"};
+    const FacetHandle<ReadAssignments> assignments {facets, "ReadAssignments"};
+    for (std::size_t col {0}; col < samples->size(); ++col) {
+        const auto& sample = (*samples)[col];
+        const auto& support = assignments->alleles.at(sample);
+        for (std::size_t row {0}; row < calls.size(); ++row) {
+            const auto depth = evaluate_sample(calls[row], sample, *alleles, support);
+            if (depth) result.set(row, col, static_cast<std::int64_t>(*depth));
+        }
+    }
+}
+
 Measure::ResultCardinality AlleleDepth::do_cardinality() const noexcept
 {
     return ResultCardinality::samples;
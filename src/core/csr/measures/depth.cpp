@@ -3,6 +3,8 @@
 
 #include "depth.hpp"
 
+#include <cstdint>
+
 #include <boost/variant.hpp>
 
 #include "io/variant/vcf_record.hpp"
@@ -58,6 +60,42 @@ Measure::ResultType Depth::do_evaluate(const VcfRecord& call, const FacetMap& fa
     }
 }
 
+void Depth::do_evaluate_block(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const
+{
+    if (aggregate_) {
+        if (recalculate_) {
+            const FacetHandle<OverlappingReads> reads {facets, "OverlappingReads"};
+            for (std::size_t row {0}; row < calls.size(); ++row) {
+                result.set(row, 0, static_cast<std::int64_t>(count_overlapped(*reads, calls[row])));
+            }
+        } else {
+            for (std::size_t row {0}; row < calls.size(); ++row) {
+                const auto depth = calls[row].info_number(vcfspec::info::combinedReadDepth);
+                if (depth) result.set(row, 0, static_cast<std::int64_t>(*depth));
+            }
+        }
+    } else {
+        const FacetHandle<Samples> samples {facets, "Samples"};
+        if (recalculate_) {
+            const FacetHandle<OverlappingReads> reads {facets, "OverlappingReads"};
+            for (std::size_t col {0}; col < samples->size(); ++col) {
+                const auto& sample_reads = reads->at((*samples)[col]);
+                for (std::size_t row {0}; row < calls.size(); ++row) {
+                    result.set(row, col, static_cast<std::int64_t>(count_overlapped(sample_reads, calls[row])));
+                }
+            }
+        } else {
+            for (std::size_t col {0}; col < samples->size(); ++col) {
+                const auto& sample = (*samples)[col];
+                for (std::size_t row {0}; row < calls.size(); ++row) {
+                    const auto depth = calls[row].sample_number(sample, vcfspec::format::combinedReadDepth);
+                    if (depth) result.set(row, col, static_cast<std::int64_t>(*depth));
+                }
+            }
+        }
+    }
+}
+
 Measure::ResultCardinality Depth::do_cardinality() const noexcept
 {
     if (aggregate_) {
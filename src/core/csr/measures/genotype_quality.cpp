@@ -34,13 +34,24 @@ Measure::ResultType GenotypeQuality::do_evaluate(const VcfRecord& call, const Fa
     result.reserve(samples.size());
     for (const auto& sample : samples) {
         static const std::string gq_field {vcfspec::format::conditionalQuality};
-        boost::optional<double> sample_gq {};
+        result.push_back(call.sample_number(sample, gq_field));
+    }
+    return result;
+}
+
+void GenotypeQuality::do_evaluate_block(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const
+{
+    static const std::string gq_field {vcfspec::format::conditionalQuality};
+    const FacetHandle<Samples> samples {facets, "Samples"};
+    for (std::size_t row {0}; row < calls.size(); ++row) {
+        const auto& call = calls[row];
         if (call.has_format(gq_field)) {
-            sample_gq = std::stod(call.get_sample_value(sample, gq_field).front());
+            for (std::size_t col {0}; col < samples->size(); ++col) {
+                const auto gq = call.sample_number((*samples)[col], gq_field);
+                if (gq) result.set(row, col, *gq);
+            }
         }
-        result.push_back(sample_gq);
     }
-    return result;
 }
 
 Measure::ResultCardinality GenotypeQuality::do_cardinality() const noexcept
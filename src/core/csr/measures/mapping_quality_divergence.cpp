@@ -8,6 +8,7 @@
 #include <cmath>
 #include <limits>
 #include <numeric>
+#include <cstdint>
 
 #include <boost/optional.hpp>
 #include <boost/variant.hpp>
@@ -140,6 +141,24 @@ auto max_pairwise_median_mapping_quality_difference(const std::vector<MappingQua
 
 } // namespace
 
+namespace {
+
+boost::optional<int>
+evaluate_sample(const VcfRecord& call, const VcfRecord::SampleName& sample,
+                const Facet::AlleleMap& alleles, const AlleleSupportMap& support)
+{
+    boost::optional<int> result {};
+    if (call.is_heterozygous(sample)) {
+        const auto mapping_qualities = extract_mapping_qualities(get_all(alleles, call, sample), support);
+        if (!mapping_qualities.empty()) {
+            result = max_pairwise_median_mapping_quality_difference(mapping_qualities);
+        }
+    }
+    return result;
+}
+
+} // namespace
+
 Measure::ResultType MappingQualityDivergence::do_evaluate(const VcfRecord& call, const FacetMap& facets) const
 {
     const auto& samples = get_value<Samples>(facets.at("Samples"));
@@ -148,18 +167,26 @@ Measure::ResultType MappingQualityDivergence::do_evaluate(const VcfRecord& call,
     std::vector<boost::optional<int>> result {};
     result.reserve(samples.size());
     for (const auto& sample : samples) {
-        boost::optional<int> sample_result {};
-        if (call.is_heterozygous(sample)) {
-            const auto mapping_qualities = extract_mapping_qualities(get_all(alleles, call, sample), assignments.at(sample));
-            if (!mapping_qualities.empty()) {
-                sample_result = max_pairwise_median_mapping_quality_difference(mapping_qualities);
-            }
-        }
-        result.push_back(sample_result);
+        result.push_back(evaluate_sample(call, sample, alleles, assignments.at(sample)));
     }
     return result;
 }
 
+void MappingQualityDivergence::do_evaluate_block(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const
+{
+    const FacetHandle<Samples> samples {facets, "Samples"};
+    const FacetHandle<Alleles> alleles {facets, "Alleles"};
+    const FacetHandle<ReadAssignments> assignments {facets, "ReadAssignments"};
+    for (std::size_t col {0}; col < samples->size(); ++col) {
+        const auto& sample = (*samples)[col];
+        const auto& support = assignments->alleles.at(sample);
+        for (std::size_t row {0}; row < calls.size(); ++row) {
+            const auto divergence = evaluate_sample(calls[row], sample, *alleles, support);
+            if (divergence) result.set(row, col, static_cast<std::int64_t>(*divergence));
+        }
+    }
+}
+
 Measure::ResultCardinality MappingQualityDivergence::do_cardinality() const noexcept
 {
     return ResultCardinality::samples;
@@ -21,6 +21,7 @@ class MappingQualityDivergence : public Measure
     std::unique_ptr<Measure> do_clone() const override;
     ResultType get_default_result() const override;
     ResultType do_evaluate(const VcfRecord& call, const FacetMap& facets) const override;
+    void do_evaluate_block(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const override;
     ResultCardinality do_cardinality() const noexcept override;
     const std::string& do_name() const override;
     std::string do_describe() const override;
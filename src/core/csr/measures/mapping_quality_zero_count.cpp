@@ -3,6 +3,8 @@
 
 #include "mapping_quality_zero_count.hpp"
 
+#include <cstdint>
+
 #include <boost/variant.hpp>
 
 #include "io/variant/vcf_record.hpp"
@@ -35,6 +37,21 @@ Measure::ResultType MappingQualityZeroCount::do_evaluate(const VcfRecord& call,
     }
 }
 
+void MappingQualityZeroCount::do_evaluate_block(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const
+{
+    if (recalculate_) {
+        const FacetHandle<OverlappingReads> reads {facets, "OverlappingReads"};
+        for (std::size_t row {0}; row < calls.size(); ++row) {
+            result.set(row, 0, static_cast<std::int64_t>(count_mapq_zero(*reads, mapped_region(calls[row]))));
+        }
+    } else {
+        for (std::size_t row {0}; row < calls.size(); ++row) {
+            const auto mq0 = calls[row].info_number("MQ0");
+            if (mq0) result.set(row, 0, static_cast<std::int64_t>(*mq0));
+        }
+    }
+}
+
 Measure::ResultCardinality MappingQualityZeroCount::do_cardinality() const noexcept
 {
     return ResultCardinality::one;
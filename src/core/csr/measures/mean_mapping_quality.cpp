@@ -39,6 +39,22 @@ Measure::ResultType MeanMappingQuality::do_evaluate(const VcfRecord& call, const
     }
 }
 
+void MeanMappingQuality::do_evaluate_block(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const
+{
+    if (recalculate_) {
+        const FacetHandle<OverlappingReads> reads {facets, "OverlappingReads"};
+        assert(!reads->empty());
+        for (std::size_t row {0}; row < calls.size(); ++row) {
+            result.set(row, 0, rmq_mapping_quality(*reads, mapped_region(calls[row])));
+        }
+    } else {
+        for (std::size_t row {0}; row < calls.size(); ++row) {
+            const auto mq = calls[row].info_number(vcfspec::info::rmsMappingQuality);
+            if (mq) result.set(row, 0, *mq);
+        }
+    }
+}
+
 Measure::ResultCardinality MeanMappingQuality::do_cardinality() const noexcept
 {
     return ResultCardinality::one;
@@ -10,6 +10,7 @@
 #include <algorithm>
 #include <cassert>
 #include <type_traits>
+#include <stdexcept>
 
 #include <boost/lexical_cast.hpp>
 
@@ -113,6 +114,82 @@ void Measure::annotate(VcfHeader::Builder& header) const
     }
 }
 
+struct MeasureColumnTypeVisitor : boost::static_visitor<MeasureColumn::Type>
+{
+    auto operator()(bool) const { return MeasureColumn::Type::flag; }
+    template <typename T, std::enable_if_t<std::is_integral<T>::value, int> = 0>
+    auto operator()(T) const { return MeasureColumn::Type::integer; }
+    template <typename T, std::enable_if_t<std::is_floating_point<T>::value, int> = 0>
+    auto operator()(T) const { return MeasureColumn::Type::real; }
+    template <typename T> auto operator()(boost::optional<T>) const { return (*this)(T{}); }
+    template <typename T> auto operator()(std::vector<T>) const { return (*this)(T{}); }
+    auto operator()(boost::any) const { return MeasureColumn::Type::real; }
+};
+
+MeasureColumn::Type Measure::column_type() const
+{
+    return boost::apply_visitor(MeasureColumnTypeVisitor {}, this->get_default_result());
+}
+
+namespace {
+
+struct MeasureColumnWriterVisitor : boost::static_visitor<>
+{
+    MeasureColumnWriterVisitor(MeasureColumn& column, std::size_t row, bool is_sample_vector)
+    : column_ {column}, row_ {row}, is_sample_vector_ {is_sample_vector} {}
+    template <typename T> void operator()(const T& value) const
+    {
+        for (std::size_t col {0}; col < column_.num_columns(); ++col) set(col, value);
+    }
+    template <typename T> void operator()(const boost::optional<T>& value) const
+    {
+        if (value) (*this)(*value);
+    }
+    // Only per-sample vectors have a column layout; other non-scalar results cannot be unboxed
+    template <typename T> void operator()(const std::vector<T>& values) const
+    {
+        if (!is_sample_vector_) throw std::runtime_error {"Vector cast not supported"};
+        const auto num_values = std::min(values.size(), column_.num_columns());
+        for (std::size_t col {0}; col < num_values; ++col) set(col, values[col]);
+    }
+    template <typename T> void operator()(const boost::optional<std::vector<T>>& values) const
+    {
+        if (values) (*this)(*values);
+    }
+    void operator()(const boost::any&) const
+    {
+        throw std::runtime_error {"Any cast not supported"};
+    }
+private:
+    MeasureColumn& column_;
+    std::size_t row_;
+    bool is_sample_vector_;
+    
+    template <typename T> void set(std::size_t col, const T& value) const
+    {
+        if (column_.type() == MeasureColumn::Type::real) {
+            column_.set(row_, col, static_cast<double>(value));
+        } else {
+            column_.set(row_, col, static_cast<std::int64_t>(value));
+        }
+    }
+    template <typename T> void set(std::size_t col, const boost::optional<T>& value) const
+    {
+        if (value) set(col, *value);
+    }
+};
+
+} // namespace
+
+void Measure::do_evaluate_block(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const
+{
+    assert(result.num_rows() == calls.size());
+    const bool is_sample_vector {this->cardinality() == ResultCardinality::samples};
+    for (std::size_t row {0}; row < calls.size(); ++row) {
+        boost::apply_visitor(MeasureColumnWriterVisitor {result, row, is_sample_vector}, this->evaluate(calls[row], facets));
+    }
+}
+
 struct VectorIndexGetterVisitor : public boost::static_visitor<Measure::ResultType>
 {
     VectorIndexGetterVisitor(std::size_t idx) : idx_ {idx} {}
@@ -174,6 +251,40 @@ bool is_missing(const Measure::ResultType& value) noexcept
     return boost::apply_visitor(IsMissingMeasureVisitor {}, value);
 }
 
+MeasureColumn make_column(const MeasureWrapper& measure, const std::size_t num_calls, const std::size_t num_samples)
+{
+    MeasureColumn result {};
+    reset_column(measure, num_calls, num_samples, result);
+    return result;
+}
+
+void reset_column(const MeasureWrapper& measure, const std::size_t num_calls, const std::size_t num_samples, MeasureColumn& column)
+{
+    const auto num_columns = measure.cardinality() == Measure::ResultCardinality::samples ? num_samples : 1;
+    column.reset(measure.column_type(), num_calls, num_columns);
+}
+
+std::size_t get_sample_column(const MeasureWrapper& measure, const std::size_t sample_idx) noexcept
+{
+    return measure.cardinality() == Measure::ResultCardinality::samples ? sample_idx : 0;
+}
+
+Measure::ResultType get_result(const MeasureColumn& column, const std::size_t row, const std::size_t col)
+{
+    switch (column.type()) {
+        case MeasureColumn::Type::flag:
+            if (column.is_missing(row, col)) return boost::optional<int> {};
+            return column.integer(row, col) != 0;
+        case MeasureColumn::Type::integer:
+            if (column.is_missing(row, col)) return boost::optional<int> {};
+            return static_cast<int>(column.integer(row, col));
+        case MeasureColumn::Type::real:
+        default:
+            if (column.is_missing(row, col)) return boost::optional<double> {};
+            return column.real(row, col);
+    }
+}
+
 std::vector<std::string> get_all_requirements(const std::vector<MeasureWrapper>& measures)
 {
     std::vector<std::string> result {};
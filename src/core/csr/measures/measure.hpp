@@ -19,6 +19,7 @@
 #include "io/variant/vcf_record.hpp"
 #include "exceptions/user_error.hpp"
 #include "../facets/facet.hpp"
+#include "measure_column.hpp"
 
 namespace octopus { namespace csr {
 
@@ -35,6 +36,7 @@ public:
                                       bool,
                                       std::vector<bool>,
                                       boost::any>;
+    using CallBlock = std::vector<VcfRecord>;
     enum class ResultCardinality { one, alleles, samples };
     
     Measure() = default;
@@ -51,6 +53,10 @@ public:
     void set_parameters(std::vector<std::string> params) { do_set_parameters(std::move(params)); }
     std::vector<std::string> parameters() const { return do_parameters(); }
     ResultType evaluate(const VcfRecord& call, const FacetMap& facets) const { return do_evaluate(call, facets); }
+    // Writes the values for each call in calls into a row of result, which must be shaped with
+    // calls.size() rows and one column, or a column per sample for measures with sample cardinality
+    void evaluate(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const { do_evaluate_block(calls, facets, result); }
+    MeasureColumn::Type column_type() const;
     ResultCardinality cardinality() const noexcept { return do_cardinality(); }
     const std::string& name() const { return do_name(); }
     std::string describe() const { return do_describe(); }
@@ -69,6 +75,7 @@ private:
     virtual std::vector<std::string> do_parameters() const { return {}; }
     virtual ResultType get_default_result() const { return boost::any {}; };
     virtual ResultType do_evaluate(const VcfRecord& call, const FacetMap& facets) const = 0;
+    virtual void do_evaluate_block(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const;
     virtual ResultCardinality do_cardinality() const noexcept = 0;
     virtual const std::string& do_name() const = 0;
     virtual std::string do_describe() const = 0;
@@ -102,6 +109,8 @@ public:
     std::vector<std::string> parameters() const { return measure_->parameters(); }
     auto operator()(const VcfRecord& call) const { return measure_->evaluate(call, {}); }
     auto operator()(const VcfRecord& call, const Measure::FacetMap& facets) const { return measure_->evaluate(call, facets); }
+    void operator()(const Measure::CallBlock& calls, const Measure::FacetMap& facets, MeasureColumn& result) const { measure_->evaluate(calls, facets, result); }
+    MeasureColumn::Type column_type() const { return measure_->column_type(); }
     Measure::ResultCardinality cardinality() const noexcept { return measure_->cardinality(); }
     const std::string& name() const { return measure_->name(); }
     std::string describe() const { return measure_->describe(); }
@@ -164,6 +173,14 @@ std::string long_name(const MeasureWrapper& measure);
 
 bool is_missing(const Measure::ResultType& value) noexcept;
 
+// A column shaped for evaluating measure on num_calls calls of num_samples samples
+MeasureColumn make_column(const MeasureWrapper& measure, std::size_t num_calls, std::size_t num_samples);
+void reset_column(const MeasureWrapper& measure, std::size_t num_calls, std::size_t num_samples, MeasureColumn& column);
+// The column of a measure's MeasureColumn holding the value of sample_idx
+std::size_t get_sample_column(const MeasureWrapper& measure, std::size_t sample_idx) noexcept;
+// A column entry as a ResultType: flags as bool, integers as int, reals as double, and missing values as empty optionals
+Measure::ResultType get_result(const MeasureColumn& column, std::size_t row, std::size_t col);
+
 std::vector<std::string> get_all_requirements(const std::vector<MeasureWrapper>& measures);
 
 Measure::ResultType get_sample_value(const Measure::ResultType& value, const MeasureWrapper& measure, std::size_t sample_idx);
@@ -0,0 +1,30 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "measure_column.hpp"
+
+namespace octopus { namespace csr {
+
+MeasureColumn::MeasureColumn(Type type, std::size_t num_rows, std::size_t num_columns)
+{
+    reset(type, num_rows, num_columns);
+}
+
+void MeasureColumn::reset(Type type, std::size_t num_rows, std::size_t num_columns)
+{
+    type_ = type;
+    num_rows_ = num_rows;
+    num_columns_ = num_columns;
+    const auto size = num_rows * num_columns;
+    if (type == Type::real) {
+        reals_.resize(size);
+        integers_.clear();
+    } else {
+        integers_.resize(size);
+        reals_.clear();
+    }
+    missing_.assign(size, true);
+}
+
+} // namespace csr
+} // namespace octopus
@@ -0,0 +1,87 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef measure_column_hpp
+#define measure_column_hpp
+
+#include <vector>
+#include <cstddef>
+#include <cstdint>
+#include <cassert>
+
+namespace octopus { namespace csr {
+
+/*
+ MeasureColumn holds the values of one measure for a block of calls, with one row per call and one
+ column per sample (or a single column for measures with a single value per call). Values are stored
+ unboxed as either reals or integers (including flags), with a mask for missing values.
+ */
+class MeasureColumn
+{
+public:
+    enum class Type { real, integer, flag };
+
+    MeasureColumn() = default;
+
+    MeasureColumn(Type type, std::size_t num_rows, std::size_t num_columns);
+
+    MeasureColumn(const MeasureColumn&)            = default;
+    MeasureColumn& operator=(const MeasureColumn&) = default;
+    MeasureColumn(MeasureColumn&&)                 = default;
+    MeasureColumn& operator=(MeasureColumn&&)      = default;
+
+    ~MeasureColumn() = default;
+
+    // Resizes the column, keeping allocated storage, and marks every value missing
+    void reset(Type type, std::size_t num_rows, std::size_t num_columns);
+
+    Type type() const noexcept { return type_; }
+    std::size_t num_rows() const noexcept { return num_rows_; }
+    std::size_t num_columns() const noexcept { return num_columns_; }
+
+    bool is_missing(std::size_t row, std::size_t column) const noexcept { return missing_[index(row, column)]; }
+    void set_missing(std::size_t row, std::size_t column) noexcept { missing_[index(row, column)] = true; }
+
+    void set(std::size_t row, std::size_t column, double value) noexcept
+    {
+        assert(type_ == Type::real);
+        const auto idx = index(row, column);
+        reals_[idx] = value;
+        missing_[idx] = false;
+    }
+    void set(std::size_t row, std::size_t column, std::int64_t value) noexcept
+    {
+        assert(type_ != Type::real);
+        const auto idx = index(row, column);
+        integers_[idx] = value;
+        missing_[idx] = false;
+    }
+
+    double real(std::size_t row, std::size_t column) const noexcept { return reals_[index(row, column)]; }
+    std::int64_t integer(std::size_t row, std::size_t column) const noexcept { return integers_[index(row, column)]; }
+
+    // The value as a double, whatever the column type. Undefined if the value is missing.
+    double get(std::size_t row, std::size_t column) const noexcept
+    {
+        const auto idx = index(row, column);
+        return type_ == Type::real ? reals_[idx] : static_cast<double>(integers_[idx]);
+    }
+
+private:
+    Type type_ = Type::real;
+    std::size_t num_rows_ = 0, num_columns_ = 0;
+    std::vector<double> reals_;
+    std::vector<std::int64_t> integers_;
+    std::vector<bool> missing_;
+
+    std::size_t index(std::size_t row, std::size_t column) const noexcept
+    {
+        assert(row < num_rows_ && column < num_columns_);
+        return row * num_columns_ + column;
+    }
+};
+
+} // namespace csr
+} // namespace octopus
+
+#endif
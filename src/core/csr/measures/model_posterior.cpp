@@ -23,11 +23,7 @@ Measure::ResultType ModelPosterior::get_default_result() const
 Measure::ResultType ModelPosterior::do_evaluate(const VcfRecord& call, const FacetMap& facets) const
 {
     namespace ovcf = octopus::vcf::spec;
-    boost::optional<double> result {};
-    if (!is_info_missing(ovcf::info::modelPosterior, call)) {
-        result = std::stod(call.info_value(ovcf::info::modelPosterior).front());
-    }
-    return result;
+    return call.info_number(ovcf::info::modelPosterior);
 }
 
 Measure::ResultCardinality ModelPosterior::do_cardinality() const noexcept
@@ -7,6 +7,8 @@
 #include <iterator>
 #include <random>
 #include <functional>
+#include <map>
+#include <tuple>
 #include <cmath>
 #include <cassert>
 
@@ -92,6 +94,11 @@ struct DirectionCounts
     unsigned forward, reverse;
 };
 
+bool operator<(const DirectionCounts& lhs, const DirectionCounts& rhs) noexcept
+{
+    return std::tie(lhs.forward, lhs.reverse) < std::tie(rhs.forward, rhs.reverse);
+}
+
 template <typename Container>
 DirectionCounts count_directions(const Container& reads, const GenomicRegion& call_region)
 {
@@ -178,6 +185,29 @@ double calculate_max_prob_different(const DirectionCountVector& direction_counts
 
 } // namespace
 
+template <typename DirectionCountVector>
+double StrandBias::calculate_bias(const DirectionCountVector& direction_counts) const
+{
+    double result;
+    if (use_resampling_) {
+        result = calculate_max_prob_different(direction_counts, small_sample_size_, min_difference_);
+        if (result >= min_big_trigger_) {
+            result = calculate_max_prob_different(direction_counts, big_sample_size_, min_difference_);
+        } else if (result >= min_medium_trigger_) {
+            result = calculate_max_prob_different(direction_counts, medium_sample_size_, min_difference_);
+            if (result >= min_big_trigger_) {
+                result = calculate_max_prob_different(direction_counts, big_sample_size_, min_difference_);
+            }
+        }
+        if (result > critical_resample_lb_ && result < critical_resample_ub_) {
+            result = calculate_max_prob_different(direction_counts, very_big_sample_size, min_difference_);
+        }
+    } else {
+        result = calculate_max_prob_different(direction_counts, big_sample_size_, min_difference_);
+    }
+    return result;
+}
+
 Measure::ResultType StrandBias::do_evaluate(const VcfRecord& call, const FacetMap& facets) const
 {
     const auto& samples = get_value<Samples>(facets.at("Samples"));
@@ -189,30 +219,38 @@ Measure::ResultType StrandBias::do_evaluate(const VcfRecord& call, const FacetMa
         boost::optional<double> sample_result {};
         if (is_evaluable(call, sample)) {
             const auto direction_counts = get_direction_counts(get_all(alleles, call, sample), assignments.at(sample), mapped_region(call));
-            double prob;
-            if (use_resampling_) {
-                prob = calculate_max_prob_different(direction_counts, small_sample_size_, min_difference_);
-                if (prob >= min_big_trigger_) {
-                    prob = calculate_max_prob_different(direction_counts, big_sample_size_, min_difference_);
-                } else if (prob >= min_medium_trigger_) {
-                    prob = calculate_max_prob_different(direction_counts, medium_sample_size_, min_difference_);
-                    if (prob >= min_big_trigger_) {
-                        prob = calculate_max_prob_different(direction_counts, big_sample_size_, min_difference_);
-                    }
-                }
-                if (prob > critical_resample_lb_ && prob < critical_resample_ub_) {
-                    prob = calculate_max_prob_different(direction_counts, very_big_sample_size, min_difference_);
-                }
-            } else {
-                prob = calculate_max_prob_different(direction_counts, big_sample_size_, min_difference_);
-            }
-            sample_result = prob;
+            sample_result = calculate_bias(direction_counts);
         }
         result.push_back(sample_result);
     }
     return result;
 }
 
+void StrandBias::do_evaluate_block(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const
+{
+    const FacetHandle<Samples> samples {facets, "Samples"};
+    const FacetHandle<Alleles> alleles {facets, "Alleles"};
+    const FacetHandle<ReadAssignments> assignments {facets, "ReadAssignments"};
+    // The resampling is seeded by the counts, so calls in the block with the same counts have the same bias
+    std::map<DirectionCountVector, double> biases {};
+    for (std::size_t col {0}; col < samples->size(); ++col) {
+        const auto& sample = (*samples)[col];
+        const auto& support = assignments->alleles.at(sample);
+        for (std::size_t row {0}; row < calls.size(); ++row) {
+            const auto& call = calls[row];
+            if (is_evaluable(call, sample)) {
+                auto direction_counts = get_direction_counts(get_all(*alleles, call, sample), support, mapped_region(call));
+                auto bias_itr = biases.find(direction_counts);
+                if (bias_itr == std::cend(biases)) {
+                    const auto bias = calculate_bias(direction_counts);
+                    bias_itr = biases.emplace(std::move(direction_counts), bias).first;
+                }
+                result.set(row, col, bias_itr->second);
+            }
+        }
+    }
+}
+
 Measure::ResultCardinality StrandBias::do_cardinality() const noexcept
 {
     return ResultCardinality::samples;
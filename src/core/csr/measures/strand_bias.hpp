@@ -23,6 +23,7 @@ class StrandBias : public Measure
     void do_set_parameters(std::vector<std::string> params) override;
     std::vector<std::string> do_parameters() const override;
     ResultType do_evaluate(const VcfRecord& call, const FacetMap& facets) const override;
+    void do_evaluate_block(const CallBlock& calls, const FacetMap& facets, MeasureColumn& result) const override;
     ResultCardinality do_cardinality() const noexcept override;
     const std::string& do_name() const override;
     std::string do_describe() const override;
@@ -36,6 +37,9 @@ class StrandBias : public Measure
     double critical_resample_lb_, critical_resample_ub_;
     bool use_resampling_ = false;
     
+    template <typename DirectionCountVector>
+    double calculate_bias(const DirectionCountVector& direction_counts) const;
+    
 public:
     StrandBias() = default;
     StrandBias(double critical_value);
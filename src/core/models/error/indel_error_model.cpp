@@ -22,4 +22,9 @@ void IndelErrorModel::set_penalties(const Haplotype& haplotype, PenaltyVector& g
     do_set_penalties(haplotype, gap_open_penalities, gap_extend_penalties);
 }
 
+void IndelErrorModel::clear() noexcept
+{
+    do_clear();
+}
+
 } // namespace octopus
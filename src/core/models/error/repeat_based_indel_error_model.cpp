@@ -12,6 +12,8 @@ namespace octopus {
 
 namespace {
 
+constexpr std::size_t maxRepeatCacheSize {2048};
+
 auto extract_repeats(const Haplotype& haplotype)
 {
     return tandem::extract_exact_tandem_repeats(haplotype.sequence(), 1, 5);
@@ -42,10 +44,27 @@ auto fill_n_if_less(FordwardIt first, std::size_t n, const Tp& value)
 
 } // namespace
 
+const RepeatBasedIndelErrorModel::RepeatVector& RepeatBasedIndelErrorModel::get_repeats(const Haplotype& haplotype) const
+{
+    const auto cache_itr = repeat_cache_.find(haplotype);
+    if (cache_itr != std::cend(repeat_cache_)) return cache_itr->second;
+    if (repeat_cache_.size() >= maxRepeatCacheSize || (cached_region_ && !is_same_region(*cached_region_, haplotype))) {
+        repeat_cache_.clear();
+    }
+    cached_region_ = mapped_region(haplotype);
+    return repeat_cache_.emplace(haplotype, extract_repeats(haplotype)).first->second;
+}
+
+void RepeatBasedIndelErrorModel::do_clear() noexcept
+{
+    cached_region_ = boost::none;
+    repeat_cache_.clear();
+}
+
 void RepeatBasedIndelErrorModel::do_set_penalties(const Haplotype& haplotype, PenaltyVector& gap_open_penalities, PenaltyType& gap_extend_penalty) const
 {
     gap_open_penalities.assign(sequence_size(haplotype), get_default_open_penalty());
-    const auto repeats = extract_repeats(haplotype);
+    const auto& repeats = get_repeats(haplotype);
     if (!repeats.empty()) {
         tandem::Repeat max_repeat {};
         Sequence motif(3, 'N');
@@ -68,7 +87,7 @@ void RepeatBasedIndelErrorModel::do_set_penalties(const Haplotype& haplotype, Pe
 {
     gap_open_penalities.assign(sequence_size(haplotype), get_default_open_penalty());
     gap_extend_penalties.assign(sequence_size(haplotype), get_default_extension_penalty());
-    auto repeats = extract_repeats(haplotype);
+    auto repeats = get_repeats(haplotype);
     if (!repeats.empty()) {
         sort_by_length(repeats);
         Sequence motif(3, 'N');
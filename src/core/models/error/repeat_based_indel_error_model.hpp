@@ -4,8 +4,16 @@
 #ifndef repeat_based_indel_error_model_hpp
 #define repeat_based_indel_error_model_hpp
 
+#include <vector>
+#include <unordered_map>
+
+#include <boost/optional.hpp>
+
+#include "tandem/tandem.hpp"
+
 #include "indel_error_model.hpp"
 
+#include "basics/genomic_region.hpp"
 #include "core/types/haplotype.hpp"
 
 namespace octopus {
@@ -29,6 +37,15 @@ protected:
     using Sequence = Haplotype::NucleotideSequence;
     
 private:
+    using RepeatVector = std::vector<tandem::Repeat>;
+    
+    // Repeats of haplotypes in the last region seen, so both set_penalties overloads share them
+    mutable boost::optional<GenomicRegion> cached_region_;
+    mutable std::unordered_map<Haplotype, RepeatVector> repeat_cache_;
+    
+    const RepeatVector& get_repeats(const Haplotype& haplotype) const;
+    
+    void do_clear() noexcept override;
     void do_set_penalties(const Haplotype& haplotype, PenaltyVector& gap_open_penalties, PenaltyType& gap_extend_penalty) const override;
     void do_set_penalties(const Haplotype& haplotype, PenaltyVector& gap_open_penalties, PenaltyVector& gap_extend_penalties) const override;
     
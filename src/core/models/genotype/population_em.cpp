@@ -0,0 +1,262 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "population_em.hpp"
+
+#include <algorithm>
+#include <iterator>
+#include <limits>
+#include <cmath>
+#include <cstdint>
+#include <cstring>
+#include <cassert>
+
+#include "utils/maths.hpp"
+#include "utils/parallel_transform.hpp"
+
+namespace octopus { namespace model {
+
+namespace {
+
+constexpr std::size_t cache_line_size {64 / sizeof(double)};
+
+} // namespace
+
+SampleGenotypeMatrix::SampleGenotypeMatrix(const std::size_t num_samples, const std::size_t num_genotypes, const double value)
+: num_samples_ {num_samples}
+, num_genotypes_ {num_genotypes}
+, stride_ {(num_genotypes + cache_line_size - 1) / cache_line_size * cache_line_size}
+, data_(num_samples * stride_, value)
+{}
+
+GenotypeHaplotypeIncidence::GenotypeHaplotypeIncidence(const MappableBlock<Genotype<IndexedHaplotype<>>>& genotypes,
+                                                       const std::size_t num_haplotypes)
+: num_haplotypes_ {num_haplotypes}
+, offsets_ {}
+, haplotypes_ {}
+, counts_ {}
+, log_multinomial_coefficients_ {}
+{
+    offsets_.reserve(genotypes.size() + 1);
+    offsets_.push_back(0);
+    log_multinomial_coefficients_.reserve(genotypes.size());
+    std::vector<unsigned> haplotype_indices {};
+    for (const auto& genotype : genotypes) {
+        haplotype_indices.clear();
+        for (const auto& haplotype : genotype) {
+            haplotype_indices.push_back(static_cast<unsigned>(index_of(haplotype)));
+        }
+        std::sort(std::begin(haplotype_indices), std::end(haplotype_indices));
+        add_genotype(haplotype_indices);
+    }
+}
+
+GenotypeHaplotypeIncidence::GenotypeHaplotypeIncidence(const GenotypeSpace& space)
+: num_haplotypes_ {space.num_elements()}
+, offsets_ {}
+, haplotypes_ {}
+, counts_ {}
+, log_multinomial_coefficients_ {}
+{
+    offsets_.reserve(space.size() + 1);
+    offsets_.push_back(0);
+    log_multinomial_coefficients_.reserve(space.size());
+    for (const auto& haplotype_indices : space) {
+        add_genotype(haplotype_indices);
+    }
+}
+
+template <typename Range>
+void GenotypeHaplotypeIncidence::add_genotype(const Range& haplotype_indices)
+{
+    assert(std::is_sorted(std::cbegin(haplotype_indices), std::cend(haplotype_indices)));
+    const auto first_count = counts_.size();
+    for (auto itr = std::cbegin(haplotype_indices); itr != std::cend(haplotype_indices);) {
+        const auto next = std::upper_bound(itr, std::cend(haplotype_indices), *itr);
+        haplotypes_.push_back(*itr);
+        counts_.push_back(static_cast<unsigned>(std::distance(itr, next)));
+        itr = next;
+    }
+    offsets_.push_back(haplotypes_.size());
+    const auto first = std::next(std::cbegin(counts_), first_count);
+    log_multinomial_coefficients_.push_back(maths::log_multinomial_coefficient<double>(first, std::cend(counts_)));
+}
+
+namespace {
+
+// Minimum work (matrix elements) per partition evaluated in parallel
+constexpr std::size_t min_partition_work {100'000};
+// Number of genotype columns accumulated at once when collapsing the posterior matrix
+constexpr std::size_t collapse_block_size {512};
+
+template <typename UnaryFunction>
+void for_each_index(const std::size_t n, const std::size_t work_per_index, boost::optional<ThreadPool&> workers, UnaryFunction f)
+{
+    if (workers) {
+        const auto min_partition_size = min_partition_work / std::max(work_per_index, std::size_t {1});
+        parallel_for_each_partition(n, min_partition_size, [&f] (std::size_t first, const std::size_t last) {
+            for (; first < last; ++first) f(first);
+        }, *workers);
+    } else {
+        for (std::size_t idx {0}; idx < n; ++idx) f(idx);
+    }
+}
+
+// exp(x) for x <= 0. The kernel is branch free so that the row loops vectorise: Cody-Waite range
+// reduction to |r| <= ln(2)/2 and a degree 13 Taylor polynomial, accurate to a few ulp. Inputs
+// below the smallest normal exponent give 0.
+inline double exp_kernel(const double x) noexcept
+{
+    constexpr double min_x {-708.0};
+    constexpr double log2e {1.4426950408889634}, ln2_hi {0.693145751953125}, ln2_lo {1.42860682030941723212e-6};
+    constexpr double shifter {6755399441055744.0}; // 1.5 * 2^52, so the low bits of n + shifter are n
+    const double clamped_x {x < min_x ? min_x : x};
+    const double n {std::nearbyint(clamped_x * log2e)};
+    const double r {(clamped_x - n * ln2_hi) - n * ln2_lo};
+    double p {1.0 / 6227020800.0};
+    p = p * r + 1.0 / 479001600.0;
+    p = p * r + 1.0 / 39916800.0;
+    p = p * r + 1.0 / 3628800.0;
+    p = p * r + 1.0 / 362880.0;
+    p = p * r + 1.0 / 40320.0;
+    p = p * r + 1.0 / 5040.0;
+    p = p * r + 1.0 / 720.0;
+    p = p * r + 1.0 / 120.0;
+    p = p * r + 1.0 / 24.0;
+    p = p * r + 1.0 / 6.0;
+    p = p * r + 0.5;
+    p = p * r + 1.0;
+    p = p * r + 1.0;
+    const double t {n + shifter};
+    std::int64_t t_bits, shifter_bits;
+    std::memcpy(&t_bits, &t, sizeof(t));
+    std::memcpy(&shifter_bits, &shifter, sizeof(shifter));
+    const std::int64_t scale_bits {(t_bits - shifter_bits + 1023) << 52};
+    double scale;
+    std::memcpy(&scale, &scale_bits, sizeof(scale));
+    return x < min_x ? 0.0 : p * scale;
+}
+
+// posteriors = normalise_exp(log_marginals + log_likelihoods)
+void update_posteriors(const double* log_marginals, const double* log_likelihoods, double* posteriors,
+                       const std::size_t n) noexcept
+{
+    double max {-std::numeric_limits<double>::infinity()};
+    for (std::size_t i {0}; i < n; ++i) {
+        const auto log_posterior = log_marginals[i] + log_likelihoods[i];
+        posteriors[i] = log_posterior;
+        max = log_posterior > max ? log_posterior : max;
+    }
+    double sum {0};
+    for (std::size_t i {0}; i < n; ++i) {
+        posteriors[i] = exp_kernel(posteriors[i] - max);
+        sum += posteriors[i];
+    }
+    const auto norm = 1.0 / sum;
+    for (std::size_t i {0}; i < n; ++i) {
+        posteriors[i] *= norm;
+    }
+}
+
+void update_posteriors(const std::vector<double>& genotype_log_marginals,
+                       const SampleGenotypeMatrix& genotype_log_likelihoods,
+                       SampleGenotypeMatrix& genotype_posteriors,
+                       boost::optional<ThreadPool&> workers)
+{
+    const auto num_genotypes = genotype_log_marginals.size();
+    for_each_index(genotype_posteriors.num_samples(), num_genotypes, workers, [&] (const std::size_t s) {
+        update_posteriors(genotype_log_marginals.data(), genotype_log_likelihoods[s], genotype_posteriors[s], num_genotypes);
+    });
+}
+
+// Sums the posteriors over samples one block of genotype columns at a time, so the block
+// accumulators stay in cache while the rows are streamed
+void collapse_posteriors(const SampleGenotypeMatrix& genotype_posteriors, std::vector<double>& result,
+                         boost::optional<ThreadPool&> workers)
+{
+    const auto num_samples = genotype_posteriors.num_samples(), num_genotypes = genotype_posteriors.num_genotypes();
+    result.assign(num_genotypes, 0.0);
+    const auto num_blocks = (num_genotypes + collapse_block_size - 1) / collapse_block_size;
+    for_each_index(num_blocks, num_samples * collapse_block_size, workers, [&] (const std::size_t block) {
+        const auto first = block * collapse_block_size, last = std::min(first + collapse_block_size, num_genotypes);
+        double* block_result {result.data() + first};
+        for (std::size_t s {0}; s < num_samples; ++s) {
+            const double* row {genotype_posteriors[s] + first};
+            for (std::size_t g {0}; g < last - first; ++g) {
+                block_result[g] += row[g];
+            }
+        }
+    });
+}
+
+double update_haplotype_frequencies(const std::vector<double>& collapsed_posteriors,
+                                    const GenotypeHaplotypeIncidence& incidence,
+                                    const double frequency_update_norm,
+                                    std::vector<double>& frequencies,
+                                    std::vector<double>& buffer)
+{
+    // A genotype contributes its posterior once to each distinct haplotype it contains
+    const auto& haplotypes = incidence.haplotypes();
+    buffer.assign(incidence.num_haplotypes(), 0.0);
+    for (std::size_t g {0}; g < collapsed_posteriors.size(); ++g) {
+        for (auto k = incidence.offset(g); k < incidence.offset(g + 1); ++k) {
+            buffer[haplotypes[k]] += collapsed_posteriors[g];
+        }
+    }
+    double max_frequency_change {0};
+    for (std::size_t h {0}; h < frequencies.size(); ++h) {
+        const auto new_frequency = buffer[h] / frequency_update_norm;
+        max_frequency_change = std::max(std::abs(frequencies[h] - new_frequency), max_frequency_change);
+        frequencies[h] = std::max(new_frequency, std::numeric_limits<double>::min());
+    }
+    return max_frequency_change;
+}
+
+// Hardy-Weinberg genotype log probabilities, with one log per haplotype rather than per genotype
+void update_genotype_log_marginals(const std::vector<double>& frequencies,
+                                   const GenotypeHaplotypeIncidence& incidence,
+                                   std::vector<double>& log_frequencies,
+                                   std::vector<double>& result)
+{
+    std::transform(std::cbegin(frequencies), std::cend(frequencies), std::begin(log_frequencies),
+                   [] (const double frequency) { return std::log(frequency); });
+    const auto& haplotypes = incidence.haplotypes();
+    const auto& counts = incidence.counts();
+    const auto& log_multinomial_coefficients = incidence.log_multinomial_coefficients();
+    for (std::size_t g {0}; g < result.size(); ++g) {
+        auto log_probability = log_multinomial_coefficients[g];
+        for (auto k = incidence.offset(g); k < incidence.offset(g + 1); ++k) {
+            log_probability += counts[k] * log_frequencies[haplotypes[k]];
+        }
+        result[g] = log_probability;
+    }
+}
+
+} // namespace
+
+SampleGenotypeMatrix
+compute_approx_genotype_marginal_posteriors(const GenotypeHaplotypeIncidence& incidence,
+                                            const SampleGenotypeMatrix& genotype_log_likelihoods,
+                                            const double frequency_update_norm,
+                                            const PopulationEMOptions& options)
+{
+    assert(genotype_log_likelihoods.num_genotypes() == incidence.num_genotypes());
+    const auto num_haplotypes = incidence.num_haplotypes(), num_genotypes = incidence.num_genotypes();
+    std::vector<double> frequencies(num_haplotypes, 1.0 / num_haplotypes), log_frequencies(num_haplotypes), frequency_buffer {};
+    std::vector<double> genotype_log_marginals(num_genotypes), collapsed_posteriors {};
+    update_genotype_log_marginals(frequencies, incidence, log_frequencies, genotype_log_marginals);
+    SampleGenotypeMatrix result {genotype_log_likelihoods.num_samples(), num_genotypes};
+    update_posteriors(genotype_log_marginals, genotype_log_likelihoods, result, options.workers);
+    for (unsigned n {1}; n <= options.max_iterations; ++n) {
+        collapse_posteriors(result, collapsed_posteriors, options.workers);
+        const auto max_change = update_haplotype_frequencies(collapsed_posteriors, incidence, frequency_update_norm,
+                                                             frequencies, frequency_buffer);
+        update_genotype_log_marginals(frequencies, incidence, log_frequencies, genotype_log_marginals);
+        update_posteriors(genotype_log_marginals, genotype_log_likelihoods, result, options.workers);
+        if (max_change <= options.epsilon) break;
+    }
+    return result;
+}
+
+} // namespace model
+} // namespace octopus
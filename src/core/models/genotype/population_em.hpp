@@ -0,0 +1,108 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef population_em_hpp
+#define population_em_hpp
+
+#include <vector>
+#include <cstddef>
+
+#include <boost/optional.hpp>
+
+#include "core/types/indexed_haplotype.hpp"
+#include "core/types/genotype.hpp"
+#include "core/types/genotype_space.hpp"
+#include "containers/mappable_block.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace octopus { namespace model {
+
+/*
+ SampleGenotypeMatrix is a dense row-major matrix with one row per sample and one column per genotype.
+ Rows are padded to a whole number of cache lines so the row kernels always start on the same alignment.
+ */
+class SampleGenotypeMatrix
+{
+public:
+    SampleGenotypeMatrix() = default;
+
+    SampleGenotypeMatrix(std::size_t num_samples, std::size_t num_genotypes, double value = 0.0);
+
+    SampleGenotypeMatrix(const SampleGenotypeMatrix&)            = default;
+    SampleGenotypeMatrix& operator=(const SampleGenotypeMatrix&) = default;
+    SampleGenotypeMatrix(SampleGenotypeMatrix&&)                 = default;
+    SampleGenotypeMatrix& operator=(SampleGenotypeMatrix&&)      = default;
+
+    ~SampleGenotypeMatrix() = default;
+
+    std::size_t num_samples() const noexcept { return num_samples_; }
+    std::size_t num_genotypes() const noexcept { return num_genotypes_; }
+
+    double* operator[](std::size_t sample) noexcept { return data_.data() + sample * stride_; }
+    const double* operator[](std::size_t sample) const noexcept { return data_.data() + sample * stride_; }
+
+private:
+    std::size_t num_samples_ = 0, num_genotypes_ = 0, stride_ = 0;
+    std::vector<double> data_;
+};
+
+/*
+ GenotypeHaplotypeIncidence is a sparse (compressed row) genotype-haplotype incidence matrix: for each
+ genotype, the distinct haplotypes it contains and their copy numbers.
+ */
+class GenotypeHaplotypeIncidence
+{
+public:
+    GenotypeHaplotypeIncidence() = default;
+
+    GenotypeHaplotypeIncidence(const MappableBlock<Genotype<IndexedHaplotype<>>>& genotypes, std::size_t num_haplotypes);
+    // All genotypes in space, in rank order
+    GenotypeHaplotypeIncidence(const GenotypeSpace& space);
+
+    GenotypeHaplotypeIncidence(const GenotypeHaplotypeIncidence&)            = default;
+    GenotypeHaplotypeIncidence& operator=(const GenotypeHaplotypeIncidence&) = default;
+    GenotypeHaplotypeIncidence(GenotypeHaplotypeIncidence&&)                 = default;
+    GenotypeHaplotypeIncidence& operator=(GenotypeHaplotypeIncidence&&)      = default;
+
+    ~GenotypeHaplotypeIncidence() = default;
+
+    std::size_t num_genotypes() const noexcept { return log_multinomial_coefficients_.size(); }
+    std::size_t num_haplotypes() const noexcept { return num_haplotypes_; }
+
+    // The distinct haplotypes of genotype are haplotypes()[offset(genotype)] up to haplotypes()[offset(genotype + 1)]
+    std::size_t offset(std::size_t genotype) const noexcept { return offsets_[genotype]; }
+    const std::vector<unsigned>& haplotypes() const noexcept { return haplotypes_; }
+    const std::vector<unsigned>& counts() const noexcept { return counts_; }
+    // The Hardy-Weinberg log multinomial coefficient of each genotype
+    const std::vector<double>& log_multinomial_coefficients() const noexcept { return log_multinomial_coefficients_; }
+
+private:
+    std::size_t num_haplotypes_ = 0;
+    std::vector<std::size_t> offsets_;
+    std::vector<unsigned> haplotypes_, counts_;
+    std::vector<double> log_multinomial_coefficients_;
+
+    template <typename Range> void add_genotype(const Range& haplotype_indices);
+};
+
+struct PopulationEMOptions
+{
+    unsigned max_iterations = 100;
+    double epsilon = 0.001;
+    // If set, the sample and genotype loops of each iteration are partitioned over workers
+    boost::optional<ThreadPool&> workers = boost::none;
+};
+
+// Approximates the genotype marginal posteriors of each sample with haplotype frequencies
+// estimated by EM under a Hardy-Weinberg genotype prior. frequency_update_norm is the total
+// number of haplotype copies over all samples.
+SampleGenotypeMatrix
+compute_approx_genotype_marginal_posteriors(const GenotypeHaplotypeIncidence& incidence,
+                                            const SampleGenotypeMatrix& genotype_log_likelihoods,
+                                            double frequency_update_norm,
+                                            const PopulationEMOptions& options);
+
+} // namespace model
+} // namespace octopus
+
+#endif
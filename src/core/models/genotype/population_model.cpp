@@ -14,8 +14,9 @@
 #include "utils/maths.hpp"
 #include "utils/select_top_k.hpp"
 #include "utils/concat.hpp"
+#include "utils/parallel_transform.hpp"
 #include "constant_mixture_genotype_likelihood_model.hpp"
-#include "hardy_weinberg_model.hpp"
+#include "population_em.hpp"
 
 namespace octopus { namespace model {
 
@@ -44,36 +45,9 @@ using LogProbability = double;
 using GenotypeLogLikelihoodVector  = std::vector<LogProbability>;
 using GenotypeLogLikelihoodMatrix  = std::vector<GenotypeLogLikelihoodVector>;
 
-struct GenotypeLogProbability
-{
-    const Genotype<IndexedHaplotype<>>& genotype;
-    double log_probability;
-};
-using GenotypeLogMarginalVector = std::vector<GenotypeLogProbability>;
-
 using GenotypeMarginalPosteriorVector  = std::vector<double>;
 using GenotypeMarginalPosteriorMatrix  = std::vector<GenotypeMarginalPosteriorVector>; // for each sample
 
-using InverseGenotypeTable = std::vector<std::vector<std::size_t>>;
-
-auto make_inverse_genotype_table(const MappableBlock<Genotype<IndexedHaplotype<>>>& genotypes,
-                                 const std::size_t num_haplotypes)
-{
-    InverseGenotypeTable result(num_haplotypes);
-    for (auto& indices : result) indices.reserve(genotypes.size() / num_haplotypes);
-    for (std::size_t genotype_idx {0}; genotype_idx < genotypes.size(); ++genotype_idx) {
-        for (const auto& haplotype : genotypes[genotype_idx]) {
-            result[index_of(haplotype)].push_back(genotype_idx);
-        }
-    }
-    for (auto& indices : result) {
-        std::sort(std::begin(indices), std::end(indices));
-        indices.erase(std::unique(std::begin(indices), std::end(indices)), std::end(indices));
-        indices.shrink_to_fit();
-    }
-    return result;
-}
-
 double calculate_frequency_update_norm(const std::size_t num_samples, const unsigned ploidy) noexcept
 {
     return static_cast<double>(num_samples) * ploidy;
@@ -84,66 +58,55 @@ double calculate_frequency_update_norm(const std::vector<unsigned>& sample_ploid
     return std::accumulate(std::cbegin(sample_ploidies), std::cend(sample_ploidies), 0.0, std::multiplies<> {});
 }
 
-struct EMOptions
+// Workers are only used when the execution policy is par
+boost::optional<ThreadPool&> get_workers(const PopulationModel::Options& options) noexcept
 {
-    unsigned max_iterations;
-    double epsilon;
-};
+    if (options.execution_policy == ExecutionPolicy::par) return options.workers;
+    return boost::none;
+}
 
-struct ModelConstants
-{
-    const PopulationModel::GenotypeVector& genotypes;
-    const GenotypeLogLikelihoodMatrix& genotype_log_likilhoods;
-    const InverseGenotypeTable genotypes_containing_haplotypes;
-    const std::size_t num_haplotypes;
-    const double frequency_update_norm;
-    
-    ModelConstants(const MappableBlock<Haplotype>& haplotypes,
-                   const PopulationModel::GenotypeVector& genotypes,
-                   const GenotypeLogLikelihoodMatrix& genotype_log_likilhoods)
-    : genotypes {genotypes}
-    , genotype_log_likilhoods {genotype_log_likilhoods}
-    , genotypes_containing_haplotypes {make_inverse_genotype_table(genotypes, haplotypes.size())}
-    , num_haplotypes {haplotypes.size()}
-    , frequency_update_norm {calculate_frequency_update_norm(genotype_log_likilhoods.size(), genotypes.front().ploidy())}
-    {}
-    ModelConstants(const MappableBlock<Haplotype>& haplotypes,
-                   const PopulationModel::GenotypeVector& genotypes,
-                   const GenotypeLogLikelihoodMatrix& genotype_log_likilhoods,
-                   const std::vector<unsigned>& sample_ploidies)
-    : genotypes {genotypes}
-    , genotype_log_likilhoods {genotype_log_likilhoods}
-    , genotypes_containing_haplotypes {make_inverse_genotype_table(genotypes, haplotypes.size())}
-    , num_haplotypes {haplotypes.size()}
-    , frequency_update_norm {calculate_frequency_update_norm(sample_ploidies)}
-    {}
-};
+// Minimum sizes of the partitions evaluated in parallel
+constexpr std::size_t min_genotype_partition_size {1'000};
+constexpr std::size_t min_combination_partition_size {10'000};
 
-HardyWeinbergModel make_hardy_weinberg_model(const ModelConstants& constants)
+template <typename LikelihoodFunction>
+GenotypeLogLikelihoodVector
+compute_sample_genotype_log_likelihoods(const std::size_t num_genotypes,
+                                        const ConstantMixtureGenotypeLikelihoodModel& likelihood_model,
+                                        LikelihoodFunction f,
+                                        boost::optional<ThreadPool&> workers)
 {
-    HardyWeinbergModel::HaplotypeFrequencyVector frequencies(constants.num_haplotypes);
-    for (std::size_t idx {0}; idx < constants.num_haplotypes; ++idx) {
-        frequencies[idx] = 1.0 / constants.num_haplotypes;
+    GenotypeLogLikelihoodVector result(num_genotypes);
+    if (workers) {
+        // The likelihood model has internal buffers, so each partition needs its own copy
+        parallel_for_each_partition(num_genotypes, min_genotype_partition_size, [&] (std::size_t first, const std::size_t last) {
+            const auto partition_likelihood_model = likelihood_model;
+            for (; first < last; ++first) result[first] = f(first, partition_likelihood_model);
+        }, *workers);
+    } else {
+        for (std::size_t genotype_idx {0}; genotype_idx < num_genotypes; ++genotype_idx) {
+            result[genotype_idx] = f(genotype_idx, likelihood_model);
+        }
     }
-    return HardyWeinbergModel {std::move(frequencies)};
+    return result;
 }
 
 GenotypeLogLikelihoodMatrix
 compute_genotype_log_likelihoods(const std::vector<SampleName>& samples,
                                  const PopulationModel::GenotypeVector& genotypes,
-                                 const HaplotypeLikelihoodArray& haplotype_likelihoods)
+                                 const HaplotypeLikelihoodArray& haplotype_likelihoods,
+                                 boost::optional<ThreadPool&> workers = boost::none)
 {
     assert(!genotypes.empty());
-    ConstantMixtureGenotypeLikelihoodModel likelihood_model {haplotype_likelihoods};
+    const ConstantMixtureGenotypeLikelihoodModel likelihood_model {haplotype_likelihoods};
+    const auto evaluate = [&] (const std::size_t genotype_idx, const auto& model) { return model.evaluate(genotypes[genotype_idx]); };
     GenotypeLogLikelihoodMatrix result {};
     result.reserve(samples.size());
-    std::transform(std::cbegin(samples), std::cend(samples), std::back_inserter(result), [&] (const auto& sample) {
-        GenotypeLogLikelihoodVector likelihoods(genotypes.size());
+    for (const auto& sample : samples) {
+        // Priming is not thread-safe, so samples are evaluated in turn
         haplotype_likelihoods.prime(sample);
-        std::transform(std::cbegin(genotypes), std::cend(genotypes), std::begin(likelihoods),
-                       [&] (const auto& genotype) { return likelihood_model.evaluate(genotype); });
-        return likelihoods;
-    });
+        result.push_back(compute_sample_genotype_log_likelihoods(genotypes.size(), likelihood_model, evaluate, workers));
+    }
     return result;
 }
 
@@ -151,173 +114,68 @@ GenotypeLogLikelihoodMatrix
 compute_genotype_log_likelihoods(const std::vector<SampleName>& samples,
                                  const PopulationModel::GenotypeVector& genotypes,
                                  const HaplotypeLikelihoodArray& haplotype_likelihoods,
-                                 const std::vector<std::vector<bool>>& sample_genotype_masks)
+                                 const std::vector<std::vector<bool>>& sample_genotype_masks,
+                                 boost::optional<ThreadPool&> workers = boost::none)
 {
     assert(!genotypes.empty());
-    ConstantMixtureGenotypeLikelihoodModel likelihood_model {haplotype_likelihoods};
+    const ConstantMixtureGenotypeLikelihoodModel likelihood_model {haplotype_likelihoods};
     GenotypeLogLikelihoodMatrix result {};
     result.reserve(samples.size());
-    std::transform(std::cbegin(samples), std::cend(samples), std::cbegin(sample_genotype_masks),
-                   std::back_inserter(result), [&] (const auto& sample, const auto& mask) {
-        GenotypeLogLikelihoodVector likelihoods(genotypes.size());
-        haplotype_likelihoods.prime(sample);
-        std::transform(std::cbegin(genotypes), std::cend(genotypes), std::cbegin(mask), std::begin(likelihoods),
-                       [&] (const auto& genotype, bool ok) {
-                           return ok ? likelihood_model.evaluate(genotype) : -std::numeric_limits<LogProbability>::infinity();
-                       });
-        return likelihoods;
-    });
-    return result;
-}
-
-GenotypeLogMarginalVector
-init_genotype_log_marginals(const PopulationModel::GenotypeVector& genotypes,
-                            const HardyWeinbergModel& hw_model)
-{
-    GenotypeLogMarginalVector result {};
-    result.reserve(genotypes.size());
-    for (const auto& genotype : genotypes) {
-        result.push_back({genotype, hw_model.evaluate(genotype)});
+    for (std::size_t sample_idx {0}; sample_idx < samples.size(); ++sample_idx) {
+        const auto& mask = sample_genotype_masks[sample_idx];
+        const auto evaluate = [&] (const std::size_t genotype_idx, const auto& model) {
+            return mask[genotype_idx] ? model.evaluate(genotypes[genotype_idx]) : -std::numeric_limits<LogProbability>::infinity();
+        };
+        haplotype_likelihoods.prime(samples[sample_idx]);
+        result.push_back(compute_sample_genotype_log_likelihoods(genotypes.size(), likelihood_model, evaluate, workers));
     }
     return result;
 }
-
-void update_genotype_log_marginals(GenotypeLogMarginalVector& current_log_marginals,
-                                   const HardyWeinbergModel& hw_model)
+auto make_sample_genotype_matrix(const GenotypeLogLikelihoodMatrix& genotype_log_likelihoods)
 {
-    std::for_each(std::begin(current_log_marginals), std::end(current_log_marginals),
-                  [&hw_model] (auto& p) { p.log_probability = hw_model.evaluate(p.genotype); });
-}
-
-GenotypeMarginalPosteriorMatrix
-init_genotype_posteriors(const GenotypeLogMarginalVector& genotype_log_marginals,
-                         const GenotypeLogLikelihoodMatrix& genotype_log_likilhoods)
-{
-    GenotypeMarginalPosteriorMatrix result {};
-    result.reserve(genotype_log_likilhoods.size());
-    for (const auto& sample_genotype_log_likilhoods : genotype_log_likilhoods) {
-        GenotypeMarginalPosteriorVector posteriors(genotype_log_marginals.size());
-        std::transform(std::cbegin(genotype_log_marginals), std::cend(genotype_log_marginals),
-                       std::cbegin(sample_genotype_log_likilhoods), std::begin(posteriors),
-                       [] (const auto& genotype_log_marginal, const auto genotype_log_likilhood) {
-                           return genotype_log_marginal.log_probability + genotype_log_likilhood;
-                       });
-        maths::normalise_exp(posteriors);
-        result.emplace_back(std::move(posteriors));
+    SampleGenotypeMatrix result {genotype_log_likelihoods.size(), genotype_log_likelihoods.front().size()};
+    for (std::size_t s {0}; s < genotype_log_likelihoods.size(); ++s) {
+        std::copy(std::cbegin(genotype_log_likelihoods[s]), std::cend(genotype_log_likelihoods[s]), result[s]);
     }
     return result;
 }
 
-void update_genotype_posteriors(GenotypeMarginalPosteriorMatrix& current_genotype_posteriors,
-                                const GenotypeLogMarginalVector& genotype_log_marginals,
-                                const GenotypeLogLikelihoodMatrix& genotype_log_likilhoods)
-{
-    auto likelihood_itr = std::cbegin(genotype_log_likilhoods);
-    for (auto& sample_genotype_posteriors : current_genotype_posteriors) {
-        std::transform(std::cbegin(genotype_log_marginals), std::cend(genotype_log_marginals),
-                       std::cbegin(*likelihood_itr++), std::begin(sample_genotype_posteriors),
-                       [] (const auto& log_marginal, const auto& log_likeilhood) {
-                           return log_marginal.log_probability + log_likeilhood;
-                       });
-        maths::normalise_exp(sample_genotype_posteriors);
-    }
-}
-
-auto collapse_genotype_posteriors(const GenotypeMarginalPosteriorMatrix& genotype_posteriors)
-{
-    assert(!genotype_posteriors.empty());
-    std::vector<double> result(genotype_posteriors.front().size());
-    for (const auto& sample_posteriors : genotype_posteriors) {
-        std::transform(std::cbegin(result), std::cend(result), std::cbegin(sample_posteriors), std::begin(result),
-                       [] (const auto curr, const auto p) { return curr + p; });
-    }
-    return result;
-}
-
-double update_haplotype_frequencies(HardyWeinbergModel& hw_model,
-                                    const GenotypeMarginalPosteriorMatrix& genotype_posteriors,
-                                    const InverseGenotypeTable& genotypes_containing_haplotypes,
-                                    const std::size_t num_haplotypes,
-                                    const double frequency_update_norm)
-{
-    const auto collaped_posteriors = collapse_genotype_posteriors(genotype_posteriors);
-    double max_frequency_change {0};
-    auto& current_haplotype_frequencies = hw_model.frequencies();
-    for (std::size_t haplotype_idx {0}; haplotype_idx < num_haplotypes; ++haplotype_idx) {
-        auto& current_frequency = current_haplotype_frequencies[haplotype_idx];
-        double new_frequency {0};
-        for (const auto& genotype_index : genotypes_containing_haplotypes[haplotype_idx]) {
-            new_frequency += collaped_posteriors[genotype_index];
-        }
-        new_frequency /= frequency_update_norm;
-        const auto frequency_change = std::abs(current_frequency - new_frequency);
-        if (frequency_change > max_frequency_change) {
-            max_frequency_change = frequency_change;
-        }
-        current_frequency = std::max(new_frequency, std::numeric_limits<decltype(new_frequency)>::min());
-    }
-    return max_frequency_change;
-}
-
-double do_em_iteration(GenotypeMarginalPosteriorMatrix& genotype_posteriors,
-                       HardyWeinbergModel& hw_model,
-                       GenotypeLogMarginalVector& genotype_log_marginals,
-                       const ModelConstants& constants)
-{
-    const auto max_change = update_haplotype_frequencies(hw_model,
-                                                         genotype_posteriors,
-                                                         constants.genotypes_containing_haplotypes,
-                                                         constants.num_haplotypes,
-                                                         constants.frequency_update_norm);
-    update_genotype_log_marginals(genotype_log_marginals, hw_model);
-    update_genotype_posteriors(genotype_posteriors, genotype_log_marginals, constants.genotype_log_likilhoods);
-    return max_change;
-}
-
-void run_em(GenotypeMarginalPosteriorMatrix& genotype_posteriors,
-            HardyWeinbergModel& hw_model,
-            GenotypeLogMarginalVector& genotype_log_marginals,
-            const ModelConstants& constants,
-            const EMOptions options,
-            boost::optional<logging::TraceLogger> trace_log = boost::none)
-{
-    for (unsigned n {1}; n <= options.max_iterations; ++n) {
-        const auto max_change = do_em_iteration(genotype_posteriors, hw_model, genotype_log_marginals,constants);
-        if (max_change <= options.epsilon) break;
-    }
-}
-
-auto compute_approx_genotype_marginal_posteriors(const PopulationModel::GenotypeVector& genotypes,
+auto compute_approx_genotype_marginal_posteriors(const MappableBlock<Haplotype>& haplotypes,
+                                                 const PopulationModel::GenotypeVector& genotypes,
                                                  const GenotypeLogLikelihoodMatrix& genotype_likelihoods,
-                                                 const ModelConstants& constants,
-                                                 const EMOptions options)
-{
-    auto hw_model = make_hardy_weinberg_model(constants);
-    auto genotype_log_marginals = init_genotype_log_marginals(genotypes, hw_model);
-    auto result = init_genotype_posteriors(genotype_log_marginals, genotype_likelihoods);
-    run_em(result, hw_model, genotype_log_marginals, constants, options);
+                                                 const double frequency_update_norm,
+                                                 const PopulationEMOptions& options)
+{
+    const GenotypeHaplotypeIncidence incidence {genotypes, haplotypes.size()};
+    const auto posteriors = compute_approx_genotype_marginal_posteriors(incidence, make_sample_genotype_matrix(genotype_likelihoods),
+                                                                        frequency_update_norm, options);
+    GenotypeMarginalPosteriorMatrix result(posteriors.num_samples());
+    for (std::size_t s {0}; s < posteriors.num_samples(); ++s) {
+        result[s].assign(posteriors[s], posteriors[s] + posteriors.num_genotypes());
+    }
     return result;
 }
 
 auto compute_approx_genotype_marginal_posteriors(const MappableBlock<Haplotype>& haplotypes,
                                                  const PopulationModel::GenotypeVector& genotypes,
                                                  const GenotypeLogLikelihoodMatrix& genotype_likelihoods,
-                                                 const EMOptions options)
+                                                 const PopulationEMOptions& options)
 {
-    const ModelConstants constants {haplotypes, genotypes, genotype_likelihoods};
-    return compute_approx_genotype_marginal_posteriors(genotypes, genotype_likelihoods, constants, options);
+    const auto frequency_update_norm = calculate_frequency_update_norm(genotype_likelihoods.size(), genotypes.front().ploidy());
+    return compute_approx_genotype_marginal_posteriors(haplotypes, genotypes, genotype_likelihoods, frequency_update_norm, options);
 }
 
 auto compute_approx_genotype_marginal_posteriors(const MappableBlock<Haplotype>& haplotypes,
                                                  const PopulationModel::GenotypeVector& genotypes,
                                                  const GenotypeLogLikelihoodMatrix& genotype_likelihoods,
                                                  const std::vector<unsigned>& sample_plodies,
-                                                 const EMOptions options)
+                                                 const PopulationEMOptions& options)
 {
-    const ModelConstants constants {haplotypes, genotypes, genotype_likelihoods, sample_plodies};
-    return compute_approx_genotype_marginal_posteriors(genotypes, genotype_likelihoods, constants, options);
+    const auto frequency_update_norm = calculate_frequency_update_norm(sample_plodies);
+    return compute_approx_genotype_marginal_posteriors(haplotypes, genotypes, genotype_likelihoods, frequency_update_norm, options);
 }
 
+
 using GenotypeCombinationVector = std::vector<std::size_t>;
 using GenotypeCombinationMatrix = std::vector<GenotypeCombinationVector>;
 
@@ -489,16 +347,91 @@ select_top_k_genotypes(const PopulationModel::GenotypeVector& genotypes,
     }
 }
 
+struct ScoredGenotypeCombinations
+{
+    GenotypeCombinationMatrix combinations;
+    std::vector<double> scores;
+};
+
+auto select_top_k_combinations(const GenotypeMarginalPosteriorMatrix& em_genotype_marginals,
+                               const std::size_t first_sample, const std::size_t last_sample,
+                               const std::size_t k)
+{
+    const GenotypeMarginalPosteriorMatrix group_marginals {std::next(std::cbegin(em_genotype_marginals), first_sample),
+                                                           std::next(std::cbegin(em_genotype_marginals), last_sample)};
+    ScoredGenotypeCombinations result {select_top_k_tuples(group_marginals, k), {}};
+    result.scores.reserve(result.combinations.size());
+    for (const auto& combination : result.combinations) {
+        double score {0};
+        for (std::size_t s {0}; s < combination.size(); ++s) {
+            score += group_marginals[s][combination[s]];
+        }
+        result.scores.push_back(score);
+    }
+    return result;
+}
+
+auto join(const ScoredGenotypeCombinations& lhs, const ScoredGenotypeCombinations& rhs, const std::size_t k)
+{
+    const auto top_pairs = detail::find_k_max_pairs(lhs.scores, rhs.scores, k);
+    ScoredGenotypeCombinations result {};
+    result.combinations.reserve(top_pairs.size());
+    result.scores.reserve(top_pairs.size());
+    for (const auto& p : top_pairs) {
+        result.combinations.push_back(concat(lhs.combinations[p.first], rhs.combinations[p.second]));
+        result.scores.push_back(lhs.scores[p.first] + rhs.scores[p.second]);
+    }
+    return result;
+}
+
+constexpr std::size_t top_k_sample_group_size {8};
+
+GenotypeCombinationMatrix
+select_top_k_combinations(const GenotypeMarginalPosteriorMatrix& em_genotype_marginals,
+                          const std::size_t k,
+                          boost::optional<ThreadPool&> workers)
+{
+    const auto num_samples = em_genotype_marginals.size();
+    if (!workers || num_samples <= top_k_sample_group_size) {
+        return select_top_k_tuples(em_genotype_marginals, k);
+    }
+    // The top-k combinations of all samples are made from the top-k combinations of any grouping of
+    // the samples, as scores are additive over samples. Groups are selected in parallel and then
+    // merged pairwise. The groups, and the merge order, do not depend on the number of threads so the
+    // selection is deterministic.
+    const auto num_groups = (num_samples + top_k_sample_group_size - 1) / top_k_sample_group_size;
+    std::vector<ScoredGenotypeCombinations> groups(num_groups);
+    parallel_for_each_partition(num_groups, 1, [&] (std::size_t first, const std::size_t last) {
+        for (; first < last; ++first) {
+            const auto first_sample = first * top_k_sample_group_size;
+            const auto last_sample = std::min(first_sample + top_k_sample_group_size, num_samples);
+            groups[first] = select_top_k_combinations(em_genotype_marginals, first_sample, last_sample, k);
+        }
+    }, *workers);
+    while (groups.size() > 1) {
+        std::vector<ScoredGenotypeCombinations> merged_groups((groups.size() + 1) / 2);
+        parallel_for_each_partition(groups.size() / 2, 1, [&] (std::size_t first, const std::size_t last) {
+            for (; first < last; ++first) {
+                merged_groups[first] = join(groups[2 * first], groups[2 * first + 1], k);
+            }
+        }, *workers);
+        if (groups.size() % 2 == 1) merged_groups.back() = std::move(groups.back());
+        groups = std::move(merged_groups);
+    }
+    return std::move(groups.front().combinations);
+}
+
 auto propose_genotype_combinations(const PopulationModel::GenotypeVector& genotypes,
                                    const GenotypeMarginalPosteriorMatrix& em_genotype_marginals,
-                                   const std::size_t max_genotype_combinations)
+                                   const std::size_t max_genotype_combinations,
+                                   boost::optional<ThreadPool&> workers = boost::none)
 {
     const auto num_samples = em_genotype_marginals.size();
     const auto max_possible_genotype_combinations = compute_num_combinations(genotypes.size(), num_samples);
     if (max_possible_genotype_combinations && *max_possible_genotype_combinations <= max_genotype_combinations) {
         return generate_all_genotype_combinations(genotypes.size(), num_samples);
     }
-    auto result = select_top_k_tuples(em_genotype_marginals, max_genotype_combinations);
+    auto result = select_top_k_combinations(em_genotype_marginals, max_genotype_combinations, workers);
     const auto top_k_genotype_indices = select_top_k_genotypes(genotypes, em_genotype_marginals, num_samples / 2);
     for (const auto genotype_idx : top_k_genotype_indices) {
         for (std::size_t sample_idx {0}; sample_idx < num_samples; ++sample_idx) {
@@ -548,16 +481,33 @@ void fill(const Range& genotypes, const GenotypeCombinationVector& combination,
 auto calculate_posteriors(const PopulationModel::GenotypeVector& genotypes,
                           const GenotypeCombinationMatrix& genotype_combinations,
                           const GenotypeLogLikelihoodMatrix& genotype_likelihoods,
-                          const PopulationPriorModel& prior_model)
+                          const PopulationPriorModel& prior_model,
+                          boost::optional<ThreadPool&> workers = boost::none)
 {
     std::vector<double> result {};
-    GenotypeLogLikelihoodVector likelihoods_buffer(genotype_likelihoods.size());
     PopulationPriorModel::GenotypeReferenceVector genotype_combination {};
     genotype_combination.reserve(genotype_combinations.front().size());
-    for (const auto& combination : genotype_combinations) {
-        fill(genotype_likelihoods, combination, likelihoods_buffer);
-        fill(genotypes, combination, genotype_combination);
-        result.push_back(prior_model.evaluate(genotype_combination) + sum(likelihoods_buffer));
+    if (workers) {
+        // Prior models are not thread-safe, so only the likelihoods are evaluated in parallel
+        result.resize(genotype_combinations.size());
+        parallel_for_each_partition(genotype_combinations.size(), min_combination_partition_size, [&] (std::size_t first, const std::size_t last) {
+            GenotypeLogLikelihoodVector likelihoods_buffer(genotype_likelihoods.size());
+            for (; first < last; ++first) {
+                fill(genotype_likelihoods, genotype_combinations[first], likelihoods_buffer);
+                result[first] = sum(likelihoods_buffer);
+            }
+        }, *workers);
+        for (std::size_t i {0}; i < genotype_combinations.size(); ++i) {
+            fill(genotypes, genotype_combinations[i], genotype_combination);
+            result[i] = prior_model.evaluate(genotype_combination) + result[i];
+        }
+    } else {
+        GenotypeLogLikelihoodVector likelihoods_buffer(genotype_likelihoods.size());
+        for (const auto& combination : genotype_combinations) {
+            fill(genotype_likelihoods, combination, likelihoods_buffer);
+            fill(genotypes, combination, genotype_combination);
+            result.push_back(prior_model.evaluate(genotype_combination) + sum(likelihoods_buffer));
+        }
     }
     const auto norm = maths::normalise_exp(result);
     return std::make_pair(std::move(result), norm);
@@ -584,10 +534,11 @@ void calculate_posterior_marginals(const Range& genotypes,
                                    const GenotypeCombinationMatrix& genotype_combinations,
                                    const GenotypeLogLikelihoodMatrix& genotype_likelihoods,
                                    const PopulationPriorModel& prior_model,
-                                   PopulationModel::InferredLatents& result)
+                                   PopulationModel::InferredLatents& result,
+                                   boost::optional<ThreadPool&> workers = boost::none)
 {
     std::vector<double> joint_posteriors; double norm;
-    std::tie(joint_posteriors, norm) = calculate_posteriors(genotypes, genotype_combinations, genotype_likelihoods, prior_model);
+    std::tie(joint_posteriors, norm) = calculate_posteriors(genotypes, genotype_combinations, genotype_likelihoods, prior_model, workers);
     const auto num_samples = genotype_likelihoods.size();
     set_posterior_marginals(genotype_combinations, joint_posteriors, genotypes.size(), num_samples, result);
     result.log_evidence = norm;
@@ -602,7 +553,8 @@ PopulationModel::evaluate(const SampleVector& samples,
                           const HaplotypeLikelihoodArray& haplotype_likelihoods) const
 {
     assert(!genotypes.empty());
-    const auto genotype_log_likelihoods = compute_genotype_log_likelihoods(samples, genotypes, haplotype_likelihoods);
+    const auto workers = get_workers(options_);
+    const auto genotype_log_likelihoods = compute_genotype_log_likelihoods(samples, genotypes, haplotype_likelihoods, workers);
     const auto num_possible_genotype_combinations = compute_num_combinations(genotypes.size(), samples.size());
     InferredLatents result;
     GenotypeCombinationMatrix genotype_combinations {};
@@ -610,11 +562,11 @@ PopulationModel::evaluate(const SampleVector& samples,
         genotype_combinations = generate_all_genotype_combinations(genotypes.size(), samples.size());
     } else {
         const auto max_genotype_combinations = options_.max_genotype_combinations ? *options_.max_genotype_combinations : *num_possible_genotype_combinations;
-        const EMOptions em_options {options_.max_em_iterations, options_.em_epsilon};
+        const PopulationEMOptions em_options {options_.max_em_iterations, options_.em_epsilon, workers};
         const auto em_genotype_marginals = compute_approx_genotype_marginal_posteriors(haplotypes, genotypes, genotype_log_likelihoods, em_options);
-        genotype_combinations = propose_genotype_combinations(genotypes, em_genotype_marginals, max_genotype_combinations);
+        genotype_combinations = propose_genotype_combinations(genotypes, em_genotype_marginals, max_genotype_combinations, workers);
     }
-    calculate_posterior_marginals(genotypes, genotype_combinations, genotype_log_likelihoods, prior_model_, result);
+    calculate_posterior_marginals(genotypes, genotype_combinations, genotype_log_likelihoods, prior_model_, result, workers);
     return result;
 }
 
@@ -680,8 +632,9 @@ PopulationModel::evaluate(const SampleVector& samples,
                           const GenotypeVector& genotypes,
                           const HaplotypeLikelihoodArray& haplotype_likelihoods) const
 {
+    const auto workers = get_workers(options_);
     const auto genotype_masks = make_genotype_masks(sample_ploidies, genotypes);
-    const auto genotype_log_likelihoods = compute_genotype_log_likelihoods(samples, genotypes, haplotype_likelihoods, genotype_masks);
+    const auto genotype_log_likelihoods = compute_genotype_log_likelihoods(samples, genotypes, haplotype_likelihoods, genotype_masks, workers);
     std::vector<std::size_t> sample_genotype_set_ids, genotype_set_sizes;
     std::tie(sample_genotype_set_ids, genotype_set_sizes) = get_genotype_sets(sample_ploidies, genotypes);
     const auto num_possible_genotype_combinations = compute_num_combinations(sample_genotype_set_ids, genotype_set_sizes);
@@ -691,11 +644,11 @@ PopulationModel::evaluate(const SampleVector& samples,
         genotype_combinations = generate_all_genotype_combinations(sample_genotype_set_ids, genotype_set_sizes);
     } else {
         const auto max_genotype_combinations = options_.max_genotype_combinations ? *options_.max_genotype_combinations : *num_possible_genotype_combinations;
-        const EMOptions em_options {options_.max_em_iterations, options_.em_epsilon};
+        const PopulationEMOptions em_options {options_.max_em_iterations, options_.em_epsilon, workers};
         const auto em_genotype_marginals = compute_approx_genotype_marginal_posteriors(haplotypes, genotypes, genotype_log_likelihoods, sample_ploidies, em_options);
-        genotype_combinations = propose_genotype_combinations(genotypes, em_genotype_marginals, max_genotype_combinations);
+        genotype_combinations = propose_genotype_combinations(genotypes, em_genotype_marginals, max_genotype_combinations, workers);
     }
-    calculate_posterior_marginals(genotypes, genotype_combinations, genotype_log_likelihoods, prior_model_, result);
+    calculate_posterior_marginals(genotypes, genotype_combinations, genotype_log_likelihoods, prior_model_, result, workers);
     return result;
 }
 
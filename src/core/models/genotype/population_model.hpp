@@ -17,6 +17,7 @@
 #include "containers/probability_matrix.hpp"
 #include "containers/mappable_block.hpp"
 #include "logging/logging.hpp"
+#include "utils/thread_pool.hpp"
 
 namespace octopus { namespace model {
 
@@ -28,6 +29,9 @@ public:
         boost::optional<std::size_t> max_genotype_combinations = boost::none;
         unsigned max_em_iterations = 100;
         double em_epsilon = 0.001;
+        ExecutionPolicy execution_policy = ExecutionPolicy::seq;
+        // Shared by all models evaluated by a caller, so EM iterations and calls reuse the same threads
+        boost::optional<ThreadPool&> workers = boost::none;
     };
     struct Latents
     {
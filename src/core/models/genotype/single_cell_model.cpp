@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <numeric>
 #include <limits>
+#include <cmath>
 
 #include "utils/k_medoids.hpp"
 #include "utils/select_top_k.hpp"
@@ -33,6 +34,12 @@ auto get_vb_model_options(const SingleCellModel::AlgorithmParameters& config)
     return result;
 }
 
+boost::optional<ThreadPool&> get_workers(const SingleCellModel::AlgorithmParameters& config) noexcept
+{
+    if (config.execution_policy == ExecutionPolicy::par) return config.workers;
+    return boost::none;
+}
+
 } // namespace
 
 SingleCellModel::SingleCellModel(std::vector<SampleName> samples,
@@ -159,11 +166,38 @@ auto l1_norm(const std::vector<double>& p, const std::vector<double>& q) noexcep
     });
 }
 
+// Same as l1_norm, but the independent partial sums let the compiler vectorise the loop
+auto unrolled_l1_norm(const std::vector<double>& p, const std::vector<double>& q) noexcept
+{
+    assert(p.size() == q.size());
+    const auto n = p.size();
+    double s0 {0}, s1 {0}, s2 {0}, s3 {0};
+    std::size_t i {0};
+    for (; i + 4 <= n; i += 4) {
+        s0 += std::abs(p[i] - q[i]);
+        s1 += std::abs(p[i + 1] - q[i + 1]);
+        s2 += std::abs(p[i + 2] - q[i + 2]);
+        s3 += std::abs(p[i + 3] - q[i + 3]);
+    }
+    for (; i < n; ++i) s0 += std::abs(p[i] - q[i]);
+    return (s0 + s1) + (s2 + s3);
+}
+
+// Above this many samples the distance matrix k_medoids builds is too costly, so clustering is done without it
+constexpr std::size_t maxExactClusteringSamples {200};
+
 ClusterVector
 cluster_samples(const std::vector<PopulationModel::Latents::ProbabilityVector>& genotype_posteriors,
-                const unsigned num_clusters)
+                const unsigned num_clusters,
+                boost::optional<ThreadPool&> workers)
 {
     ClusterVector result {};
+    if (genotype_posteriors.size() > maxExactClusteringSamples) {
+        LargeKMediodsParameters params {};
+        params.workers = workers;
+        large_k_medoids(genotype_posteriors, num_clusters, result, unrolled_l1_norm, params);
+        return result;
+    }
     KMediodsParameters params {};
     params.initialisation = KMediodsParameters::InitialisationMode::max_distance;
     auto best_fit = k_medoids(genotype_posteriors, num_clusters, result, l1_norm, params).second;
@@ -386,9 +420,9 @@ SingleCellModel::propose_genotype_combinations(const GenotypeVector& genotypes,
         if (clusters.empty()) {
             auto population_inferences = population_model.evaluate(samples_, haplotypes, genotypes, haplotype_likelihoods);
             population_genotype_posteriors = std::move(population_inferences.posteriors.marginal_genotype_probabilities);
-            clusters = cluster_samples(population_genotype_posteriors, std::max(samples_.size() / 4, 2 * num_groups));
+            clusters = cluster_samples(population_genotype_posteriors, std::max(samples_.size() / 4, 2 * num_groups), get_workers(config_));
         } else if (clusters.size() > 2 * num_groups) {
-            clusters = cluster_samples(cluster_marginal_genotype_posteriors, std::max(clusters.size() / 2, 2 * num_groups));
+            clusters = cluster_samples(cluster_marginal_genotype_posteriors, std::max(clusters.size() / 2, 2 * num_groups), get_workers(config_));
         } else {
             auto num_effective_clusters = sum_entropies(cluster_marginal_genotype_posteriors);
             if ((clusters.size() == num_groups + 1 && num_effective_clusters < num_groups / 2)
@@ -405,7 +439,7 @@ SingleCellModel::propose_genotype_combinations(const GenotypeVector& genotypes,
             if (clusters.size() <= num_groups + 1) break;
             num_effective_clusters = sum_entropies(cluster_marginal_genotype_posteriors);
             if (num_groups < 4 && clusters.size() <= num_groups + 2 && num_effective_clusters < 2) break;
-            clusters = cluster_samples(cluster_marginal_genotype_posteriors, num_groups + 1);
+            clusters = cluster_samples(cluster_marginal_genotype_posteriors, num_groups + 1, get_workers(config_));
         }
         cluster_marginal_genotype_posteriors.clear();
         std::vector<std::vector<SampleName>> next_samples_by_cluster {};
@@ -626,9 +660,9 @@ SingleCellModel::propose_genotype_combinations(const PhylogenyNodePloidyMap& phy
         if (clusters.empty()) {
             auto population_inferences = population_model.evaluate(samples_, haplotypes, genotypes, haplotype_likelihoods);
             population_genotype_posteriors = std::move(population_inferences.posteriors.marginal_genotype_probabilities);
-            clusters = cluster_samples(population_genotype_posteriors, std::max(samples_.size() / 4, 2 * num_groups));
+            clusters = cluster_samples(population_genotype_posteriors, std::max(samples_.size() / 4, 2 * num_groups), get_workers(config_));
         } else if (clusters.size() > 2 * num_groups) {
-            clusters = cluster_samples(cluster_marginal_genotype_posteriors, std::max(clusters.size() / 2, 2 * num_groups));
+            clusters = cluster_samples(cluster_marginal_genotype_posteriors, std::max(clusters.size() / 2, 2 * num_groups), get_workers(config_));
         } else {
             auto num_effective_clusters = sum_entropies(cluster_marginal_genotype_posteriors);
             if ((clusters.size() == num_groups + 1 && num_effective_clusters < num_groups / 2)
@@ -643,7 +677,7 @@ SingleCellModel::propose_genotype_combinations(const PhylogenyNodePloidyMap& phy
                 cluster_marginal_genotype_posteriors.pop_back();
             }
             if (clusters.size() <= num_groups + 1) break;
-            clusters = cluster_samples(cluster_marginal_genotype_posteriors, num_groups + 1);
+            clusters = cluster_samples(cluster_marginal_genotype_posteriors, num_groups + 1, get_workers(config_));
         }
         cluster_marginal_genotype_posteriors.clear();
         std::vector<std::vector<SampleName>> next_samples_by_cluster {};
@@ -17,6 +17,7 @@
 #include "core/types/phylogeny.hpp"
 #include "core/models/haplotype_likelihood_array.hpp"
 #include "exceptions/program_error.hpp"
+#include "utils/thread_pool.hpp"
 #include "single_cell_prior_model.hpp"
 #include "population_prior_model.hpp"
 #include "uniform_population_prior_model.hpp"
@@ -53,6 +54,8 @@ public:
         boost::optional<std::size_t> max_genotype_combinations;
         unsigned max_seeds = 20;
         ExecutionPolicy execution_policy = ExecutionPolicy::seq;
+        // Used for sample clustering when the execution policy is par
+        boost::optional<ThreadPool&> workers = boost::none;
     };
     
     struct NoViableGenotypeCombinationsError : public ProgramError
@@ -15,6 +15,8 @@
 #include <boost/iterator/transform_iterator.hpp>
 
 #include "utils/maths.hpp"
+#include "utils/append.hpp"
+#include "utils/parallel_transform.hpp"
 #include "constant_mixture_genotype_likelihood_model.hpp"
 
 namespace octopus { namespace model {
@@ -126,12 +128,35 @@ bool operator>(const ParentsProbabilityPair& lhs, const ParentsProbabilityPair&
     return lhs.probability > rhs.probability;
 }
 
+// Workers are only used when the execution policy is par
+boost::optional<ThreadPool&> get_workers(const TrioModel::Options& options) noexcept
+{
+    if (options.execution_policy == ExecutionPolicy::par) return options.workers;
+    return boost::none;
+}
+
+// Minimum sizes of the partitions evaluated in parallel
+constexpr std::size_t min_genotype_partition_size {1'000};
+constexpr std::size_t min_join_partition_size {32};
+
 auto compute_likelihoods(const TrioModel::GenotypeVector& genotypes,
-                         const ConstantMixtureGenotypeLikelihoodModel& model)
+                         const ConstantMixtureGenotypeLikelihoodModel& model,
+                         boost::optional<ThreadPool&> workers = boost::none)
 {
     std::vector<GenotypeIndexProbabilityPair> result(genotypes.size());
-    for (GenotypeIndex idx {0}; idx < static_cast<GenotypeIndex>(genotypes.size()); ++idx) {
-        result[idx] = {model.evaluate(genotypes[idx]), idx};
+    const auto compute_partition = [&] (const std::size_t first, const std::size_t last) {
+        // The likelihood model has internal buffers, so each partition needs its own copy
+        const auto partition_model = model;
+        for (auto idx = static_cast<GenotypeIndex>(first); idx < static_cast<GenotypeIndex>(last); ++idx) {
+            result[idx] = {partition_model.evaluate(genotypes[idx]), idx};
+        }
+    };
+    if (workers) {
+        parallel_for_each_partition(genotypes.size(), min_genotype_partition_size, compute_partition, *workers);
+    } else {
+        for (GenotypeIndex idx {0}; idx < static_cast<GenotypeIndex>(genotypes.size()); ++idx) {
+            result[idx] = {model.evaluate(genotypes[idx]), idx};
+        }
     }
     return result;
 }
@@ -677,36 +702,66 @@ auto joint_probability(const ParentsProbabilityPair& parents,
            + joint_probability_function(genotypes.child[child.genotype], genotypes.maternal[parents.maternal], genotypes.paternal[parents.paternal]);
 }
 
+template <typename F>
+void join(const ReducedVectorMap<ParentsProbabilityPair>& parents,
+          const ReducedVectorMap<GenotypeIndexProbabilityPair>& child,
+          const TrioGenotypeData& genotypes,
+          std::size_t first_row, const std::size_t last_row,
+          F jpdf, std::vector<JointProbability>& result)
+{
+    // The rows are the outer loop elements of the three join blocks, in join order
+    const auto num_full_join_parents = static_cast<std::size_t>(std::distance(parents.first, parents.last_full_join));
+    const auto num_parents = static_cast<std::size_t>(std::distance(parents.first, parents.last));
+    for (; first_row < last_row; ++first_row) {
+        if (first_row < num_parents) {
+            const auto& p = parents.first[first_row];
+            const auto last_child = first_row < num_full_join_parents ? child.last_full_join : child.last_to_partially_join;
+            std::for_each(child.first, last_child, [&] (const auto& c) {
+                result.push_back({joint_probability(p, c, genotypes, jpdf), 0.0, p.maternal, p.paternal, c.genotype});
+            });
+        } else {
+            const auto& c = child.last_full_join[first_row - num_parents];
+            std::for_each(parents.first, parents.last_to_partially_join, [&] (const auto& p) {
+                result.push_back({joint_probability(p, c, genotypes, jpdf), 0.0, p.maternal, p.paternal, c.genotype});
+            });
+        }
+    }
+}
+
 template <typename F>
 auto join(const ReducedVectorMap<ParentsProbabilityPair>& parents,
           const ReducedVectorMap<GenotypeIndexProbabilityPair>& child,
           const TrioGenotypeData& genotypes,
-          F jpdf)
+          const DeNovoModel& mutation_model,
+          boost::optional<ThreadPool&> workers)
 {
+    const auto num_rows = static_cast<std::size_t>(std::distance(parents.first, parents.last) + std::distance(child.last_full_join, child.last));
     std::vector<JointProbability> result {};
-    result.reserve(join_size(parents, child));
-    std::for_each(parents.first, parents.last_full_join, [&] (const auto& p) {
-        std::for_each(child.first, child.last_full_join, [&] (const auto& c) {
-            result.push_back({joint_probability(p, c, genotypes, jpdf), 0.0, p.maternal, p.paternal, c.genotype});
-        });
-    });
-    std::for_each(parents.last_full_join, parents.last, [&] (const auto& p) {
-        std::for_each(child.first, child.last_to_partially_join, [&] (const auto& c) {
-            result.push_back({joint_probability(p, c, genotypes, jpdf), 0.0, p.maternal, p.paternal, c.genotype});
-        });
-    });
-    std::for_each(child.last_full_join, child.last, [&] (const auto& c) {
-        std::for_each(parents.first, parents.last_to_partially_join, [&] (const auto& p) {
-            result.push_back({joint_probability(p, c, genotypes, jpdf), 0.0, p.maternal, p.paternal, c.genotype});
-        });
-    });
+    if (workers) {
+        // The mutation model caches are not thread-safe, so each partition needs its own copy. Partition
+        // results are concatenated in row order, so the join is the same as the sequential join.
+        auto partition_results = parallel_transform_partitions(num_rows, min_join_partition_size, [&] (const std::size_t first, const std::size_t last) {
+            const DeNovoModel partition_mutation_model {mutation_model};
+            std::vector<JointProbability> partition_result {};
+            join(parents, child, genotypes, first, last, F {partition_mutation_model}, partition_result);
+            return partition_result;
+        }, *workers);
+        result.reserve(join_size(parents, child));
+        for (auto& partition_result : partition_results) {
+            utils::append(std::move(partition_result), result);
+        }
+    } else {
+        result.reserve(join_size(parents, child));
+        join(parents, child, genotypes, 0, num_rows, F {mutation_model}, result);
+    }
     return result;
 }
 
 auto join(const ReducedVectorMap<ParentsProbabilityPair>& parents,
           const ReducedVectorMap<GenotypeIndexProbabilityPair>& child,
           const TrioGenotypeData& genotypes,
-          const DeNovoModel& mutation_model)
+          const DeNovoModel& mutation_model,
+          boost::optional<ThreadPool&> workers = boost::none)
 {
     const auto maternal_ploidy = genotypes.maternal[parents.first->maternal].ploidy();
     const auto paternal_ploidy = genotypes.paternal[parents.first->paternal].ploidy();
@@ -714,26 +769,26 @@ auto join(const ReducedVectorMap<ParentsProbabilityPair>& parents,
     if (child_ploidy == 1) {
         if (paternal_ploidy == 1) {
             if (maternal_ploidy == 0) {
-                return join(parents, child, genotypes, ProbabilityOfChildGivenParents<1, 0, 1> {mutation_model});
+                return join<ProbabilityOfChildGivenParents<1, 0, 1>>(parents, child, genotypes, mutation_model, workers);
             }
             if (maternal_ploidy == 1) {
-                return join(parents, child, genotypes, ProbabilityOfChildGivenParents<1, 1, 1> {mutation_model});
+                return join<ProbabilityOfChildGivenParents<1, 1, 1>>(parents, child, genotypes, mutation_model, workers);
             }
             if (maternal_ploidy == 2) {
-                return join(parents, child, genotypes, ProbabilityOfChildGivenParents<1, 2, 1> {mutation_model});
+                return join<ProbabilityOfChildGivenParents<1, 2, 1>>(parents, child, genotypes, mutation_model, workers);
             }
         }
     } else if (child_ploidy == 2) {
         if (maternal_ploidy == 2) {
             if (paternal_ploidy == 1) {
-                return join(parents, child, genotypes, ProbabilityOfChildGivenParents<2, 2, 1> {mutation_model});
+                return join<ProbabilityOfChildGivenParents<2, 2, 1>>(parents, child, genotypes, mutation_model, workers);
             }
             if (paternal_ploidy == 2) {
-                return join(parents, child, genotypes, ProbabilityOfChildGivenParents<2, 2, 2> {mutation_model});
+                return join<ProbabilityOfChildGivenParents<2, 2, 2>>(parents, child, genotypes, mutation_model, workers);
             }
         }
     } else if (child_ploidy == 3 && maternal_ploidy == 3 && paternal_ploidy == 3) {
-        return join(parents, child, genotypes, ProbabilityOfChildGivenParents<3, 3, 3> {mutation_model});
+        return join<ProbabilityOfChildGivenParents<3, 3, 3>>(parents, child, genotypes, mutation_model, workers);
     }
     throw std::runtime_error {"TrioModel: unimplemented joint probability function"};
 }
@@ -796,12 +851,13 @@ TrioModel::evaluate(const GenotypeVector& maternal_genotypes,
     assert(!maternal_genotypes.empty() && !paternal_genotypes.empty() && !child_genotypes.empty());
     const TrioGenotypeData genotypes {maternal_genotypes, paternal_genotypes, child_genotypes};
     const ConstantMixtureGenotypeLikelihoodModel likelihood_model {haplotype_likelihoods};
+    const auto workers = get_workers(options_);
     haplotype_likelihoods.prime(trio_.mother());
-    auto maternal_likelihoods = compute_likelihoods(genotypes.maternal, likelihood_model);
+    auto maternal_likelihoods = compute_likelihoods(genotypes.maternal, likelihood_model, workers);
     haplotype_likelihoods.prime(trio_.father());
-    auto paternal_likelihoods = compute_likelihoods(genotypes.paternal, likelihood_model);
+    auto paternal_likelihoods = compute_likelihoods(genotypes.paternal, likelihood_model, workers);
     haplotype_likelihoods.prime(trio_.child());
-    auto child_likelihoods = compute_likelihoods(genotypes.child, likelihood_model);
+    auto child_likelihoods = compute_likelihoods(genotypes.child, likelihood_model, workers);
     if (debug_log_) {
         debug::print(stream(*debug_log_), "maternal", genotypes.maternal, maternal_likelihoods);
         debug::print(stream(*debug_log_), "paternal", genotypes.paternal, paternal_likelihoods);
@@ -824,7 +880,7 @@ TrioModel::evaluate(const GenotypeVector& maternal_genotypes,
     paternal_likelihoods.shrink_to_fit();
     reduced_paternal_likelihoods.clear();
     reduced_paternal_likelihoods.shrink_to_fit();
-    auto joint_likelihoods = join(reduced_parental_likelihoods, reduced_child_likelihoods_info, genotypes, mutation_model_);
+    auto joint_likelihoods = join(reduced_parental_likelihoods, reduced_child_likelihoods_info, genotypes, mutation_model_, workers);
     if (debug_log_) debug::print(stream(*debug_log_), genotypes, joint_likelihoods);
     const auto evidence = normalise_exp(joint_likelihoods);
     if (lost_log_mass) *lost_log_mass *= 2 * std::distance(reduced_child_likelihoods_info.first, reduced_child_likelihoods_info.last_full_join);
@@ -891,11 +947,12 @@ TrioModel::evaluate_allosome(const GenotypeVector& parent_genotypes,
     assert(!parent_genotypes.empty() && !child_genotypes.empty());
     const ConstantMixtureGenotypeLikelihoodModel likelihood_model {haplotype_likelihoods};
     assert(haplotype_likelihoods.is_primed());
-    auto child_likelihoods = compute_likelihoods(child_genotypes, likelihood_model);
+    const auto workers = get_workers(options_);
+    auto child_likelihoods = compute_likelihoods(child_genotypes, likelihood_model, workers);
     if (debug_log_) debug::print(stream(*debug_log_), "child", child_genotypes, child_likelihoods);
     boost::optional<double> lost_log_mass {};
     const auto reduced_child_likelihoods = reduce(child_likelihoods, prior_model_, lost_log_mass, options_, child_genotypes);
-    auto parent_likelihoods = compute_likelihoods(parent_genotypes, likelihood_model);
+    auto parent_likelihoods = compute_likelihoods(parent_genotypes, likelihood_model, workers);
     if (debug_log_) debug::print(stream(*debug_log_), "parent", child_genotypes, parent_likelihoods);
     const auto reduced_parent_likelihoods = reduce(parent_likelihoods, prior_model_, lost_log_mass, options_, parent_genotypes);
     haplotype_likelihoods.prime(trio_.child());
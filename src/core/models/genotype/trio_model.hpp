@@ -10,6 +10,7 @@
 
 #include <boost/optional.hpp>
 
+#include "config/common.hpp"
 #include "basics/trio.hpp"
 #include "core/types/haplotype.hpp"
 #include "core/types/indexed_haplotype.hpp"
@@ -18,6 +19,7 @@
 #include "core/types/genotype.hpp"
 #include "population_prior_model.hpp"
 #include "logging/logging.hpp"
+#include "utils/thread_pool.hpp"
 
 namespace octopus { namespace model {
 
@@ -49,6 +51,9 @@ public:
     {
         boost::optional<std::size_t> max_genotype_combinations = boost::none;
         double max_individual_log_probability_loss = -1'000, max_joint_log_probability_loss = -10'000;
+        ExecutionPolicy execution_policy = ExecutionPolicy::seq;
+        // Shared by all models evaluated by a caller, so calls reuse the same threads
+        boost::optional<ThreadPool&> workers = boost::none;
     };
     
     TrioModel() = delete;
@@ -7,7 +7,10 @@
 #include <cassert>
 #include <deque>
 
+#include <boost/functional/hash.hpp>
+
 #include "utils/erase_if.hpp"
+#include "logging/logging.hpp"
 
 namespace octopus {
 
@@ -19,9 +22,7 @@ HaplotypeLikelihoodArray::HaplotypeLikelihoodArray(const unsigned num_haplotypes
 , haplotype_indices_ {num_haplotypes_hint}
 , sample_indices_ {samples.size()}
 , samples_ {samples}
-{
-    mapping_positions_.resize(maxMappingPositions);
-}
+{}
 
 HaplotypeLikelihoodArray::HaplotypeLikelihoodArray(HaplotypeLikelihoodModel likelihood_model,
                                                    unsigned num_haplotypes_hint,
@@ -31,9 +32,7 @@ HaplotypeLikelihoodArray::HaplotypeLikelihoodArray(HaplotypeLikelihoodModel like
 , haplotype_indices_ {num_haplotypes_hint}
 , sample_indices_ {samples.size()}
 , samples_ {samples}
-{
-    mapping_positions_.resize(maxMappingPositions);
-}
+{}
 
 HaplotypeLikelihoodArray::ReadPacket::ReadPacket(Iterator first, Iterator last)
 : first {first}
@@ -60,41 +59,31 @@ void HaplotypeLikelihoodArray::populate(const ReadMap& reads,
     set_read_iterators_and_sample_indices(reads);
     assert(reads.size() == read_iterators_.size());
     const auto num_samples = reads.size();
-    // Precompute all read hashes so we don't have to recompute for each haplotype
-    std::vector<std::vector<KmerPerfectHashes>> read_hashes {};
-    read_hashes.reserve(num_samples);
+    // Map each read to all haplotypes at once so the mapping isn't repeated for each haplotype
+    index_haplotypes(haplotypes);
+    rotate_likelihood_cache();
+    const HaplotypeLikelihoodModel::ScoreMemoGuard score_memo_guard {likelihood_model_};
     for (const auto& t : read_iterators_) {
-        std::vector<KmerPerfectHashes> sample_read_hashes {};
-        sample_read_hashes.reserve(t.num_reads);
-        std::transform(t.first, t.last, std::back_inserter(sample_read_hashes),
-                       [] (const AlignedRead& read) { return compute_kmer_hashes<mapperKmerSize>(read.sequence()); });
-        read_hashes.emplace_back(std::move(sample_read_hashes));
+        std::for_each(t.first, t.last, [this] (const AlignedRead& read) { map_read(read); });
     }
-    auto haplotype_hashes = init_kmer_hash_table<mapperKmerSize>();
-    const auto first_mapping_position = std::begin(mapping_positions_);
     likelihoods_.resize(haplotypes.size(), std::vector<LikelihoodVector>(num_samples));
     for (std::size_t haplotype_idx {0}; haplotype_idx < haplotypes.size(); ++haplotype_idx) {
         const auto& haplotype = haplotypes[haplotype_idx];
-        populate_kmer_hash_table<mapperKmerSize>(haplotype.sequence(), haplotype_hashes);
-        auto haplotype_mapping_counts = init_mapping_counts(haplotype_hashes);
         likelihood_model_.reset(haplotype, flank_state);
+        std::size_t read_idx {0};
         for (std::size_t sample_idx {0}; sample_idx < num_samples; ++sample_idx) {
             auto& likelihoods = likelihoods_[haplotype_idx][sample_idx];
             const auto& t = read_iterators_[sample_idx];
             likelihoods.resize(t.num_reads);
-            std::transform(t.first, t.last, std::cbegin(read_hashes[sample_idx]), std::begin(likelihoods),
-                           [&] (const AlignedRead& read, const auto& read_hashes) {
-                               const auto last_mapping_position = map_query_to_target(read_hashes, haplotype_hashes,
-                                                                                      haplotype_mapping_counts,
-                                                                                      first_mapping_position,
-                                                                                      maxMappingPositions);
-                               reset_mapping_counts(haplotype_mapping_counts);
-                               return likelihood_model_.evaluate(read, first_mapping_position, last_mapping_position);
-                           });
+            std::transform(t.first, t.last, std::begin(likelihoods), [&] (const AlignedRead& read) {
+                const auto result = evaluate(read, read_idx, read_idx * haplotypes.size() + haplotype_idx);
+                ++read_idx;
+                return result;
+            });
         }
-        clear_kmer_hash_table(haplotype_hashes);
         haplotype_indices_.emplace(haplotype, haplotype_idx);
     }
+    log_cache_stats();
     likelihood_model_.clear();
     read_iterators_.clear();
     haplotypes_ = haplotypes;
@@ -111,51 +100,36 @@ void HaplotypeLikelihoodArray::populate(const TemplateMap& reads,
     set_template_iterators_and_sample_indices(reads);
     assert(reads.size() == template_iterators_.size());
     const auto num_samples = reads.size();
-    // Precompute all read hashes so we don't have to recompute for each haplotype
-    std::vector<std::vector<std::vector<KmerPerfectHashes>>> template_hashes {};
-    template_hashes.reserve(num_samples);
+    index_haplotypes(haplotypes);
+    rotate_likelihood_cache();
+    const HaplotypeLikelihoodModel::ScoreMemoGuard score_memo_guard {likelihood_model_};
     for (const auto& t : template_iterators_) {
-        std::vector<std::vector<KmerPerfectHashes>> sample_read_hashes {};
-        sample_read_hashes.reserve(t.num_templates);
-        std::transform(t.first, t.last, std::back_inserter(sample_read_hashes), [] (const AlignedTemplate& reads) {
-            std::vector<KmerPerfectHashes> result {};
-            result.reserve(reads.size());
-            for (const auto& read : reads) result.push_back(compute_kmer_hashes<mapperKmerSize>(read.sequence()));
-            return result;
+        std::for_each(t.first, t.last, [this] (const AlignedTemplate& reads) {
+            for (const auto& read : reads) map_read(read);
         });
-        template_hashes.emplace_back(std::move(sample_read_hashes));
     }
-    auto haplotype_hashes = init_kmer_hash_table<mapperKmerSize>();
-    thread_local std::vector<HaplotypeLikelihoodModel::MappingPositionVector> mapping_positions {};
     likelihoods_.resize(haplotypes.size(), std::vector<LikelihoodVector>(num_samples));
     for (std::size_t haplotype_idx {0}; haplotype_idx < haplotypes.size(); ++haplotype_idx) {
         const auto& haplotype = haplotypes[haplotype_idx];
-        populate_kmer_hash_table<mapperKmerSize>(haplotype.sequence(), haplotype_hashes);
-        auto haplotype_mapping_counts = init_mapping_counts(haplotype_hashes);
         likelihood_model_.reset(haplotype, flank_state);
+        std::size_t read_idx {0};
         for (std::size_t sample_idx {0}; sample_idx < num_samples; ++sample_idx) {
             auto& likelihoods = likelihoods_[haplotype_idx][sample_idx];
             const auto& t = template_iterators_[sample_idx];
             likelihoods.resize(t.num_templates);
-            std::transform(t.first, t.last, std::cbegin(template_hashes[sample_idx]), std::begin(likelihoods),
-                           [&] (const AlignedTemplate& read_template, const auto& template_hashes) {
-                               mapping_positions.resize(read_template.size());
-                               assert(read_template.size() == template_hashes.size());
-                               for (std::size_t i {0}; i < template_hashes.size(); ++i) {
-                                   mapping_positions[i].resize(maxMappingPositions);
-                                   mapping_positions[i].erase(map_query_to_target(template_hashes[i], haplotype_hashes,
-                                                                                  haplotype_mapping_counts,
-                                                                                  std::begin(mapping_positions[i]),
-                                                                                  maxMappingPositions),
-                                                              std::end(mapping_positions[i]));
-                                   reset_mapping_counts(haplotype_mapping_counts);
-                               }
-                               return likelihood_model_.evaluate(read_template, mapping_positions);
-                           });
+            // Same as HaplotypeLikelihoodModel::evaluate(const AlignedTemplate&, ...) but each read can use the cache
+            std::transform(t.first, t.last, std::begin(likelihoods), [&] (const AlignedTemplate& read_template) {
+                LogProbability result {0};
+                for (const auto& read : read_template) {
+                    result += evaluate(read, read_idx, read_idx * haplotypes.size() + haplotype_idx);
+                    ++read_idx;
+                }
+                return result;
+            });
         }
-        clear_kmer_hash_table(haplotype_hashes);
         haplotype_indices_.emplace(haplotype, haplotype_idx);
     }
+    log_cache_stats();
     likelihood_model_.clear();
     read_iterators_.clear();
     haplotypes_ = haplotypes;
@@ -253,6 +227,11 @@ void HaplotypeLikelihoodArray::unprime() const noexcept
     primed_sample_ = boost::none;
 }
 
+HaplotypeLikelihoodArray::LikelihoodCacheStats HaplotypeLikelihoodArray::likelihood_cache_stats() const noexcept
+{
+    return {num_likelihood_cache_hits_, num_likelihood_cache_misses_};
+}
+
 // private methods
 
 void HaplotypeLikelihoodArray::set_read_iterators_and_sample_indices(const ReadMap& reads)
@@ -291,6 +270,128 @@ void HaplotypeLikelihoodArray::set_template_iterators_and_sample_indices(const T
     }
 }
 
+void HaplotypeLikelihoodArray::index_haplotypes(const MappableBlock<Haplotype>& haplotypes)
+{
+    TargetSequenceRefs haplotype_sequences {};
+    haplotype_sequences.reserve(haplotypes.size());
+    for (const auto& haplotype : haplotypes) haplotype_sequences.emplace_back(haplotype.sequence());
+    populate_kmer_hash_table<mapperKmerSize>(haplotype_sequences, haplotype_kmers_);
+    mapping_counts_ = init_mapping_counts(haplotype_kmers_);
+    mapping_offsets_.assign(1, 0);
+    mapping_positions_.clear();
+    read_keys_.clear();
+}
+
+namespace {
+
+// Everything about a read the likelihood model uses
+std::size_t hash_likelihood_evidence(const AlignedRead& read)
+{
+    using boost::hash_combine;
+    std::size_t result {std::hash<AlignedRead::NucleotideSequence>()(read.sequence())};
+    hash_combine(result, boost::hash_range(std::cbegin(read.base_qualities()), std::cend(read.base_qualities())));
+    hash_combine(result, read.mapping_quality());
+    hash_combine(result, read.is_marked_reverse_mapped());
+    return result;
+}
+
+} // namespace
+
+void HaplotypeLikelihoodArray::map_read(const AlignedRead& read)
+{
+    read_keys_.push_back(hash_likelihood_evidence(read));
+    compute_kmer_hashes<mapperKmerSize>(read.sequence(), read_hashes_);
+    map_query_to_targets(read_hashes_, haplotype_kmers_, mapping_counts_,
+                         [this] (std::size_t, auto first_position, auto last_position) {
+                             mapping_positions_.insert(std::cend(mapping_positions_), first_position, last_position);
+                             mapping_offsets_.push_back(static_cast<std::uint32_t>(mapping_positions_.size()));
+                         }, maxMappingPositions);
+}
+
+HaplotypeLikelihoodModel::MappingPositionItr
+HaplotypeLikelihoodArray::mapping_position(const std::size_t mapping_index) const noexcept
+{
+    return std::next(std::cbegin(mapping_positions_), mapping_offsets_[mapping_index]);
+}
+
+void HaplotypeLikelihoodArray::rotate_likelihood_cache() noexcept
+{
+    std::swap(likelihood_cache_, previous_likelihood_cache_);
+    likelihood_cache_.clear();
+    likelihood_cache_bytes_ = 0;
+    num_likelihood_cache_hits_ = 0;
+    num_likelihood_cache_misses_ = 0;
+}
+
+namespace {
+
+template <typename CachedLikelihood>
+bool is_cached(const CachedLikelihood& cached, const AlignedRead& read,
+               const std::size_t read_key, const std::size_t evaluation_key) noexcept
+{
+    return cached.read_key == read_key && cached.evaluation_key == evaluation_key
+        && cached.read_begin == mapped_begin(read) && cached.read_name == read.name();
+}
+
+template <typename Cache>
+std::size_t cache_footprint(const typename Cache::value_type& entry) noexcept
+{
+    // Node, bucket, and name buffer if not stored inline
+    std::size_t result {sizeof(typename Cache::value_type) + 3 * sizeof(void*)};
+    if (entry.second.read_name.capacity() > std::string {}.capacity()) {
+        result += entry.second.read_name.capacity() + 1;
+    }
+    return result;
+}
+
+} // namespace
+
+HaplotypeLikelihoodArray::LogProbability
+HaplotypeLikelihoodArray::evaluate(const AlignedRead& read, const std::size_t read_index, const std::size_t mapping_index)
+{
+    const auto first_mapping_position = mapping_position(mapping_index);
+    const auto last_mapping_position = mapping_position(mapping_index + 1);
+    const auto evaluation_key = likelihood_model_.evaluation_key(read, first_mapping_position, last_mapping_position);
+    if (!evaluation_key) {
+        return likelihood_model_.evaluate(read, first_mapping_position, last_mapping_position);
+    }
+    const auto read_key = read_keys_[read_index];
+    auto key = read_key;
+    boost::hash_combine(key, *evaluation_key);
+    const auto cached_itr = likelihood_cache_.find(key);
+    if (cached_itr != std::cend(likelihood_cache_) && is_cached(cached_itr->second, read, read_key, *evaluation_key)) {
+        ++num_likelihood_cache_hits_;
+        return cached_itr->second.likelihood;
+    }
+    LogProbability result;
+    const auto previous_itr = previous_likelihood_cache_.find(key);
+    if (previous_itr != std::cend(previous_likelihood_cache_) && is_cached(previous_itr->second, read, read_key, *evaluation_key)) {
+        ++num_likelihood_cache_hits_;
+        result = previous_itr->second.likelihood;
+    } else {
+        ++num_likelihood_cache_misses_;
+        result = likelihood_model_.evaluate(read, first_mapping_position, last_mapping_position);
+    }
+    if (cached_itr == std::cend(likelihood_cache_) && likelihood_cache_bytes_ < maxLikelihoodCacheBytes / 2) {
+        const auto inserted = likelihood_cache_.emplace(key, CachedLikelihood {read.name(), mapped_begin(read), read_key, *evaluation_key, result});
+        likelihood_cache_bytes_ += cache_footprint<LikelihoodCache>(*inserted.first);
+    }
+    return result;
+}
+
+void HaplotypeLikelihoodArray::log_cache_stats() const
+{
+    static auto debug_log = logging::get_debug_log();
+    if (debug_log) {
+        const auto num_lookups = num_likelihood_cache_hits_ + num_likelihood_cache_misses_;
+        stream(*debug_log) << "Reused " << num_likelihood_cache_hits_ << " of " << num_lookups
+                           << " read-haplotype likelihoods from haplotypes unchanged around the read";
+        const auto memo_stats = likelihood_model_.score_memo_stats();
+        stream(*debug_log) << "Saved " << memo_stats.hits << " of " << (memo_stats.hits + memo_stats.evaluations)
+                           << " pair-HMM evaluations with identical haplotype windows";
+    }
+}
+
 void HaplotypeLikelihoodArray::reset(MappableBlock<Haplotype> haplotypes)
 {
     assert(haplotypes.size() <= haplotypes_.size());
@@ -12,6 +12,8 @@
 #include <iostream>
 #include <iomanip>
 #include <limits>
+#include <string>
+#include <cstdint>
 
 #include <boost/optional.hpp>
 
@@ -44,6 +46,11 @@ public:
     using HaplotypeRef         = std::reference_wrapper<const Haplotype>;
     using SampleLikelihoodMap  = std::unordered_map<HaplotypeRef, LikelihoodVectorRef>;
     
+    struct LikelihoodCacheStats
+    {
+        std::size_t hits, misses;
+    };
+    
     HaplotypeLikelihoodArray() = default;
     
     HaplotypeLikelihoodArray(unsigned num_haplotypes_hint, const std::vector<SampleName>& samples);
@@ -94,9 +101,13 @@ public:
     HaplotypeLikelihoodArray merge_samples(const std::vector<SampleName>& samples, boost::optional<SampleName> new_sample = boost::none) const;
     HaplotypeLikelihoodArray merge_samples(boost::optional<SampleName> new_sample = boost::none) const;
     
+    // Likelihoods reused from previous populations by the last population
+    LikelihoodCacheStats likelihood_cache_stats() const noexcept;
+    
 private:
     static constexpr unsigned char mapperKmerSize {6};
     static constexpr std::size_t maxMappingPositions {10};
+    static constexpr std::size_t maxLikelihoodCacheBytes {64'000'000}; // shared by both populations' caches
     
     HaplotypeLikelihoodModel likelihood_model_;
     
@@ -126,10 +137,37 @@ private:
     // Just to optimise population
     std::vector<ReadPacket> read_iterators_;
     std::vector<TemplatePacket> template_iterators_;
+    MultiKmerHashTable haplotype_kmers_;
+    MultiMappedIndexCounts mapping_counts_;
+    KmerPerfectHashes read_hashes_;
+    std::vector<std::uint32_t> mapping_offsets_; // by read, then haplotype
     std::vector<std::size_t> mapping_positions_;
+    std::vector<std::size_t> read_keys_;
+    
+    // Likelihoods from this and the previous population, keyed by read and model evaluation key, so
+    // reads are not re-evaluated against haplotypes that are unchanged around them. Entries not used
+    // by a population are dropped by the next one. Unlike the likelihoods, these survive clear().
+    // The read identity and both hashes are stored with each likelihood so a hash collision is a miss.
+    struct CachedLikelihood
+    {
+        std::string read_name;
+        GenomicRegion::Position read_begin;
+        std::size_t read_key, evaluation_key;
+        LogProbability likelihood;
+    };
+    using LikelihoodCache = std::unordered_map<std::size_t, CachedLikelihood>;
+    LikelihoodCache likelihood_cache_, previous_likelihood_cache_;
+    std::size_t likelihood_cache_bytes_ = 0;
+    std::size_t num_likelihood_cache_hits_ = 0, num_likelihood_cache_misses_ = 0;
     
     void set_read_iterators_and_sample_indices(const ReadMap& reads);
     void set_template_iterators_and_sample_indices(const TemplateMap& reads);
+    void index_haplotypes(const MappableBlock<Haplotype>& haplotypes);
+    void map_read(const AlignedRead& read);
+    HaplotypeLikelihoodModel::MappingPositionItr mapping_position(std::size_t mapping_index) const noexcept;
+    void rotate_likelihood_cache() noexcept;
+    LogProbability evaluate(const AlignedRead& read, std::size_t read_index, std::size_t mapping_index);
+    void log_cache_stats() const;
 };
 
 // non-member methods
@@ -8,6 +8,8 @@
 #include <limits>
 #include <cassert>
 
+#include <boost/functional/hash.hpp>
+
 #include "core/models/error/error_model_factory.hpp"
 #include "concepts/mappable.hpp"
 #include "utils/maths.hpp"
@@ -75,6 +77,7 @@ void HaplotypeLikelihoodModel::reset(const Haplotype& haplotype, boost::optional
     if (indel_error_model_) {
         indel_error_model_->set_penalties(haplotype, haplotype_gap_open_penalities_, haplotype_gap_extend_penalities_);
     }
+    set_window_hashes();
 }
 
 void HaplotypeLikelihoodModel::clear() noexcept
@@ -83,6 +86,36 @@ void HaplotypeLikelihoodModel::clear() noexcept
     haplotype_flank_state_ = boost::none;
 }
 
+void HaplotypeLikelihoodModel::clear_caches() noexcept
+{
+    clear();
+    if (indel_error_model_) indel_error_model_->clear();
+    score_memo_.clear();
+    score_memo_stats_ = {0, 0};
+}
+
+void HaplotypeLikelihoodModel::enable_score_memo(const bool enable) noexcept
+{
+    use_score_memo_ = enable;
+    score_memo_.clear();
+    score_memo_stats_ = {0, 0};
+}
+
+HaplotypeLikelihoodModel::ScoreMemoStats HaplotypeLikelihoodModel::score_memo_stats() const noexcept
+{
+    return score_memo_stats_;
+}
+
+HaplotypeLikelihoodModel::ScoreMemoGuard::ScoreMemoGuard(HaplotypeLikelihoodModel& model) : model_ {model}
+{
+    model_.enable_score_memo();
+}
+
+HaplotypeLikelihoodModel::ScoreMemoGuard::~ScoreMemoGuard()
+{
+    model_.enable_score_memo(false);
+}
+
 HaplotypeLikelihoodModel::HaplotypeLikelihoodModel()
 : HaplotypeLikelihoodModel {make_snv_error_model(), make_indel_error_model(), Config {}} {}
 
@@ -134,6 +167,9 @@ HaplotypeLikelihoodModel::HaplotypeLikelihoodModel(const HaplotypeLikelihoodMode
     haplotype_snv_reverse_priors_ = other.haplotype_snv_reverse_priors_;
     haplotype_gap_open_penalities_ = other.haplotype_gap_open_penalities_;
     haplotype_gap_extend_penalities_ = other.haplotype_gap_extend_penalities_;
+    haplotype_forward_window_hashes_ = other.haplotype_forward_window_hashes_;
+    haplotype_reverse_window_hashes_ = other.haplotype_reverse_window_hashes_;
+    window_hash_powers_ = other.window_hash_powers_;
     config_ = other.config_;
     hmm_ = other.hmm_;
 }
@@ -160,8 +196,15 @@ void swap(HaplotypeLikelihoodModel& lhs, HaplotypeLikelihoodModel& rhs) noexcept
     swap(lhs.haplotype_snv_reverse_priors_, rhs.haplotype_snv_reverse_priors_);
     swap(lhs.haplotype_gap_open_penalities_, rhs.haplotype_gap_open_penalities_);
     swap(lhs.haplotype_gap_extend_penalities_, rhs.haplotype_gap_extend_penalities_);
+    swap(lhs.haplotype_forward_window_hashes_, rhs.haplotype_forward_window_hashes_);
+    swap(lhs.haplotype_reverse_window_hashes_, rhs.haplotype_reverse_window_hashes_);
+    swap(lhs.window_hash_powers_, rhs.window_hash_powers_);
     swap(lhs.config_, rhs.config_);
     swap(lhs.hmm_, rhs.hmm_);
+    swap(lhs.evaluation_positions_, rhs.evaluation_positions_);
+    swap(lhs.use_score_memo_, rhs.use_score_memo_);
+    swap(lhs.score_memo_, rhs.score_memo_);
+    swap(lhs.score_memo_stats_, rhs.score_memo_stats_);
 }
 
 bool HaplotypeLikelihoodModel::can_use_flank_state() const noexcept
@@ -208,34 +251,30 @@ bool is_in_range(const std::size_t mapping_position, const AlignedRead& read, co
 
 } // namespace
 
+// The positions evaluate scores the read at: the in-range mapping positions and the original mapping
+// position, or the original mapping position shifted into range if none are in range
 template <typename InputIt, typename pHMM>
-HaplotypeLikelihoodModel::LogProbability
-max_score(const AlignedRead& read, const Haplotype& haplotype,
-          InputIt first_mapping_position, InputIt last_mapping_position,
-          const pHMM& hmm)
+void select_evaluation_positions(const AlignedRead& read, const Haplotype& haplotype,
+                                 InputIt first_mapping_position, InputIt last_mapping_position,
+                                 const pHMM& hmm, HaplotypeLikelihoodModel::MappingPositionVector& result)
 {
     assert(contains(haplotype, read));
-    using LogProbability = HaplotypeLikelihoodModel::LogProbability;
     using PositionType = typename std::iterator_traits<InputIt>::value_type;
     const auto original_mapping_position = static_cast<PositionType>(begin_distance(haplotype, read));
-    auto max_log_probability = std::numeric_limits<LogProbability>::lowest();
-    bool is_original_position_mapped {false}, has_in_range_mapping_position {false};
+    result.clear();
+    bool is_original_position_mapped {false};
     std::for_each(first_mapping_position, last_mapping_position, [&] (const auto position) {
         if (position == original_mapping_position) {
             is_original_position_mapped = true;
         }
         if (is_in_range(position, read, haplotype, hmm)) {
-            has_in_range_mapping_position = true;
-            auto p = hmm.evaluate(read.sequence(), haplotype.sequence(), read.base_qualities(), position);
-            max_log_probability = std::max(static_cast<LogProbability>(p), max_log_probability);
+            result.push_back(position);
         }
     });
     if (!is_original_position_mapped && is_in_range(original_mapping_position, read, haplotype, hmm)) {
-        has_in_range_mapping_position = true;
-        auto p = hmm.evaluate(read.sequence(), haplotype.sequence(), read.base_qualities(), original_mapping_position);
-        max_log_probability = std::max(static_cast<LogProbability>(p), max_log_probability);
+        result.push_back(original_mapping_position);
     }
-    if (!has_in_range_mapping_position) {
+    if (result.empty()) {
         const auto min_shift = num_out_of_range_bases(original_mapping_position, read, haplotype, hmm);
         auto final_mapping_position = original_mapping_position;
         if (min_shift > 0) {
@@ -252,7 +291,22 @@ max_score(const AlignedRead& read, const Haplotype& haplotype,
                 throw HaplotypeLikelihoodModel::ShortHaplotypeError {haplotype, required_extension};
             }
         }
-        max_log_probability = hmm.evaluate(read.sequence(), haplotype.sequence(), read.base_qualities(), final_mapping_position);
+        result.push_back(final_mapping_position);
+    }
+}
+
+template <typename InputIt, typename pHMM, typename ScoreFunction>
+HaplotypeLikelihoodModel::LogProbability
+max_score(const AlignedRead& read, const Haplotype& haplotype,
+          InputIt first_mapping_position, InputIt last_mapping_position,
+          const pHMM& hmm, HaplotypeLikelihoodModel::MappingPositionVector& evaluation_positions,
+          ScoreFunction score)
+{
+    using LogProbability = HaplotypeLikelihoodModel::LogProbability;
+    select_evaluation_positions(read, haplotype, first_mapping_position, last_mapping_position, hmm, evaluation_positions);
+    auto max_log_probability = std::numeric_limits<LogProbability>::lowest();
+    for (const auto position : evaluation_positions) {
+        max_log_probability = std::max(score(position), max_log_probability);
     }
     assert(max_log_probability > std::numeric_limits<LogProbability>::lowest() && max_log_probability <= 0);
     return max_log_probability;
@@ -281,7 +335,9 @@ HaplotypeLikelihoodModel::evaluate(const AlignedRead& read,
         model.rhs_flank_size = 0;
     }
     hmm_.set(model);
-    const auto ln_prob_given_mapped = max_score(read, *haplotype_, first_mapping_position, last_mapping_position, hmm_);
+    const auto ln_prob_given_mapped = max_score(read, *haplotype_, first_mapping_position, last_mapping_position, hmm_,
+                                                evaluation_positions_,
+                                                [&] (const auto position) { return this->score(read, position); });
     if (config_.use_mapping_quality) {
         // This calculation is approximately
         // p(read | hap) = p(read missmapped) p(read | hap, missmapped)
@@ -319,6 +375,25 @@ HaplotypeLikelihoodModel::evaluate(const AlignedTemplate& reads, const std::vect
                               { return this->evaluate(read, mapping_positions); });
 }
 
+boost::optional<std::size_t>
+HaplotypeLikelihoodModel::evaluation_key(const AlignedRead& read,
+                                         MappingPositionItr first_mapping_position,
+                                         MappingPositionItr last_mapping_position) const
+{
+    if (haplotype_ == nullptr) {
+        throw std::runtime_error {"HaplotypeLikelihoodModel: no buffered Haplotype"};
+    }
+    if (haplotype_forward_window_hashes_.empty()) return boost::none;
+    select_evaluation_positions(read, *haplotype_, first_mapping_position, last_mapping_position, hmm_, evaluation_positions_);
+    // The score is the maximum over positions, so the order doesn't matter
+    std::sort(std::begin(evaluation_positions_), std::end(evaluation_positions_));
+    std::size_t result {0};
+    for (const auto position : evaluation_positions_) {
+        boost::hash_combine(result, hash_window(read, position));
+    }
+    return result;
+}
+
 HaplotypeLikelihoodModel::Alignment
 HaplotypeLikelihoodModel::align(const AlignedRead& read) const
 {
@@ -430,6 +505,124 @@ HaplotypeLikelihoodModel::align(const AlignedRead& read, MappingPositionItr firs
     return result;
 }
 
+// private methods
+
+namespace {
+
+// Polynomial hashing modulo the Mersenne prime 2^61 - 1
+constexpr std::uint64_t windowHashModulus {(std::uint64_t {1} << 61) - 1};
+constexpr std::uint64_t windowHashBase {0x9e3779b97f4a7c15 % windowHashModulus};
+
+std::uint64_t multiply_mod(const std::uint64_t lhs, const std::uint64_t rhs) noexcept
+{
+    const auto product = static_cast<unsigned __int128>(lhs) * rhs;
+    auto result = (static_cast<std::uint64_t>(product) & windowHashModulus) + static_cast<std::uint64_t>(product >> 61);
+    if (result >= windowHashModulus) result -= windowHashModulus;
+    return result;
+}
+
+template <typename T>
+std::uint64_t to_site_bits(const T value) noexcept
+{
+    return static_cast<std::uint8_t>(value);
+}
+
+// Sites are encoded injectively into 40 bits, so below the modulus
+std::uint64_t site_hash(const char base, const char snv_mask, const hmm::Penalty snv_prior,
+                        const hmm::Penalty gap_open, const hmm::Penalty gap_extend) noexcept
+{
+    return 1 + (to_site_bits(base) | to_site_bits(snv_mask) << 8 | to_site_bits(snv_prior) << 16
+                | to_site_bits(gap_open) << 24 | to_site_bits(gap_extend) << 32);
+}
+
+void set_prefix_hashes(const Haplotype::NucleotideSequence& sequence,
+                       const std::vector<char>& snv_mask, const std::vector<hmm::Penalty>& snv_priors,
+                       const std::vector<hmm::Penalty>& gap_open, const std::vector<hmm::Penalty>& gap_extend,
+                       std::vector<std::uint64_t>& result)
+{
+    result.resize(sequence.size() + 1);
+    result.front() = 0;
+    for (std::size_t i {0}; i < sequence.size(); ++i) {
+        result[i + 1] = multiply_mod(result[i], windowHashBase) + site_hash(sequence[i], snv_mask[i], snv_priors[i], gap_open[i], gap_extend[i]);
+        if (result[i + 1] >= windowHashModulus) result[i + 1] -= windowHashModulus;
+    }
+}
+
+} // namespace
+
+void HaplotypeLikelihoodModel::set_window_hashes()
+{
+    const auto& sequence = haplotype_->sequence();
+    const auto n = sequence.size();
+    if (haplotype_snv_forward_mask_.size() != n || haplotype_snv_reverse_mask_.size() != n
+        || haplotype_snv_forward_priors_.size() != n || haplotype_snv_reverse_priors_.size() != n
+        || haplotype_gap_open_penalities_.size() != n || haplotype_gap_extend_penalities_.size() != n) {
+        haplotype_forward_window_hashes_.clear();
+        haplotype_reverse_window_hashes_.clear();
+        return;
+    }
+    set_prefix_hashes(sequence, haplotype_snv_forward_mask_, haplotype_snv_forward_priors_,
+                      haplotype_gap_open_penalities_, haplotype_gap_extend_penalities_, haplotype_forward_window_hashes_);
+    set_prefix_hashes(sequence, haplotype_snv_reverse_mask_, haplotype_snv_reverse_priors_,
+                      haplotype_gap_open_penalities_, haplotype_gap_extend_penalities_, haplotype_reverse_window_hashes_);
+    if (window_hash_powers_.empty()) window_hash_powers_.push_back(1);
+    while (window_hash_powers_.size() <= n) {
+        window_hash_powers_.push_back(multiply_mod(window_hash_powers_.back(), windowHashBase));
+    }
+}
+
+std::size_t HaplotypeLikelihoodModel::ScoreMemoKeyHash::operator()(const ScoreMemoKey& key) const noexcept
+{
+    std::size_t result {std::hash<const AlignedRead*>()(key.read)};
+    boost::hash_combine(result, key.window);
+    return result;
+}
+
+HaplotypeLikelihoodModel::LogProbability
+HaplotypeLikelihoodModel::score(const AlignedRead& read, const MappingPosition mapping_position) const
+{
+    if (!use_score_memo_ || haplotype_forward_window_hashes_.empty()) {
+        return hmm_.evaluate(read.sequence(), haplotype_->sequence(), read.base_qualities(), mapping_position);
+    }
+    const ScoreMemoKey key {std::addressof(read), hash_window(read, mapping_position)};
+    const auto memo_itr = score_memo_.find(key);
+    if (memo_itr != std::cend(score_memo_)) {
+        ++score_memo_stats_.hits;
+        return memo_itr->second;
+    }
+    ++score_memo_stats_.evaluations;
+    const LogProbability result {hmm_.evaluate(read.sequence(), haplotype_->sequence(), read.base_qualities(), mapping_position)};
+    score_memo_.emplace(key, result);
+    return result;
+}
+
+// The alignment at a mapping position only depends on the haplotype band around the read, and on
+// where the flanks start relative to it
+std::uint64_t HaplotypeLikelihoodModel::hash_window(const AlignedRead& read, const MappingPosition mapping_position) const noexcept
+{
+    const auto& prefix_hashes = read.is_marked_reverse_mapped() ? haplotype_reverse_window_hashes_ : haplotype_forward_window_hashes_;
+    const auto pad = static_cast<std::size_t>(hmm_.band_size());
+    const auto window_begin = mapping_position - pad;
+    const auto window_end = std::min(mapping_position + sequence_size(read) + pad, prefix_hashes.size() - 1);
+    const auto window_size = window_end - window_begin;
+    auto result = prefix_hashes[window_end] + windowHashModulus
+                  - multiply_mod(prefix_hashes[window_begin], window_hash_powers_[window_size]);
+    if (result >= windowHashModulus) result -= windowHashModulus;
+    using SignedPosition = std::int64_t;
+    SignedPosition lhs_flank {0}, rhs_flank_begin {static_cast<SignedPosition>(prefix_hashes.size() - 1)};
+    if (haplotype_flank_state_) {
+        lhs_flank = haplotype_flank_state_->lhs_flank;
+        rhs_flank_begin -= haplotype_flank_state_->rhs_flank;
+    }
+    const auto lhs_flank_overlap = std::max(lhs_flank - static_cast<SignedPosition>(window_begin), SignedPosition {0});
+    const auto rhs_flank_offset = std::min(rhs_flank_begin - static_cast<SignedPosition>(window_begin),
+                                           static_cast<SignedPosition>(window_size));
+    std::size_t key {result};
+    boost::hash_combine(key, lhs_flank_overlap);
+    boost::hash_combine(key, rhs_flank_offset);
+    return key;
+}
+
 HaplotypeLikelihoodModel make_haplotype_likelihood_model(const std::string label, bool use_mapping_quality)
 {
     HaplotypeLikelihoodModel::Config config {};
@@ -11,6 +11,7 @@
 #include <algorithm>
 #include <functional>
 #include <memory>
+#include <unordered_map>
 #include <stdexcept>
 
 #include <boost/optional.hpp>
@@ -49,6 +50,7 @@ public:
     };
     
     class ShortHaplotypeError;
+    class ScoreMemoGuard;
     
     using MappingPosition       = std::size_t;
     using MappingPositionVector = std::vector<MappingPosition>;
@@ -61,6 +63,11 @@ public:
         LogProbability likelihood;
     };
     
+    struct ScoreMemoStats
+    {
+        std::size_t hits, evaluations;
+    };
+    
     HaplotypeLikelihoodModel();
     HaplotypeLikelihoodModel(Config config);
     HaplotypeLikelihoodModel(std::unique_ptr<SnvErrorModel> snv_model,
@@ -89,6 +96,16 @@ public:
     
     void clear() noexcept;
     
+    // Clears the current haplotype and all state cached from previously evaluated haplotypes and reads
+    void clear_caches() noexcept;
+    
+    // While enabled, pair-HMM scores are memoised by read and haplotype window, so a read is only
+    // aligned once to each distinct window across all buffered haplotypes. The evaluated reads must
+    // stay alive and not move until the memo is disabled, which clears it. Prefer ScoreMemoGuard,
+    // which also disables the memo if evaluation throws.
+    void enable_score_memo(bool enable = true) noexcept;
+    ScoreMemoStats score_memo_stats() const noexcept;
+    
     // ln p(read | haplotype, model)
     LogProbability evaluate(const AlignedRead& read) const;
     LogProbability evaluate(const AlignedRead& read, const MappingPositionVector& mapping_positions) const;
@@ -98,6 +115,14 @@ public:
     LogProbability evaluate(const AlignedTemplate& reads) const;
     LogProbability evaluate(const AlignedTemplate& reads, const std::vector<MappingPositionVector>& mapping_positions) const;
     
+    // A key such that evaluate(read, first_mapping_position, last_mapping_position) gives the same
+    // likelihood for any buffered haplotype with the same key. It covers the haplotype sequence, error
+    // model parameters, and flank boundaries in each alignment window the evaluation would use, so
+    // haplotypes that only differ outside these windows share keys. Keys are hashes so may collide.
+    boost::optional<std::size_t> evaluation_key(const AlignedRead& read,
+                                                MappingPositionItr first_mapping_position,
+                                                MappingPositionItr last_mapping_position) const;
+    
     Alignment align(const AlignedRead& read) const;
     Alignment align(const AlignedRead& read, const MappingPositionVector& mapping_positions) const;
     Alignment align(const AlignedRead& read, MappingPositionItr first_mapping_position, MappingPositionItr last_mapping_position) const;
@@ -116,8 +141,36 @@ private:
     std::vector<Penalty> haplotype_snv_forward_priors_, haplotype_snv_reverse_priors_;
     
     std::vector<Penalty> haplotype_gap_open_penalities_, haplotype_gap_extend_penalities_;
+    
+    // Prefix hashes of the haplotype sequence and strand specific error model parameters
+    std::vector<std::uint64_t> haplotype_forward_window_hashes_, haplotype_reverse_window_hashes_;
+    std::vector<std::uint64_t> window_hash_powers_;
+    
     Config config_;
     mutable HMM hmm_;
+    mutable MappingPositionVector evaluation_positions_;
+    
+    struct ScoreMemoKey
+    {
+        const AlignedRead* read;
+        std::uint64_t window;
+        friend bool operator==(const ScoreMemoKey& lhs, const ScoreMemoKey& rhs) noexcept
+        {
+            return lhs.read == rhs.read && lhs.window == rhs.window;
+        }
+    };
+    struct ScoreMemoKeyHash
+    {
+        std::size_t operator()(const ScoreMemoKey& key) const noexcept;
+    };
+    
+    bool use_score_memo_ = false;
+    mutable std::unordered_map<ScoreMemoKey, LogProbability, ScoreMemoKeyHash> score_memo_;
+    mutable ScoreMemoStats score_memo_stats_ = {0, 0};
+    
+    void set_window_hashes();
+    std::uint64_t hash_window(const AlignedRead& read, MappingPosition mapping_position) const noexcept;
+    LogProbability score(const AlignedRead& read, MappingPosition mapping_position) const;
 };
 
 class HaplotypeLikelihoodModel::ShortHaplotypeError : public std::runtime_error
@@ -138,6 +191,25 @@ private:
     Length required_extension_;
 };
 
+// Enables the score memo of a model for the lifetime of the guard
+class HaplotypeLikelihoodModel::ScoreMemoGuard
+{
+public:
+    ScoreMemoGuard() = delete;
+    
+    ScoreMemoGuard(HaplotypeLikelihoodModel& model);
+    
+    ScoreMemoGuard(const ScoreMemoGuard&)            = delete;
+    ScoreMemoGuard& operator=(const ScoreMemoGuard&) = delete;
+    ScoreMemoGuard(ScoreMemoGuard&&)                 = delete;
+    ScoreMemoGuard& operator=(ScoreMemoGuard&&)      = delete;
+    
+    ~ScoreMemoGuard();
+    
+private:
+    HaplotypeLikelihoodModel& model_;
+};
+
 HaplotypeLikelihoodModel make_haplotype_likelihood_model(const std::string label, bool use_mapping_quality = true);
 
 } // namespace octopus
@@ -173,8 +173,68 @@ auto coalescent(const unsigned n, const unsigned k_snp, const unsigned k_indel,
     return result;
 }
 
+detail::SharedCoalescentTable& shared_coalescent_table()
+{
+    static detail::SharedCoalescentTable result {};
+    return result;
+}
+
+auto shared_coalescent(const unsigned n, const unsigned k_snp, const unsigned k_indel,
+                       const double theta_snp, const double theta_indel)
+{
+    return shared_coalescent_table().get(n, k_snp, k_indel, theta_snp, theta_indel);
+}
+
 } // namespace
 
+namespace detail {
+
+CoalescentModel::LogProbability
+coalescent_log_probability(const unsigned n, const unsigned k_snp, const unsigned k_indel,
+                           const double theta_snp, const double theta_indel)
+{
+    return coalescent(n, k_snp, k_indel, theta_snp, theta_indel);
+}
+
+SharedCoalescentTable::SharedCoalescentTable(const std::size_t max_size)
+: max_size_ {max_size}
+{}
+
+SharedCoalescentTable::LogProbability
+SharedCoalescentTable::get(const unsigned n, const unsigned k_snp, const unsigned k_indel,
+                           const double theta_snp, const double theta_indel)
+{
+    const Key key {n, k_snp, k_indel, theta_snp, theta_indel};
+    auto& shard = shards_[KeyHash {}(key) % numShards];
+    {
+        std::lock_guard<std::mutex> lock {shard.mutex};
+        const auto itr = shard.table.find(key);
+        if (itr != std::cend(shard.table)) {
+            ++hits_;
+            return itr->second;
+        }
+    }
+    ++misses_;
+    const auto result = coalescent_log_probability(n, k_snp, k_indel, theta_snp, theta_indel);
+    if (size_ < max_size_) {
+        std::lock_guard<std::mutex> lock {shard.mutex};
+        if (shard.table.emplace(key, result).second) ++size_;
+    }
+    return result;
+}
+
+CoalescentModel::SharedTableStats SharedCoalescentTable::stats() const noexcept
+{
+    return {hits_.load(), misses_.load(), size_.load()};
+}
+
+} // namespace detail
+
+CoalescentModel::SharedTableStats CoalescentModel::shared_table_stats() noexcept
+{
+    return shared_coalescent_table().stats();
+}
+
 CoalescentModel::LogProbability CoalescentModel::evaluate(const SiteCountTuple& t) const
 {
     unsigned k_snp, k_indel, n;
@@ -192,7 +252,7 @@ CoalescentModel::LogProbability CoalescentModel::evaluate(const unsigned k_snp,
         if (k_indel_zero_result_cache_[n].size() > k_snp) {
             auto& result = k_indel_zero_result_cache_[n][k_snp];
             if (!result) {
-                result = coalescent(n, k_snp, 0, params_.snp_heterozygosity, params_.indel_heterozygosity);
+                result = shared_coalescent(n, k_snp, 0, params_.snp_heterozygosity, params_.indel_heterozygosity);
             }
             return *result;
         } else {
@@ -202,7 +262,7 @@ CoalescentModel::LogProbability CoalescentModel::evaluate(const unsigned k_snp,
         k_indel_zero_result_cache_.resize(n + 1);
         k_indel_zero_result_cache_[n].assign(k_snp + 1, boost::none);
     }
-    const auto result = coalescent(n, k_snp, 0, params_.snp_heterozygosity, params_.indel_heterozygosity);
+    const auto result = shared_coalescent(n, k_snp, 0, params_.snp_heterozygosity, params_.indel_heterozygosity);
     k_indel_zero_result_cache_[n][k_snp] = result;
     return result;
 }
@@ -210,12 +270,13 @@ CoalescentModel::LogProbability CoalescentModel::evaluate(const unsigned k_snp,
 CoalescentModel::LogProbability CoalescentModel::evaluate(const unsigned k_snp, const unsigned k_indel, const unsigned n) const
 {
     const auto indel_heterozygosity = calculate_buffered_indel_heterozygosity();
-    const auto t = std::make_tuple(k_snp, k_indel, n, maths::round_sf(indel_heterozygosity, 6));
+    const auto rounded_indel_heterozygosity = maths::round_sf(indel_heterozygosity, 6);
+    const auto t = std::make_tuple(k_snp, k_indel, n, rounded_indel_heterozygosity);
     auto itr = k_indel_pos_result_cache_.find(t);
     if (itr != std::cend(k_indel_pos_result_cache_)) {
         return itr->second;
     }
-    const auto result = coalescent(n, k_snp, k_indel, params_.snp_heterozygosity, indel_heterozygosity);
+    const auto result = shared_coalescent(n, k_snp, k_indel, params_.snp_heterozygosity, rounded_indel_heterozygosity);
     k_indel_pos_result_cache_.emplace(t, result);
     return result;
 }
@@ -15,6 +15,9 @@
 #include <tuple>
 #include <cassert>
 #include <type_traits>
+#include <array>
+#include <mutex>
+#include <atomic>
 
 #include <boost/functional/hash.hpp>
 #include <boost/optional.hpp>
@@ -40,6 +43,14 @@ public:
     
     enum class CachingStrategy { none, value, address };
     
+    // Statistics of the process-wide table of coalescent terms shared by all models
+    struct SharedTableStats
+    {
+        std::size_t hits, misses, size;
+    };
+    
+    static SharedTableStats shared_table_stats() noexcept;
+    
     CoalescentModel() = delete;
     
     CoalescentModel(Haplotype reference,
@@ -117,6 +128,67 @@ CoalescentModel::LogProbability CoalescentModel::evaluate(const Container& haplo
     return evaluate(count_segregating_sites(haplotypes));
 }
 
+namespace detail {
+
+// ln p(k_snp, k_indel | n, theta_snp, theta_indel), computed without any caching
+CoalescentModel::LogProbability
+coalescent_log_probability(unsigned n, unsigned k_snp, unsigned k_indel, double theta_snp, double theta_indel);
+
+// The coalescent terms depend only on the number of haplotypes, the segregating site counts, and the
+// heterozygosities, so are shared by every model (and thread) in the process. Models keep their own
+// unsynchronised caches in front of this table. Once max_size terms are stored, new terms are computed
+// but not stored.
+class SharedCoalescentTable
+{
+public:
+    using LogProbability = CoalescentModel::LogProbability;
+    
+    SharedCoalescentTable(std::size_t max_size = 1'000'000);
+    
+    LogProbability get(unsigned n, unsigned k_snp, unsigned k_indel, double theta_snp, double theta_indel);
+    
+    CoalescentModel::SharedTableStats stats() const noexcept;
+    
+private:
+    struct Key
+    {
+        unsigned n, k_snp, k_indel;
+        double theta_snp, theta_indel;
+        friend bool operator==(const Key& lhs, const Key& rhs) noexcept
+        {
+            return lhs.n == rhs.n && lhs.k_snp == rhs.k_snp && lhs.k_indel == rhs.k_indel
+                && lhs.theta_snp == rhs.theta_snp && lhs.theta_indel == rhs.theta_indel;
+        }
+    };
+    struct KeyHash
+    {
+        std::size_t operator()(const Key& key) const noexcept
+        {
+            std::size_t result {};
+            using boost::hash_combine;
+            hash_combine(result, key.n);
+            hash_combine(result, key.k_snp);
+            hash_combine(result, key.k_indel);
+            hash_combine(result, key.theta_snp);
+            hash_combine(result, key.theta_indel);
+            return result;
+        }
+    };
+    struct Shard
+    {
+        std::mutex mutex;
+        std::unordered_map<Key, LogProbability, KeyHash> table;
+    };
+    
+    static constexpr std::size_t numShards {16};
+    
+    std::size_t max_size_;
+    std::array<Shard, numShards> shards_;
+    std::atomic<std::size_t> hits_ {0}, misses_ {0}, size_ {0};
+};
+
+} // namespace detail
+
 // private methods
 
 namespace detail {
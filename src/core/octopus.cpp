@@ -8,6 +8,7 @@
 #include <queue>
 #include <map>
 #include <set>
+#include <unordered_set>
 #include <algorithm>
 #include <numeric>
 #include <memory>
@@ -42,6 +43,9 @@
 #include "config/octopus_vcf.hpp"
 #include "core/callers/caller_factory.hpp"
 #include "core/callers/caller.hpp"
+#include "core/callers/caller_cache.hpp"
+#include "core/contig_completion_tracker.hpp"
+#include "core/models/mutation/coalescent_model.hpp"
 #include "utils/maths.hpp"
 #include "logging/progress_meter.hpp"
 #include "logging/logging.hpp"
@@ -496,20 +500,23 @@ auto create_unique_temp_output_file_path(const GenomicRegion& region,
     return result;
 }
 
-VcfHeader make_temp_vcf_header(const GenomeCallingComponents& components, const GenomicRegion& region)
+VcfHeader make_temp_vcf_header(const GenomeCallingComponents& components)
 {
-    const auto call_types = get_call_types(components, {region.contig_name()});
-    return make_vcf_header(components.samples(), region.contig_name(), components.reference(), call_types, {"octopus-internal", ""});
+    // Temp files share the final output dictionaries so BCF records can be copied into the output verbatim
+    const auto call_types = get_call_types(components, components.contigs());
+    return make_vcf_header(components.samples(), components.contigs(), components.reference(), call_types, {"octopus-internal", ""});
 }
 
-VcfWriter create_unique_temp_output_file(const GenomicRegion& region, const GenomeCallingComponents& components)
+VcfWriter create_unique_temp_output_file(const GenomicRegion& region, const GenomeCallingComponents& components,
+                                         const VcfHeader& header)
 {
-    return {create_unique_temp_output_file_path(region, components), make_temp_vcf_header(components, region)};
+    return {create_unique_temp_output_file_path(region, components), header};
 }
 
-VcfWriter create_unique_temp_output_file(const GenomicRegion::ContigName& contig, const GenomeCallingComponents& components)
+VcfWriter create_unique_temp_output_file(const GenomicRegion::ContigName& contig, const GenomeCallingComponents& components,
+                                         const VcfHeader& header)
 {
-    return create_unique_temp_output_file(components.reference().contig_region(contig), components);
+    return create_unique_temp_output_file(components.reference().contig_region(contig), components, header);
 }
 
 using TempVcfWriterMap = std::unordered_map<ContigName, VcfWriter>;
@@ -519,10 +526,11 @@ TempVcfWriterMap make_temp_vcf_writers(const GenomeCallingComponents& components
     if (!components.temp_directory()) {
         throw std::runtime_error {"Could not make temp writers"};
     }
+    const auto temp_header = make_temp_vcf_header(components);
     TempVcfWriterMap result {};
     result.reserve(components.contigs().size());
     for (const auto& contig : components.contigs()) {
-        auto contig_writer = create_unique_temp_output_file(contig, components);
+        auto contig_writer = create_unique_temp_output_file(contig, components, temp_header);
         contig_writer.close();
         result.emplace(contig, std::move(contig_writer));
     }
@@ -654,6 +662,17 @@ void make_region_tasks(const GenomicRegion& region,
     }
 }
 
+// Contigs with no search regions have no tasks, but must still be marked finished
+void mark_finished_without_tasks(const ContigName& contig, TaskMakerSyncPacket& sync, const bool last_contig)
+{
+    std::unique_lock<std::mutex> lock {sync.mutex};
+    sync.cv.wait(lock, [&] () { return sync.ready; });
+    sync.finished.at(contig) = true;
+    if (last_contig) sync.all_done = true;
+    lock.unlock();
+    sync.cv.notify_one();
+}
+
 void make_contig_tasks(const ContigCallingComponents& components,
                        const ExecutionPolicy policy,
                        TaskQueue& result,
@@ -661,7 +680,7 @@ void make_contig_tasks(const ContigCallingComponents& components,
                        const bool last_contig,
                        const WindowConfig& window_config)
 {
-    if (components.regions.empty()) return;
+    assert(!components.regions.empty());
     std::for_each(std::cbegin(components.regions), std::prev(std::cend(components.regions)), [&] (const auto& region) {
         make_region_tasks(region, components, policy, result, sync, false, last_contig, window_config);
     });
@@ -698,7 +717,13 @@ void make_tasks_helper(TaskMap& tasks,
             const auto& contig = contigs[i];
             if (debug_log) stream(*debug_log) << "Making tasks for contig " << contig;
             auto contig_components = make_contig_components(contig, components, num_threads);
-            make_contig_tasks(contig_components, execution_policy, tasks[contig], sync, i == contigs.size() - 1, window_config);
+            const bool last_contig {i == contigs.size() - 1};
+            if (contig_components.regions.empty()) {
+                // Don't add an empty task queue as pop expects the first queue to have tasks
+                mark_finished_without_tasks(contig, sync, last_contig);
+            } else {
+                make_contig_tasks(contig_components, execution_policy, tasks[contig], sync, last_contig, window_config);
+            }
             if (debug_log) stream(*debug_log) << "Finished making tasks for contig " << contig;
         }
         if (debug_log) *debug_log << "Finished making tasks";
@@ -806,16 +831,18 @@ bool is_ready(const std::future<R>& f)
     return f.valid() && f.wait_for(std::chrono::seconds(0)) == std::future_status::ready;
 }
 
-auto run(Task task, ContigCallingComponents components, CallerSyncPacket& sync)
+auto run(Task task, ContigCallingComponents components, CallerCache& callers, CallerSyncPacket& sync)
 {
     static auto debug_log = get_debug_log();
     if (debug_log) stream(*debug_log) << "Spawning task " << task;
-    return std::async(std::launch::async, [task = std::move(task), components = std::move(components), &sync] () {
+    return std::async(std::launch::async, [task = std::move(task), components = std::move(components), &callers, &sync] () mutable {
         try {
             CompletedTask result {task};
             result.runtime.start = std::chrono::system_clock::now();
             result.calls = components.caller->call(task.region, components.progress_meter);
             result.runtime.end = std::chrono::system_clock::now();
+            // Only return the caller if the call succeeded as it may otherwise be left in a bad state
+            callers.release(contig_name(task), std::move(components.caller));
             std::unique_lock<std::mutex> lock {sync.mutex};
             ++sync.num_finished;
             lock.unlock();
@@ -865,12 +892,12 @@ auto get_writable_completed_tasks(CompletedTask&& task, CompletedTaskMap::mapped
 using ContigCallingComponentFactory    = std::function<ContigCallingComponents()>;
 using ContigCallingComponentFactoryMap = std::map<ContigName, ContigCallingComponentFactory>;
 
-auto make_contig_calling_component_factory_map(GenomeCallingComponents& components)
+auto make_contig_calling_component_factory_map(GenomeCallingComponents& components, CallerCache& callers)
 {
     ContigCallingComponentFactoryMap result {};
     for (const auto& contig : components.contigs()) {
-        result.emplace(contig, [&components, contig] () -> ContigCallingComponents
-                       { return ContigCallingComponents {contig, components}; });
+        result.emplace(contig, [&components, &callers, contig] () -> ContigCallingComponents
+                       { return ContigCallingComponents {contig, callers.acquire(contig), components}; });
     }
     return result;
 }
@@ -924,6 +951,8 @@ struct TaskWriterSyncPacket
     std::condition_variable cv;
     std::mutex mutex;
     std::deque<CompletedTask> tasks = {};
+    std::deque<ContigName> finished_contigs = {};
+    bool writing = false;
     bool done = false;
 };
 
@@ -940,19 +969,196 @@ void write(std::deque<CompletedTask>& tasks, TempVcfWriterMap& writers)
     tasks.clear();
 }
 
-void write_temp_vcf_helper(TempVcfWriterMap& writers, TaskWriterSyncPacket& sync)
+void finish(std::deque<ContigName>& contigs, TempVcfWriterMap& writers)
+{
+    contigs.clear(); // temp files are merged at the end
+}
+
+// Writes completed tasks straight to the final output in contig output order. Tasks from contigs
+// after the one currently being written are held in memory, and spilled to temporary files when
+// too many calls are buffered.
+class OrderedTaskWriter
+{
+public:
+    OrderedTaskWriter() = delete;
+    
+    OrderedTaskWriter(GenomeCallingComponents& components);
+    
+    OrderedTaskWriter(const OrderedTaskWriter&)            = delete;
+    OrderedTaskWriter& operator=(const OrderedTaskWriter&) = delete;
+    OrderedTaskWriter(OrderedTaskWriter&&)                 = default;
+    OrderedTaskWriter& operator=(OrderedTaskWriter&&)      = default;
+    
+    ~OrderedTaskWriter() = default;
+    
+    void write(CompletedTask&& task);
+    void finish(const ContigName& contig);
+    void finish();
+    
+private:
+    struct ContigBuffer
+    {
+        std::deque<CompletedTask> tasks = {};
+        std::size_t num_calls = 0;
+        boost::optional<VcfWriter> spill = boost::none;
+    };
+    
+    std::reference_wrapper<GenomeCallingComponents> components_;
+    std::deque<ContigName> pending_contigs_;
+    std::unordered_map<ContigName, ContigBuffer> buffers_;
+    std::unordered_set<ContigName> finished_contigs_;
+    boost::optional<VcfHeader> spill_header_;
+    std::size_t num_buffered_calls_, max_buffered_calls_;
+    std::size_t peak_buffered_calls_, num_spills_;
+    
+    void advance();
+    void flush(const ContigName& contig);
+    void spill();
+};
+
+OrderedTaskWriter::OrderedTaskWriter(GenomeCallingComponents& components)
+: components_ {components}
+, pending_contigs_ {std::cbegin(components.contigs()), std::cend(components.contigs())}
+, buffers_ {}
+, finished_contigs_ {}
+, spill_header_ {}
+, num_buffered_calls_ {0}
+, max_buffered_calls_ {components.max_buffered_output_calls()}
+, peak_buffered_calls_ {0}
+, num_spills_ {0}
+{}
+
+void OrderedTaskWriter::write(CompletedTask&& task)
+{
+    static auto debug_log = get_debug_log();
+    const auto& contig = contig_name(task);
+    if (!pending_contigs_.empty() && contig == pending_contigs_.front()) {
+        if (debug_log) stream(*debug_log) << "Writing completed task " << task << " that finished in " << duration(task);
+        write_calls(std::move(task.calls), components_.get().output());
+    } else {
+        if (debug_log) stream(*debug_log) << "Buffering out-of-order completed task " << task;
+        auto& buffer = buffers_[contig];
+        buffer.num_calls += task.calls.size();
+        num_buffered_calls_ += task.calls.size();
+        peak_buffered_calls_ = std::max(num_buffered_calls_, peak_buffered_calls_);
+        buffer.tasks.push_back(std::move(task));
+        if (num_buffered_calls_ > max_buffered_calls_) spill();
+    }
+}
+
+void OrderedTaskWriter::finish(const ContigName& contig)
+{
+    finished_contigs_.insert(contig);
+    advance();
+}
+
+void OrderedTaskWriter::finish()
+{
+    static auto debug_log = get_debug_log();
+    for (; !pending_contigs_.empty(); pending_contigs_.pop_front()) {
+        flush(pending_contigs_.front());
+    }
+    assert(buffers_.empty());
+    if (debug_log) stream(*debug_log) << "Ordered task writer buffered at most " << peak_buffered_calls_
+                                      << " calls and spilled " << num_spills_ << " times";
+}
+
+void OrderedTaskWriter::advance()
+{
+    while (!pending_contigs_.empty() && finished_contigs_.count(pending_contigs_.front()) == 1) {
+        finished_contigs_.erase(pending_contigs_.front());
+        pending_contigs_.pop_front();
+        if (!pending_contigs_.empty()) flush(pending_contigs_.front());
+    }
+}
+
+void OrderedTaskWriter::flush(const ContigName& contig)
+{
+    const auto itr = buffers_.find(contig);
+    if (itr == std::end(buffers_)) return;
+    auto& buffer = itr->second;
+    auto& output = components_.get().output();
+    if (buffer.spill) {
+        const auto spill_path = *buffer.spill->path();
+        buffer.spill->close();
+        {
+            VcfReader spilled {spill_path};
+            copy(spilled, output);
+        }
+        // Remove before destroying the writer so it is not indexed
+        boost::system::error_code ec {};
+        boost::filesystem::remove(spill_path, ec);
+        buffer.spill = boost::none;
+    }
+    for (auto& task : buffer.tasks) {
+        write_calls(std::move(task.calls), output);
+    }
+    num_buffered_calls_ -= buffer.num_calls;
+    buffers_.erase(itr);
+}
+
+void OrderedTaskWriter::spill()
+{
+    static auto debug_log = get_debug_log();
+    const auto itr = std::max_element(std::begin(buffers_), std::end(buffers_),
+                                      [] (const auto& lhs, const auto& rhs) { return lhs.second.num_calls < rhs.second.num_calls; });
+    auto& buffer = itr->second;
+    if (!buffer.spill) {
+        if (!components_.get().temp_directory()) {
+            throw std::runtime_error {"Could not make temp writers"};
+        }
+        if (!spill_header_) spill_header_ = make_temp_vcf_header(components_);
+        buffer.spill = create_unique_temp_output_file(itr->first, components_, *spill_header_);
+    }
+    if (debug_log) stream(*debug_log) << "Spilling " << buffer.num_calls << " buffered calls from contig " << itr->first;
+    for (auto& task : buffer.tasks) {
+        write_calls(std::move(task.calls), *buffer.spill);
+    }
+    buffer.tasks.clear();
+    num_buffered_calls_ -= buffer.num_calls;
+    buffer.num_calls = 0;
+    ++num_spills_;
+}
+
+void write(std::deque<CompletedTask>& tasks, OrderedTaskWriter& writer)
+{
+    for (auto&& task : tasks) {
+        writer.write(std::move(task));
+    }
+    tasks.clear();
+}
+
+void finish(std::deque<ContigName>& contigs, OrderedTaskWriter& writer)
+{
+    for (const auto& contig : contigs) {
+        writer.finish(contig);
+    }
+    contigs.clear();
+}
+
+template <typename TaskWriter>
+void write_task_helper(TaskWriter& writer, TaskWriterSyncPacket& sync)
 {
     try {
         std::unique_lock<std::mutex> lock {sync.mutex, std::defer_lock};
         std::deque<CompletedTask> buffer {};
+        std::deque<ContigName> finished_contigs {};
         while (!sync.done) {
             lock.lock();
-            sync.cv.wait(lock, [&] () { return !sync.tasks.empty() || sync.done; });
-            assert(buffer.empty());
+            sync.cv.wait(lock, [&] () { return !sync.tasks.empty() || !sync.finished_contigs.empty() || sync.done; });
+            assert(buffer.empty() && finished_contigs.empty());
             std::swap(sync.tasks, buffer);
+            std::swap(sync.finished_contigs, finished_contigs);
+            sync.writing = true;
             lock.unlock();
-            sync.cv.notify_one();
-            write(buffer, writers);
+            sync.cv.notify_all();
+            // Contig completions are pushed after their tasks so must be processed after them
+            write(buffer, writer);
+            finish(finished_contigs, writer);
+            lock.lock();
+            sync.writing = false;
+            lock.unlock();
+            sync.cv.notify_all();
         }
         logging::DebugLogger debug_log {};
         debug_log << "Task writer finished";
@@ -973,9 +1179,10 @@ void write_temp_vcf_helper(TempVcfWriterMap& writers, TaskWriterSyncPacket& sync
     }
 }
 
-std::thread make_task_writer_thread(TempVcfWriterMap& temp_writers, TaskWriterSyncPacket& writer_sync)
+template <typename TaskWriter>
+std::thread make_task_writer_thread(TaskWriter& writer, TaskWriterSyncPacket& writer_sync)
 {
-    return std::thread {write_temp_vcf_helper, std::ref(temp_writers), std::ref(writer_sync)};
+    return std::thread {write_task_helper<TaskWriter>, std::ref(writer), std::ref(writer_sync)};
 }
 
 void write(std::deque<CompletedTask>&& tasks, VcfWriter& temp_vcf)
@@ -1019,13 +1226,42 @@ void write_or_buffer(CompletedTask&& task, CompletedTaskMap::mapped_type& buffer
     }
 }
 
+bool is_finished(const ContigName& contig, const TaskMap& pending_tasks, const TaskQueue& running_tasks,
+                 TaskMakerSyncPacket& task_maker_sync)
+{
+    if (!running_tasks.empty()) return false;
+    std::lock_guard<std::mutex> lock {task_maker_sync.mutex};
+    if (!task_maker_sync.finished.at(contig)) return false;
+    const auto itr = pending_tasks.find(contig);
+    return itr == std::cend(pending_tasks) || itr->second.empty();
+}
+
+// Once a contig has no running or pending tasks the holdback task can be written
+void write_finished_contig(const ContigName& contig, CompletedTaskMap::mapped_type& buffered_tasks,
+                           HoldbackTask& holdback, TaskWriterSyncPacket& sync)
+{
+    static auto debug_log = get_debug_log();
+    if (debug_log) stream(*debug_log) << "Finished calling contig " << contig;
+    std::deque<CompletedTask> tasks {};
+    for (auto& p : buffered_tasks) {
+        tasks.push_back(std::move(p.second));
+    }
+    buffered_tasks.clear();
+    holdback = boost::none;
+    std::unique_lock<std::mutex> lock {sync.mutex};
+    utils::append(std::move(tasks), sync.tasks);
+    sync.finished_contigs.push_back(contig);
+    lock.unlock();
+    sync.cv.notify_all();
+}
+
 void wait_until_finished(TaskWriterSyncPacket& sync)
 {
     std::unique_lock<std::mutex> lock {sync.mutex};
-    sync.cv.wait(lock, [&] () { return sync.tasks.empty(); });
+    sync.cv.wait(lock, [&] () { return sync.tasks.empty() && sync.finished_contigs.empty() && !sync.writing; });
     sync.done = true;
     lock.unlock();
-    sync.cv.notify_one();
+    sync.cv.notify_all();
 }
 
 using FutureCompletedTasks = std::vector<std::future<CompletedTask>>;
@@ -1088,14 +1324,23 @@ void write(RemainingTaskMap&& remaining_tasks, TempVcfWriterMap& temp_vcfs)
     }
 }
 
-void write_remaining_tasks(FutureCompletedTasks& futures, CompletedTaskMap& buffered_tasks, TempVcfWriterMap& temp_vcfs,
+void write(RemainingTaskMap&& remaining_tasks, OrderedTaskWriter& writer)
+{
+    for (auto& p : remaining_tasks) {
+        write(p.second, writer);
+    }
+    writer.finish();
+}
+
+template <typename TaskWriter>
+void write_remaining_tasks(FutureCompletedTasks& futures, CompletedTaskMap& buffered_tasks, TaskWriter& writer,
                            const ContigCallingComponentFactoryMap& calling_components)
 {
     static auto debug_log = get_debug_log();
     if (debug_log) stream(*debug_log) << "Waiting for " << futures.size() << " running tasks to finish";
     auto remaining_tasks = extract_remaining_tasks(futures, buffered_tasks);
     resolve_connecting_calls(remaining_tasks, calling_components);
-    write(std::move(remaining_tasks), temp_vcfs);
+    write(std::move(remaining_tasks), writer);
 }
 
 auto extract_writers(TempVcfWriterMap&& vcfs)
@@ -1109,16 +1354,66 @@ auto extract_writers(TempVcfWriterMap&& vcfs)
     return result;
 }
 
-auto extract_as_readers(TempVcfWriterMap&& vcfs)
+auto extract_as_readers(TempVcfWriterMap&& vcfs, const unsigned max_threads)
 {
-    return writers_to_readers(extract_writers(std::move(vcfs)), false);
+    return writers_to_readers(extract_writers(std::move(vcfs)), false, max_threads);
+}
+
+bool is_bcf(const boost::optional<boost::filesystem::path>& path)
+{
+    return path && path->extension().string() == ".bcf";
+}
+
+auto get_temp_paths(const TempVcfWriterMap& vcfs, const std::vector<ContigName>& contigs)
+{
+    std::vector<boost::filesystem::path> result {};
+    result.reserve(vcfs.size());
+    for (const auto& contig : contigs) {
+        const auto itr = vcfs.find(contig);
+        if (itr != std::cend(vcfs)) {
+            auto path = itr->second.path();
+            if (path) result.push_back(std::move(*path));
+        }
+    }
+    return result;
+}
+
+bool can_block_merge(const TempVcfWriterMap& temp_vcf_writers, const GenomeCallingComponents& components)
+{
+    return is_bcf(components.output().path()) && !components.sites_only()
+        && std::all_of(std::cbegin(temp_vcf_writers), std::cend(temp_vcf_writers),
+                       [] (const auto& p) { return is_bcf(p.second.path()); });
+}
+
+bool try_block_merge(TempVcfWriterMap& temp_vcf_writers, GenomeCallingComponents& components, const unsigned max_threads)
+{
+    if (!can_block_merge(temp_vcf_writers, components)) return false;
+    for (auto& p : temp_vcf_writers) p.second.close();
+    const auto temp_paths = get_temp_paths(temp_vcf_writers, components.contigs());
+    components.output().close();
+    if (!concatenate_bcf_blocks(temp_paths, *components.output().path(), max_threads)) {
+        components.output().open();
+        return false;
+    }
+    // Remove the temp files now so the writers don't index them on destruction
+    for (const auto& path : temp_paths) {
+        boost::system::error_code ec {};
+        boost::filesystem::remove(path, ec);
+    }
+    temp_vcf_writers.clear();
+    return true;
 }
 
 void merge(TempVcfWriterMap&& temp_vcf_writers, GenomeCallingComponents& components)
 {
     static auto debug_log = get_debug_log();
+    const auto max_threads = calculate_num_task_threads(components);
     if (debug_log) stream(*debug_log) << "Merging " << temp_vcf_writers.size() << " temporary VCF files";
-    auto temp_readers = extract_as_readers(std::move(temp_vcf_writers));
+    if (try_block_merge(temp_vcf_writers, components, max_threads)) {
+        if (debug_log) stream(*debug_log) << "Merged temporary VCF files by BGZF block concatenation";
+        return;
+    }
+    auto temp_readers = extract_as_readers(std::move(temp_vcf_writers), max_threads);
     merge(temp_readers, components.output(), components.contigs());
 }
 
@@ -1152,13 +1447,24 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
         holdbacks.emplace(contig, boost::none);
     }
     
+    ContigCompletionTracker unfinished_contigs {components.contigs()};
     CallerSyncPacket caller_sync {};
-    const auto calling_components = make_contig_calling_component_factory_map(components);
+    CallerCache callers {components.caller_factory(), num_task_threads};
+    const auto calling_components = make_contig_calling_component_factory_map(components, callers);
     unsigned num_idle_futures {0};
     
-    auto temp_writers = make_temp_vcf_writers(components);
+    // Stream calls to the final output unless all tasks must go through temp files
+    const bool stream_output {components.max_buffered_output_calls() > 0};
+    TempVcfWriterMap temp_writers {};
+    boost::optional<OrderedTaskWriter> ordered_writer {};
+    if (stream_output) {
+        ordered_writer = OrderedTaskWriter {components};
+    } else {
+        temp_writers = make_temp_vcf_writers(components);
+    }
     TaskWriterSyncPacket task_writer_sync {};
-    auto task_writer_thread = make_task_writer_thread(temp_writers, task_writer_sync);
+    auto task_writer_thread = stream_output ? make_task_writer_thread(*ordered_writer, task_writer_sync)
+                                            : make_task_writer_thread(temp_writers, task_writer_sync);
     if (!task_writer_thread.joinable()) {
         logging::FatalLogger fatal_log {};
         fatal_log << "Unable to make task writer thread";
@@ -1167,8 +1473,9 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
     task_writer_thread.detach();
     
     // Wait for the first task to be made
-    const auto tasks_available = [&] () noexcept { return task_maker_sync.num_tasks > 0; };
-    while(task_maker_sync.num_tasks == 0) {
+    // The task maker may finish without making any more tasks if the remaining contigs are empty
+    const auto tasks_available = [&] () noexcept { return task_maker_sync.num_tasks > 0 || task_maker_sync.all_done; };
+    while(!tasks_available()) {
         pending_task_lock.lock();
         task_maker_sync.cv.wait(pending_task_lock, tasks_available);
         pending_task_lock.unlock();
@@ -1185,7 +1492,7 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
             if (num_idle_futures < futures.size()) {
                 // If there are running futures then it's good periodically check to see if
                 // any have finished and process them while we wait for the task maker.
-                while (task_maker_sync.num_tasks == 0 && caller_sync.num_finished == 0) {
+                while (!tasks_available() && caller_sync.num_finished == 0) {
                     auto now = std::chrono::system_clock::now();
                     task_maker_sync.cv.wait_until(pending_task_lock, now + 5s, tasks_available);
                 }
@@ -1198,7 +1505,7 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
         for (auto& future : futures) {
             if (is_ready(future)) {
                 auto completed_task = future.get();
-                const auto& contig = contig_name(completed_task.region);
+                const auto contig = contig_name(completed_task.region);
                 write_or_buffer(std::move(completed_task), buffered_tasks.at(contig),
                                 running_tasks.at(contig), holdbacks.at(contig),
                                 task_writer_sync, calling_components.at(contig));
@@ -1209,7 +1516,7 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
                 if (task_maker_sync.num_tasks > 0) {
                     pending_task_lock.unlock(); // As pop will need to lock the mutex too == deadlock
                     auto task = pop(pending_tasks, task_maker_sync);
-                    future = run(task, calling_components.at(contig_name(task))(), caller_sync);
+                    future = run(task, calling_components.at(contig_name(task))(), callers, caller_sync);
                     running_tasks.at(contig_name(task)).push(std::move(task));
                 } else {
                     pending_task_lock.unlock();
@@ -1217,6 +1524,15 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
                 }
             }
         }
+        // All unfinished contigs are checked, not just those with a task that just completed, as a contig
+        // may be marked finished by the task maker after its last task completes, or have no tasks at all
+        const auto finished_contigs = unfinished_contigs.pop_finished([&] (const ContigName& contig) {
+            return is_finished(contig, pending_tasks, running_tasks.at(contig), task_maker_sync);
+        });
+        for (const auto& contig : finished_contigs) {
+            write_finished_contig(contig, buffered_tasks.at(contig), holdbacks.at(contig), task_writer_sync);
+            callers.evict(contig);
+        }
         // If there are no idle futures then all threads are busy and we must wait for one to finish,
         // otherwise we must have run out of tasks, so we should wait for new ones.
         if (num_idle_futures == 0 && caller_sync.num_finished == 0) {
@@ -1234,9 +1550,18 @@ void run_octopus_multi_threaded(GenomeCallingComponents& components)
     holdbacks.clear(); // holdbacks are just references to buffered tasks
     if (debug_log) *debug_log << "Finished making new tasks. Waiting for task writer to complete existing jobs";
     wait_until_finished(task_writer_sync);
-    write_remaining_tasks(futures, buffered_tasks, temp_writers, calling_components);
-    components.progress_meter().stop();
-    merge(std::move(temp_writers), components);
+    if (stream_output) {
+        write_remaining_tasks(futures, buffered_tasks, *ordered_writer, calling_components);
+        components.progress_meter().stop();
+    } else {
+        write_remaining_tasks(futures, buffered_tasks, temp_writers, calling_components);
+        components.progress_meter().stop();
+        merge(std::move(temp_writers), components);
+    }
+    if (debug_log) {
+        const auto caller_stats = callers.stats();
+        stream(*debug_log) << "Made " << caller_stats.num_made << " callers and reused " << caller_stats.num_reused;
+    }
 }
 
 } // namespace
@@ -1257,6 +1582,12 @@ void run_calling(GenomeCallingComponents& components)
     } else {
         run_octopus_single_threaded(components);
     }
+    static auto debug_log = get_debug_log();
+    if (debug_log) {
+        const auto coalescent_stats = CoalescentModel::shared_table_stats();
+        stream(*debug_log) << "Shared coalescent table has " << coalescent_stats.size << " entries ("
+                           << coalescent_stats.hits << " hits, " << coalescent_stats.misses << " misses)";
+    }
 }
 
 void destroy(VcfWriter& writer)
@@ -1344,6 +1675,7 @@ void run_csr(GenomeCallingComponents& components)
         BufferedReadPipe::Config buffer_config {components.read_buffer_size()};
         buffer_config.fetch_expansion = 100;
         buffer_config.max_hint_gap = 5'000;
+        buffer_config.prefetch_hints = !components.num_threads() || *components.num_threads() > 1;
         BufferedReadPipe buffered_rp {filter_read_pipe, buffer_config};
         if (use_unfiltered_call_region_hints_for_filtering(components)) {
             buffered_rp.hint(extract_call_regions(*input_path));
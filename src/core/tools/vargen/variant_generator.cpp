@@ -29,6 +29,7 @@ VariantGenerator::VariantGenerator(const VariantGenerator& other)
         this->variant_generators_.push_back(generator->clone());
     }
     this->active_region_generator_ = other.active_region_generator_;
+    this->workers_ = other.workers_;
 }
 
 VariantGenerator& VariantGenerator::operator=(VariantGenerator other)
@@ -47,6 +48,7 @@ void swap(VariantGenerator& lhs, VariantGenerator& rhs) noexcept
     using std::swap;
     swap(lhs.variant_generators_, rhs.variant_generators_);
     swap(lhs.active_region_generator_, rhs.active_region_generator_);
+    swap(lhs.workers_, rhs.workers_);
 }
 
 void VariantGenerator::add(std::unique_ptr<VariantGenerator> generator)
@@ -60,6 +62,11 @@ unsigned VariantGenerator::num_generators() const noexcept
     return static_cast<unsigned>(variant_generators_.size());
 }
 
+void VariantGenerator::set_thread_pool(std::shared_ptr<ThreadPool> workers) noexcept
+{
+    workers_ = std::move(workers);
+}
+
 std::unique_ptr<VariantGenerator> VariantGenerator::clone() const
 {
     return do_clone();
@@ -98,12 +105,35 @@ void log_candidates(const std::vector<Variant>& candidates, const std::string& g
 
 std::vector<Variant> VariantGenerator::generate(const GenomicRegion& region) const
 {
+    std::vector<RegionSet> active_regions {};
+    active_regions.reserve(variant_generators_.size());
+    for (const auto& generator : variant_generators_) {
+        active_regions.push_back(generate_active_regions(region, *generator));
+        debug::log_active_regions(active_regions.back(), generator->name(), debug_log_);
+    }
+    std::vector<std::vector<Variant>> generator_results {};
+    if (use_workers()) {
+        std::vector<std::future<std::vector<Variant>>> futures {};
+        futures.reserve(variant_generators_.size());
+        for (std::size_t i {0}; i < variant_generators_.size(); ++i) {
+            const auto& generator = *variant_generators_[i];
+            const auto& regions = active_regions[i];
+            futures.push_back(workers_->push([&generator, &regions] () { return generator.do_generate(regions); }));
+        }
+        generator_results.reserve(futures.size());
+        std::exception_ptr error {};
+        get_all(futures, generator_results, error);
+        if (error) std::rethrow_exception(error);
+    } else {
+        generator_results.reserve(variant_generators_.size());
+        for (std::size_t i {0}; i < variant_generators_.size(); ++i) {
+            generator_results.push_back(variant_generators_[i]->do_generate(active_regions[i]));
+        }
+    }
     std::vector<Variant> result {};
-    for (auto& generator : variant_generators_) {
-        const auto active_regions = generate_active_regions(region, *generator);
-        debug::log_active_regions(active_regions, generator->name(), debug_log_);
-        auto generator_result = generator->do_generate(active_regions);
-        debug::log_candidates(generator_result, generator->name(), debug_log_);
+    for (std::size_t i {0}; i < variant_generators_.size(); ++i) {
+        auto& generator_result = generator_results[i];
+        debug::log_candidates(generator_result, variant_generators_[i]->name(), debug_log_);
         assert(std::is_sorted(std::cbegin(generator_result), std::cend(generator_result)));
         auto itr = utils::append(std::move(generator_result), result);
         std::inplace_merge(std::begin(result), itr, std::end(result));
@@ -147,5 +177,12 @@ VariantGenerator::generate_active_regions(const GenomicRegion& region, const Var
     }
 }
 
+bool VariantGenerator::use_workers() const noexcept
+{
+    // Waiting on workers from a worker thread could deadlock the pool, and running a single
+    // generator on a worker only adds overhead
+    return workers_ && workers_->size() > 1 && num_generators() > 1 && !workers_->is_worker_thread();
+}
+
 } // namespace coretools
 } // namespace octopus
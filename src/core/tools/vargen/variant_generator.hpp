@@ -11,6 +11,8 @@
 #include <functional>
 #include <cstddef>
 #include <type_traits>
+#include <future>
+#include <exception>
 
 #include <boost/optional.hpp>
 
@@ -20,6 +22,8 @@
 #include "basics/aligned_read.hpp"
 #include "core/types/variant.hpp"
 #include "containers/mappable_flat_multi_set.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/parallel_transform.hpp"
 #include "active_region_generator.hpp"
 
 namespace octopus { namespace coretools {
@@ -42,6 +46,12 @@ public:
     
     unsigned num_generators() const noexcept;
     
+    // Sub-generators are independent so may consume reads and generate candidates concurrently on
+    // workers, which may be shared with other generators. Sub-generators are run inline if called
+    // from one of the workers' threads. Candidates are merged in the order the generators were added,
+    // so the result does not depend on the number of workers.
+    void set_thread_pool(std::shared_ptr<ThreadPool> workers) noexcept;
+    
     std::unique_ptr<VariantGenerator> clone() const;
     
     std::vector<Variant> generate(const GenomicRegion& region) const;
@@ -66,6 +76,7 @@ protected:
 private:
     std::vector<std::unique_ptr<VariantGenerator>> variant_generators_;
     boost::optional<ActiveRegionGenerator> active_region_generator_;
+    std::shared_ptr<ThreadPool> workers_;
     
     virtual std::unique_ptr<VariantGenerator> do_clone() const;
     virtual std::vector<Variant> do_generate(const RegionSet& regions) const { return {}; };
@@ -84,13 +95,30 @@ private:
     virtual std::string name() const { return "VariantGenerator"; }
     
     RegionSet generate_active_regions(const GenomicRegion& region, const VariantGenerator& generator) const;
+    bool use_workers() const noexcept;
 };
 
 template <typename InputIt>
 void VariantGenerator::add_reads(const SampleName& sample, InputIt first, InputIt last)
 {
-    if (active_region_generator_) active_region_generator_->add_reads(sample, first, last);
-    for (auto& generator : variant_generators_) generator->do_add_reads(sample, first, last);
+    if (use_workers()) {
+        std::vector<std::future<void>> futures {};
+        futures.reserve(variant_generators_.size());
+        for (auto& generator : variant_generators_) {
+            futures.push_back(workers_->push([&generator, &sample, first, last] () { generator->do_add_reads(sample, first, last); }));
+        }
+        std::exception_ptr error {};
+        try {
+            if (active_region_generator_) active_region_generator_->add_reads(sample, first, last);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        get_all(futures, error);
+        if (error) std::rethrow_exception(error);
+    } else {
+        if (active_region_generator_) active_region_generator_->add_reads(sample, first, last);
+        for (auto& generator : variant_generators_) generator->do_add_reads(sample, first, last);
+    }
 }
 
 // non-member methods
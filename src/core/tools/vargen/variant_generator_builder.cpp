@@ -31,6 +31,14 @@ VariantGeneratorBuilder::add_vcf_extractor(boost::filesystem::path file, VcfExtr
     return *this;
 }
 
+VariantGeneratorBuilder&
+VariantGeneratorBuilder::add_vcf_extractor(std::shared_ptr<const SourceCandidateStore> store, VcfExtractor::Options options)
+{
+    auto file = store->path();
+    vcf_extractors_.push_back({std::move(file), std::move(options), std::move(store)});
+    return *this;
+}
+
 VariantGeneratorBuilder&
 VariantGeneratorBuilder::set_repeat_scanner(RepeatScanner::Options options)
 {
@@ -59,6 +67,13 @@ VariantGeneratorBuilder::set_active_region_generator(ActiveRegionGenerator::Opti
     return *this;
 }
 
+VariantGeneratorBuilder&
+VariantGeneratorBuilder::set_thread_pool(std::shared_ptr<ThreadPool> workers)
+{
+    workers_ = std::move(workers);
+    return *this;
+}
+
 VariantGenerator VariantGeneratorBuilder::build(const ReferenceGenome& reference) const
 {
     
@@ -70,7 +85,11 @@ VariantGenerator VariantGeneratorBuilder::build(const ReferenceGenome& reference
         result.add(std::make_unique<LocalReassembler>(reference, *local_reassembler_));
     }
     for (auto packet : vcf_extractors_) {
-        result.add(std::make_unique<VcfExtractor>(std::make_unique<VcfReader>(packet.file), packet.options));
+        if (packet.store) {
+            result.add(std::make_unique<VcfExtractor>(std::move(packet.store), packet.options));
+        } else {
+            result.add(std::make_unique<VcfExtractor>(std::make_unique<VcfReader>(packet.file), packet.options));
+        }
     }
     if (repeat_scanner_) {
         result.add(std::make_unique<RepeatScanner>(reference, *repeat_scanner_));
@@ -81,6 +100,7 @@ VariantGenerator VariantGeneratorBuilder::build(const ReferenceGenome& reference
     for (auto options : randomisers_) {
         result.add(std::make_unique<Randomiser>(reference, options));
     }
+    result.set_thread_pool(workers_);
     return result;
 }
     
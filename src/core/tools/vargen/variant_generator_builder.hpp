@@ -5,6 +5,7 @@
 #define variant_generator_builder_hpp
 
 #include <deque>
+#include <memory>
 
 #include <boost/optional.hpp>
 #include <boost/filesystem.hpp>
@@ -17,6 +18,7 @@
 #include "randomiser.hpp"
 #include "io/reference/reference_genome.hpp"
 #include "io/variant/vcf_reader.hpp"
+#include "utils/thread_pool.hpp"
 #include "active_region_generator.hpp"
 
 namespace octopus {
@@ -40,10 +42,13 @@ public:
     VariantGeneratorBuilder& set_local_reassembler(LocalReassembler::Options options);
     VariantGeneratorBuilder& add_vcf_extractor(boost::filesystem::path reader,
                                                VcfExtractor::Options options = VcfExtractor::Options {});
+    VariantGeneratorBuilder& add_vcf_extractor(std::shared_ptr<const SourceCandidateStore> store,
+                                               VcfExtractor::Options options = VcfExtractor::Options {});
     VariantGeneratorBuilder& set_repeat_scanner(RepeatScanner::Options options);
     VariantGeneratorBuilder& add_downloader(Downloader::Options options = Downloader::Options {});
     VariantGeneratorBuilder& add_randomiser(Randomiser::Options options = Randomiser::Options {});
     VariantGeneratorBuilder& set_active_region_generator(ActiveRegionGenerator::Options options = ActiveRegionGenerator::Options {});
+    VariantGeneratorBuilder& set_thread_pool(std::shared_ptr<ThreadPool> workers);
     
     VariantGenerator build(const ReferenceGenome& reference) const;
 
@@ -52,6 +57,7 @@ private:
     {
         boost::filesystem::path file;
         VcfExtractor::Options options;
+        std::shared_ptr<const SourceCandidateStore> store = nullptr;
     };
     
     boost::optional<CigarScanner::Options> cigar_scanner_;
@@ -61,6 +67,7 @@ private:
     std::deque<Downloader::Options> downloaders_;
     std::deque<Randomiser::Options> randomisers_;
     ActiveRegionGenerator::Options active_region_generator_;
+    std::shared_ptr<ThreadPool> workers_ = nullptr;
 };
 
 } // namespace coretools
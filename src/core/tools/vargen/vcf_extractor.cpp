@@ -21,11 +21,18 @@ VcfExtractor::VcfExtractor(std::unique_ptr<VcfReader> reader)
 
 VcfExtractor::VcfExtractor(std::unique_ptr<VcfReader> reader, Options options)
 : reader_ {std::move(reader)}
+, store_ {}
 , options_ {options}
 {
     reader_->close();
 }
 
+VcfExtractor::VcfExtractor(std::shared_ptr<const SourceCandidateStore> store, Options options)
+: reader_ {}
+, store_ {std::move(store)}
+, options_ {options}
+{}
+
 std::unique_ptr<VariantGenerator> VcfExtractor::do_clone() const
 {
     return std::make_unique<VcfExtractor>(*this);
@@ -48,58 +55,89 @@ auto make_allele(const Iterator first_base, const Iterator last_base)
     return result;
 }
 
+// pos is one based, as in VCF
+template <typename Sequence, typename Container>
+void extract_variants(const GenomicRegion::ContigName& contig, const GenomicRegion::Position pos,
+                      const Sequence& ref_allele, const Sequence& alt_allele,
+                      Container& result, const bool split_complex)
+{
+    if (ref_allele.size() != alt_allele.size()) {
+        auto begin = pos;
+        const auto p = std::mismatch(std::cbegin(ref_allele), std::cend(ref_allele),
+                                     std::cbegin(alt_allele), std::cend(alt_allele));
+        if (p.first != std::cend(ref_allele) && alt_allele.size() > ref_allele.size()) {
+            const auto ref_pad_size = std::distance(std::cbegin(ref_allele), p.first);
+            begin += ref_pad_size;
+            const auto remaining_ref_size = ref_allele.size() - ref_pad_size;
+            if (split_complex) {
+                // Split non-reference padded insertions into snv (or mnv) and insertion with empty
+                // reference (e.g. A -> TT makes two variants A -> T and -> T).
+                const auto first_alt_end = std::next(p.second, remaining_ref_size);
+                result.emplace_back(contig, begin - 1,
+                                    make_allele(p.first, std::cend(ref_allele)),
+                                    make_allele(p.second, first_alt_end));
+                begin += remaining_ref_size;
+                result.emplace_back(contig, begin - 1, "",
+                                    make_allele(first_alt_end, std::cend(alt_allele)));
+            } else {
+                // otherwise extract as complete MNV
+                result.emplace_back(contig, begin - 1,
+                                    make_allele(p.first, std::cend(ref_allele)),
+                                    make_allele(p.second, std::cend(alt_allele)));
+            }
+        } else {
+            begin += std::distance(std::cbegin(ref_allele), p.first);
+            result.emplace_back(contig, begin - 1,
+                                make_allele(p.first, std::cend(ref_allele)),
+                                make_allele(p.second, std::cend(alt_allele)));
+        }
+    } else {
+        result.emplace_back(contig, pos - 1,
+                            make_allele(std::cbegin(ref_allele), std::cend(ref_allele)),
+                            make_allele(std::cbegin(alt_allele), std::cend(alt_allele)));
+    }
+}
+
 template <typename Container>
 void extract_variants(const VcfRecord& record, Container& result, const bool split_complex)
 {
     for (const auto& alt_allele : record.alt()) {
         if (is_canonical(alt_allele)) {
-            const auto& ref_allele = record.ref();
-            if (ref_allele.size() != alt_allele.size()) {
-                auto begin = record.pos();
-                const auto p = std::mismatch(std::cbegin(ref_allele), std::cend(ref_allele),
-                                             std::cbegin(alt_allele), std::cend(alt_allele));
-                if (p.first != std::cend(ref_allele) && alt_allele.size() > ref_allele.size()) {
-                    const auto ref_pad_size = std::distance(std::cbegin(ref_allele), p.first);
-                    begin += ref_pad_size;
-                    const auto remaining_ref_size = ref_allele.size() - ref_pad_size;
-                    if (split_complex) {
-                        // Split non-reference padded insertions into snv (or mnv) and insertion with empty
-                        // reference (e.g. A -> TT makes two variants A -> T and -> T).
-                        const auto first_alt_end = std::next(p.second, remaining_ref_size);
-                        result.emplace_back(record.chrom(), begin - 1,
-                                            make_allele(p.first, std::cend(ref_allele)),
-                                            make_allele(p.second, first_alt_end));
-                        begin += remaining_ref_size;
-                        result.emplace_back(record.chrom(), begin - 1, "",
-                                            make_allele(first_alt_end, std::cend(alt_allele)));
-                    } else {
-                        // otherwise extract as complete MNV
-                        result.emplace_back(record.chrom(), begin - 1,
-                                            make_allele(p.first, std::cend(ref_allele)),
-                                            make_allele(p.second, std::cend(alt_allele)));
-                    }
-                } else {
-                    begin += std::distance(std::cbegin(ref_allele), p.first);
-                    result.emplace_back(record.chrom(), begin - 1,
-                                        make_allele(p.first, std::cend(ref_allele)),
-                                        make_allele(p.second, std::cend(alt_allele)));
-                }
-            } else {
-                using utils::capitalise_copy;
-                result.emplace_back(record.chrom(), record.pos() - 1,
-                                    capitalise_copy(record.ref()),
-                                    capitalise_copy(alt_allele));
-            }
+            extract_variants(record.chrom(), record.pos(), record.ref(), alt_allele, result, split_complex);
         }
     }
 }
 
+template <typename Container>
+void extract_variants(const GenomicRegion::ContigName& contig, const SourceCandidateStore::Candidate& candidate,
+                      Container& result, const bool split_complex)
+{
+    // Stored alleles are already canonical and capitalised
+    extract_variants(contig, candidate.begin + 1, candidate.ref, candidate.alt, result, split_complex);
+}
+
+template <typename Container>
+std::vector<Variant> sort_unique(Container& variants)
+{
+    std::vector<Variant> result {std::make_move_iterator(std::begin(variants)),
+                                 std::make_move_iterator(std::end(variants))};
+    std::sort(std::begin(result), std::end(result));
+    result.erase(std::unique(std::begin(result), std::end(result)), std::end(result));
+    return result;
+}
+
 } // namespace
 
 std::vector<Variant> VcfExtractor::do_generate(const RegionSet& regions) const
 {
-    reader_->open();
     std::vector<Variant> result {};
+    if (store_) {
+        for (const auto& region : regions) {
+            utils::append(fetch_stored_variants(region), result);
+        }
+        return result;
+    }
+    reader_->open();
     for (const auto& region : regions) {
         utils::append(fetch_variants(region), result);
     }
@@ -120,11 +158,18 @@ std::vector<Variant> VcfExtractor::fetch_variants(const GenomicRegion& region) c
             extract_variants(*p.first, variants, options_.split_complex);
         }
     }
-    std::vector<Variant> result {std::make_move_iterator(std::begin(variants)),
-                                 std::make_move_iterator(std::end(variants))};
-    std::sort(std::begin(result), std::end(result));
-    result.erase(std::unique(std::begin(result), std::end(result)), std::end(result));
-    return result;
+    return sort_unique(variants);
+}
+
+std::vector<Variant> VcfExtractor::fetch_stored_variants(const GenomicRegion& region) const
+{
+    std::deque<Variant> variants {};
+    for (const auto& candidate : store_->fetch(region)) {
+        if (is_good(candidate)) {
+            extract_variants(region.contig_name(), candidate, variants, options_.split_complex);
+        }
+    }
+    return sort_unique(variants);
 }
 
 bool VcfExtractor::is_good(const VcfRecord& record) const
@@ -133,5 +178,11 @@ bool VcfExtractor::is_good(const VcfRecord& record) const
     return !options_.min_quality || (record.qual() && *record.qual() >= *options_.min_quality);
 }
 
+bool VcfExtractor::is_good(const SourceCandidateStore::Candidate& candidate) const
+{
+    if (!options_.extract_filtered && candidate.filtered) return false;
+    return !options_.min_quality || (candidate.quality && *candidate.quality >= *options_.min_quality);
+}
+
 } // namespace coretools
 } // namespace octopus
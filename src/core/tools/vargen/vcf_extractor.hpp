@@ -11,6 +11,7 @@
 #include <boost/optional.hpp>
 
 #include "io/variant/vcf.hpp"
+#include "io/variant/source_candidate_store.hpp"
 #include "core/types/variant.hpp"
 #include "variant_generator.hpp"
 
@@ -35,6 +36,7 @@ public:
     
     VcfExtractor(std::unique_ptr<VcfReader> reader);
     VcfExtractor(std::unique_ptr<VcfReader> reader, Options options);
+    VcfExtractor(std::shared_ptr<const SourceCandidateStore> store, Options options);
     
     VcfExtractor(const VcfExtractor&)            = default;
     VcfExtractor& operator=(const VcfExtractor&) = default;
@@ -49,10 +51,13 @@ private:
     std::string name() const override;
     
     mutable std::shared_ptr<VcfReader> reader_;
+    std::shared_ptr<const SourceCandidateStore> store_;
     Options options_;
     
     std::vector<Variant> fetch_variants(const GenomicRegion& region) const;
+    std::vector<Variant> fetch_stored_variants(const GenomicRegion& region) const;
     bool is_good(const VcfRecord& record) const;
+    bool is_good(const SourceCandidateStore::Candidate& candidate) const;
 };
 
 } // namespace coretools
@@ -30,6 +30,7 @@
 #include "haplotype.hpp"
 #include "indexed_haplotype.hpp"
 #include "shared_haplotype.hpp"
+#include "genotype_space.hpp"
 
 namespace octopus {
 
@@ -1333,6 +1334,39 @@ auto generate_all_genotypes(const Range& elements, const unsigned ploidy,
     return result_itr;
 }
 
+template <typename Range>
+auto generate_genotype(const Range& elements, const GenotypeSpace& space, const GenotypeSpace::Index index)
+{
+    return detail::generate_genotype(elements, space.unrank(index));
+}
+
+// Applies f to every genotype in the order of generate_all_genotypes, constructing one genotype at a time
+template <typename Range, typename UnaryFunction>
+void for_each_genotype(const Range& elements, const unsigned ploidy, UnaryFunction&& f)
+{
+    const GenotypeSpace space {static_cast<unsigned>(elements.size()), ploidy};
+    for (const auto& element_indices : space) {
+        f(detail::generate_genotype(elements, element_indices));
+    }
+}
+
+// The k genotypes with the greatest sum of element_scores (e.g. log haplotype posteriors) over their
+// elements, best first, without generating the others
+template <typename Range>
+auto generate_top_genotypes(const Range& elements, const unsigned ploidy, const std::vector<double>& element_scores,
+                            const std::size_t k)
+{
+    auto result = detail::construct_empty_genotype_container(elements);
+    if (ploidy == 0 || elements.empty()) return result;
+    const GenotypeSpace space {static_cast<unsigned>(elements.size()), ploidy};
+    const auto top_element_indices = select_top_k_genotypes(space, element_scores, k);
+    result.reserve(top_element_indices.size());
+    for (const auto& element_indices : top_element_indices) {
+        result.push_back(detail::generate_genotype(elements, element_indices));
+    }
+    return result;
+}
+
 std::size_t num_max_zygosity_genotypes(unsigned num_elements, unsigned ploidy);
 boost::optional<std::size_t> num_max_zygosity_genotypes_noexcept(unsigned num_elements, unsigned ploidy) noexcept;
 
@@ -0,0 +1,234 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "genotype_space.hpp"
+
+#include <algorithm>
+#include <numeric>
+#include <queue>
+#include <unordered_set>
+#include <limits>
+#include <stdexcept>
+#include <cassert>
+
+namespace octopus {
+
+namespace {
+
+constexpr auto saturated = std::numeric_limits<GenotypeSpace::Index>::max();
+
+} // namespace
+
+GenotypeSpace::GenotypeSpace(const unsigned num_elements, const unsigned ploidy)
+: num_elements_ {num_elements}
+, ploidy_ {ploidy}
+, size_ {0}
+, binomials_ {}
+{
+    if (num_elements_ == 0 || ploidy_ == 0) return;
+    // Pascal's triangle up to C(num_elements + ploidy - 1, ploidy), saturating on overflow
+    const auto num_rows = num_elements_ + ploidy_;
+    const auto num_cols = ploidy_ + 1;
+    binomials_.assign(num_rows * num_cols, 0);
+    for (unsigned n {0}; n < num_rows; ++n) {
+        binomials_[n * num_cols] = 1;
+        for (unsigned k {1}; k <= std::min(n, ploidy_); ++k) {
+            const auto a = binomials_[(n - 1) * num_cols + k - 1], b = binomials_[(n - 1) * num_cols + k];
+            binomials_[n * num_cols + k] = (a > saturated - b) ? saturated : a + b;
+        }
+    }
+    size_ = num_multisets(num_elements_, ploidy_);
+    if (size_ == saturated) {
+        throw std::overflow_error {"GenotypeSpace: number of genotypes overflows"};
+    }
+}
+
+unsigned GenotypeSpace::num_elements() const noexcept
+{
+    return num_elements_;
+}
+
+unsigned GenotypeSpace::ploidy() const noexcept
+{
+    return ploidy_;
+}
+
+GenotypeSpace::Index GenotypeSpace::size() const noexcept
+{
+    return size_;
+}
+
+bool GenotypeSpace::empty() const noexcept
+{
+    return size_ == 0;
+}
+
+GenotypeSpace::Index GenotypeSpace::rank(const ElementIndexVector& element_indices) const noexcept
+{
+    assert(element_indices.size() == ploidy_);
+    assert(std::is_sorted(std::cbegin(element_indices), std::cend(element_indices)));
+    // The genotypes preceding element_indices are, for each position j, those that match up to j and
+    // then take a smaller element at j. Summing the multiset counts over these smaller elements
+    // telescopes (hockey-stick identity) into two binomials.
+    Index result {0};
+    ElementIndex lo {0};
+    for (unsigned j {0}; j < ploidy_; ++j) {
+        const auto r = ploidy_ - j - 1;
+        const auto e = element_indices[j];
+        assert(e < num_elements_);
+        result += binomial(num_elements_ - lo + r, r + 1) - binomial(num_elements_ - e + r, r + 1);
+        lo = e;
+    }
+    return result;
+}
+
+GenotypeSpace::ElementIndexVector GenotypeSpace::unrank(const Index index) const
+{
+    ElementIndexVector result {};
+    unrank(index, result);
+    return result;
+}
+
+void GenotypeSpace::unrank(Index index, ElementIndexVector& result) const
+{
+    assert(index < size_);
+    result.resize(ploidy_);
+    ElementIndex e {0};
+    for (unsigned j {0}; j < ploidy_; ++j) {
+        const auto r = ploidy_ - j - 1;
+        for (; e < num_elements_ - 1; ++e) {
+            const auto count = num_multisets(num_elements_ - e, r);
+            if (index < count) break;
+            index -= count;
+        }
+        result[j] = e;
+    }
+}
+
+GenotypeSpace::const_iterator GenotypeSpace::begin() const
+{
+    return const_iterator {*this, 0};
+}
+
+GenotypeSpace::const_iterator GenotypeSpace::end() const
+{
+    return const_iterator {*this, size_};
+}
+
+GenotypeSpace::const_iterator GenotypeSpace::cbegin() const
+{
+    return begin();
+}
+
+GenotypeSpace::const_iterator GenotypeSpace::cend() const
+{
+    return end();
+}
+
+GenotypeSpace::Index GenotypeSpace::binomial(const unsigned n, const unsigned k) const noexcept
+{
+    if (k > n) return 0;
+    assert(n < num_elements_ + ploidy_ && k <= ploidy_);
+    return binomials_[n * (ploidy_ + 1) + k];
+}
+
+GenotypeSpace::Index GenotypeSpace::num_multisets(const unsigned num_elements, const unsigned size) const noexcept
+{
+    if (size == 0) return 1;
+    if (num_elements == 0) return 0;
+    return binomial(num_elements + size - 1, size);
+}
+
+// GenotypeSpace::const_iterator
+
+GenotypeSpace::const_iterator::const_iterator(const GenotypeSpace& space, const Index index)
+: element_indices_ {}
+, index_ {index}
+, num_elements_ {space.num_elements()}
+{
+    if (index_ < space.size()) space.unrank(index_, element_indices_);
+}
+
+GenotypeSpace::const_iterator& GenotypeSpace::const_iterator::operator++() noexcept
+{
+    // Increment the last element that can be incremented, and set all following elements equal to it
+    ++index_;
+    auto itr = std::find_if(element_indices_.rbegin(), element_indices_.rend(),
+                            [this] (auto e) noexcept { return e + 1 < num_elements_; });
+    if (itr != element_indices_.rend()) {
+        const auto e = ++(*itr);
+        std::fill(itr.base(), element_indices_.end(), e);
+    }
+    return *this;
+}
+
+GenotypeSpace::const_iterator GenotypeSpace::const_iterator::operator++(int) noexcept
+{
+    auto result = *this;
+    ++(*this);
+    return result;
+}
+
+// non-member methods
+
+namespace {
+
+struct ScoredGenotype
+{
+    double score;
+    GenotypeSpace::ElementIndexVector positions;
+};
+
+bool operator<(const ScoredGenotype& lhs, const ScoredGenotype& rhs) noexcept
+{
+    return lhs.score < rhs.score;
+}
+
+} // namespace
+
+std::vector<GenotypeSpace::ElementIndexVector>
+select_top_k_genotypes(const GenotypeSpace& space, const std::vector<double>& element_scores, const std::size_t k)
+{
+    assert(element_scores.size() == space.num_elements());
+    std::vector<GenotypeSpace::ElementIndexVector> result {};
+    if (space.empty() || k == 0) return result;
+    result.reserve(std::min(k, space.size()));
+    // Search over positions in the elements sorted by decreasing score, so that incrementing any
+    // position of a genotype never increases its score
+    std::vector<GenotypeSpace::ElementIndex> order(space.num_elements());
+    std::iota(std::begin(order), std::end(order), 0);
+    std::stable_sort(std::begin(order), std::end(order),
+                     [&] (auto lhs, auto rhs) { return element_scores[lhs] > element_scores[rhs]; });
+    const auto score = [&] (const GenotypeSpace::ElementIndexVector& positions) {
+        return std::accumulate(std::cbegin(positions), std::cend(positions), 0.0,
+                               [&] (double total, auto p) { return total + element_scores[order[p]]; });
+    };
+    std::priority_queue<ScoredGenotype> frontier {};
+    std::unordered_set<GenotypeSpace::Index> seen {};
+    GenotypeSpace::ElementIndexVector best(space.ploidy(), 0);
+    seen.insert(space.rank(best));
+    frontier.push({score(best), std::move(best)});
+    while (!frontier.empty() && result.size() < k) {
+        auto top = frontier.top();
+        frontier.pop();
+        const auto num_positions = top.positions.size();
+        for (std::size_t j {0}; j < num_positions; ++j) {
+            auto& p = top.positions[j];
+            if (p + 1 < space.num_elements() && (j + 1 == num_positions || p < top.positions[j + 1])) {
+                ++p;
+                if (seen.insert(space.rank(top.positions)).second) {
+                    frontier.push({score(top.positions), top.positions});
+                }
+                --p;
+            }
+        }
+        GenotypeSpace::ElementIndexVector genotype(num_positions);
+        std::transform(std::cbegin(top.positions), std::cend(top.positions), std::begin(genotype),
+                       [&] (auto p) { return order[p]; });
+        std::sort(std::begin(genotype), std::end(genotype));
+        result.push_back(std::move(genotype));
+    }
+    return result;
+}
+
+} // namespace octopus
@@ -0,0 +1,107 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef genotype_space_hpp
+#define genotype_space_hpp
+
+#include <vector>
+#include <cstddef>
+#include <iterator>
+
+namespace octopus {
+
+/*
+ GenotypeSpace indexes every genotype (multiset) of ploidy elements drawn from num_elements elements,
+ without materialising them. A genotype is represented by its element indices in ascending order,
+ and genotypes are ranked in lexicographical order of these, which is the order
+ generate_all_genotypes generates them in. Ranking and unranking use the combinatorial number system.
+ */
+class GenotypeSpace
+{
+public:
+    using Index = std::size_t;
+    using ElementIndex = unsigned;
+    using ElementIndexVector = std::vector<ElementIndex>;
+
+    class const_iterator;
+
+    GenotypeSpace() = default;
+
+    // Throws std::overflow_error if the number of genotypes does not fit in an Index
+    GenotypeSpace(unsigned num_elements, unsigned ploidy);
+
+    GenotypeSpace(const GenotypeSpace&)            = default;
+    GenotypeSpace& operator=(const GenotypeSpace&) = default;
+    GenotypeSpace(GenotypeSpace&&)                 = default;
+    GenotypeSpace& operator=(GenotypeSpace&&)      = default;
+
+    ~GenotypeSpace() = default;
+
+    unsigned num_elements() const noexcept;
+    unsigned ploidy() const noexcept;
+    Index size() const noexcept;
+    bool empty() const noexcept;
+
+    // element_indices must be sorted in ascending order
+    Index rank(const ElementIndexVector& element_indices) const noexcept;
+    ElementIndexVector unrank(Index index) const;
+    void unrank(Index index, ElementIndexVector& result) const;
+
+    const_iterator begin() const;
+    const_iterator end() const;
+    const_iterator cbegin() const;
+    const_iterator cend() const;
+
+private:
+    unsigned num_elements_ = 0, ploidy_ = 0;
+    Index size_ = 0;
+    std::vector<Index> binomials_;
+
+    Index binomial(unsigned n, unsigned k) const noexcept;
+    Index num_multisets(unsigned num_elements, unsigned size) const noexcept;
+};
+
+class GenotypeSpace::const_iterator
+{
+public:
+    using iterator_category = std::forward_iterator_tag;
+    using value_type        = ElementIndexVector;
+    using difference_type   = std::ptrdiff_t;
+    using pointer           = const ElementIndexVector*;
+    using reference         = const ElementIndexVector&;
+
+    const_iterator() = default;
+
+    const_iterator(const GenotypeSpace& space, Index index);
+
+    reference operator*() const noexcept { return element_indices_; }
+    pointer operator->() const noexcept { return &element_indices_; }
+
+    const_iterator& operator++() noexcept;
+    const_iterator operator++(int) noexcept;
+
+    Index index() const noexcept { return index_; }
+
+    friend bool operator==(const const_iterator& lhs, const const_iterator& rhs) noexcept
+    {
+        return lhs.index_ == rhs.index_;
+    }
+    friend bool operator!=(const const_iterator& lhs, const const_iterator& rhs) noexcept
+    {
+        return !(lhs == rhs);
+    }
+
+private:
+    ElementIndexVector element_indices_;
+    Index index_ = 0;
+    unsigned num_elements_ = 0;
+};
+
+// The k genotypes with the greatest sum of element scores (e.g. haplotype log posteriors) over their
+// elements, best first, found by best-first search rather than scoring every genotype in the space
+std::vector<GenotypeSpace::ElementIndexVector>
+select_top_k_genotypes(const GenotypeSpace& space, const std::vector<double>& element_scores, std::size_t k);
+
+} // namespace octopus
+
+#endif
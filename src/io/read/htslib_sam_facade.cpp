@@ -25,7 +25,10 @@
 #include "exceptions/malformed_file_error.hpp"
 #include "exceptions/unwritable_file_error.hpp"
 #include "utils/string_utils.hpp"
+#include "config/common.hpp"
+#include "logging/logging.hpp"
 #include "annotated_aligned_read.hpp"
+#include "read_index_cache.hpp"
 
 #include <iostream>
 
@@ -177,17 +180,21 @@ bool is_cram(const boost::filesystem::path& file)
 
 } // namespace
 
-HtslibSamFacade::HtslibSamFacade(Path file_path)
+HtslibSamFacade::HtslibSamFacade(Path file_path, const unsigned max_handles, std::shared_ptr<ReadIndexCache> index_cache)
 : file_path_ {std::move(file_path)}
 , hts_file_ {open_hts_file(file_path_), HtsFileDeleter {}}
-, hts_header_ {(hts_file_) ? sam_hdr_read(hts_file_.get()) : nullptr, HtsHeaderDeleter {}}
-, hts_index_ {(hts_file_) ? sam_index_load(hts_file_.get(), file_path_.c_str()) : nullptr, HtsIndexDeleter {}}
+, hts_header_ {}
+, hts_index_ {}
+, index_cache_ {std::move(index_cache)}
 , hts_targets_ {}
 , contig_names_ {}
 , sample_names_ {}
 , samples_ {}
+, max_handles_ {std::max(max_handles, 1u)}
+, handles_ {}
 {
     namespace fs = boost::filesystem;
+    load_header_and_index();
     if (!hts_file_) {
         if (!fs::exists(file_path_)) {
             if (is_cram(file_path_)) {
@@ -223,6 +230,7 @@ HtslibSamFacade::HtslibSamFacade(Path file_path)
     }
     samples_.shrink_to_fit();
     std::sort(std::begin(samples_), std::end(samples_));
+    reset_handles();
 }
 
 auto open_hts_writable_file(const boost::filesystem::path& path)
@@ -245,6 +253,7 @@ HtslibSamFacade::HtslibSamFacade(Path sam_out, Path sam_template)
     if (!hts_file_) {
         throw UnwritableBAM {std::move(file_path_)};
     }
+    handles_.reset();
     hts_index_ = nullptr;
     if (sam_hdr_write(hts_file_.get(), hts_header_.get()) < 0) {
         throw UnwritableBAM {std::move(file_path_)};
@@ -254,7 +263,7 @@ HtslibSamFacade::HtslibSamFacade(Path sam_out, Path sam_template)
 HtslibSamFacade::~HtslibSamFacade()
 {
     if (!hts_index_) {
-        hts_header_.reset(nullptr);
+        hts_header_.reset();
         hts_file_.reset(nullptr);
         if (sam_index_build(file_path_.c_str(), 0) < 0) {
             return;
@@ -270,17 +279,16 @@ bool HtslibSamFacade::is_open() const noexcept
 void HtslibSamFacade::open()
 {
     hts_file_.reset(sam_open(file_path_.string().c_str(), "r"));
-    if (hts_file_) {
-        hts_header_.reset(sam_hdr_read(hts_file_.get()));
-        hts_index_.reset(sam_index_load(hts_file_.get(), file_path_.c_str()));
-    }
+    load_header_and_index();
+    if (is_open()) reset_handles();
 }
 
 void HtslibSamFacade::close()
 {
+    handles_.reset();
     hts_file_.reset(nullptr);
-    hts_header_.reset(nullptr);
-    hts_index_.reset(nullptr);
+    hts_header_.reset();
+    hts_index_.reset();
 }
 
 GenomicRegion::Size HtslibSamFacade::reference_size(const GenomicRegion::ContigName& contig) const
@@ -864,6 +872,140 @@ const std::string& HtslibSamFacade::get_contig_name(HtsTid target) const
     return contig_names_.at(target);
 }
 
+namespace {
+
+std::shared_ptr<bam_hdr_t> make_shared_header(bam_hdr_t* header)
+{
+    if (!header) return nullptr;
+    return std::shared_ptr<bam_hdr_t> {header, bam_hdr_destroy};
+}
+
+std::shared_ptr<hts_idx_t> make_shared_index(hts_idx_t* index)
+{
+    if (!index) return nullptr;
+    return std::shared_ptr<hts_idx_t> {index, hts_idx_destroy};
+}
+
+} // namespace
+
+void HtslibSamFacade::load_header_and_index()
+{
+    hts_header_.reset();
+    hts_index_.reset();
+    if (!hts_file_) return;
+    // CRAM indices are bound to the file handle that loaded them so cannot be shared
+    const bool use_cache {index_cache_ && !hts_file_->is_cram};
+    if (use_cache) {
+        auto cached = index_cache_->find(file_path_);
+        if (cached) {
+            // BAM iterators seek directly to indexed offsets so the header need not be read again
+            hts_header_ = std::move(cached->header);
+            hts_index_  = std::move(cached->index);
+            return;
+        }
+    }
+    hts_header_ = make_shared_header(sam_hdr_read(hts_file_.get()));
+    if (hts_header_) hts_index_ = make_shared_index(sam_index_load(hts_file_.get(), file_path_.c_str()));
+    if (use_cache && hts_header_ && hts_index_) {
+        // Build the name dictionary before the header is shared between threads, as htslib builds it lazily
+        if (hts_header_->n_targets > 0) bam_name2id(hts_header_.get(), hts_header_->target_name[0]);
+        index_cache_->insert(file_path_, {hts_header_, hts_index_});
+    }
+}
+
+// HandlePool
+
+void HtslibSamFacade::reset_handles()
+{
+    // Name lookups build a header dictionary on first use, so build it before the header is shared
+    if (hts_header_->n_targets > 0) bam_name2id(hts_header_.get(), hts_header_->target_name[0]);
+    auto primary = std::make_unique<ReaderHandle>();
+    primary->file   = hts_file_.get();
+    primary->header = hts_header_.get();
+    primary->index  = hts_index_.get();
+    handles_ = std::make_unique<HandlePool>(std::move(primary), max_handles_, file_path_);
+}
+
+std::unique_ptr<HtslibSamFacade::ReaderHandle> HtslibSamFacade::open_handle() const
+{
+    auto result = std::make_unique<ReaderHandle>();
+    result->owned_file.reset(open_hts_file(file_path_));
+    if (!result->owned_file) return nullptr;
+    if (result->owned_file->is_cram) {
+        result->owned_header.reset(sam_hdr_read(result->owned_file.get()));
+        if (!result->owned_header) return nullptr;
+        result->owned_index.reset(sam_index_load(result->owned_file.get(), file_path_.c_str()));
+        if (!result->owned_index) return nullptr;
+        result->header = result->owned_header.get();
+        result->index  = result->owned_index.get();
+    } else {
+        // BAM iterators seek directly to indexed offsets so the header need not be read
+        result->header = hts_header_.get();
+        result->index  = hts_index_.get();
+    }
+    result->file = result->owned_file.get();
+    return result;
+}
+
+void HtslibSamFacade::HandleReturner::operator()(ReaderHandle* handle) const
+{
+    pool->release(handle);
+}
+
+HtslibSamFacade::HandlePool::HandlePool(std::unique_ptr<ReaderHandle> primary, const unsigned max_handles, Path file_path)
+: file_path_ {std::move(file_path)}
+, idle_ {}
+, max_handles_ {max_handles}
+, num_handles_ {1}
+, num_acquires_ {0}
+, num_waits_ {0}
+, mutex_ {}
+, available_ {}
+{
+    idle_.reserve(max_handles_);
+    idle_.push_back(std::move(primary));
+}
+
+HtslibSamFacade::HandlePool::~HandlePool()
+{
+    static auto debug_log = logging::get_debug_log();
+    if (debug_log && num_acquires_ > 0) {
+        stream(*debug_log) << "Read file " << file_path_ << " served " << num_acquires_ << " iterators with "
+                           << num_handles_ << " handles; " << num_waits_ << " waited for a free handle";
+    }
+}
+
+HtslibSamFacade::PooledHandle HtslibSamFacade::HandlePool::acquire(const HtslibSamFacade& facade)
+{
+    std::unique_lock<std::mutex> lock {mutex_};
+    ++num_acquires_;
+    if (idle_.empty() && num_handles_ < max_handles_) {
+        ++num_handles_;
+        lock.unlock();
+        auto handle = facade.open_handle();
+        if (handle) return PooledHandle {handle.release(), HandleReturner {this}};
+        // Probably hit the open file limit, so make do with the handles we have
+        lock.lock();
+        --num_handles_;
+        max_handles_ = num_handles_;
+    }
+    if (idle_.empty()) {
+        ++num_waits_;
+        available_.wait(lock, [this] () { return !idle_.empty(); });
+    }
+    auto result = std::move(idle_.back());
+    idle_.pop_back();
+    return PooledHandle {result.release(), HandleReturner {this}};
+}
+
+void HtslibSamFacade::HandlePool::release(ReaderHandle* handle)
+{
+    std::unique_lock<std::mutex> lock {mutex_};
+    idle_.emplace_back(handle);
+    lock.unlock();
+    available_.notify_one();
+}
+
 // HtslibIterator
 
 auto make_hts_iterator(const hts_idx_t* idx, bam_hdr_t* hdr, const GenomicRegion& region)
@@ -874,9 +1016,8 @@ auto make_hts_iterator(const hts_idx_t* idx, bam_hdr_t* hdr, const GenomicRegion
 
 HtslibSamFacade::HtslibIterator::HtslibIterator(const HtslibSamFacade& hts_facade, const GenomicRegion& region)
 : hts_facade_ {hts_facade}
-, hts_iterator_ {hts_facade.is_open()
-        ? make_hts_iterator(hts_facade_.hts_index_.get(), hts_facade_.hts_header_.get(), region)
-    : nullptr, HtsIteratorDeleter {}}
+, handle_ {hts_facade.is_open() ? hts_facade.handles_->acquire(hts_facade) : PooledHandle {nullptr, HandleReturner {nullptr}}}
+, hts_iterator_ {handle_ ? make_hts_iterator(handle_->index, handle_->header, region) : nullptr, HtsIteratorDeleter {}}
 , hts_bam1_ {bam_init1(), HtsBam1Deleter {}}
 {
     if (hts_iterator_ == nullptr) {
@@ -889,8 +1030,8 @@ HtslibSamFacade::HtslibIterator::HtslibIterator(const HtslibSamFacade& hts_facad
 
 HtslibSamFacade::HtslibIterator::HtslibIterator(const HtslibSamFacade& hts_facade, const GenomicRegion::ContigName& contig)
 : hts_facade_ {hts_facade}
-, hts_iterator_ {hts_facade.is_open() ? sam_itr_querys(hts_facade_.hts_index_.get(), hts_facade_.hts_header_.get(),
-                                                     contig.c_str()) : nullptr, HtsIteratorDeleter {}}
+, handle_ {hts_facade.is_open() ? hts_facade.handles_->acquire(hts_facade) : PooledHandle {nullptr, HandleReturner {nullptr}}}
+, hts_iterator_ {handle_ ? sam_itr_querys(handle_->index, handle_->header, contig.c_str()) : nullptr, HtsIteratorDeleter {}}
 , hts_bam1_ {bam_init1(), HtsBam1Deleter {}}
 {
     if (hts_iterator_ == nullptr) {
@@ -908,7 +1049,7 @@ std::string extract_read_name(const bam1_t* b)
 
 bool HtslibSamFacade::HtslibIterator::operator++()
 {
-    return sam_itr_next(hts_facade_.hts_file_.get(), hts_iterator_.get(), hts_bam1_.get()) >= 0;
+    return sam_itr_next(handle_->file, hts_iterator_.get(), hts_bam1_.get()) >= 0;
 }
 
 auto extract_read_pos(const bam1_t* b) noexcept
@@ -11,6 +11,8 @@
 #include <cstdint>
 #include <memory>
 #include <utility>
+#include <mutex>
+#include <condition_variable>
 
 #include <boost/filesystem/path.hpp>
 #include <boost/optional.hpp>
@@ -29,6 +31,8 @@ class AnnotatedAlignedRead;
 
 namespace io {
 
+class ReadIndexCache;
+
 class HtslibSamFacade : public IReadReaderImpl
 {
 public:
@@ -47,7 +51,7 @@ public:
     
     HtslibSamFacade() = delete;
     
-    HtslibSamFacade(Path file_path);
+    HtslibSamFacade(Path file_path, unsigned max_handles = 1, std::shared_ptr<ReadIndexCache> index_cache = nullptr);
     HtslibSamFacade(Path sam_out, Path sam_template);
     
     HtslibSamFacade(const HtslibSamFacade&)            = delete;
@@ -138,6 +142,56 @@ private:
         void operator()(bam1_t* b) const { bam_destroy1(b); }
     };
     
+    // An independent file position for iteration. Handles opened by the pool own their file; BAM
+    // handles share the facade's header and index, but CRAM indices are bound to a file handle so
+    // each CRAM handle loads its own.
+    struct ReaderHandle
+    {
+        htsFile* file;
+        bam_hdr_t* header;
+        const hts_idx_t* index;
+        std::unique_ptr<htsFile, HtsFileDeleter> owned_file = nullptr;
+        std::unique_ptr<bam_hdr_t, HtsHeaderDeleter> owned_header = nullptr;
+        std::unique_ptr<hts_idx_t, HtsIndexDeleter> owned_index = nullptr;
+    };
+    
+    class HandlePool;
+    
+    struct HandleReturner
+    {
+        HandlePool* pool;
+        void operator()(ReaderHandle* handle) const;
+    };
+    
+    using PooledHandle = std::unique_ptr<ReaderHandle, HandleReturner>;
+    
+    // Checks out handles for concurrent iteration, opening new ones on demand up to max_handles
+    class HandlePool
+    {
+    public:
+        HandlePool() = delete;
+        
+        HandlePool(std::unique_ptr<ReaderHandle> primary, unsigned max_handles, Path file_path);
+        
+        HandlePool(const HandlePool&)            = delete;
+        HandlePool& operator=(const HandlePool&) = delete;
+        HandlePool(HandlePool&&)                 = delete;
+        HandlePool& operator=(HandlePool&&)      = delete;
+        
+        ~HandlePool();
+        
+        PooledHandle acquire(const HtslibSamFacade& facade);
+        void release(ReaderHandle* handle);
+        
+    private:
+        Path file_path_;
+        std::vector<std::unique_ptr<ReaderHandle>> idle_;
+        unsigned max_handles_, num_handles_;
+        std::size_t num_acquires_, num_waits_;
+        std::mutex mutex_;
+        std::condition_variable available_;
+    };
+    
     class HtslibIterator
     {
     public:
@@ -172,6 +226,7 @@ private:
         
         const HtslibSamFacade& hts_facade_;
         
+        PooledHandle handle_;
         std::unique_ptr<hts_itr_t, HtsIteratorDeleter> hts_iterator_;
         std::unique_ptr<bam1_t, HtsBam1Deleter> hts_bam1_;
     };
@@ -179,8 +234,10 @@ private:
     Path file_path_;
     
     std::unique_ptr<htsFile, HtsFileDeleter> hts_file_;
-    std::unique_ptr<bam_hdr_t, HtsHeaderDeleter> hts_header_;
-    std::unique_ptr<hts_idx_t, HtsIndexDeleter> hts_index_;
+    // Shared with the index cache, if any
+    std::shared_ptr<bam_hdr_t> hts_header_;
+    std::shared_ptr<hts_idx_t> hts_index_;
+    std::shared_ptr<ReadIndexCache> index_cache_;
     
     std::unordered_map<GenomicRegion::ContigName, HtsTid> hts_targets_;
     std::unordered_map<HtsTid, GenomicRegion::ContigName> contig_names_;
@@ -188,7 +245,13 @@ private:
     
     std::vector<SampleName> samples_;
     
+    unsigned max_handles_;
+    std::unique_ptr<HandlePool> handles_;
+    
+    void load_header_and_index();
     void init_maps();
+    void reset_handles();
+    std::unique_ptr<ReaderHandle> open_handle() const;
     HtsTid get_htslib_target(const GenomicRegion::ContigName& contig) const;
     const GenomicRegion::ContigName& get_contig_name(HtsTid target) const;
     std::uint64_t get_num_mapped_reads(const GenomicRegion::ContigName& contig) const;
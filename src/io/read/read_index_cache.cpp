@@ -0,0 +1,90 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "read_index_cache.hpp"
+
+#include <array>
+#include <cstring>
+#include <cstdint>
+
+#include <boost/filesystem/operations.hpp>
+
+namespace octopus { namespace io {
+
+namespace fs = boost::filesystem;
+
+ReadIndexCache::ReadIndexCache(std::size_t max_bytes)
+: max_bytes_ {max_bytes}
+, num_bytes_ {0}
+, entries_ {}
+, lookup_ {}
+, stats_ {0, 0, 0}
+, mutex_ {}
+{}
+
+boost::optional<ReadIndexCache::Entry> ReadIndexCache::find(const Path& file)
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    const auto itr = lookup_.find(file);
+    if (itr == std::cend(lookup_)) {
+        ++stats_.misses;
+        return boost::none;
+    }
+    ++stats_.hits;
+    entries_.splice(std::begin(entries_), entries_, itr->second);
+    return itr->second->entry;
+}
+
+void ReadIndexCache::insert(const Path& file, Entry entry)
+{
+    if (!entry.header || !entry.index) return;
+    const auto bytes = estimate_bytes(file, entry);
+    if (bytes > max_bytes_) return;
+    std::lock_guard<std::mutex> lock {mutex_};
+    const auto itr = lookup_.find(file);
+    if (itr != std::cend(lookup_)) {
+        num_bytes_ -= itr->second->bytes;
+        entries_.erase(itr->second);
+        lookup_.erase(itr);
+    }
+    while (!entries_.empty() && num_bytes_ + bytes > max_bytes_) {
+        num_bytes_ -= entries_.back().bytes;
+        lookup_.erase(entries_.back().file);
+        entries_.pop_back();
+        ++stats_.evictions;
+    }
+    entries_.push_front({file, std::move(entry), bytes});
+    lookup_.emplace(file, std::begin(entries_));
+    num_bytes_ += bytes;
+}
+
+ReadIndexCache::Stats ReadIndexCache::stats() const
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    return stats_;
+}
+
+// htslib does not report index memory usage, but the in-memory index is about the size of the index file
+std::size_t ReadIndexCache::estimate_bytes(const Path& file, const Entry& entry) const
+{
+    std::size_t result {sizeof(bam_hdr_t) + entry.header->l_text};
+    for (int target {0}; target < entry.header->n_targets; ++target) {
+        result += std::strlen(entry.header->target_name[target]) + sizeof(std::uint32_t);
+    }
+    const std::array<Path, 4> index_candidates {
+        file.string() + ".bai", fs::path {file}.replace_extension(".bai"),
+        file.string() + ".csi", file.string() + ".crai"
+    };
+    for (const auto& index_path : index_candidates) {
+        boost::system::error_code ec {};
+        const auto index_size = fs::file_size(index_path, ec);
+        if (!ec) {
+            result += index_size;
+            break;
+        }
+    }
+    return result;
+}
+
+} // namespace io
+} // namespace octopus
@@ -0,0 +1,85 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef read_index_cache_hpp
+#define read_index_cache_hpp
+
+#include <list>
+#include <unordered_map>
+#include <memory>
+#include <utility>
+#include <cstddef>
+#include <mutex>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
+
+#include "htslib/hts.h"
+#include "htslib/sam.h"
+
+#include "utils/hash_functions.hpp"
+
+namespace octopus { namespace io {
+
+/*
+ ReadIndexCache keeps the parsed headers and indices of recently opened alignment files, up to a
+ memory budget, independently of the file handles. Read files that are closed to respect the open
+ file limit can then be reopened without reloading the header and index from disk.
+
+ Entries are shared, so evicting an entry does not invalidate readers still using it.
+ */
+class ReadIndexCache
+{
+public:
+    using Path = boost::filesystem::path;
+
+    struct Entry
+    {
+        std::shared_ptr<bam_hdr_t> header;
+        std::shared_ptr<hts_idx_t> index;
+    };
+
+    struct Stats
+    {
+        std::size_t hits, misses, evictions;
+    };
+
+    ReadIndexCache() = delete;
+
+    ReadIndexCache(std::size_t max_bytes);
+
+    ReadIndexCache(const ReadIndexCache&)            = delete;
+    ReadIndexCache& operator=(const ReadIndexCache&) = delete;
+    ReadIndexCache(ReadIndexCache&&)                 = delete;
+    ReadIndexCache& operator=(ReadIndexCache&&)      = delete;
+
+    ~ReadIndexCache() = default;
+
+    boost::optional<Entry> find(const Path& file);
+    void insert(const Path& file, Entry entry);
+
+    Stats stats() const;
+
+private:
+    struct CachedEntry
+    {
+        Path file;
+        Entry entry;
+        std::size_t bytes;
+    };
+
+    using EntryList = std::list<CachedEntry>;
+
+    std::size_t max_bytes_, num_bytes_;
+    EntryList entries_; // most recently used first
+    std::unordered_map<Path, EntryList::iterator, utils::FilepathHash> lookup_;
+    Stats stats_;
+    mutable std::mutex mutex_;
+
+    std::size_t estimate_bytes(const Path& file, const Entry& entry) const;
+};
+
+} // namespace io
+} // namespace octopus
+
+#endif
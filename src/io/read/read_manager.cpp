@@ -15,12 +15,29 @@
 #include "basics/aligned_read.hpp"
 #include "utils/append.hpp"
 #include "utils/coverage_tracker.hpp"
+#include "config/common.hpp"
+#include "logging/logging.hpp"
+#include "read_index_cache.hpp"
 
 namespace octopus { namespace io {
 
-ReadManager::ReadManager(std::vector<Path> read_file_paths, unsigned max_open_files)
+namespace {
+
+// Each open reader may hold up to one handle per thread, but the total number of open handles
+// should still respect max_open_files
+unsigned calculate_max_handles_per_file(const unsigned max_open_files, const std::size_t num_files, const unsigned max_threads)
+{
+    const auto num_open_files = std::max(std::min(static_cast<unsigned>(num_files), max_open_files), 1u);
+    return std::max(std::min(max_threads, max_open_files / num_open_files), 1u);
+}
+
+} // namespace
+
+ReadManager::ReadManager(std::vector<Path> read_file_paths, unsigned max_open_files, unsigned max_threads,
+                         std::size_t max_index_cache_bytes)
 : max_open_files_ {max_open_files}
 , num_files_ {static_cast<unsigned>(read_file_paths.size())}
+, max_handles_per_file_ {calculate_max_handles_per_file(max_open_files, read_file_paths.size(), max_threads)}
 , all_readers_single_sample_ {true}
 , closed_readers_ {
     std::make_move_iterator(std::begin(read_file_paths)),
@@ -29,6 +46,8 @@ ReadManager::ReadManager(std::vector<Path> read_file_paths, unsigned max_open_fi
 , reader_paths_containing_sample_ {}
 , possible_regions_in_readers_ {}
 , samples_ {}
+, index_cache_ {max_index_cache_bytes > 0 ? std::make_shared<ReadIndexCache>(max_index_cache_bytes) : nullptr}
+, previously_opened_readers_ {}
 {
     setup_reader_samples_and_regions();
     open_initial_files();
@@ -56,62 +75,94 @@ ReadManager::ReadManager(std::initializer_list<Path> read_file_paths)
 
 ReadManager::ReadManager(ReadManager&& other)
 {
-    std::lock_guard<std::mutex> lock {other.mutex_};
+    std::lock_guard<std::shared_timed_mutex> lock {other.mutex_};
     using std::move;
     max_open_files_                 = move(other.max_open_files_);
     num_files_                      = move(other.num_files_);
+    max_handles_per_file_           = move(other.max_handles_per_file_);
     all_readers_single_sample_      = move(other.all_readers_single_sample_);
     closed_readers_                 = move(other.closed_readers_);
     open_readers_                   = move(other.open_readers_);
     reader_paths_containing_sample_ = move(other.reader_paths_containing_sample_);
     possible_regions_in_readers_    = move(other.possible_regions_in_readers_);
     samples_                        = move(other.samples_);
+    index_cache_                    = move(other.index_cache_);
+    previously_opened_readers_      = move(other.previously_opened_readers_);
+    num_reopens_                    = other.num_reopens_;
+    num_exclusive_checkouts_        = other.num_exclusive_checkouts_;
+    other.num_reopens_ = other.num_exclusive_checkouts_ = 0;
 }
 
 ReadManager& ReadManager::operator=(ReadManager&& other)
 {
     if (this != &other) {
-        std::unique_lock<std::mutex> lock_lhs {mutex_, std::defer_lock}, lock_rhs {other.mutex_, std::defer_lock};
+        std::unique_lock<std::shared_timed_mutex> lock_lhs {mutex_, std::defer_lock}, lock_rhs {other.mutex_, std::defer_lock};
         std::lock(lock_lhs, lock_rhs);
         using std::move;
         max_open_files_                 = move(other.max_open_files_);
         num_files_                      = move(other.num_files_);
+        max_handles_per_file_           = move(other.max_handles_per_file_);
         all_readers_single_sample_      = move(other.all_readers_single_sample_);
         closed_readers_                 = move(other.closed_readers_);
         open_readers_                   = move(other.open_readers_);
         reader_paths_containing_sample_ = move(other.reader_paths_containing_sample_);
         possible_regions_in_readers_    = move(other.possible_regions_in_readers_);
         samples_                        = move(other.samples_);
+        index_cache_                    = move(other.index_cache_);
+        previously_opened_readers_      = move(other.previously_opened_readers_);
+        num_reopens_                    = other.num_reopens_;
+        num_exclusive_checkouts_        = other.num_exclusive_checkouts_;
+        other.num_reopens_ = other.num_exclusive_checkouts_ = 0;
     }
     return *this;
 }
 
+ReadManager::~ReadManager()
+{
+    static auto debug_log = logging::get_debug_log();
+    if (debug_log && num_reopens_ > 0) {
+        auto log = stream(*debug_log);
+        log << "ReadManager reopened read files " << num_reopens_ << " times over "
+            << num_exclusive_checkouts_ << " queries that needed to open files";
+        if (index_cache_) {
+            const auto stats = index_cache_->stats();
+            log << "; index cache hits: " << stats.hits << ", misses: " << stats.misses
+                << ", evictions: " << stats.evictions;
+        }
+    }
+}
+
 void swap(ReadManager& lhs, ReadManager& rhs) noexcept
 {
     if (&lhs == &rhs) return;
     std::lock(lhs.mutex_, rhs.mutex_);
-    std::lock_guard<std::mutex> lock_lhs {lhs.mutex_, std::adopt_lock}, lock_rhs {rhs.mutex_, std::adopt_lock};
+    std::lock_guard<std::shared_timed_mutex> lock_lhs {lhs.mutex_, std::adopt_lock}, lock_rhs {rhs.mutex_, std::adopt_lock};
     using std::swap;
     swap(lhs.max_open_files_,                 rhs.max_open_files_);
     swap(lhs.num_files_,                      rhs.num_files_);
+    swap(lhs.max_handles_per_file_,           rhs.max_handles_per_file_);
     swap(lhs.all_readers_single_sample_,             rhs.all_readers_single_sample_);
     swap(lhs.closed_readers_,                 rhs.closed_readers_);
     swap(lhs.open_readers_,                   rhs.open_readers_);
     swap(lhs.reader_paths_containing_sample_, rhs.reader_paths_containing_sample_);
     swap(lhs.possible_regions_in_readers_,    rhs.possible_regions_in_readers_);
     swap(lhs.samples_,                        rhs.samples_);
+    swap(lhs.index_cache_,                    rhs.index_cache_);
+    swap(lhs.previously_opened_readers_,      rhs.previously_opened_readers_);
+    swap(lhs.num_reopens_,                    rhs.num_reopens_);
+    swap(lhs.num_exclusive_checkouts_,        rhs.num_exclusive_checkouts_);
 }
 
 void ReadManager::close() const noexcept
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::lock_guard<std::shared_timed_mutex> lock {mutex_};
     close_readers(num_files_);
 }
 
 bool ReadManager::good() const noexcept
 {
     return std::all_of(std::cbegin(open_readers_), std::cend(open_readers_),
-                       [] (const auto& p) { return p.second.is_open(); });
+                       [] (const auto& p) { return p.second->is_open(); });
 }
 
 unsigned ReadManager::num_files() const noexcept
@@ -119,11 +170,16 @@ unsigned ReadManager::num_files() const noexcept
     return static_cast<unsigned>(closed_readers_.size() + open_readers_.size());
 }
 
+unsigned ReadManager::max_open_files() const noexcept
+{
+    return max_open_files_;
+}
+
 std::vector<ReadManager::Path> ReadManager::paths() const
 {
     std::vector<Path> result {};
     result.reserve(num_files_);
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     for (const auto& path : closed_readers_) {
         result.push_back(path);
     }
@@ -246,20 +302,15 @@ bool ReadManager::has_reads(const std::vector<SampleName>& samples, const Genomi
 {
     if (all_readers_are_open()) {
         return std::any_of(std::cbegin(open_readers_), std::cend(open_readers_),
-                           [&] (const auto& p) { return p.second.has_reads(samples, region); });
+                           [&] (const auto& p) { return p.second->has_reads(samples, region); });
     } else {
-        std::lock_guard<std::mutex> lock {mutex_};
         auto reader_paths = get_reader_paths_containing_samples(samples);
-        auto reader_itr = partition_open(reader_paths);
         while (!reader_paths.empty()) {
-            if (std::any_of(reader_itr, end(reader_paths),
-                            [this, &region, &samples] (const auto& reader_path) {
-                                return open_readers_.at(reader_path).has_reads(samples, region);
-                            })) {
+            const auto readers = checkout_readers(reader_paths);
+            if (std::any_of(std::cbegin(readers), std::cend(readers),
+                            [&] (const auto& reader) { return reader->has_reads(samples, region); })) {
                 return true;
             }
-            reader_paths.erase(reader_itr, end(reader_paths));
-            reader_itr = open_readers(begin(reader_paths), end(reader_paths));
         }
         return false;
     }
@@ -269,20 +320,15 @@ bool ReadManager::has_reads(const GenomicRegion& region) const
 {
     if (all_readers_are_open()) {
         return std::any_of(std::cbegin(open_readers_), std::cend(open_readers_),
-                           [&] (const auto& p) { return p.second.has_reads(region); });
+                           [&] (const auto& p) { return p.second->has_reads(region); });
     } else {
-        std::lock_guard<std::mutex> lock {mutex_};
         auto reader_paths = get_reader_paths_containing_samples(samples());
-        auto reader_itr = partition_open(reader_paths);
         while (!reader_paths.empty()) {
-            if (std::any_of(reader_itr, end(reader_paths),
-                            [this, &region] (const auto& reader_path) {
-                                return open_readers_.at(reader_path).has_reads(region);
-                            })) {
+            const auto readers = checkout_readers(reader_paths);
+            if (std::any_of(std::cbegin(readers), std::cend(readers),
+                            [&] (const auto& reader) { return reader->has_reads(region); })) {
                 return true;
             }
-            reader_paths.erase(reader_itr, end(reader_paths));
-            reader_itr = open_readers(begin(reader_paths), end(reader_paths));
         }
         return false;
     }
@@ -293,20 +339,15 @@ std::size_t ReadManager::count_reads(const SampleName& sample, const GenomicRegi
     if (all_readers_are_open()) {
         return std::accumulate(std::cbegin(open_readers_), std::cend(open_readers_), std::size_t {0},
                                [&] (std::size_t curr, const auto& p) {
-                                   return curr + p.second.count_reads(sample, region);
+                                   return curr + p.second->count_reads(sample, region);
                                });
     } else {
-        std::lock_guard<std::mutex> lock {mutex_};
         auto reader_paths = get_possible_reader_paths({sample}, region);
-        auto reader_itr = partition_open(reader_paths);
         std::size_t result {0};
         while (!reader_paths.empty()) {
-            using std::begin; using std::end; using std::for_each;
-            for_each(reader_itr, end(reader_paths), [this, &sample, &region, &result] (const auto& reader_path) {
-                result += open_readers_.at(reader_path).count_reads(sample, region);
-            });
-            reader_paths.erase(reader_itr, end(reader_paths));
-            reader_itr = open_readers(begin(reader_paths), end(reader_paths));
+            for (const auto& reader : checkout_readers(reader_paths)) {
+                result += reader->count_reads(sample, region);
+            }
         }
         return result;
     }
@@ -317,20 +358,15 @@ std::size_t ReadManager::count_reads(const std::vector<SampleName>& samples, con
     if (all_readers_are_open()) {
         return std::accumulate(std::cbegin(open_readers_), std::cend(open_readers_), std::size_t {0},
                                [&] (std::size_t curr, const auto& p) {
-                                   return curr + p.second.count_reads(samples, region);
+                                   return curr + p.second->count_reads(samples, region);
                                });
     } else {
-        std::lock_guard<std::mutex> lock {mutex_};
         auto reader_paths = get_possible_reader_paths(samples, region);
-        auto reader_itr = partition_open(reader_paths);
         std::size_t result {0};
         while (!reader_paths.empty()) {
-            using std::begin; using std::end; using std::for_each;
-            for_each(reader_itr, end(reader_paths), [this, &samples, &region, &result] (const auto& reader_path) {
-                result += open_readers_.at(reader_path).count_reads(samples, region);
-            });
-            reader_paths.erase(reader_itr, end(reader_paths));
-            reader_itr = open_readers(begin(reader_paths), end(reader_paths));
+            for (const auto& reader : checkout_readers(reader_paths)) {
+                result += reader->count_reads(samples, region);
+            }
         }
         return result;
     }
@@ -393,25 +429,21 @@ GenomicRegion ReadManager::find_covered_subregion(const std::vector<SampleName>&
     if (all_readers_are_open()) {
         for (const auto& p : open_readers_) {
             // Request one more than the max so we can determine if the entire request region can be included
-            const auto positions = p.second.extract_read_positions(samples, region, max_reads + 1);
+            const auto positions = p.second->extract_read_positions(samples, region, max_reads + 1);
             for (auto position : positions) {
                 add(position, position_tracker);
             }
         }
     } else {
-        std::lock_guard<std::mutex> lock {mutex_};
         auto reader_paths = get_possible_reader_paths(samples, region);
-        auto reader_itr = partition_open(reader_paths);
         while (!reader_paths.empty()) {
-            std::for_each(reader_itr, end(reader_paths), [&] (const auto& reader_path) {
+            for (const auto& reader : checkout_readers(reader_paths)) {
                 // Request one more than the max so we can determine if the entire request region can be included
-                const auto positions = open_readers_.at(reader_path).extract_read_positions(samples, region, max_reads + 1);
+                const auto positions = reader->extract_read_positions(samples, region, max_reads + 1);
                 for (auto position : positions) {
                     add(position, position_tracker);
                 }
-            });
-            reader_paths.erase(reader_itr, end(reader_paths));
-            reader_itr = open_readers(begin(reader_paths), end(reader_paths));
+            }
         }
     }
     return max_head_region(position_tracker, region, max_reads);
@@ -438,19 +470,14 @@ ReadManager::ReadContainer ReadManager::fetch_reads(const SampleName& sample, co
     ReadContainer result {};
     if (all_readers_are_open()) {
         for (const auto& p : open_readers_) {
-            merge_insert(p.second.fetch_reads(sample, region), result);
+            merge_insert(p.second->fetch_reads(sample, region), result);
         }
     } else {
-        std::lock_guard<std::mutex> lock {mutex_};
         auto reader_paths = get_possible_reader_paths({sample}, region);
-        auto reader_itr = partition_open(reader_paths);
         while (!reader_paths.empty()) {
-            using std::begin; using std::end; using std::make_move_iterator; using std::for_each;
-            for_each(reader_itr, end(reader_paths), [&] (const auto& reader_path) {
-                merge_insert(open_readers_.at(reader_path).fetch_reads(sample, region), result);
-            });
-            reader_paths.erase(reader_itr, end(reader_paths));
-            reader_itr = open_readers(begin(reader_paths), end(reader_paths));
+            for (const auto& reader : checkout_readers(reader_paths)) {
+                merge_insert(reader->fetch_reads(sample, region), result);
+            }
         }
     }
     return result;
@@ -465,7 +492,7 @@ ReadManager::SampleReadMap ReadManager::fetch_reads(const std::vector<SampleName
     }
     if (all_readers_are_open()) {
         for (const auto& p : open_readers_) {
-            auto reads = p.second.fetch_reads(samples, region);
+            auto reads = p.second->fetch_reads(samples, region);
             for (auto&& r : reads) {
                 merge_insert(std::move(r.second), result.at(r.first));
                 r.second.clear();
@@ -473,21 +500,16 @@ ReadManager::SampleReadMap ReadManager::fetch_reads(const std::vector<SampleName
             }
         }
     } else {
-        std::lock_guard<std::mutex> lock {mutex_};
         auto reader_paths = get_possible_reader_paths(samples, region);
-        auto reader_itr = partition_open(reader_paths);
         while (!reader_paths.empty()) {
-            using std::begin; using std::end; using std::make_move_iterator; using std::for_each;
-            for_each(reader_itr, end(reader_paths), [&] (const auto& reader_path) {
-                auto reads = open_readers_.at(reader_path).fetch_reads(samples, region);
+            for (const auto& reader : checkout_readers(reader_paths)) {
+                auto reads = reader->fetch_reads(samples, region);
                 for (auto&& r : reads) {
                     merge_insert(std::move(r.second), result.at(r.first));
                     r.second.clear();
                     r.second.shrink_to_fit();
                 }
-            });
-            reader_paths.erase(reader_itr, end(reader_paths));
-            reader_itr = open_readers(begin(reader_paths), end(reader_paths));
+            }
         }
     }
     return result;
@@ -551,7 +573,7 @@ void ReadManager::open_initial_files()
 
 ReadReader ReadManager::make_reader(const Path& reader_path) const
 {
-    return ReadReader {reader_path};
+    return ReadReader {reader_path, max_handles_per_file_, index_cache_};
 }
 
 bool ReadManager::all_readers_are_open() const noexcept
@@ -586,8 +608,9 @@ void ReadManager::open_reader(const Path& reader_path) const
     if (num_open_readers() == max_open_files_) { // do we need this?
         close_reader(choose_reader_to_close());
     }
-    open_readers_.emplace(reader_path, make_reader(reader_path));
+    open_readers_.emplace(reader_path, std::make_shared<const ReadReader>(make_reader(reader_path)));
     closed_readers_.erase(reader_path);
+    if (!previously_opened_readers_.insert(reader_path).second) ++num_reopens_;
 }
 
 std::vector<ReadManager::Path>::iterator
@@ -637,6 +660,36 @@ void ReadManager::close_readers(unsigned n) const
     }
 }
 
+void ReadManager::pin_open_readers(std::vector<Path>& reader_paths, std::vector<ReaderPtr>& result) const
+{
+    const auto first_open = partition_open(reader_paths);
+    std::transform(first_open, std::end(reader_paths), std::back_inserter(result),
+                   [this] (const Path& path) { return open_readers_.at(path); });
+    reader_paths.erase(first_open, std::end(reader_paths));
+}
+
+// Removes the returned readers from reader_paths. Readers that are already open only need a shared
+// lock; otherwise as many of the remaining readers as possible are opened under an exclusive lock.
+// The returned readers stay valid even if another thread closes them.
+std::vector<ReadManager::ReaderPtr> ReadManager::checkout_readers(std::vector<Path>& reader_paths) const
+{
+    std::vector<ReaderPtr> result {};
+    result.reserve(reader_paths.size());
+    {
+        std::shared_lock<std::shared_timed_mutex> lock {mutex_};
+        pin_open_readers(reader_paths, result);
+        if (!result.empty() || reader_paths.empty()) return result;
+    }
+    std::lock_guard<std::shared_timed_mutex> lock {mutex_};
+    ++num_exclusive_checkouts_;
+    pin_open_readers(reader_paths, result); // another thread may have opened some
+    const auto first_opened = open_readers(std::begin(reader_paths), std::end(reader_paths));
+    std::transform(first_opened, std::end(reader_paths), std::back_inserter(result),
+                   [this] (const Path& path) { return open_readers_.at(path); });
+    reader_paths.erase(first_opened, std::end(reader_paths));
+    return result;
+}
+
 void ReadManager::add_possible_regions_to_reader_map(const Path& reader_path, const std::vector<GenomicRegion>& regions)
 {
     for (const auto& region : regions) {
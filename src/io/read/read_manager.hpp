@@ -10,7 +10,9 @@
 #include <unordered_set>
 #include <initializer_list>
 #include <cstddef>
+#include <memory>
 #include <mutex>
+#include <shared_mutex>
 
 #include <boost/filesystem.hpp>
 
@@ -27,6 +29,15 @@ class AlignedRead;
 
 namespace io {
 
+class ReadIndexCache;
+
+/*
+ ReadManager provides sample-based access to a set of read files, keeping at most max_open_files
+ open at once. Queries on readers that are already open only take a shared lock, and readers are
+ pinned for the duration of a query so may briefly outlive being closed by another thread.
+ Headers and indices are kept in a ReadIndexCache, if given a budget, so reopening a file need not
+ reload them.
+ */
 class ReadManager
 {
 public:
@@ -40,7 +51,8 @@ public:
     
     ReadManager() = default;
     
-    ReadManager(std::vector<Path> read_file_paths, unsigned max_open_files);
+    ReadManager(std::vector<Path> read_file_paths, unsigned max_open_files, unsigned max_threads = 1,
+                std::size_t max_index_cache_bytes = 0);
     ReadManager(std::initializer_list<Path> read_file_paths);
     
     ReadManager(const ReadManager&)            = delete;
@@ -48,13 +60,14 @@ public:
     ReadManager(ReadManager &&);
     ReadManager& operator=(ReadManager &&);
     
-    ~ReadManager() = default;
+    ~ReadManager();
     
     friend void swap(ReadManager& lhs, ReadManager& rhs) noexcept;
     
     void close() const noexcept; // close all readers
     bool good() const noexcept;
     unsigned num_files() const noexcept;
+    unsigned max_open_files() const noexcept;
     std::vector<Path> paths() const; // Managed files
     bool all_readers_have_one_sample() const;
     unsigned num_samples() const noexcept;
@@ -105,7 +118,8 @@ private:
         bool operator()(const Path& lhs, const Path& rhs) const;
     };
     
-    using OpenReaderMap           = std::map<Path, ReadReader, FileSizeCompare>;
+    using ReaderPtr               = std::shared_ptr<const ReadReader>;
+    using OpenReaderMap           = std::map<Path, ReaderPtr, FileSizeCompare>;
     using ClosedReaderSet         = std::unordered_set<Path, PathHash>;
     using SampleIdToReaderPathMap = std::unordered_map<SampleName, std::vector<Path>>;
     using ContigMap               = MappableMap<GenomicRegion::ContigName, ContigRegion>;
@@ -113,6 +127,7 @@ private:
     
     unsigned max_open_files_ = 200;
     unsigned num_files_;
+    unsigned max_handles_per_file_ = 1;
     bool all_readers_single_sample_;
     
     mutable ClosedReaderSet closed_readers_;
@@ -122,7 +137,11 @@ private:
     ReaderRegionsMap possible_regions_in_readers_;
     std::vector<SampleName> samples_;
     
-    mutable std::mutex mutex_;
+    std::shared_ptr<ReadIndexCache> index_cache_;
+    mutable ClosedReaderSet previously_opened_readers_;
+    mutable std::size_t num_reopens_ = 0, num_exclusive_checkouts_ = 0;
+    
+    mutable std::shared_timed_mutex mutex_;
     
     void setup_reader_samples_and_regions();
     void open_initial_files();
@@ -140,6 +159,8 @@ private:
     void close_reader(const Path& reader_path) const;
     Path choose_reader_to_close() const;
     void close_readers(unsigned n) const;
+    void pin_open_readers(std::vector<Path>& reader_paths, std::vector<ReaderPtr>& result) const;
+    std::vector<ReaderPtr> checkout_readers(std::vector<Path>& reader_paths) const;
     
     template <typename Visitor>
     void iterate_helper(const std::vector<SampleName>& samples,
@@ -163,19 +184,15 @@ void ReadManager::iterate_helper(const std::vector<SampleName>& samples,
 {
     if (all_readers_are_open()) {
         for (const auto& p : open_readers_) {
-            if (!p.second.iterate(samples, region, visitor)) return;
+            if (!p.second->iterate(samples, region, visitor)) return;
         }
     } else {
-        std::lock_guard<std::mutex> lock {mutex_};
         auto reader_paths = get_reader_paths_containing_samples(samples);
-        auto reader_itr = partition_open(reader_paths);
         while (!reader_paths.empty()) {
-            auto itr = std::find_if(reader_itr, end(reader_paths), [&] (const auto& reader_path) {
-                return !open_readers_.at(reader_path).iterate(samples, region, visitor);
-            });
-            if (itr != end(reader_paths)) break;
-            reader_paths.erase(reader_itr, end(reader_paths));
-            reader_itr = open_readers(begin(reader_paths), end(reader_paths));
+            const auto readers = checkout_readers(reader_paths);
+            for (const auto& reader : readers) {
+                if (!reader->iterate(samples, region, visitor)) return;
+            }
         }
     }
 }
@@ -67,24 +67,26 @@ bool is_valid_read_file_type(const boost::filesystem::path& file_path)
     return includes(validReadFileExtensions, get_extension(file_path));
 }
 
-auto make_reader(const boost::filesystem::path& file_path)
+auto make_reader(const boost::filesystem::path& file_path, const unsigned max_handles,
+                 std::shared_ptr<ReadIndexCache> index_cache)
 {
     if (!is_valid_read_file_type(file_path)) {
         throw UnknownReadFileFormat {file_path};
     }
-    return std::make_unique<HtslibSamFacade>(file_path);
+    return std::make_unique<HtslibSamFacade>(file_path, max_handles, std::move(index_cache));
 }
 
 } //namespace
 
-ReadReader::ReadReader(const boost::filesystem::path& file_path)
+ReadReader::ReadReader(const boost::filesystem::path& file_path, const unsigned max_handles,
+                       std::shared_ptr<ReadIndexCache> index_cache)
 : file_path_ {file_path}
-, impl_ {make_reader(file_path_)}
+, impl_ {make_reader(file_path_, max_handles, std::move(index_cache))}
 {}
 
 ReadReader::ReadReader(ReadReader&& other)
 {
-    std::lock_guard<std::mutex> lock {other.mutex_};
+    std::lock_guard<std::shared_timed_mutex> lock {other.mutex_};
     file_path_ = std::move(other.file_path_);
     impl_  = std::move(other.impl_);
 }
@@ -93,7 +95,7 @@ void swap(ReadReader& lhs, ReadReader& rhs) noexcept
 {
     if (&lhs == &rhs) return;
     std::lock(lhs.mutex_, rhs.mutex_);
-    std::lock_guard<std::mutex> lock_lhs {lhs.mutex_, std::adopt_lock}, lock_rhs {rhs.mutex_, std::adopt_lock};
+    std::lock_guard<std::shared_timed_mutex> lock_lhs {lhs.mutex_, std::adopt_lock}, lock_rhs {rhs.mutex_, std::adopt_lock};
     using std::swap;
     swap(lhs.file_path_, rhs.file_path_);
     swap(lhs.impl_, rhs.impl_);
@@ -101,19 +103,19 @@ void swap(ReadReader& lhs, ReadReader& rhs) noexcept
 
 bool ReadReader::is_open() const noexcept
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->is_open();
 }
 
 void ReadReader::open()
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::lock_guard<std::shared_timed_mutex> lock {mutex_};
     impl_->open();
 }
 
 void ReadReader::close()
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::lock_guard<std::shared_timed_mutex> lock {mutex_};
     impl_->close();
 }
 
@@ -124,44 +126,44 @@ const ReadReader::Path& ReadReader::path() const noexcept
 
 std::vector<ReadReader::SampleName> ReadReader::extract_samples() const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->extract_samples();
 }
 
 std::vector<std::string> ReadReader::extract_read_groups(const SampleName& sample) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->extract_read_groups(sample);
 }
 
 std::vector<GenomicRegion::ContigName> ReadReader::reference_contigs() const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->reference_contigs();
 }
 
 GenomicRegion::Size ReadReader::reference_size(const GenomicRegion::ContigName& contig) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->reference_size(contig);
 }
 
 boost::optional<std::vector<GenomicRegion::ContigName>> ReadReader::mapped_contigs() const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->mapped_contigs();
 }
 
 boost::optional<std::vector<GenomicRegion>> ReadReader::mapped_regions() const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->mapped_regions();
 }
 
 bool ReadReader::iterate(const GenomicRegion& region,
                          AlignedReadReadVisitor visitor) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->iterate(region, visitor);
 }
 
@@ -169,7 +171,7 @@ bool ReadReader::iterate(const SampleName& sample,
                          const GenomicRegion& region,
                          AlignedReadReadVisitor visitor) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->iterate(sample, region, visitor);
 }
 
@@ -177,14 +179,14 @@ bool ReadReader::iterate(const std::vector<SampleName>& samples,
                          const GenomicRegion& region,
                          AlignedReadReadVisitor visitor) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->iterate(samples, region, visitor);
 }
 
 bool ReadReader::iterate(const GenomicRegion& region,
                          ContigRegionVisitor visitor) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->iterate(region, visitor);
 }
 
@@ -192,7 +194,7 @@ bool ReadReader::iterate(const SampleName& sample,
                          const GenomicRegion& region,
                          ContigRegionVisitor visitor) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->iterate(sample, region, visitor);
 }
 
@@ -200,51 +202,51 @@ bool ReadReader::iterate(const std::vector<SampleName>& samples,
                          const GenomicRegion& region,
                          ContigRegionVisitor visitor) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->iterate(samples, region, visitor);
 }
 
 bool ReadReader::has_reads(const GenomicRegion& region) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->has_reads(region);
 }
 
 bool ReadReader::has_reads(const SampleName& sample, const GenomicRegion& region) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->has_reads(sample, region);
 }
 
 bool ReadReader::has_reads(const std::vector<SampleName>& samples,
                            const GenomicRegion& region) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->has_reads(samples, region);
 }
 
 std::size_t ReadReader::count_reads(const GenomicRegion& region) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->count_reads(region);
 }
 
 std::size_t ReadReader::count_reads(const SampleName& sample, const GenomicRegion& region) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->count_reads(sample, region);
 }
 
 std::size_t ReadReader::count_reads(const std::vector<SampleName>& samples, const GenomicRegion& region) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->count_reads(samples, region);
 }
 
 ReadReader::PositionList
 ReadReader::extract_read_positions(const GenomicRegion& region, std::size_t max_coverage) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->extract_read_positions(region, max_coverage);
 }
 
@@ -252,7 +254,7 @@ ReadReader::PositionList
 ReadReader::extract_read_positions(const SampleName& sample, const GenomicRegion& region,
                                    std::size_t max_coverage) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->extract_read_positions(sample, region, max_coverage);
 }
 
@@ -260,26 +262,26 @@ ReadReader::PositionList
 ReadReader::extract_read_positions(const std::vector<SampleName>& samples,
                                    const GenomicRegion& region, std::size_t max_coverage) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->extract_read_positions(samples, region, max_coverage);
 }
 
 ReadReader::SampleReadMap ReadReader::fetch_reads(const GenomicRegion& region) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->fetch_reads(region);
 }
 
 ReadReader::ReadContainer ReadReader::fetch_reads(const SampleName& sample, const GenomicRegion& region) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->fetch_reads(sample, region);
 }
 
 ReadReader::SampleReadMap ReadReader::fetch_reads(const std::vector<SampleName>& samples,
                                                   const GenomicRegion& region) const
 {
-    std::lock_guard<std::mutex> lock {mutex_};
+    std::shared_lock<std::shared_timed_mutex> lock {mutex_};
     return impl_->fetch_reads(samples, region);
 }
 
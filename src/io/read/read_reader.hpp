@@ -8,6 +8,7 @@
 #include <cstddef>
 #include <memory>
 #include <mutex>
+#include <shared_mutex>
 #include <utility>
 #include <functional>
 
@@ -24,8 +25,11 @@ class AlignedRead;
 
 namespace io {
 
+class ReadIndexCache;
+
 /*
- ReadReader is a simple RAII threadsafe wrapper around a IReadReaderImpl
+ ReadReader is a simple RAII threadsafe wrapper around a IReadReaderImpl. Queries may run
+ concurrently, up to max_handles at a time, as each iteration uses its own file handle.
  */
 class ReadReader : public Equitable<ReadReader>
 {
@@ -41,7 +45,7 @@ public:
     
     ReadReader() = default;
     
-    ReadReader(const Path& file_path);
+    ReadReader(const Path& file_path, unsigned max_handles = 1, std::shared_ptr<ReadIndexCache> index_cache = nullptr);
     
     ReadReader(const ReadReader&)            = delete;
     ReadReader& operator=(const ReadReader&) = delete;
@@ -116,7 +120,7 @@ private:
     Path file_path_;
     std::unique_ptr<IReadReaderImpl> impl_;
     
-    mutable std::mutex mutex_;
+    mutable std::shared_timed_mutex mutex_;
 };
 
 bool operator==(const ReadReader& lhs, const ReadReader& rhs);
@@ -11,6 +11,7 @@
 #include "fasta.hpp"
 #include "threadsafe_fasta.hpp"
 #include "caching_fasta.hpp"
+#include "utils/tandem_repeat_index.hpp"
 
 namespace octopus {
 
@@ -18,6 +19,7 @@ ReferenceGenome::ReferenceGenome(std::unique_ptr<io::ReferenceReader> impl)
 : impl_ {std::move(impl)}
 , name_{}
 , contig_sizes_ {}
+, repeat_index_ {}
 {
     if (impl_->is_open()) {
         try {
@@ -40,6 +42,7 @@ ReferenceGenome::ReferenceGenome(const ReferenceGenome& other)
 , name_ {other.name_}
 , contig_sizes_ {other.contig_sizes_}
 , ordered_contigs_ {other.ordered_contigs_}
+, repeat_index_ {other.repeat_index_}
 {}
 
 ReferenceGenome& ReferenceGenome::operator=(ReferenceGenome other)
@@ -49,6 +52,7 @@ ReferenceGenome& ReferenceGenome::operator=(ReferenceGenome other)
     swap(name_,            other.name_);
     swap(contig_sizes_,    other.contig_sizes_);
     swap(ordered_contigs_, other.ordered_contigs_);
+    swap(repeat_index_,    other.repeat_index_);
     return *this;
 }
 
@@ -92,6 +96,17 @@ ReferenceGenome::GeneticSequence ReferenceGenome::fetch_sequence(const GenomicRe
     return impl_->fetch_sequence(region);
 }
 
+void ReferenceGenome::set_repeat_index(std::shared_ptr<const TandemRepeatIndex> index) noexcept
+{
+    repeat_index_ = std::move(index);
+}
+
+boost::optional<const TandemRepeatIndex&> ReferenceGenome::repeat_index() const noexcept
+{
+    if (repeat_index_) return *repeat_index_;
+    return boost::none;
+}
+
 // non-member functions
 
 ReferenceGenome make_reference(boost::filesystem::path reference_path,
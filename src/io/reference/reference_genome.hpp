@@ -11,6 +11,7 @@
 #include <memory>
 
 #include <boost/filesystem/path.hpp>
+#include <boost/optional.hpp>
 
 #include "basics/genomic_region.hpp"
 #include "utils/memory_footprint.hpp"
@@ -18,6 +19,8 @@
 
 namespace octopus {
 
+class TandemRepeatIndex;
+
 class ReferenceGenome
 {
 public:
@@ -46,11 +49,16 @@ public:
     
     GeneticSequence fetch_sequence(const GenomicRegion& region) const;
     
+    // The index is shared between copies of the reference
+    void set_repeat_index(std::shared_ptr<const TandemRepeatIndex> index) noexcept;
+    boost::optional<const TandemRepeatIndex&> repeat_index() const noexcept;
+    
 private:
     std::unique_ptr<io::ReferenceReader> impl_;
     std::string name_;
     std::unordered_map<ContigName, ContigRegion::Size> contig_sizes_;
     std::vector<ContigName> ordered_contigs_;
+    std::shared_ptr<const TandemRepeatIndex> repeat_index_;
 };
 
 // non-member functions
@@ -13,6 +13,7 @@
 #include <cstring>
 #include <cstdint>
 #include <cmath>
+#include <mutex>
 
 #include <boost/filesystem/operations.hpp>
 #include <boost/optional.hpp>
@@ -25,6 +26,8 @@
 #include "vcf_header.hpp"
 #include "vcf_record.hpp"
 
+#include "htslib/hts_endian.h"
+
 #include <iostream> // TEST
 
 namespace octopus {
@@ -88,6 +91,15 @@ HtslibBcfFacade::HtslibBcfFacade()
 , file_ {bcf_open("-", "[w]"), HtsFileDeleter {}}
 , header_ {bcf_hdr_init("w"), HtsHeaderDeleter {}}
 , samples_ {}
+, decoder_header_ {}
+, decoder_samples_ {}
+, encoded_record_ {nullptr, HtsBcf1Deleter {}}
+, passthrough_source_ {}
+, passthrough_header_ {nullptr, HtsHeaderDeleter {}}
+, is_passthrough_compatible_ {false}
+, info_types_ {}
+, format_types_ {}
+, encode_buffers_ {}
 {
     if (file_ == nullptr) {
         throw std::runtime_error {"HtslibBcfFacade: could not open stdout writer"};
@@ -102,6 +114,15 @@ HtslibBcfFacade::HtslibBcfFacade(Path file_path, Mode mode)
 , file_ {nullptr, HtsFileDeleter {}}
 , header_ {nullptr, HtsHeaderDeleter {}}
 , samples_ {}
+, decoder_header_ {}
+, decoder_samples_ {}
+, encoded_record_ {nullptr, HtsBcf1Deleter {}}
+, passthrough_source_ {}
+, passthrough_header_ {nullptr, HtsHeaderDeleter {}}
+, is_passthrough_compatible_ {false}
+, info_types_ {}
+, format_types_ {}
+, encode_buffers_ {}
 {
     const auto hts_mode = get_hts_mode(file_path_, mode);
     if (mode == Mode::read) {
@@ -115,6 +136,10 @@ HtslibBcfFacade::HtslibBcfFacade(Path file_path, Mode mode)
                 throw std::runtime_error {"HtslibBcfFacade: could not make header for file " + file_path_.string()};
             }
             samples_ = extract_samples(header_.get());
+            decoder_header_.reset(bcf_hdr_dup(header_.get()), HtsHeaderDeleter {});
+            auto sorted_samples = samples_;
+            std::sort(std::begin(sorted_samples), std::end(sorted_samples));
+            decoder_samples_ = std::make_shared<const std::vector<std::string>>(std::move(sorted_samples));
         } else {
             throw std::runtime_error {"HtslibBcfFacade: " + file_path_.string() + " does not exist"};
         }
@@ -390,18 +415,19 @@ void HtslibBcfFacade::write(const VcfHeader& header)
     }
     header_.reset(hdr);
     samples_ = extract_samples(header_.get());
+    info_types_.clear();
+    format_types_.clear();
+    passthrough_source_.reset();
+    passthrough_header_.reset();
 }
 
 void set_chrom(const bcf_hdr_t* header, bcf1_t* record, const std::string& chrom);
 void set_pos(bcf1_t* record, GenomicRegion::Position pos);
-void set_id(bcf1_t* record, const std::string& id);
+void set_id(const bcf_hdr_t* header, bcf1_t* record, const std::string& id);
 void set_alleles(const bcf_hdr_t* header, bcf1_t* record, const VcfRecord::NucleotideSequence& ref,
                  const std::vector<VcfRecord::NucleotideSequence>& alts);
 void set_qual(bcf1_t* record, VcfRecord::QualityType qual);
 void set_filter(const bcf_hdr_t* header, bcf1_t* record, const std::vector<std::string>& filters);
-void set_info(const bcf_hdr_t* header, bcf1_t* dest, const VcfRecord& source);
-void set_samples(const bcf_hdr_t* header, bcf1_t* dest, const VcfRecord& source,
-                 const std::vector<std::string>& samples);
 
 void HtslibBcfFacade::write(const VcfRecord& record)
 {
@@ -418,23 +444,35 @@ void HtslibBcfFacade::write(const VcfRecord& record)
         throw std::runtime_error {"HtslibBcfFacade: required contig header line missing for contig \"" + contig + "\""};
     }
     
-    auto hts_record = bcf_init();
+    if (record.decoder_) {
+        // Records read lazily are only decoded and re-encoded if they can't be written as they are
+        if (!write_encoded(record)) {
+            write(VcfRecord::Builder {record}.build_once());
+        }
+        return;
+    }
+    
+    if (!encoded_record_) {
+        encoded_record_.reset(bcf_init());
+    } else {
+        bcf_clear(encoded_record_.get());
+    }
+    const auto hts_record = encoded_record_.get();
     set_chrom(header_.get(), hts_record, contig);
     set_pos(hts_record, record.pos() - 1);
-    set_id(hts_record, record.id());
+    set_id(header_.get(), hts_record, record.id());
     set_alleles(header_.get(), hts_record, record.ref(), record.alt());
     if (record.qual()) {
         set_qual(hts_record, *record.qual());
     }
     set_filter(header_.get(), hts_record, record.filter());
-    set_info(header_.get(), hts_record, record);
+    set_info(record, hts_record);
     if (record.num_samples() > 0) {
-        set_samples(header_.get(), hts_record, record, samples_);
+        set_samples(record, hts_record);
     }
     if (bcf_write(file_.get(), header_.get(), hts_record) < 0) {
         throw std::runtime_error {"HtslibBcfFacade: record write failed"};
     }
-    bcf_destroy(hts_record);
 }
 
 // HtslibBcfFacade::RecordIterator
@@ -534,9 +572,9 @@ void extract_id(const bcf1_t* record, VcfRecord::Builder& builder)
     builder.set_id(record->d.id);
 }
 
-void set_id(bcf1_t* record, const std::string& id)
+void set_id(const bcf_hdr_t* header, bcf1_t* record, const std::string& id)
 {
-    record->d.id = malloc_copy(id);
+    bcf_update_id(header, record, id.c_str());
 }
 
 void extract_ref(const bcf1_t* record, VcfRecord::Builder& builder)
@@ -595,13 +633,14 @@ void set_filter(const bcf_hdr_t* header, bcf1_t* record, const std::vector<std::
     }
 }
 
-void extract_info(const bcf_hdr_t* header, bcf1_t* record, VcfRecord::Builder& builder)
+VcfRecord::ValueMap extract_info(const bcf_hdr_t* header, bcf1_t* record)
 {
+    VcfRecord::ValueMap result {};
     int* intinfo {nullptr};
     float* floatinfo {nullptr};
     char* stringinfo {nullptr};
     int* flaginfo {nullptr}; // not actually populated
-    builder.reserve_info(record->n_info);
+    result.reserve(record->n_info);
     for (unsigned i {0}; i < record->n_info; ++i) {
         int nintinfo {0}, nfloatinfo {0}, nstringinfo {0}, nflaginfo {0};
         const auto key_id = record->d.info[i].key;
@@ -647,12 +686,13 @@ void extract_info(const bcf_hdr_t* header, bcf1_t* record, VcfRecord::Builder& b
                 break;
             }
         }
-        builder.set_info(key, std::move(values));
+        result[key] = std::move(values);
     }
     if (intinfo != nullptr) std::free(intinfo);
     if (floatinfo != nullptr) std::free(floatinfo);
     if (stringinfo != nullptr) std::free(stringinfo);
     if (flaginfo != nullptr) std::free(flaginfo);
+    return result;
 }
 
 float get_bcf_float_missing() noexcept
@@ -662,32 +702,66 @@ float get_bcf_float_missing() noexcept
     return result;
 }
 
-void set_info(const bcf_hdr_t* header, bcf1_t* dest, const VcfRecord& source)
+namespace {
+
+int parse_int(const std::string& value) noexcept
 {
-    for (const auto& key : source.info_keys()) {
-        const auto& values    = source.info_value(key);
+    return !is_missing(value) ? static_cast<int>(std::strtol(value.c_str(), nullptr, 10)) : bcf_int32_missing;
+}
+
+float parse_float(const std::string& value) noexcept
+{
+    return !is_missing(value) ? std::strtof(value.c_str(), nullptr) : get_bcf_float_missing();
+}
+
+int lookup_type(const bcf_hdr_t* header, const int line_type, const std::string& key, std::unordered_map<std::string, int>& types)
+{
+    const auto itr = types.find(key);
+    if (itr != std::cend(types)) return itr->second;
+    const auto id = bcf_hdr_id2int(header, BCF_DT_ID, key.c_str());
+    const auto type = id >= 0 && bcf_hdr_idinfo_exists(header, line_type, id) ? static_cast<int>(bcf_hdr_id2type(header, line_type, id)) : -1;
+    types.emplace(key, type);
+    return type;
+}
+
+} // namespace
+
+int HtslibBcfFacade::get_info_type(const std::string& key)
+{
+    return lookup_type(header_.get(), BCF_HL_INFO, key, info_types_);
+}
+
+int HtslibBcfFacade::get_format_type(const std::string& key)
+{
+    return lookup_type(header_.get(), BCF_HL_FMT, key, format_types_);
+}
+
+void HtslibBcfFacade::set_info(const VcfRecord& source, bcf1_t* dest)
+{
+    const auto header = header_.get();
+    for (const auto& p : source.info_) {
+        const auto& key = p.first;
+        const auto& values = p.second;
         const auto num_values = static_cast<int>(values.size());
-        static constexpr std::size_t defaultBufferCapacity {100};
-        switch (bcf_hdr_id2type(header, BCF_HL_INFO, bcf_hdr_id2int(header, BCF_DT_ID, key.c_str()))) {
+        switch (get_info_type(key)) {
             case BCF_HT_INT:
             {
-                bc::small_vector<int, defaultBufferCapacity> vals(num_values);
-                std::transform(std::cbegin(values), std::cend(values), std::begin(vals),
-                               [] (const auto& v) { return !is_missing(v) ? std::stoi(v) : bcf_int32_missing; });
+                auto& vals = encode_buffers_.integers;
+                vals.resize(num_values);
+                std::transform(std::cbegin(values), std::cend(values), std::begin(vals), parse_int);
                 bcf_update_info_int32(header, dest, key.c_str(), vals.data(), num_values);
                 break;
             }
             case BCF_HT_REAL:
             {
-                bc::small_vector<float, defaultBufferCapacity> vals(num_values);
-                std::transform(std::cbegin(values), std::cend(values), std::begin(vals),
-                               [] (const auto& v) { return !is_missing(v) ? std::stof(v) : get_bcf_float_missing(); });
+                auto& vals = encode_buffers_.floats;
+                vals.resize(num_values);
+                std::transform(std::cbegin(values), std::cend(values), std::begin(vals), parse_float);
                 bcf_update_info_float(header, dest, key.c_str(), vals.data(), num_values);
                 break;
             }
             case BCF_HT_STR:
             {
-                // Can we also use small_vector here?
                 const auto vals = utils::join(values, vcfspec::info::valueSeperator);
                 bcf_update_info_string(header, dest, key.c_str(), vals.c_str());
                 break;
@@ -720,116 +794,376 @@ auto extract_format(const bcf_hdr_t* header, const bcf1_t* record)
     return result;
 }
 
-void extract_samples(const bcf_hdr_t* header, bcf1_t* record, VcfRecord::Builder& builder)
+std::vector<VcfRecord::Genotype> extract_genotypes(const bcf_hdr_t* header, bcf1_t* record)
 {
-    auto format = extract_format(header, record);
     const auto num_samples = record->n_sample;
-    builder.reserve_samples(num_samples);
-    auto first_format = std::cbegin(format);
-    if (format.front() == vcfspec::format::genotype) { // the first key must be GT if present
-        int ngt {}, g {};
-        int* gt {nullptr};
-        bcf_get_genotypes(header, record, &gt, &ngt); // mallocs gt
-        const auto max_ploidy = static_cast<unsigned>(record->d.fmt->n);
-        for (unsigned sample {0}, i {0}; sample < num_samples; ++sample, i += max_ploidy) {
-            std::vector<VcfRecord::NucleotideSequence> alleles {};
-            alleles.reserve(max_ploidy);
-            for (unsigned p {0}; p < max_ploidy; ++p) {
-                g = gt[i + p];
-                if (g == bcf_int32_vector_end) {
-                    alleles.shrink_to_fit();
-                    break;
-                } else if (bcf_gt_is_missing(g)) {
-                    alleles.push_back(bcf_missing_str);
+    std::vector<VcfRecord::Genotype> result {};
+    result.reserve(num_samples);
+    int ngt {}, g {};
+    int* gt {nullptr};
+    bcf_get_genotypes(header, record, &gt, &ngt); // mallocs gt
+    const auto max_ploidy = static_cast<unsigned>(record->d.fmt->n);
+    for (unsigned sample {0}, i {0}; sample < num_samples; ++sample, i += max_ploidy) {
+        std::vector<VcfRecord::NucleotideSequence> alleles {};
+        alleles.reserve(max_ploidy);
+        for (unsigned p {0}; p < max_ploidy; ++p) {
+            g = gt[i + p];
+            if (g == bcf_int32_vector_end) {
+                alleles.shrink_to_fit();
+                break;
+            } else if (bcf_gt_is_missing(g)) {
+                alleles.push_back(bcf_missing_str);
+            } else {
+                const auto idx = bcf_gt_allele(g);
+                if (idx < record->n_allele) {
+                    alleles.emplace_back(record->d.allele[idx]);
                 } else {
-                    const auto idx = bcf_gt_allele(g);
-                    if (idx < record->n_allele) {
-                        alleles.emplace_back(record->d.allele[idx]);
-                    } else {
-                        alleles.push_back(bcf_missing_str);
-                    }
+                    alleles.push_back(bcf_missing_str);
                 }
             }
-            using Phasing = VcfRecord::Builder::Phasing;
-            builder.set_genotype(header->samples[sample], std::move(alleles),
-                                 bcf_gt_is_phased(g) ? Phasing::phased : Phasing::unphased);
         }
-        std::free(gt);
-        ++first_format;
+        result.push_back(VcfRecord::Genotype {std::move(alleles), static_cast<bool>(bcf_gt_is_phased(g))});
     }
-    int* intformat {nullptr};
-    float* floatformat {nullptr};
-    char** stringformat {nullptr};
-    int nintformat {}, nfloatformat {}, nstringformat {};
-    for (auto itr = first_format, end = std::cend(format); itr != end; ++itr) {
-        const auto& key = *itr;
-        std::vector<std::vector<std::string>> values(num_samples, std::vector<std::string> {});
-        switch (bcf_hdr_id2type(header, BCF_HL_FMT, bcf_hdr_id2int(header, BCF_DT_ID, key.c_str()))) {
-            case BCF_HT_INT: {
-                const auto num_values_written = bcf_get_format_int32(header, record, key.c_str(), &intformat, &nintformat);
-                if (num_values_written > 0) {
-                    const auto num_values_per_sample = num_values_written / num_samples;
-                    auto ptr = intformat;
-                    for (unsigned sample {0}; sample < num_samples; ++sample, ptr += num_values_per_sample) {
-                        const static auto is_pad = [] (auto x) noexcept { return x == bcf_int32_vector_end; };
-                        const auto pad_ritr = std::find_if_not(std::make_reverse_iterator(ptr + num_values_per_sample), std::make_reverse_iterator(ptr), is_pad);
-                        const auto num_pad_values = std::distance(std::make_reverse_iterator(ptr + num_values_per_sample), pad_ritr);
-                        assert(num_pad_values <= num_values_per_sample);
-                        const auto num_sample_values = num_values_per_sample - num_pad_values;
-                        values[sample].reserve(num_sample_values);
-                        std::transform(ptr, ptr + num_sample_values, std::back_inserter(values[sample]),
-                                       [] (auto v) {
-                                           return v != bcf_int32_missing ? std::to_string(v) : bcf_missing_str;
-                                       });
-                    }
+    std::free(gt);
+    return result;
+}
+
+std::vector<std::vector<VcfRecord::ValueType>>
+extract_format_values(const bcf_hdr_t* header, bcf1_t* record, const VcfRecord::KeyType& key)
+{
+    const auto num_samples = record->n_sample;
+    std::vector<std::vector<VcfRecord::ValueType>> result(num_samples, std::vector<VcfRecord::ValueType> {});
+    switch (bcf_hdr_id2type(header, BCF_HL_FMT, bcf_hdr_id2int(header, BCF_DT_ID, key.c_str()))) {
+        case BCF_HT_INT: {
+            int* intformat {nullptr};
+            int nintformat {};
+            const auto num_values_written = bcf_get_format_int32(header, record, key.c_str(), &intformat, &nintformat);
+            if (num_values_written > 0) {
+                const auto num_values_per_sample = num_values_written / num_samples;
+                auto ptr = intformat;
+                for (unsigned sample {0}; sample < num_samples; ++sample, ptr += num_values_per_sample) {
+                    const static auto is_pad = [] (auto x) noexcept { return x == bcf_int32_vector_end; };
+                    const auto pad_ritr = std::find_if_not(std::make_reverse_iterator(ptr + num_values_per_sample), std::make_reverse_iterator(ptr), is_pad);
+                    const auto num_pad_values = std::distance(std::make_reverse_iterator(ptr + num_values_per_sample), pad_ritr);
+                    assert(num_pad_values <= num_values_per_sample);
+                    const auto num_sample_values = num_values_per_sample - num_pad_values;
+                    result[sample].reserve(num_sample_values);
+                    std::transform(ptr, ptr + num_sample_values, std::back_inserter(result[sample]),
+                                   [] (auto v) {
+                                       return v != bcf_int32_missing ? std::to_string(v) : bcf_missing_str;
+                                   });
                 }
-                break;
             }
-            case BCF_HT_REAL: {
-                const auto num_values_written = bcf_get_format_float(header, record, key.c_str(), &floatformat, &nfloatformat);
-                if (num_values_written > 0) {
-                    const auto num_values_per_sample = num_values_written / num_samples;
-                    auto ptr = floatformat;
-                    for (unsigned sample {0}; sample < num_samples; ++sample, ptr += num_values_per_sample) {
-                        const static auto is_pad = [] (auto x) noexcept { return bcf_float_is_vector_end(x); };
-                        const auto pad_ritr = std::find_if_not(std::make_reverse_iterator(ptr + num_values_per_sample), std::make_reverse_iterator(ptr), is_pad);
-                        const auto num_pad_values = std::distance(std::make_reverse_iterator(ptr + num_values_per_sample), pad_ritr);
-                        assert(num_pad_values <= num_values_per_sample);
-                        const auto num_sample_values = num_values_per_sample - num_pad_values;
-                        values[sample].reserve(num_sample_values);
-                        std::transform(ptr, ptr + num_sample_values, std::back_inserter(values[sample]),
-                                       [] (auto v) {
-                                           return v != bcf_float_missing ? std::to_string(v) : bcf_missing_str;
-                                       });
-                    }
+            if (intformat != nullptr) std::free(intformat);
+            break;
+        }
+        case BCF_HT_REAL: {
+            float* floatformat {nullptr};
+            int nfloatformat {};
+            const auto num_values_written = bcf_get_format_float(header, record, key.c_str(), &floatformat, &nfloatformat);
+            if (num_values_written > 0) {
+                const auto num_values_per_sample = num_values_written / num_samples;
+                auto ptr = floatformat;
+                for (unsigned sample {0}; sample < num_samples; ++sample, ptr += num_values_per_sample) {
+                    const static auto is_pad = [] (auto x) noexcept { return bcf_float_is_vector_end(x); };
+                    const auto pad_ritr = std::find_if_not(std::make_reverse_iterator(ptr + num_values_per_sample), std::make_reverse_iterator(ptr), is_pad);
+                    const auto num_pad_values = std::distance(std::make_reverse_iterator(ptr + num_values_per_sample), pad_ritr);
+                    assert(num_pad_values <= num_values_per_sample);
+                    const auto num_sample_values = num_values_per_sample - num_pad_values;
+                    result[sample].reserve(num_sample_values);
+                    std::transform(ptr, ptr + num_sample_values, std::back_inserter(result[sample]),
+                                   [] (auto v) {
+                                       return v != bcf_float_missing ? std::to_string(v) : bcf_missing_str;
+                                   });
                 }
-                break;
             }
-            case BCF_HT_STR:
-                // TODO: Check this usage is correct. What if more than one value per sample?
-                if (bcf_get_format_string(header, record, key.c_str(), &stringformat, &nstringformat) > 0) {
-                    unsigned sample {0};
-                    std::for_each(stringformat, stringformat + num_samples,
-                                  [&values, &sample] (const char* str) {
-                                      values[sample++].emplace_back(str);
-                                  });
-                }
-                break;
+            if (floatformat != nullptr) std::free(floatformat);
+            break;
         }
-        for (unsigned sample {0}; sample < num_samples; ++sample) {
-            builder.set_format(header->samples[sample], key, std::move(values[sample]));
+        case BCF_HT_STR: {
+            char** stringformat {nullptr};
+            int nstringformat {};
+            // TODO: Check this usage is correct. What if more than one value per sample?
+            if (bcf_get_format_string(header, record, key.c_str(), &stringformat, &nstringformat) > 0) {
+                unsigned sample {0};
+                std::for_each(stringformat, stringformat + num_samples,
+                              [&result, &sample] (const char* str) {
+                                  result[sample++].emplace_back(str);
+                              });
+            }
+            if (stringformat != nullptr) {
+                // bcf_get_format_string allocates two arrays
+                std::free(stringformat[0]);
+                std::free(stringformat);
+            }
+            break;
         }
     }
-    builder.set_format(std::move(format));
-    if (intformat != nullptr) std::free(intformat);
-    if (floatformat != nullptr) std::free(floatformat);
-    if (stringformat != nullptr) {
-        // bcf_get_format_string allocates two arrays
-        std::free(stringformat[0]);
-        std::free(stringformat);
+    return result;
+}
+
+namespace {
+
+// Reads a single value from a BCF typed array, avoiding the copy made by bcf_get_*_values
+boost::optional<double> get_typed_value(const std::uint8_t* data, const int type, const int index) noexcept
+{
+    switch (type) {
+        case BCF_BT_INT8: {
+            const auto value = static_cast<std::int8_t>(data[index]);
+            if (value == bcf_int8_missing || value == bcf_int8_vector_end) return boost::none;
+            return static_cast<double>(value);
+        }
+        case BCF_BT_INT16: {
+            const auto value = le_to_i16(data + 2 * index);
+            if (value == bcf_int16_missing || value == bcf_int16_vector_end) return boost::none;
+            return static_cast<double>(value);
+        }
+        case BCF_BT_INT32: {
+            const auto value = le_to_i32(data + 4 * index);
+            if (value == bcf_int32_missing || value == bcf_int32_vector_end) return boost::none;
+            return static_cast<double>(value);
+        }
+        case BCF_BT_FLOAT: {
+            const auto value = le_to_float(data + 4 * index);
+            if (bcf_float_is_missing(value) || bcf_float_is_vector_end(value)) return boost::none;
+            return static_cast<double>(value);
+        }
+        default: return boost::none;
     }
 }
 
+boost::optional<double> get_number(const std::vector<VcfRecord::ValueType>& values, const unsigned index)
+{
+    if (index >= values.size() || is_missing(values[index])) return boost::none;
+    return std::stod(values[index]);
+}
+
+// Decodes the INFO and FORMAT fields of a copy of the record as they are requested. Numeric
+// fields can be read without decoding the field for every sample.
+class BcfFieldDecoder : public VcfRecord::FieldDecoder
+{
+public:
+    using HeaderPtr  = std::shared_ptr<bcf_hdr_t>;
+    using SampleList = std::shared_ptr<const std::vector<VcfRecord::SampleName>>;
+    
+    BcfFieldDecoder() = delete;
+    
+    BcfFieldDecoder(HeaderPtr header, bcf1_t* record, SampleList samples);
+    
+    BcfFieldDecoder(const BcfFieldDecoder&)            = delete;
+    BcfFieldDecoder& operator=(const BcfFieldDecoder&) = delete;
+    BcfFieldDecoder(BcfFieldDecoder&&)                 = delete;
+    BcfFieldDecoder& operator=(BcfFieldDecoder&&)      = delete;
+    
+    ~BcfFieldDecoder() override = default;
+    
+    const VcfRecord::ValueMap& info() const override;
+    boost::optional<double> info_number(const VcfRecord::KeyType& key, unsigned index) const override;
+    
+    const std::vector<VcfRecord::SampleName>& samples() const override;
+    const VcfRecord::Genotype& genotype(const VcfRecord::SampleName& sample) const override;
+    const std::vector<VcfRecord::ValueType>& format(const VcfRecord::SampleName& sample, const VcfRecord::KeyType& key) const override;
+    boost::optional<double> format_number(const VcfRecord::SampleName& sample, const VcfRecord::KeyType& key, unsigned index) const override;
+    
+    // The header of the file the record was read from
+    const HeaderPtr& header() const noexcept;
+    // Copies the still encoded record, so it can be written without decoding its fields
+    void copy_record(bcf1_t* dest) const;
+    
+private:
+    struct Bcf1Deleter
+    {
+        void operator()(bcf1_t* bcf1) const { bcf_destroy(bcf1); }
+    };
+    
+    using FormatValues = std::vector<std::vector<VcfRecord::ValueType>>;
+    
+    HeaderPtr header_;
+    std::unique_ptr<bcf1_t, Bcf1Deleter> record_;
+    SampleList samples_;
+    
+    mutable std::once_flag unpacked_;
+    mutable std::mutex mutex_;
+    mutable boost::optional<VcfRecord::ValueMap> info_;
+    mutable boost::optional<std::vector<VcfRecord::Genotype>> genotypes_;
+    mutable std::unordered_map<VcfRecord::KeyType, FormatValues> format_;
+    
+    bcf1_t* unpacked_record() const;
+    std::size_t sample_index(const VcfRecord::SampleName& sample) const;
+};
+
+BcfFieldDecoder::BcfFieldDecoder(HeaderPtr header, bcf1_t* record, SampleList samples)
+: header_ {std::move(header)}
+, record_ {record, Bcf1Deleter {}}
+, samples_ {std::move(samples)}
+, unpacked_ {}
+, mutex_ {}
+, info_ {}
+, genotypes_ {}
+, format_ {}
+{}
+
+const VcfRecord::ValueMap& BcfFieldDecoder::info() const
+{
+    const auto record = unpacked_record();
+    std::lock_guard<std::mutex> lock {mutex_};
+    if (!info_) info_ = extract_info(header_.get(), record);
+    return *info_;
+}
+
+boost::optional<double> BcfFieldDecoder::info_number(const VcfRecord::KeyType& key, const unsigned index) const
+{
+    const auto info = bcf_get_info(header_.get(), unpacked_record(), key.c_str());
+    if (info == nullptr || static_cast<int>(index) >= info->len) return boost::none;
+    if (info->type == BCF_BT_CHAR) return get_number(this->info().at(key), index);
+    return get_typed_value(info->vptr, info->type, index);
+}
+
+const std::vector<VcfRecord::SampleName>& BcfFieldDecoder::samples() const
+{
+    return *samples_;
+}
+
+const VcfRecord::Genotype& BcfFieldDecoder::genotype(const VcfRecord::SampleName& sample) const
+{
+    const auto sample_idx = sample_index(sample);
+    const auto record = unpacked_record();
+    std::lock_guard<std::mutex> lock {mutex_};
+    if (!genotypes_) {
+        if (bcf_get_fmt(header_.get(), record, vcfspec::format::genotype) == nullptr) {
+            throw std::out_of_range {"HtslibBcfFacade: record has no genotypes"};
+        }
+        genotypes_ = extract_genotypes(header_.get(), record);
+    }
+    return (*genotypes_)[sample_idx];
+}
+
+const std::vector<VcfRecord::ValueType>&
+BcfFieldDecoder::format(const VcfRecord::SampleName& sample, const VcfRecord::KeyType& key) const
+{
+    const auto sample_idx = sample_index(sample);
+    const auto record = unpacked_record();
+    std::lock_guard<std::mutex> lock {mutex_};
+    auto itr = format_.find(key);
+    if (itr == std::cend(format_)) {
+        if (bcf_get_fmt(header_.get(), record, key.c_str()) == nullptr) {
+            throw std::out_of_range {"HtslibBcfFacade: record has no FORMAT field " + key};
+        }
+        itr = format_.emplace(key, extract_format_values(header_.get(), record, key)).first;
+    }
+    return itr->second[sample_idx];
+}
+
+boost::optional<double>
+BcfFieldDecoder::format_number(const VcfRecord::SampleName& sample, const VcfRecord::KeyType& key, const unsigned index) const
+{
+    const auto sample_idx = sample_index(sample);
+    if (key == vcfspec::format::genotype) return boost::none;
+    const auto fmt = bcf_get_fmt(header_.get(), unpacked_record(), key.c_str());
+    if (fmt == nullptr || static_cast<int>(index) >= fmt->n) return boost::none;
+    if (fmt->type == BCF_BT_CHAR) return get_number(format(sample, key), index);
+    return get_typed_value(fmt->p + sample_idx * fmt->size, fmt->type, index);
+}
+
+const BcfFieldDecoder::HeaderPtr& BcfFieldDecoder::header() const noexcept
+{
+    return header_;
+}
+
+void BcfFieldDecoder::copy_record(bcf1_t* dest) const
+{
+    std::lock_guard<std::mutex> lock {mutex_};
+    bcf_copy(dest, record_.get());
+}
+
+bcf1_t* BcfFieldDecoder::unpacked_record() const
+{
+    // The record is unpacked on first access, so records that are only copied or written are never
+    // unpacked. It is only read afterwards, so is then safe to share between threads.
+    std::call_once(unpacked_, [this] () {
+        std::lock_guard<std::mutex> lock {mutex_};
+        bcf_unpack(record_.get(), BCF_UN_ALL);
+    });
+    return record_.get();
+}
+
+std::size_t BcfFieldDecoder::sample_index(const VcfRecord::SampleName& sample) const
+{
+    const auto result = samples_->empty() ? -1 : bcf_hdr_id2int(header_.get(), BCF_DT_SAMPLE, sample.c_str());
+    if (result < 0) {
+        throw std::out_of_range {"HtslibBcfFacade: record has no sample " + sample};
+    }
+    return static_cast<std::size_t>(result);
+}
+
+// A copy of the site fields of the record, leaving out the encoded sample data
+bcf1_t* copy_site(const bcf1_t* record)
+{
+    auto result = bcf_init();
+    result->rid = record->rid;
+    result->pos = record->pos;
+    result->rlen = record->rlen;
+    result->qual = record->qual;
+    result->n_info = record->n_info;
+    result->n_allele = record->n_allele;
+    kputsn(record->shared.s, record->shared.l, &result->shared);
+    return result;
+}
+
+bool have_same_samples(const bcf_hdr_t* lhs, const bcf_hdr_t* rhs)
+{
+    if (bcf_hdr_nsamples(lhs) != bcf_hdr_nsamples(rhs)) return false;
+    for (int i {0}; i < bcf_hdr_nsamples(lhs); ++i) {
+        if (std::strcmp(lhs->samples[i], rhs->samples[i]) != 0) return false;
+    }
+    return true;
+}
+
+// True if every FILTER, INFO, and FORMAT field defined in source is defined the same way in dest
+bool defines_fields(const bcf_hdr_t* dest, const bcf_hdr_t* source)
+{
+    for (int id {0}; id < source->n[BCF_DT_ID]; ++id) {
+        const char* key {source->id[BCF_DT_ID][id].key};
+        if (key == nullptr) continue;
+        const auto dest_id = bcf_hdr_id2int(dest, BCF_DT_ID, key);
+        for (const int line_type : {BCF_HL_FLT, BCF_HL_INFO, BCF_HL_FMT}) {
+            if (!bcf_hdr_idinfo_exists(source, line_type, id)) continue;
+            if (dest_id < 0 || !bcf_hdr_idinfo_exists(dest, line_type, dest_id)) return false;
+            if (line_type != BCF_HL_FLT
+                && (bcf_hdr_id2type(source, line_type, id) != bcf_hdr_id2type(dest, line_type, dest_id)
+                 || bcf_hdr_id2length(source, line_type, id) != bcf_hdr_id2length(dest, line_type, dest_id)
+                 || bcf_hdr_id2number(source, line_type, id) != bcf_hdr_id2number(dest, line_type, dest_id))) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+} // namespace
+
+bool HtslibBcfFacade::write_encoded(const VcfRecord& record)
+{
+    const auto decoder = dynamic_cast<const BcfFieldDecoder*>(record.decoder_.get());
+    if (decoder == nullptr || record.num_samples() != samples_.size()) return false;
+    if (decoder->header() != passthrough_source_) {
+        passthrough_source_ = decoder->header();
+        passthrough_header_.reset(bcf_hdr_dup(passthrough_source_.get()));
+        is_passthrough_compatible_ = have_same_samples(passthrough_header_.get(), header_.get())
+                                     && defines_fields(header_.get(), passthrough_header_.get());
+    }
+    if (!is_passthrough_compatible_) return false;
+    if (!encoded_record_) {
+        encoded_record_.reset(bcf_init());
+    }
+    decoder->copy_record(encoded_record_.get());
+    if (bcf_translate(header_.get(), passthrough_header_.get(), encoded_record_.get()) != 0) return false;
+    if (bcf_write(file_.get(), header_.get(), encoded_record_.get()) < 0) {
+        throw std::runtime_error {"HtslibBcfFacade: record write failed"};
+    }
+    return true;
+}
+
 template <typename T, typename Container>
 auto genotype_number(const T& allele, const Container& alleles, const bool is_phased)
 {
@@ -841,15 +1175,6 @@ auto genotype_number(const T& allele, const Container& alleles, const bool is_ph
     return (is_phased) ? allele_num + 1 : allele_num;
 }
 
-auto max_format_cardinality(const VcfRecord& record, const VcfRecord::KeyType& key, const std::vector<std::string>& samples)
-{
-    std::size_t result {0};
-    for (const auto& sample : samples) {
-        result = std::max(result, record.get_sample_value(sample, key).size());
-    }
-    return result;
-}
-
 float get_bcf_float_pad() noexcept
 {
     float result;
@@ -857,64 +1182,94 @@ float get_bcf_float_pad() noexcept
     return result;
 }
 
-void set_samples(const bcf_hdr_t* header, bcf1_t* dest, const VcfRecord& source,
-                 const std::vector<std::string>& samples)
+void HtslibBcfFacade::map_samples(const VcfRecord& source)
+{
+    // Records written to the same file almost always have the same samples, so the mapping
+    // from header samples to record samples is usually the same as for the last record
+    auto& indices = encode_buffers_.sample_indices;
+    const auto& record_samples = source.samples_;
+    bool is_mapped {indices.size() == samples_.size()};
+    for (std::size_t i {0}; i < indices.size() && is_mapped; ++i) {
+        is_mapped = indices[i] < record_samples.size() && record_samples.nth(indices[i])->first == samples_[i];
+    }
+    if (!is_mapped) {
+        indices.resize(samples_.size());
+        std::transform(std::cbegin(samples_), std::cend(samples_), std::begin(indices), [&] (const auto& sample) {
+            const auto itr = record_samples.find(sample);
+            return itr != std::cend(record_samples) ? record_samples.index_of(itr) : record_samples.size();
+        });
+    }
+}
+
+void HtslibBcfFacade::set_samples(const VcfRecord& source, bcf1_t* dest)
 {
-    if (samples.empty()) return;
-    const auto num_samples = static_cast<int>(source.num_samples());
-    const auto& format = source.format();
-    if (format.empty()) return;
-    auto first_format = std::cbegin(format);
+    if (samples_.empty() || source.format_.empty()) return;
+    map_samples(source);
+    const auto header = header_.get();
+    const auto num_samples = samples_.size();
+    const auto get_sample_data = [&] (const std::size_t sample_idx) -> const VcfRecord::SampleData* {
+        const auto record_idx = encode_buffers_.sample_indices[sample_idx];
+        return record_idx < source.samples_.size() ? &source.samples_.nth(record_idx)->second : nullptr;
+    };
+    auto first_format = std::cbegin(source.format_);
     if (*first_format == vcfspec::format::genotype) {
-        const auto& alt_alleles = source.alt();
         bc::small_vector<VcfRecord::NucleotideSequence, 5> alleles {};
-        alleles.reserve(alt_alleles.size() + 1);
-        alleles.push_back(source.ref());
-        alleles.insert(std::end(alleles), std::cbegin(alt_alleles), std::cend(alt_alleles));
-        unsigned max_ploidy {};
-        for (const auto& sample : samples) {
-            const auto p = source.ploidy(sample);
-            if (p > max_ploidy) max_ploidy = p;
+        alleles.reserve(source.alt_.size() + 1);
+        alleles.push_back(source.ref_);
+        alleles.insert(std::end(alleles), std::cbegin(source.alt_), std::cend(source.alt_));
+        std::size_t max_ploidy {0};
+        for (std::size_t s {0}; s < num_samples; ++s) {
+            const auto data = get_sample_data(s);
+            if (data && data->genotype) max_ploidy = std::max(max_ploidy, data->genotype->alleles.size());
         }
-        const auto ngt = num_samples * static_cast<int>(max_ploidy);
-        bc::small_vector<int, 1'000> genotype(ngt);
-        auto genotype_itr = std::begin(genotype);
-        for (const auto& sample : samples) {
-            const bool is_phased {source.is_sample_phased(sample)};
-            const auto& genotype = source.get_sample_value(sample, vcfspec::format::genotype);
-            const auto ploidy = static_cast<unsigned>(genotype.size());
-            genotype_itr = std::transform(std::cbegin(genotype), std::cend(genotype), genotype_itr,
-                                          [is_phased, &alleles] (const auto& allele) {
-                                              return genotype_number(allele, alleles, is_phased);
-                                          });
+        auto& genotypes = encode_buffers_.integers;
+        genotypes.resize(num_samples * max_ploidy);
+        auto genotype_itr = std::begin(genotypes);
+        for (std::size_t s {0}; s < num_samples; ++s) {
+            const auto data = get_sample_data(s);
+            std::size_t ploidy {0};
+            if (data && data->genotype) {
+                const bool is_phased {data->genotype->phased};
+                const auto& genotype = data->genotype->alleles;
+                genotype_itr = std::transform(std::cbegin(genotype), std::cend(genotype), genotype_itr,
+                                              [is_phased, &alleles] (const auto& allele) {
+                                                  return genotype_number(allele, alleles, is_phased);
+                                              });
+                ploidy = genotype.size();
+            } else if (max_ploidy > 0) {
+                *genotype_itr++ = bcf_gt_missing;
+                ploidy = 1;
+            }
             genotype_itr = std::fill_n(genotype_itr, max_ploidy - ploidy, bcf_int32_vector_end);
         }
-        bcf_update_genotypes(header, dest, genotype.data(), ngt);
+        bcf_update_genotypes(header, dest, genotypes.data(), static_cast<int>(genotypes.size()));
         ++first_format;
     }
-    std::vector<std::string> str_buffer {};
-    std::for_each(first_format, std::cend(format), [&] (const auto& key) {
-        const auto key_cardinality = source.format_cardinality(key);
-        int num_values {};
-        if (key_cardinality) {
-            num_values = *key_cardinality * num_samples;
-        } else {
-            num_values = max_format_cardinality(source, key, samples) * num_samples;
+    static const std::vector<VcfRecord::ValueType> no_values {};
+    auto& values = encode_buffers_.sample_values;
+    values.resize(num_samples);
+    std::for_each(first_format, std::cend(source.format_), [&] (const auto& key) {
+        std::size_t num_values_per_sample {0};
+        bool is_fixed_cardinality {true};
+        for (std::size_t s {0}; s < num_samples; ++s) {
+            values[s] = &no_values;
+            if (const auto data = get_sample_data(s)) {
+                const auto itr = data->other.find(key);
+                if (itr != std::cend(data->other)) values[s] = &itr->second;
+            }
+            if (s > 0 && values[s]->size() != num_values_per_sample) is_fixed_cardinality = false;
+            num_values_per_sample = std::max(num_values_per_sample, values[s]->size());
         }
-        const auto num_values_per_sample = static_cast<std::size_t>(num_values / num_samples);
-        static constexpr std::size_t defaultValueCapacity {1'000};
-        switch (bcf_hdr_id2type(header, BCF_HL_FMT, bcf_hdr_id2int(header, BCF_DT_ID, key.c_str()))) {
+        auto num_values = static_cast<int>(num_values_per_sample * num_samples);
+        switch (get_format_type(key)) {
           case BCF_HT_INT:
           {
-              static const int pad {bcf_int32_vector_end};
-              bc::small_vector<int, defaultValueCapacity> typed_values(num_values);
+              auto& typed_values = encode_buffers_.integers;
+              typed_values.resize(num_values);
               auto value_itr = std::begin(typed_values);
-              for (const auto& sample : samples) {
-                  const auto& values = source.get_sample_value(sample, key);
-                  value_itr = std::transform(std::cbegin(values), std::cend(values), value_itr,
-                                             [] (const auto& v) { return !is_missing(v) ? std::stoi(v) : bcf_int32_missing; });
-                  assert(values.size() <= num_values_per_sample);
-                  value_itr = std::fill_n(value_itr, num_values_per_sample - values.size(), pad);
+              for (const auto sample_values : values) {
+                  value_itr = std::transform(std::cbegin(*sample_values), std::cend(*sample_values), value_itr, parse_int);
+                  value_itr = std::fill_n(value_itr, num_values_per_sample - sample_values->size(), bcf_int32_vector_end);
               }
               bcf_update_format_int32(header, dest, key.c_str(), typed_values.data(), num_values);
               break;
@@ -922,38 +1277,34 @@ void set_samples(const bcf_hdr_t* header, bcf1_t* dest, const VcfRecord& source,
           case BCF_HT_REAL:
           {
               static const float pad {get_bcf_float_pad()};
-              bc::small_vector<float, defaultValueCapacity> typed_values(num_values);
+              auto& typed_values = encode_buffers_.floats;
+              typed_values.resize(num_values);
               auto value_itr = std::begin(typed_values);
-              for (const auto& sample : samples) {
-                  const auto& values = source.get_sample_value(sample, key);
-                  value_itr = std::transform(std::cbegin(values), std::cend(values), value_itr,
-                                             [] (const auto& v) { return !is_missing(v) ? std::stof(v) : get_bcf_float_missing(); });
-                  assert(values.size() <= num_values_per_sample);
-                  value_itr = std::fill_n(value_itr, num_values_per_sample - values.size(), pad);
+              for (const auto sample_values : values) {
+                  value_itr = std::transform(std::cbegin(*sample_values), std::cend(*sample_values), value_itr, parse_float);
+                  value_itr = std::fill_n(value_itr, num_values_per_sample - sample_values->size(), pad);
               }
               bcf_update_format_float(header, dest, key.c_str(), typed_values.data(), num_values);
               break;
           }
           case BCF_HT_STR:
           {
-              bc::small_vector<const char*, defaultValueCapacity> typed_values;
-              if (key_cardinality && *key_cardinality <= 1) {
+              auto& typed_values = encode_buffers_.strings;
+              if (is_fixed_cardinality && num_values_per_sample <= 1) {
                   typed_values.resize(num_values);
                   auto value_itr = std::begin(typed_values);
-                  for (const auto& sample : samples) {
-                      const auto& values = source.get_sample_value(sample, key);
-                      value_itr = std::transform(std::cbegin(values), std::cend(values), value_itr,
+                  for (const auto sample_values : values) {
+                      value_itr = std::transform(std::cbegin(*sample_values), std::cend(*sample_values), value_itr,
                                                  [] (const auto& value) { return value.c_str(); });
                   }
               } else {
-                  str_buffer.clear();
-                  str_buffer.reserve(num_samples);
-                  for (const auto& sample : samples) {
-                      str_buffer.push_back(utils::join(source.get_sample_value(sample, key), vcfspec::format::valueSeperator));
-                  }
-                  num_values = num_samples;
+                  auto& joined_values = encode_buffers_.joined_strings;
+                  joined_values.resize(num_samples);
+                  std::transform(std::cbegin(values), std::cend(values), std::begin(joined_values),
+                                 [] (const auto sample_values) { return utils::join(*sample_values, vcfspec::format::valueSeperator); });
+                  num_values = static_cast<int>(num_samples);
                   typed_values.resize(num_values);
-                  std::transform(std::cbegin(str_buffer), std::cend(str_buffer), std::begin(typed_values),
+                  std::transform(std::cbegin(joined_values), std::cend(joined_values), std::begin(typed_values),
                                  [] (const auto& value) { return value.c_str(); });
               }
               bcf_update_format_string(header, dest, key.c_str(), typed_values.data(), num_values);
@@ -979,7 +1330,8 @@ std::size_t HtslibBcfFacade::count_records(HtsBcfSrPtr& sr) const
 VcfRecord HtslibBcfFacade::fetch_record(const bcf_srs_t* sr, UnpackPolicy level) const
 {
     auto hts_record = bcf_sr_get_line(sr, 0);
-    bcf_unpack(hts_record, level == UnpackPolicy::all ? BCF_UN_ALL : BCF_UN_SHR);
+    const bool fetch_samples {level == UnpackPolicy::all && has_samples(header_.get())};
+    bcf_unpack(hts_record, fetch_samples ? BCF_UN_ALL : BCF_UN_SHR);
     VcfRecord::Builder record_builder {};
     extract_chrom(header_.get(), hts_record, record_builder);
     extract_pos(hts_record, record_builder);
@@ -988,11 +1340,18 @@ VcfRecord HtslibBcfFacade::fetch_record(const bcf_srs_t* sr, UnpackPolicy level)
     extract_alt(hts_record, record_builder);
     extract_qual(hts_record, record_builder);
     extract_filter(header_.get(), hts_record, record_builder);
-    extract_info(header_.get(), hts_record, record_builder);
-    if (level == UnpackPolicy::all && has_samples(header_.get())) {
-        extract_samples(header_.get(), hts_record, record_builder);
+    if (fetch_samples) {
+        record_builder.set_format(extract_format(header_.get(), hts_record));
     }
-    return record_builder.build_once();
+    auto result = record_builder.build_once();
+    // INFO and sample fields are left encoded until they are accessed
+    if (fetch_samples) {
+        result.decoder_ = std::make_shared<BcfFieldDecoder>(decoder_header_, bcf_dup(hts_record), decoder_samples_);
+    } else if (hts_record->n_info > 0) {
+        static const auto no_samples = std::make_shared<const std::vector<VcfRecord::SampleName>>();
+        result.decoder_ = std::make_shared<BcfFieldDecoder>(decoder_header_, copy_site(hts_record), no_samples);
+    }
+    return result;
 }
 
 HtslibBcfFacade::RecordContainer
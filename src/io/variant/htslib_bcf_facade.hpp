@@ -5,7 +5,9 @@
 #define htslib_bcf_facade_hpp
 
 #include <string>
+#include <vector>
 #include <set>
+#include <unordered_map>
 #include <memory>
 #include <cstddef>
 #include <iterator>
@@ -85,10 +87,39 @@ private:
     using HtsBcfSrPtr = std::unique_ptr<bcf_srs_t, HtsSrsDeleter>;
     using HtsBcf1Ptr  = std::unique_ptr<bcf1_t, HtsBcf1Deleter>;
     
+    // Reused between writes so encoding a record doesn't allocate once the buffers have grown
+    struct EncodeBuffers
+    {
+        std::vector<int> integers;
+        std::vector<float> floats;
+        std::vector<const char*> strings;
+        std::vector<std::string> joined_strings;
+        std::vector<std::size_t> sample_indices; // index into the record's samples for each header sample
+        std::vector<const std::vector<VcfRecord::ValueType>*> sample_values;
+    };
+    
     Path file_path_;
     std::unique_ptr<htsFile, HtsFileDeleter> file_;
     std::unique_ptr<bcf_hdr_t, HtsHeaderDeleter> header_;
     std::vector<std::string> samples_;
+    // Shared with the records read from this file, which decode their fields lazily
+    std::shared_ptr<bcf_hdr_t> decoder_header_;
+    std::shared_ptr<const std::vector<std::string>> decoder_samples_;
+    HtsBcf1Ptr encoded_record_;
+    // Records read lazily from a file with a compatible header are written without decoding them.
+    // bcf_translate caches its ID mapping in the source header, so this keeps its own copy of it.
+    std::shared_ptr<bcf_hdr_t> passthrough_source_;
+    std::unique_ptr<bcf_hdr_t, HtsHeaderDeleter> passthrough_header_;
+    bool is_passthrough_compatible_;
+    std::unordered_map<std::string, int> info_types_, format_types_;
+    EncodeBuffers encode_buffers_;
+    
+    int get_info_type(const std::string& key);
+    int get_format_type(const std::string& key);
+    void map_samples(const VcfRecord& source);
+    void set_info(const VcfRecord& source, bcf1_t* dest);
+    void set_samples(const VcfRecord& source, bcf1_t* dest);
+    bool write_encoded(const VcfRecord& record);
     
     bool is_bcf() const noexcept;
     std::size_t count_records(HtsBcfSrPtr& sr) const;
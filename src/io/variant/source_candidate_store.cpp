@@ -0,0 +1,366 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "source_candidate_store.hpp"
+
+#include <array>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <cmath>
+#include <limits>
+#include <unordered_set>
+#include <utility>
+
+#include <boost/filesystem.hpp>
+
+#include "vcf_reader.hpp"
+#include "vcf_spec.hpp"
+#include "utils/sequence_utils.hpp"
+#include "utils/checksum.hpp"
+#include "utils/mapped_file_format.hpp"
+#include "exceptions/malformed_file_error.hpp"
+#include "exceptions/unwritable_file_error.hpp"
+#include "logging/logging.hpp"
+
+namespace octopus {
+
+namespace fs = boost::filesystem;
+namespace mapped_file = utils::mapped_file;
+
+class MalformedSourceCandidateStore : public MalformedFileError
+{
+    std::string do_where() const override { return "SourceCandidateStore"; }
+    std::string do_help() const override { return "delete the store so it is rebuilt from the source candidate file"; }
+public:
+    MalformedSourceCandidateStore(boost::filesystem::path file, std::string reason)
+    : MalformedFileError {std::move(file), "source candidate store"}
+    {
+        set_reason(std::move(reason));
+    }
+};
+
+class UnsortedSourceCandidateFile : public MalformedFileError
+{
+    std::string do_where() const override { return "build_source_candidate_store"; }
+    std::string do_help() const override { return "sort and index the source candidate file"; }
+public:
+    UnsortedSourceCandidateFile(boost::filesystem::path file)
+    : MalformedFileError {std::move(file), "VCF"}
+    {
+        set_reason("records are not grouped by contig");
+    }
+};
+
+class UnwritableSourceCandidateStore : public UnwritableFileError
+{
+    std::string do_where() const override { return "build_source_candidate_store"; }
+public:
+    UnwritableSourceCandidateStore(boost::filesystem::path file) : UnwritableFileError {std::move(file), "source candidate store"} {}
+};
+
+namespace {
+
+// The payload is, per contig, Record[num_records] sorted by begin, u32 block_ends[num_blocks], then the allele bytes.
+// The table is: u64 source fingerprint, u64 num_contigs, then per contig: contig name, u64 record offset,
+// u64 num records, u64 block offset, u64 num blocks, u64 allele offset, u64 num allele bytes.
+// Each record's reference allele is at allele_offset in its contig's allele pool, immediately followed by the alt allele.
+constexpr mapped_file::Magic magic {'O', 'C', 'T', 'S', 'R', 'C', 'C', '\0'};
+constexpr std::uint32_t version {2};
+constexpr std::size_t block_size {64};
+constexpr std::uint32_t filtered_flag {1};
+// The fingerprint includes this much of the start of the source file, which covers the header of most files
+constexpr std::size_t fingerprint_prefix_size {1 << 16};
+
+using Record = SourceCandidateStore::Record;
+
+std::uint32_t get_end(const Record& record) noexcept
+{
+    return record.begin + record.ref_length;
+}
+
+void update_checksum(const fs::path& file, const std::size_t max_bytes, utils::Checksum& checksum)
+{
+    std::ifstream in {file.string(), std::ios::binary};
+    std::array<char, 1 << 16> buffer {};
+    for (std::size_t num_read {0}; in && num_read < max_bytes; ) {
+        in.read(buffer.data(), std::min(buffer.size(), max_bytes - num_read));
+        const auto n = static_cast<std::size_t>(in.gcount());
+        checksum.update(buffer.data(), n);
+        num_read += n;
+    }
+}
+
+} // namespace
+
+SourceCandidateStore::SourceCandidateStore(Path store_path)
+: path_ {std::move(store_path)}
+, file_ {}
+, source_fingerprint_ {}
+, contigs_ {}
+{
+    try {
+        file_.open(path_.string());
+    } catch (const std::exception& e) {
+        throw MalformedSourceCandidateStore {path_, e.what()};
+    }
+    load_contig_table();
+}
+
+const SourceCandidateStore::Path& SourceCandidateStore::path() const noexcept
+{
+    return path_;
+}
+
+std::uint64_t SourceCandidateStore::source_fingerprint() const noexcept
+{
+    return source_fingerprint_;
+}
+
+bool SourceCandidateStore::has_contig(const GenomicRegion::ContigName& contig) const noexcept
+{
+    return contigs_.count(contig) == 1;
+}
+
+std::size_t SourceCandidateStore::count_candidates(const GenomicRegion::ContigName& contig) const noexcept
+{
+    const auto itr = contigs_.find(contig);
+    return itr != std::cend(contigs_) ? itr->second.num_records : 0;
+}
+
+std::vector<SourceCandidateStore::Candidate> SourceCandidateStore::fetch(const GenomicRegion& region) const
+{
+    std::vector<Candidate> result {};
+    const auto contig_itr = contigs_.find(region.contig_name());
+    if (contig_itr == std::cend(contigs_)) return result;
+    const auto& contig = contig_itr->second;
+    const auto first_record_idx = mapped_file::find_first_block_record(contig.block_ends, contig.num_blocks, block_size,
+                                                                        contig.num_records, static_cast<std::uint32_t>(region.begin()));
+    const auto last_record = contig.records + contig.num_records;
+    for (auto record = contig.records + first_record_idx;
+         record != last_record && record->begin < region.end(); ++record) {
+        if (get_end(*record) <= region.begin()) continue;
+        const auto ref = contig.alleles + record->allele_offset;
+        Candidate candidate {};
+        candidate.begin = record->begin;
+        candidate.ref = boost::string_ref {ref, record->ref_length};
+        candidate.alt = boost::string_ref {ref + record->ref_length, record->alt_length};
+        if (!std::isnan(record->quality)) candidate.quality = record->quality;
+        candidate.filtered = (record->flags & filtered_flag) != 0;
+        result.push_back(candidate);
+    }
+    return result;
+}
+
+void SourceCandidateStore::load_contig_table()
+{
+    using mapped_file::read_value;
+    const auto data = file_.data();
+    const auto file_size = file_.size();
+    try {
+        auto offset = mapped_file::read_header(data, file_size, magic, version);
+        source_fingerprint_ = read_value<std::uint64_t>(data, offset, file_size);
+        const auto num_contigs = read_value<std::uint64_t>(data, offset, file_size);
+        contigs_.reserve(num_contigs);
+        for (std::uint64_t i {0}; i < num_contigs; ++i) {
+            auto contig = mapped_file::read_string(data, offset, file_size);
+            ContigEntry entry {};
+            const auto record_offset = read_value<std::uint64_t>(data, offset, file_size);
+            entry.num_records = read_value<std::uint64_t>(data, offset, file_size);
+            const auto block_offset = read_value<std::uint64_t>(data, offset, file_size);
+            entry.num_blocks = read_value<std::uint64_t>(data, offset, file_size);
+            const auto allele_offset = read_value<std::uint64_t>(data, offset, file_size);
+            entry.num_allele_bytes = read_value<std::uint64_t>(data, offset, file_size);
+            entry.records = mapped_file::get_array<Record>(data, record_offset, entry.num_records, file_size);
+            entry.block_ends = mapped_file::get_array<std::uint32_t>(data, block_offset, entry.num_blocks, file_size);
+            entry.alleles = mapped_file::get_array<char>(data, allele_offset, entry.num_allele_bytes, file_size);
+            const auto bad_record = std::find_if(entry.records, entry.records + entry.num_records, [&] (const Record& record) {
+                return record.allele_offset + record.ref_length + record.alt_length > entry.num_allele_bytes;
+            });
+            if (bad_record != entry.records + entry.num_records) throw std::runtime_error {"corrupt allele offsets"};
+            contigs_.emplace(std::move(contig), entry);
+        }
+    } catch (const std::exception& e) {
+        throw MalformedSourceCandidateStore {path_, e.what()};
+    }
+}
+
+SourceCandidateStore::Path make_source_candidate_store_path(const SourceCandidateStore::Path& vcf_path)
+{
+    return vcf_path.string() + ".octsc";
+}
+
+SourceCandidateStore::Path make_source_candidate_store_path(const SourceCandidateStore::Path& vcf_path,
+                                                            const SourceCandidateStore::Path& directory)
+{
+    // Source files with the same name in different directories must not share a store
+    utils::Checksum source_checksum {};
+    source_checksum.update(fs::absolute(vcf_path).string());
+    std::ostringstream name {};
+    name << vcf_path.filename().string() << '.' << std::hex << source_checksum.value() << ".octsc";
+    return directory / name.str();
+}
+
+std::uint64_t make_source_fingerprint(const SourceCandidateStore::Path& vcf_path)
+{
+    utils::Checksum result {};
+    boost::system::error_code ec {};
+    result.update(std::uint64_t {fs::file_size(vcf_path, ec)});
+    result.update(static_cast<std::uint64_t>(fs::last_write_time(vcf_path, ec)));
+    update_checksum(vcf_path, fingerprint_prefix_size, result);
+    for (const auto& index_path : {fs::path {vcf_path.string() + ".csi"}, fs::path {vcf_path.string() + ".tbi"}}) {
+        if (fs::is_regular_file(index_path, ec)) {
+            update_checksum(index_path, std::numeric_limits<std::size_t>::max(), result);
+            break;
+        }
+    }
+    return result.value();
+}
+
+bool is_up_to_date(const SourceCandidateStore::Path& store_path, const SourceCandidateStore::Path& vcf_path)
+{
+    boost::system::error_code ec {};
+    if (!fs::is_regular_file(store_path, ec)) return false;
+    try {
+        return SourceCandidateStore {store_path}.source_fingerprint() == make_source_fingerprint(vcf_path);
+    } catch (const MalformedFileError&) {
+        return false;
+    }
+}
+
+namespace {
+
+bool is_canonical(const VcfRecord::NucleotideSequence& allele)
+{
+    return allele != vcfspec::missingValue
+           && std::none_of(std::cbegin(allele), std::cend(allele),
+                           [](const auto base) { return base == vcfspec::deletedBase; });
+}
+
+struct ContigCandidates
+{
+    std::vector<Record> records;
+    std::string alleles;
+};
+
+void add_candidates(const VcfRecord& record, ContigCandidates& result)
+{
+    const auto ref = utils::capitalise_copy(record.ref());
+    const auto quality = record.qual() ? *record.qual() : std::numeric_limits<SourceCandidateStore::QualityType>::quiet_NaN();
+    const auto flags = is_filtered(record) ? filtered_flag : 0u;
+    for (const auto& alt : record.alt()) {
+        if (!is_canonical(alt)) continue;
+        Record candidate {};
+        candidate.allele_offset = result.alleles.size();
+        candidate.begin = static_cast<std::uint32_t>(record.pos() - 1);
+        candidate.ref_length = static_cast<std::uint32_t>(ref.size());
+        candidate.alt_length = static_cast<std::uint32_t>(alt.size());
+        candidate.quality = quality;
+        candidate.flags = flags;
+        result.alleles += ref;
+        result.alleles += utils::capitalise_copy(alt);
+        result.records.push_back(candidate);
+    }
+}
+
+struct ContigTableEntry
+{
+    GenomicRegion::ContigName contig;
+    std::uint64_t record_offset, num_records, block_offset, num_blocks, allele_offset, num_allele_bytes;
+};
+
+ContigTableEntry write_contig(GenomicRegion::ContigName contig, ContigCandidates& candidates, std::ostream& out)
+{
+    // Sites are sorted by position in an indexed file, but this is not guaranteed for unindexed files
+    std::stable_sort(std::begin(candidates.records), std::end(candidates.records),
+                     [] (const Record& lhs, const Record& rhs) noexcept { return lhs.begin < rhs.begin; });
+    const auto block_ends = mapped_file::make_block_ends(candidates.records, block_size, get_end);
+    mapped_file::pad_to_alignment(out, 8);
+    ContigTableEntry result {std::move(contig), static_cast<std::uint64_t>(out.tellp()), candidates.records.size(),
+                             0, block_ends.size(), 0, candidates.alleles.size()};
+    mapped_file::write_array(out, candidates.records);
+    result.block_offset = static_cast<std::uint64_t>(out.tellp());
+    mapped_file::write_array(out, block_ends);
+    result.allele_offset = static_cast<std::uint64_t>(out.tellp());
+    out.write(candidates.alleles.data(), candidates.alleles.size());
+    candidates.records.clear();
+    candidates.alleles.clear();
+    return result;
+}
+
+std::string make_contig_table(const std::uint64_t source_fingerprint, const std::vector<ContigTableEntry>& entries)
+{
+    using mapped_file::write_value;
+    std::ostringstream result {std::ios::binary};
+    write_value(result, source_fingerprint);
+    write_value(result, std::uint64_t {entries.size()});
+    for (const auto& entry : entries) {
+        mapped_file::write_string(result, entry.contig);
+        write_value(result, entry.record_offset);
+        write_value(result, entry.num_records);
+        write_value(result, entry.block_offset);
+        write_value(result, entry.num_blocks);
+        write_value(result, entry.allele_offset);
+        write_value(result, entry.num_allele_bytes);
+    }
+    return result.str();
+}
+
+std::size_t write_source_candidate_store(const SourceCandidateStore::Path& vcf_path, const SourceCandidateStore::Path& path)
+{
+    // The fingerprint is taken before reading so a source modified during the build is seen as stale
+    const auto source_fingerprint = make_source_fingerprint(vcf_path);
+    VcfReader reader {vcf_path};
+    std::ofstream out {path.string(), std::ios::binary};
+    if (!out) throw UnwritableSourceCandidateStore {path};
+    mapped_file::write_header(out, magic, version);
+    std::vector<ContigTableEntry> table {};
+    std::unordered_set<GenomicRegion::ContigName> finished_contigs {};
+    // Only one contig is held in memory at a time, which requires records to be grouped by contig
+    GenomicRegion::ContigName current_contig {};
+    ContigCandidates candidates {};
+    std::size_t result {0};
+    for (auto p = reader.iterate(VcfReader::UnpackPolicy::sites); p.first != p.second; ++p.first) {
+        const auto& record = *p.first;
+        if (record.chrom() != current_contig) {
+            if (!current_contig.empty()) {
+                result += candidates.records.size();
+                table.push_back(write_contig(current_contig, candidates, out));
+                finished_contigs.insert(current_contig);
+            }
+            if (finished_contigs.count(record.chrom()) == 1) throw UnsortedSourceCandidateFile {vcf_path};
+            current_contig = record.chrom();
+        }
+        add_candidates(record, candidates);
+    }
+    if (!current_contig.empty()) {
+        result += candidates.records.size();
+        table.push_back(write_contig(current_contig, candidates, out));
+    }
+    mapped_file::write_table(out, make_contig_table(source_fingerprint, table));
+    out.close();
+    if (!out) throw UnwritableSourceCandidateStore {path};
+    return result;
+}
+
+} // namespace
+
+void build_source_candidate_store(const SourceCandidateStore::Path& vcf_path, const SourceCandidateStore::Path& store_path)
+{
+    // Write to a unique temporary and rename so concurrent builds never interleave or expose a partial store
+    const auto tmp_path = mapped_file::make_temp_path(store_path);
+    std::size_t num_candidates {};
+    try {
+        num_candidates = write_source_candidate_store(vcf_path, tmp_path);
+        fs::rename(tmp_path, store_path);
+    } catch (...) {
+        boost::system::error_code ec {};
+        fs::remove(tmp_path, ec);
+        throw;
+    }
+    logging::InfoLogger info_log {};
+    stream(info_log) << "Stored " << num_candidates << " source candidate alleles from " << vcf_path << " in " << store_path;
+}
+
+} // namespace octopus
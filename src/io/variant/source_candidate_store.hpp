@@ -0,0 +1,115 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef source_candidate_store_hpp
+#define source_candidate_store_hpp
+
+#include <vector>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+#include <boost/optional.hpp>
+#include <boost/utility/string_ref.hpp>
+
+#include "basics/genomic_region.hpp"
+#include "vcf_record.hpp"
+
+namespace octopus {
+
+/*
+ SourceCandidateStore is a memory-mapped, compacted copy of the sites in a VCF/BCF file of source
+ candidates. Each usable ALT allele is stored as a fixed size record (position, allele lengths, QUAL
+ and FILTER status) sorted by position, with the alleles themselves in a contiguous byte pool, so
+ fetching candidates requires no decompression or string parsing.
+
+ Alleles that could never become candidates (missing or containing deleted bases) are dropped, and
+ alleles are capitalised, when the store is built. QUAL and FILTER are retained so the same store
+ can be queried with different quality and filter settings. The store is immutable once opened so
+ can be queried concurrently without locking.
+ */
+class SourceCandidateStore
+{
+public:
+    using Path = boost::filesystem::path;
+    using QualityType = VcfRecord::QualityType;
+
+    struct Candidate
+    {
+        GenomicRegion::Position begin;
+        boost::string_ref ref, alt;
+        boost::optional<QualityType> quality;
+        bool filtered;
+    };
+
+    SourceCandidateStore() = delete;
+
+    SourceCandidateStore(Path store_path);
+
+    SourceCandidateStore(const SourceCandidateStore&)            = delete;
+    SourceCandidateStore& operator=(const SourceCandidateStore&) = delete;
+    SourceCandidateStore(SourceCandidateStore&&)                 = default;
+    SourceCandidateStore& operator=(SourceCandidateStore&&)      = default;
+
+    ~SourceCandidateStore() = default;
+
+    const Path& path() const noexcept;
+
+    // Identifies the version of the source file the store was built from
+    std::uint64_t source_fingerprint() const noexcept;
+
+    bool has_contig(const GenomicRegion::ContigName& contig) const noexcept;
+
+    std::size_t count_candidates(const GenomicRegion::ContigName& contig) const noexcept;
+
+    // Candidates whose reference allele overlaps region, in file order. The returned alleles
+    // refer to the mapped file so are valid for the lifetime of the store.
+    std::vector<Candidate> fetch(const GenomicRegion& region) const;
+
+    struct Record
+    {
+        std::uint64_t allele_offset;
+        std::uint32_t begin, ref_length, alt_length;
+        QualityType quality; // NaN if missing
+        std::uint32_t flags, padding;
+    };
+
+private:
+    struct ContigEntry
+    {
+        const Record* records;
+        std::size_t num_records;
+        const std::uint32_t* block_ends;
+        std::size_t num_blocks;
+        const char* alleles;
+        std::size_t num_allele_bytes;
+    };
+
+    Path path_;
+    boost::iostreams::mapped_file_source file_;
+    std::uint64_t source_fingerprint_;
+    std::unordered_map<GenomicRegion::ContigName, ContigEntry> contigs_;
+
+    void load_contig_table();
+};
+
+// The conventional store path for a source candidate file, next to the file
+SourceCandidateStore::Path make_source_candidate_store_path(const SourceCandidateStore::Path& vcf_path);
+// The store path for a source candidate file in a directory shared with the stores of other files
+SourceCandidateStore::Path make_source_candidate_store_path(const SourceCandidateStore::Path& vcf_path,
+                                                            const SourceCandidateStore::Path& directory);
+
+// A checksum of the size, modification time, start (including the header) and index of vcf_path
+std::uint64_t make_source_fingerprint(const SourceCandidateStore::Path& vcf_path);
+
+// True if the store exists, is readable, and was built from vcf_path as it is now
+bool is_up_to_date(const SourceCandidateStore::Path& store_path, const SourceCandidateStore::Path& vcf_path);
+
+// The store is written to a temporary file in the same directory and renamed into place when complete
+void build_source_candidate_store(const SourceCandidateStore::Path& vcf_path, const SourceCandidateStore::Path& store_path);
+
+} // namespace octopus
+
+#endif
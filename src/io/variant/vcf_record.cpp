@@ -5,6 +5,7 @@
 
 #include <algorithm>
 #include <iterator>
+#include <string>
 
 #include <boost/lexical_cast.hpp>
 
@@ -66,14 +67,15 @@ const std::vector<VcfRecord::KeyType>& VcfRecord::filter() const noexcept
 
 bool VcfRecord::has_info(const KeyType& key) const noexcept
 {
-    return info_.count(key) == 1;
+    return info().count(key) == 1;
 }
 
 std::vector<VcfRecord::KeyType> VcfRecord::info_keys() const
 {
+    const auto& info = this->info();
     std::vector<KeyType> result {};
-    result.reserve(info_.size());
-    std::transform(info_.cbegin(), info_.cend(), std::back_inserter(result), [] (const auto& p) {
+    result.reserve(info.size());
+    std::transform(info.cbegin(), info.cend(), std::back_inserter(result), [] (const auto& p) {
         return p.first;
     });
     return result;
@@ -81,7 +83,24 @@ std::vector<VcfRecord::KeyType> VcfRecord::info_keys() const
 
 const std::vector<VcfRecord::ValueType>& VcfRecord::info_value(const KeyType& key) const
 {
-    return info_.at(key);
+    return info().at(key);
+}
+
+namespace {
+
+boost::optional<double> get_number(const std::vector<VcfRecord::ValueType>& values, const unsigned index)
+{
+    if (index >= values.size() || values[index] == vcfspec::missingValue) return boost::none;
+    return std::stod(values[index]);
+}
+
+} // namespace
+
+boost::optional<double> VcfRecord::info_number(const KeyType& key, const unsigned index) const
+{
+    if (decoder_) return decoder_->info_number(key, index);
+    const auto itr = info_.find(key);
+    return itr != std::cend(info_) ? get_number(itr->second, index) : boost::none;
 }
 
 bool VcfRecord::has_format(const KeyType& key) const noexcept
@@ -93,8 +112,8 @@ boost::optional<unsigned> VcfRecord::format_cardinality(const KeyType& key) cons
 {
     boost::optional<unsigned> result {};
     if (has_format(key)) {
-        for (const auto& p : samples_) {
-            const auto sample_format_cardinality = p.second.other.at(key).size();
+        for (const auto& sample : samples()) {
+            const auto sample_format_cardinality = get_sample_value(sample, key).size();
             if (result) {
                 if (*result != sample_format_cardinality) return boost::none;
             } else {
@@ -112,7 +131,7 @@ const std::vector<VcfRecord::KeyType>& VcfRecord::format() const noexcept
 
 unsigned VcfRecord::num_samples() const noexcept
 {
-    return samples_.size();
+    return decoder_ ? decoder_->samples().size() : samples_.size();
 }
 
 bool VcfRecord::has_genotypes() const noexcept
@@ -152,6 +171,12 @@ bool VcfRecord::is_homozygous_ref(const SampleName& sample) const
 bool VcfRecord::is_refcall() const
 {
     const auto is_ref = [this] (const auto& allele) { return allele == ref_; };
+    if (decoder_) {
+        const auto& samples = decoder_->samples();
+        return std::all_of(std::cbegin(samples), std::cend(samples), [&] (const auto& sample) {
+            const auto& genotype = decoder_->genotype(sample).alleles;
+            return std::all_of(std::cbegin(genotype), std::cend(genotype), is_ref); });
+    }
     const auto is_hom_ref = [&] (const auto& p) {
         return std::all_of(std::cbegin(p.second.genotype->alleles), std::cend(p.second.genotype->alleles), is_ref); };
     return std::all_of(std::cbegin(samples_), std::cend(samples_), is_hom_ref);
@@ -180,8 +205,16 @@ bool VcfRecord::has_alt_allele(const SampleName& sample) const
 
 const std::vector<VcfRecord::ValueType>& VcfRecord::get_sample_value(const SampleName& sample, const KeyType& key) const
 {
-    const auto& data = samples_.at(sample);
-    return (key == vcfspec::format::genotype) ? data.genotype->alleles : data.other.at(key);
+    if (key == vcfspec::format::genotype) return get_genotype(sample).alleles;
+    return decoder_ ? decoder_->format(sample, key) : samples_.at(sample).other.at(key);
+}
+
+boost::optional<double> VcfRecord::sample_number(const SampleName& sample, const KeyType& key, const unsigned index) const
+{
+    if (decoder_) return decoder_->format_number(sample, key, index);
+    const auto& data = samples_.at(sample).other;
+    const auto itr = data.find(key);
+    return itr != std::cend(data) ? get_number(itr->second, index) : boost::none;
 }
 
 // helper non-members needed for printing
@@ -212,8 +245,36 @@ std::ostream& operator<<(std::ostream& os, const std::vector<T>& v)
 
 // private methods
 
+const VcfRecord::ValueMap& VcfRecord::info() const
+{
+    return decoder_ ? decoder_->info() : info_;
+}
+
+VcfRecord::SampleDataMap VcfRecord::decode_samples() const
+{
+    if (!decoder_) return samples_;
+    SampleDataMap result {};
+    const auto& samples = decoder_->samples();
+    result.reserve(samples.size());
+    for (const auto& sample : samples) {
+        SampleData data {};
+        auto first_format = std::cbegin(format_);
+        if (has_genotypes()) {
+            data.genotype = decoder_->genotype(sample);
+            ++first_format;
+        }
+        data.other.reserve(format_.size());
+        std::for_each(first_format, std::cend(format_), [&] (const auto& key) {
+            data.other.emplace(key, decoder_->format(sample, key));
+        });
+        result.emplace_hint(std::cend(result), sample, std::move(data));
+    }
+    return result;
+}
+
 std::vector<VcfRecord::SampleName> VcfRecord::samples() const
 {
+    if (decoder_) return decoder_->samples();
     std::vector<SampleName> result {};
     result.reserve(samples_.size());
     for (const auto& p : samples_) {
@@ -224,7 +285,7 @@ std::vector<VcfRecord::SampleName> VcfRecord::samples() const
 
 const VcfRecord::Genotype& VcfRecord::get_genotype(const SampleName& sample) const
 {
-    return *samples_.at(sample).genotype;
+    return decoder_ ? decoder_->genotype(sample) : *samples_.at(sample).genotype;
 }
 
 std::string VcfRecord::get_allele_number(const NucleotideSequence& allele) const
@@ -241,11 +302,12 @@ std::string VcfRecord::get_allele_number(const NucleotideSequence& allele) const
 
 void VcfRecord::print_info(std::ostream& os) const
 {
-    if (info_.empty()) {
+    const auto& info = this->info();
+    if (info.empty()) {
         os << ".";
     } else {
-        auto last = std::next(std::cbegin(info_), info_.size() - 1);
-        std::for_each(std::cbegin(info_), last,
+        auto last = std::next(std::cbegin(info), info.size() - 1);
+        std::for_each(std::cbegin(info), last,
                       [&os] (const auto& p) {
                           os << p.first;
                           if (!p.second.empty()) {
@@ -269,23 +331,6 @@ void VcfRecord::print_genotype_allele_numbers(std::ostream& os, const SampleName
     print(os, allele_numbers, (genotype.phased) ? "|" : "/");
 }
 
-void VcfRecord::print_other_sample_data(std::ostream& os, const SampleName& sample) const
-{
-    if (!samples_.empty()) {
-        if (samples_.at(sample).other.empty()) {
-            os << ".";
-        } else {
-            const auto& data = samples_.at(sample).other;
-            auto last = std::next(cbegin(data), data.size() - 1);
-            std::for_each(std::cbegin(data), last, [&os] (const auto& p) {
-                print(os, p.second, ",");
-                os << ":";
-            });
-            print(os, last->second, ",");
-        }
-    }
-}
-
 void VcfRecord::print_sample_data(std::ostream& os) const
 {
     if (num_samples() > 0) {
@@ -438,9 +483,9 @@ VcfRecord::Builder::Builder(const VcfRecord& call)
 , alt_ {call.alt()}
 , qual_ {call.qual()}
 , filter_ {call.filter()}
-, info_ {call.info_}
+, info_ {call.info()}
 , format_ {call.format()}
-, samples_ {call.samples_}
+, samples_ {call.decode_samples()}
 {}
 
 VcfRecord::Builder& VcfRecord::Builder::set_chrom(std::string name)
@@ -13,6 +13,7 @@
 #include <utility>
 #include <initializer_list>
 #include <functional>
+#include <memory>
 
 #include <boost/optional.hpp>
 #include <boost/container/flat_map.hpp>
@@ -30,12 +31,20 @@ class VcfRecord : public Comparable<VcfRecord>, public Mappable<VcfRecord>
 {
 public:
     class Builder;
+    class FieldDecoder;
     
     using NucleotideSequence = std::string;
     using QualityType        = float;
     using SampleName         = std::string;
     using KeyType            = std::string;
     using ValueType          = std::string;
+    using ValueMap           = boost::container::flat_map<KeyType, std::vector<ValueType>>;
+    
+    struct Genotype
+    {
+        std::vector<NucleotideSequence> alleles;
+        bool phased;
+    };
     
     VcfRecord() = default;
     
@@ -90,6 +99,8 @@ public:
     bool has_info(const KeyType& key) const noexcept;
     std::vector<KeyType> info_keys() const;
     const std::vector<ValueType>& info_value(const KeyType& key) const;
+    // Returns boost::none if the key or value is missing
+    boost::optional<double> info_number(const KeyType& key, unsigned index = 0) const;
     
     //
     // Sample releated functions
@@ -109,17 +120,14 @@ public:
     bool has_ref_allele(const SampleName& sample) const;
     bool has_alt_allele(const SampleName& sample) const;
     const std::vector<ValueType>& get_sample_value(const SampleName& sample, const KeyType& key) const;
+    // Returns boost::none if the key or value is missing
+    boost::optional<double> sample_number(const SampleName& sample, const KeyType& key, unsigned index = 0) const;
     
     friend std::ostream& operator<<(std::ostream& os, const VcfRecord& record);
     friend Builder;
+    friend class HtslibBcfFacade;
     
 private:
-    using ValueMap = boost::container::flat_map<KeyType, std::vector<ValueType>>;
-    struct Genotype
-    {
-        std::vector<NucleotideSequence> alleles;
-        bool phased;
-    };
     struct SampleData
     {
         boost::optional<Genotype> genotype;
@@ -138,16 +146,38 @@ private:
     // optional fields
     std::vector<KeyType> format_;
     SampleDataMap samples_;
+    // INFO and sample fields that are decoded on first access, in which case info_ and samples_ are empty
+    std::shared_ptr<const FieldDecoder> decoder_;
     
+    const ValueMap& info() const;
+    SampleDataMap decode_samples() const;
     const Genotype& get_genotype(const SampleName& sample) const;
     std::string get_allele_number(const NucleotideSequence& allele) const;
     std::vector<SampleName> samples() const;
     void print_info(std::ostream& os) const;
     void print_genotype_allele_numbers(std::ostream& os, const SampleName& sample) const;
-    void print_other_sample_data(std::ostream& os, const SampleName& sample) const;
     void print_sample_data(std::ostream& os) const;
 };
 
+/*
+ FieldDecoder lets a reader leave INFO and sample fields encoded until they are needed, which avoids
+ converting every FORMAT field of every sample to strings when only a few are used. Copies of a record
+ share its decoder, and a decoder must be safe to use from multiple threads.
+ */
+class VcfRecord::FieldDecoder
+{
+public:
+    virtual ~FieldDecoder() = default;
+    
+    virtual const ValueMap& info() const = 0;
+    virtual boost::optional<double> info_number(const KeyType& key, unsigned index) const = 0;
+    
+    virtual const std::vector<SampleName>& samples() const = 0; // sorted
+    virtual const Genotype& genotype(const SampleName& sample) const = 0;
+    virtual const std::vector<ValueType>& format(const SampleName& sample, const KeyType& key) const = 0;
+    virtual boost::optional<double> format_number(const SampleName& sample, const KeyType& key, unsigned index) const = 0;
+};
+
 // non-member functions
 
 std::vector<VcfRecord::NucleotideSequence> get_genotype(const VcfRecord& record, const VcfRecord::SampleName& sample);
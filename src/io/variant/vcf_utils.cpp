@@ -12,9 +12,19 @@
 #include <functional>
 #include <stdexcept>
 #include <numeric>
+#include <memory>
+#include <array>
+#include <fstream>
+#include <future>
+#include <cstring>
+
+#include <boost/filesystem/operations.hpp>
 
 #include "htslib/vcf.h"
 #include "htslib/tbx.h"
+#include "htslib/bgzf.h"
+
+#include "utils/thread_pool.hpp"
 
 #include "basics/contig_region.hpp"
 #include "basics/genomic_region.hpp"
@@ -82,7 +92,7 @@ void index_vcfs(const std::vector<VcfReader>& readers)
     for (const auto& reader : readers) index_vcf(reader);
 }
 
-std::vector<VcfReader> writers_to_readers(std::vector<VcfWriter>&& writers, const bool keep_open)
+std::vector<VcfReader> writers_to_readers(std::vector<VcfWriter>&& writers, const bool keep_open, const unsigned max_threads)
 {
     std::vector<VcfReader> result {};
     result.reserve(writers.size());
@@ -94,10 +104,172 @@ std::vector<VcfReader> writers_to_readers(std::vector<VcfWriter>&& writers, cons
             if (!keep_open) result.back().close();
         }
     }
+    if (max_threads > 1 && writers.size() > 1) {
+        // Writers build their index on destruction, so destroy them concurrently
+        ThreadPool workers {std::min(static_cast<std::size_t>(max_threads), writers.size())};
+        std::vector<std::future<void>> futures {};
+        futures.reserve(writers.size());
+        for (auto& writer : writers) {
+            futures.push_back(workers.push([&writer] () { const auto tmp = std::move(writer); }));
+        }
+        for (auto& future : futures) future.wait();
+    }
     writers.clear();
     return result;
 }
 
+namespace {
+
+namespace fs = boost::filesystem;
+
+// The empty block htslib writes to mark the end of a BGZF file
+constexpr std::size_t bgzfEOFSize {28};
+constexpr std::array<unsigned char, bgzfEOFSize> bgzfEOF {
+    0x1f, 0x8b, 0x08, 0x04, 0x00, 0x00, 0x00, 0x00, 0x00, 0xff, 0x06, 0x00, 0x42, 0x43,
+    0x02, 0x00, 0x1b, 0x00, 0x03, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00, 0x00
+};
+
+struct HtsFileDeleter
+{
+    void operator()(htsFile* file) const { hts_close(file); }
+};
+struct BcfHeaderDeleter
+{
+    void operator()(bcf_hdr_t* header) const { bcf_hdr_destroy(header); }
+};
+
+struct BcfLayout
+{
+    std::unique_ptr<bcf_hdr_t, BcfHeaderDeleter> header;
+    std::uintmax_t body_begin, body_end; // compressed offsets of the record blocks
+};
+
+bool ends_with_bgzf_eof(const fs::path& path, const std::uintmax_t file_size)
+{
+    if (file_size < bgzfEOFSize) return false;
+    std::ifstream file {path.string(), std::ios::binary};
+    file.seekg(file_size - bgzfEOFSize);
+    std::array<char, bgzfEOFSize> tail {};
+    file.read(tail.data(), tail.size());
+    return file && std::equal(std::cbegin(tail), std::cend(tail), std::cbegin(bgzfEOF),
+                              [] (char lhs, unsigned char rhs) { return static_cast<unsigned char>(lhs) == rhs; });
+}
+
+boost::optional<BcfLayout> read_bcf_layout(const fs::path& path)
+{
+    std::unique_ptr<htsFile, HtsFileDeleter> file {hts_open(path.c_str(), "r")};
+    if (!file) return boost::none;
+    const auto format = *hts_get_format(file.get());
+    if (format.format != bcf || format.compression != bgzf) return boost::none;
+    BcfLayout result {};
+    result.header.reset(bcf_hdr_read(file.get()));
+    if (!result.header) return boost::none;
+    const auto header_end = bgzf_tell(file->fp.bgzf);
+    if ((header_end & 0xFFFF) != 0) return boost::none; // records must start on a block boundary
+    boost::system::error_code ec {};
+    const auto file_size = fs::file_size(path, ec);
+    if (ec || !ends_with_bgzf_eof(path, file_size)) return boost::none;
+    result.body_begin = static_cast<std::uintmax_t>(header_end >> 16);
+    result.body_end = file_size - bgzfEOFSize;
+    return result;
+}
+
+bool are_equal(const bcf_idpair_t& lhs, const bcf_idpair_t& rhs) noexcept
+{
+    if (lhs.key == nullptr || rhs.key == nullptr) return lhs.key == rhs.key;
+    if (std::strcmp(lhs.key, rhs.key) != 0) return false;
+    if (lhs.val == nullptr || rhs.val == nullptr) return lhs.val == rhs.val;
+    return std::equal(std::cbegin(lhs.val->info), std::cend(lhs.val->info), std::cbegin(rhs.val->info));
+}
+
+// BCF records refer to contigs, fields, and samples by dictionary index, so records can only be copied
+// verbatim between files with identical dictionaries
+bool are_binary_compatible(const bcf_hdr_t& lhs, const bcf_hdr_t& rhs) noexcept
+{
+    for (const int type : {BCF_DT_ID, BCF_DT_CTG, BCF_DT_SAMPLE}) {
+        if (lhs.n[type] != rhs.n[type]) return false;
+        if (!std::equal(lhs.id[type], lhs.id[type] + lhs.n[type], rhs.id[type], are_equal)) return false;
+    }
+    return true;
+}
+
+void copy_bytes(const fs::path& src, const std::uintmax_t begin, const std::uintmax_t end,
+                const fs::path& dst, const std::uintmax_t offset)
+{
+    std::ifstream in {src.string(), std::ios::binary};
+    std::fstream out {dst.string(), std::ios::binary | std::ios::in | std::ios::out};
+    in.seekg(begin);
+    out.seekp(offset);
+    std::vector<char> buffer(std::min(end - begin, std::uintmax_t {1} << 22));
+    for (auto remaining = end - begin; remaining > 0 && in && out;) {
+        const auto n = std::min(remaining, static_cast<std::uintmax_t>(buffer.size()));
+        in.read(buffer.data(), n);
+        out.write(buffer.data(), n);
+        remaining -= n;
+    }
+    if (!in || !out) {
+        throw std::ios::failure {"concatenate_bcf_blocks: failed copying " + src.string() + " to " + dst.string()};
+    }
+}
+
+} // namespace
+
+bool concatenate_bcf_blocks(const std::vector<fs::path>& sources, const fs::path& dst, const unsigned max_threads)
+{
+    const auto dst_layout = read_bcf_layout(dst);
+    if (!dst_layout) return false;
+    std::vector<BcfLayout> source_layouts {};
+    source_layouts.reserve(sources.size());
+    for (const auto& source : sources) {
+        auto layout = read_bcf_layout(source);
+        if (!layout || !are_binary_compatible(*dst_layout->header, *layout->header)) return false;
+        source_layouts.push_back(std::move(*layout));
+    }
+    // The result is built in a temporary copy of dst, which replaces dst only once complete, so dst
+    // is left unchanged if copying fails part way
+    const auto temp = dst.parent_path() / fs::unique_path(dst.filename().string() + ".%%%%-%%%%-%%%%.tmp");
+    try {
+        // Each source body is copied to a precomputed offset so the copies are independent
+        std::vector<std::uintmax_t> offsets {dst_layout->body_end};
+        offsets.reserve(sources.size() + 1);
+        for (const auto& layout : source_layouts) {
+            offsets.push_back(offsets.back() + (layout.body_end - layout.body_begin));
+        }
+        fs::copy_file(dst, temp);
+        fs::resize_file(temp, offsets.back() + bgzfEOFSize);
+        const auto copy_body = [&] (const std::size_t idx) {
+            copy_bytes(sources[idx], source_layouts[idx].body_begin, source_layouts[idx].body_end, temp, offsets[idx]);
+        };
+        if (max_threads > 1 && sources.size() > 1) {
+            ThreadPool workers {std::min(static_cast<std::size_t>(max_threads), sources.size())};
+            std::vector<std::future<void>> futures {};
+            futures.reserve(sources.size());
+            for (std::size_t idx {0}; idx < sources.size(); ++idx) {
+                futures.push_back(workers.push(copy_body, idx));
+            }
+            for (auto& future : futures) future.wait();
+            for (auto& future : futures) future.get();
+        } else {
+            for (std::size_t idx {0}; idx < sources.size(); ++idx) copy_body(idx);
+        }
+        {
+            std::fstream out {temp.string(), std::ios::binary | std::ios::in | std::ios::out};
+            out.seekp(offsets.back());
+            out.write(reinterpret_cast<const char*>(bgzfEOF.data()), bgzfEOF.size());
+            out.flush();
+            if (!out) {
+                throw std::ios::failure {"concatenate_bcf_blocks: failed writing " + temp.string()};
+            }
+        }
+        fs::rename(temp, dst);
+    } catch (...) {
+        boost::system::error_code ec {};
+        fs::remove(temp, ec);
+        throw;
+    }
+    return true;
+}
+
 void copy(VcfReader& src, VcfWriter& dst)
 {
     const bool is_closed {!src.is_open()};
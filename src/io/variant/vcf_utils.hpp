@@ -34,7 +34,15 @@ void index_vcf(const boost::filesystem::path& vcf_path);
 void index_vcf(const VcfReader& reader);
 void index_vcfs(const std::vector<VcfReader>& readers);
 
-std::vector<VcfReader> writers_to_readers(std::vector<VcfWriter>&& writers, bool keep_open = true);
+std::vector<VcfReader> writers_to_readers(std::vector<VcfWriter>&& writers, bool keep_open = true,
+                                          unsigned max_threads = 1);
+
+// Appends the records of BGZF compressed BCF sources to dst by copying compressed blocks, without
+// re-encoding. Returns false if any header is not binary compatible with dst. dst is unchanged unless
+// true is returned, including when an exception is thrown.
+bool concatenate_bcf_blocks(const std::vector<boost::filesystem::path>& sources,
+                            const boost::filesystem::path& dst,
+                            unsigned max_threads = 1);
 
 void copy(VcfReader& src, VcfWriter& dst);
 void copy(const VcfReader& src, VcfWriter& dst);
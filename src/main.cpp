@@ -88,6 +88,11 @@ int main(const int argc, const char** argv)
             log_program_startup();
             logging::InfoLogger info_log {};
             const auto start = std::chrono::system_clock::now();
+            if (is_build_repeat_index_command(options)) {
+                make_reference(options);
+                log_program_end();
+                return EXIT_SUCCESS;
+            }
             sanity_check(options);
             log_command_line_options(options);
             auto components = collate_genome_calling_components(options);
@@ -7,6 +7,8 @@
 #include <limits>
 #include <algorithm>
 #include <iterator>
+#include <chrono>
+#include <cassert>
 
 #include "utils/mappable_algorithms.hpp"
 #include "utils/read_stats.hpp"
@@ -36,6 +38,7 @@ const ReadPipe& BufferedReadPipe::source() const noexcept
 
 void BufferedReadPipe::clear() noexcept
 {
+    cancel_prefetch();
     buffer_.clear();
     buffered_region_ = boost::none;
     hints_.clear();
@@ -70,45 +73,139 @@ bool BufferedReadPipe::is_cached(const GenomicRegion& region) const noexcept
 
 // private methods
 
+std::size_t BufferedReadPipe::buffer_budget() const noexcept
+{
+    return config_.prefetch_hints ? std::max(config_.max_buffer_size / 2, std::size_t {1}) : config_.max_buffer_size;
+}
+
 void BufferedReadPipe::setup_buffer(const GenomicRegion& request) const
 {
     if (!is_cached(request)) {
         if (debug_log_) stream(*debug_log_) << "Request " << request << " is not cached";
-        auto max_region = get_max_fetch_region(request);
-        if (debug_log_) stream(*debug_log_) << "Max fetch region for request " << request << " is " << max_region;
-        bool unchecked_fetch {false};
-        if (can_make_unchecked_fetch()) {
-            buffered_region_ = std::move(max_region);
-            unchecked_fetch = true;
-        } else {
-            buffered_region_ = source_.get().read_manager().find_covered_subregion(max_region, config_.max_buffer_size);
+        if (!use_prefetched_buffer(request)) {
+            auto plan = plan_fetch(request);
+            if (debug_log_) stream(*debug_log_) << "Max fetch region for request " << request << " is " << plan.max_region;
+            commit(execute(source_, std::move(plan), buffer_budget(), config_.fetch_expansion));
         }
         if (debug_log_) stream(*debug_log_) << "Buffer region for request " << request << " is " << *buffered_region_;
-        buffer_ = source_.get().fetch_reads(expand(*buffered_region_, config_.fetch_expansion));
-        if (unchecked_fetch) {
-            const auto fetch_size = count_reads(buffer_);
-            if (fetch_size > config_.max_buffer_size) {
-                if (default_unchecked_fetch_overflowed_) {
-                    adjusted_unchecked_fetch_overflowed_ = true;
-                } else {
-                    default_unchecked_fetch_overflowed_ = true;
-                }
-                // Clear buffer of reads to rhs of request
-                for (auto& p : buffer_) {
-                    const auto last_overlapped = find_first_after(p.second, request);
-                    p.second.erase(last_overlapped, std::cend(p.second));
-                }
-                buffered_region_ = request;
-            }
-        } else {
-            if (min_checked_fetch_size_) {
-                min_checked_fetch_size_ = std::min(size(*buffered_region_), *min_checked_fetch_size_);
+        if (config_.prefetch_hints) prefetch_next_hint();
+    } else if (debug_log_) {
+        stream(*debug_log_) << "Request " << request << " is already cached";
+    }
+}
+
+bool BufferedReadPipe::use_prefetched_buffer(const GenomicRegion& request) const
+{
+    if (!prefetch_plan_) {
+        if (config_.prefetch_hints) ++prefetch_stats_.misses;
+        return false;
+    }
+    bool result {false};
+    if (overlaps(prefetch_plan_->max_region, request) && !is_before(request, prefetch_plan_->request)) {
+        if (prefetch_.wait_for(std::chrono::seconds {0}) != std::future_status::ready) {
+            ++prefetch_stats_.stalls;
+        }
+        commit(prefetch_.get());
+        result = is_cached(request);
+    } else {
+        cancel_prefetch();
+    }
+    prefetch_plan_ = boost::none;
+    if (result) {
+        ++prefetch_stats_.hits;
+    } else {
+        ++prefetch_stats_.misses;
+    }
+    if (debug_log_) {
+        stream(*debug_log_) << "Prefetch " << (result ? "hit" : "miss") << " for request " << request
+                            << " (hits: " << prefetch_stats_.hits << ", misses: " << prefetch_stats_.misses
+                            << ", stalls: " << prefetch_stats_.stalls << ")";
+    }
+    return result;
+}
+
+void BufferedReadPipe::cancel_prefetch() const noexcept
+{
+    if (prefetch_.valid()) {
+        try {
+            prefetch_.get(); // cannot interrupt an in-flight fetch, but must not leave it referencing the buffer
+        } catch (...) {}
+    }
+    prefetch_plan_ = boost::none;
+}
+
+void BufferedReadPipe::prefetch_next_hint() const
+{
+    cancel_prefetch();
+    const auto next_request = next_hinted_request();
+    if (next_request) {
+        prefetch_plan_ = plan_fetch(*next_request);
+        if (debug_log_) stream(*debug_log_) << "Prefetching " << prefetch_plan_->max_region << " for hinted request " << *next_request;
+        prefetch_ = std::async(std::launch::async, execute, std::cref(source_.get()), *prefetch_plan_,
+                               buffer_budget(), config_.fetch_expansion);
+    }
+}
+
+boost::optional<GenomicRegion> BufferedReadPipe::next_hinted_request() const
+{
+    assert(buffered_region_);
+    const auto contig_hints_itr = hints_.find(buffered_region_->contig_name());
+    if (contig_hints_itr == std::cend(hints_)) return boost::none;
+    const auto& contig_hints = contig_hints_itr->second;
+    // Hints are merged into disjoint sorted regions, so their ends are sorted too
+    const auto next_hint_itr = std::upper_bound(std::cbegin(contig_hints), std::cend(contig_hints), *buffered_region_,
+                                                [] (const auto& buffered, const auto& hint) { return ends_before(buffered, hint); });
+    if (next_hint_itr == std::cend(contig_hints)) return boost::none;
+    if (begins_before(*next_hint_itr, *buffered_region_)) {
+        return right_overhang_region(*next_hint_itr, *buffered_region_);
+    } else {
+        return *next_hint_itr;
+    }
+}
+
+BufferedReadPipe::FetchPlan BufferedReadPipe::plan_fetch(const GenomicRegion& request) const
+{
+    return FetchPlan {request, get_max_fetch_region(request), can_make_unchecked_fetch()};
+}
+
+BufferedReadPipe::FetchResult
+BufferedReadPipe::execute(const ReadPipe& source, FetchPlan plan, const std::size_t budget, const GenomicRegion::Size fetch_expansion)
+{
+    FetchResult result {std::move(plan), {}, {}};
+    if (result.plan.unchecked) {
+        result.region = result.plan.max_region;
+    } else {
+        result.region = source.read_manager().find_covered_subregion(result.plan.max_region, budget);
+    }
+    result.reads = source.fetch_reads(expand(result.region, fetch_expansion));
+    return result;
+}
+
+void BufferedReadPipe::commit(FetchResult result) const
+{
+    buffer_ = std::move(result.reads);
+    buffered_region_ = std::move(result.region);
+    if (result.plan.unchecked) {
+        const auto fetch_size = count_reads(buffer_);
+        if (fetch_size > buffer_budget()) {
+            if (default_unchecked_fetch_overflowed_) {
+                adjusted_unchecked_fetch_overflowed_ = true;
             } else {
-                min_checked_fetch_size_ = size(*buffered_region_);
+                default_unchecked_fetch_overflowed_ = true;
             }
+            // Clear buffer of reads to rhs of request
+            for (auto& p : buffer_) {
+                const auto last_overlapped = find_first_after(p.second, result.plan.request);
+                p.second.erase(last_overlapped, std::cend(p.second));
+            }
+            buffered_region_ = result.plan.request;
+        }
+    } else {
+        if (min_checked_fetch_size_) {
+            min_checked_fetch_size_ = std::min(size(*buffered_region_), *min_checked_fetch_size_);
+        } else {
+            min_checked_fetch_size_ = size(*buffered_region_);
         }
-    } else if (debug_log_) {
-        stream(*debug_log_) << "Request " << request << " is already cached";
     }
 }
 
@@ -6,6 +6,7 @@
 
 #include <functional>
 #include <cstddef>
+#include <future>
 
 #include <boost/optional.hpp>
 
@@ -26,6 +27,9 @@ public:
         boost::optional<GenomicRegion::Size> max_fetch_size = boost::none;
         boost::optional<GenomicRegion::Size> max_hint_gap = boost::none;
         bool allow_unchecked_fetches = true;
+        // If set, the next hinted region is fetched on a background thread while the current buffer is used.
+        // The buffer memory budget is shared between the current and prefetched buffers.
+        bool prefetch_hints = false;
     };
     
     BufferedReadPipe() = delete;
@@ -56,6 +60,22 @@ public:
 private:
     using RegionMap = MappableSetMap<GenomicRegion::ContigName, GenomicRegion>;
     
+    struct FetchPlan
+    {
+        GenomicRegion request, max_region;
+        bool unchecked;
+    };
+    struct FetchResult
+    {
+        FetchPlan plan;
+        GenomicRegion region;
+        ReadMap reads;
+    };
+    struct PrefetchStats
+    {
+        std::size_t hits = 0, misses = 0, stalls = 0;
+    };
+    
     std::reference_wrapper<const ReadPipe> source_;
     Config config_;
     mutable ReadMap buffer_;
@@ -64,9 +84,20 @@ private:
     mutable bool default_unchecked_fetch_overflowed_ = false;
     mutable bool adjusted_unchecked_fetch_overflowed_ = false;
     mutable boost::optional<GenomicRegion::Size> min_checked_fetch_size_ = boost::none;
+    mutable boost::optional<FetchPlan> prefetch_plan_ = boost::none;
+    mutable std::future<FetchResult> prefetch_;
+    mutable PrefetchStats prefetch_stats_ = {};
     mutable boost::optional<logging::DebugLogger> debug_log_;
     
+    std::size_t buffer_budget() const noexcept;
     void setup_buffer(const GenomicRegion& request) const;
+    bool use_prefetched_buffer(const GenomicRegion& request) const;
+    void cancel_prefetch() const noexcept;
+    void prefetch_next_hint() const;
+    boost::optional<GenomicRegion> next_hinted_request() const;
+    FetchPlan plan_fetch(const GenomicRegion& request) const;
+    static FetchResult execute(const ReadPipe& source, FetchPlan plan, std::size_t budget, GenomicRegion::Size fetch_expansion);
+    void commit(FetchResult result) const;
     GenomicRegion get_max_fetch_region(const GenomicRegion& request) const;
     GenomicRegion get_default_max_fetch_region(const GenomicRegion& request) const;
     bool can_make_unchecked_fetch() const noexcept;
@@ -7,6 +7,7 @@
 #include <iterator>
 #include <algorithm>
 #include <cassert>
+#include <future>
 
 #include "utils/read_stats.hpp"
 #include "utils/mappable_algorithms.hpp"
@@ -29,6 +30,7 @@ ReadPipe::ReadPipe(const ReadManager& source, ReadTransformer transformer, ReadF
 , downsampler_ {std::move(downsampler)}
 , samples_ {std::move(samples)}
 , fragment_size_ {}
+, workers_ {}
 , debug_log_ {}
 {
     if (DEBUG_MODE) debug_log_ = logging::DebugLogger {};
@@ -44,6 +46,7 @@ ReadPipe::ReadPipe(const ReadManager& source, ReadTransformer prefilter_transfor
 , downsampler_ {std::move(downsampler)}
 , samples_ {std::move(samples)}
 , fragment_size_ {}
+, workers_ {}
 , debug_log_ {}
 {
     if (DEBUG_MODE) debug_log_ = logging::DebugLogger {};
@@ -59,18 +62,12 @@ ReadPipe::ReadPipe(const ReadManager& source, GenomicRegion::Size fragment_size,
 , downsampler_ {std::move(downsampler)}
 , samples_ {std::move(samples)}
 , fragment_size_ {fragment_size}
+, workers_ {}
 , debug_log_ {}
 {
     if (DEBUG_MODE) debug_log_ = logging::DebugLogger {};
 }
 
-std::vector<std::vector<SampleName>> batch_samples(std::vector<SampleName> samples)
-{
-    std::vector<std::vector<SampleName>> result {};
-    result.emplace_back(std::move(samples)); // TODO: find a better strategy for this
-    return result;
-}
-
 const ReadManager& ReadPipe::read_manager() const noexcept
 {
     return source_;
@@ -91,6 +88,18 @@ const std::vector<SampleName>& ReadPipe::samples() const noexcept
     return samples_;
 }
 
+void ReadPipe::set_max_fetch_threads(const unsigned n)
+{
+    // Only worth having workers if there are independent files to decode, all of which can stay open
+    const ReadManager& source {source_.get()};
+    const auto num_batches = static_cast<unsigned>(batch_samples().size());
+    if (std::min(n, num_batches) > 1 && source.num_files() <= source.max_open_files()) {
+        workers_ = std::make_unique<ThreadPool>(std::min(n, num_batches));
+    } else {
+        workers_.reset();
+    }
+}
+
 namespace {
 
 template <typename Map>
@@ -101,7 +110,7 @@ void sort_each(Map& reads)
     }
 }
 
-auto fetch_batch(const ReadManager& rm, const std::vector<SampleName>& samples, const GenomicRegion& region)
+auto fetch_sorted(const ReadManager& rm, const std::vector<SampleName>& samples, const GenomicRegion& region)
 {
     auto result = rm.fetch_reads(samples, region);
     sort_each(result);
@@ -182,93 +191,152 @@ struct IsMappingQualityZero
     bool operator()(const AlignedRead& read) const noexcept { return read.mapping_quality() == 0; }
 };
 
+template <typename Map>
+void move_insert(Map& src, Map& dst)
+{
+    for (auto& p : src) dst.emplace(p.first, std::move(p.second));
+}
+
+void merge(ReadPipe::Report&& src, ReadPipe::Report& dst)
+{
+    move_insert(src.raw_depths, dst.raw_depths);
+    move_insert(src.mapping_quality_zero_depths, dst.mapping_quality_zero_depths);
+    move_insert(src.downsample_report, dst.downsample_report);
+}
+
 } // namespace
 
-ReadMap ReadPipe::fetch_reads(const GenomicRegion& region, boost::optional<Report&> report) const
+std::vector<ReadPipe::SampleBatch> ReadPipe::batch_samples() const
+{
+    std::vector<SampleBatch> result {};
+    const ReadManager& source {source_.get()};
+    if (samples_.size() > 1 && source.num_files() > 1 && source.all_readers_have_one_sample()) {
+        // Each sample lives in its own file(s), so batches can be decoded independently
+        result.reserve(samples_.size());
+        for (const auto& sample : samples_) result.push_back({sample});
+    } else {
+        result.push_back(samples_);
+    }
+    return result;
+}
+
+ReadManager::SampleReadMap
+ReadPipe::fetch_batch(const SampleBatch& samples, const GenomicRegion& region, boost::optional<Report&> report,
+                      boost::optional<logging::DebugLogger>& debug_log) const
 {
     using namespace readpipe;
-    ReadMap result {samples_.size()};
-    for (const auto& sample : samples_) {
-        result.emplace(std::piecewise_construct, std::forward_as_tuple(sample), std::forward_as_tuple());
+    auto batch_reads = fetch_sorted(source_, samples, region);
+    if (debug_log) {
+        stream(*debug_log) << "Fetched " << count_reads(batch_reads) << " unfiltered reads from " << region;
     }
-    if (report) report->raw_depths.reserve(samples_.size());
-    for (const auto& batch : batch_samples(samples_)) {
-        auto batch_reads = fetch_batch(source_, batch, region);
-        if (debug_log_) {
-            stream(*debug_log_) << "Fetched " << count_reads(batch_reads) << " unfiltered reads from " << region;
+    if (report) {
+        for (const auto& p : batch_reads) {
+            report->raw_depths.emplace(p.first, make_coverage_tracker(p.second));
+            report->mapping_quality_zero_depths.emplace(p.first, make_coverage_tracker(p.second, IsMappingQualityZero {}));
+        }
+    }
+    transform_reads(batch_reads, prefilter_transformer_);
+    if (debug_log) {
+        SampleFilterCountMap<SampleName, decltype(filterer_)> filter_counts {};
+        filter_counts.reserve(samples.size());
+        for (const auto& sample : samples) {
+            filter_counts[sample].reserve(filterer_.num_filters());
         }
-        if (report) {
-            for (const auto& p : batch_reads) {
-                report->raw_depths.emplace(p.first, make_coverage_tracker(p.second));
-                report->mapping_quality_zero_depths.emplace(p.first, make_coverage_tracker(p.second, IsMappingQualityZero {}));
+        erase_filtered_reads(batch_reads, filter(batch_reads, filterer_, filter_counts));
+        if (filterer_.num_filters() > 0) {
+            for (const auto& p : filter_counts) {
+                stream(*debug_log) << "In sample " << p.first;
+                if (!p.second.empty()) {
+                    for (const auto& c : p.second) {
+                        stream(*debug_log) << c.second << " reads failed the " << c.first << " filter";
+                    }
+                } else {
+                    *debug_log << "No reads were filtered";
+                }
             }
         }
-        transform_reads(batch_reads, prefilter_transformer_);
-        if (debug_log_) {
+    } else {
+        erase_filtered_reads(batch_reads, filter(batch_reads, filterer_));
+    }
+    if (postfilter_transformer_) {
+        transform_reads(batch_reads, *postfilter_transformer_);
+    }
+    if (debug_log) {
+        stream(*debug_log) << "There are " << count_reads(batch_reads) << " reads in " << region
+                        << " after filtering";
+    }
+    if (fragment_size_) {
+        fragment(batch_reads, *fragment_size_, region);
+        if (debug_log) {
+            stream(*debug_log) << "Fragmented reads from " << region << " into " << count_reads(batch_reads) << " reads";
             SampleFilterCountMap<SampleName, decltype(filterer_)> filter_counts {};
-            filter_counts.reserve(samples_.size());
-            for (const auto& sample : samples_) {
+            filter_counts.reserve(samples.size());
+            for (const auto& sample : samples) {
                 filter_counts[sample].reserve(filterer_.num_filters());
             }
             erase_filtered_reads(batch_reads, filter(batch_reads, filterer_, filter_counts));
             if (filterer_.num_filters() > 0) {
                 for (const auto& p : filter_counts) {
-                    stream(*debug_log_) << "In sample " << p.first;
+                    stream(*debug_log) << "In sample " << p.first;
                     if (!p.second.empty()) {
                         for (const auto& c : p.second) {
-                            stream(*debug_log_) << c.second << " reads failed the " << c.first << " filter";
+                            stream(*debug_log) << c.second << " read fragments failed the " << c.first << " filter";
                         }
                     } else {
-                        *debug_log_ << "No reads were filtered";
+                        *debug_log << "No read fragments were filtered";
                     }
                 }
             }
         } else {
             erase_filtered_reads(batch_reads, filter(batch_reads, filterer_));
         }
-        if (postfilter_transformer_) {
-            transform_reads(batch_reads, *postfilter_transformer_);
+    }
+    return batch_reads;
+}
+
+ReadMap ReadPipe::fetch_reads(const GenomicRegion& region, boost::optional<Report&> report) const
+{
+    using namespace readpipe;
+    ReadMap result {samples_.size()};
+    for (const auto& sample : samples_) {
+        result.emplace(std::piecewise_construct, std::forward_as_tuple(sample), std::forward_as_tuple());
+    }
+    if (report) report->raw_depths.reserve(samples_.size());
+    const auto batches = batch_samples();
+    // Downsampling is the last pipeline stage so it runs in the same task as the fetch
+    const auto process_batch = [&] (const SampleBatch& batch, boost::optional<Report&> batch_report) {
+        // Loggers are not thread-safe, so each task logs through its own logger; records are
+        // serialised by the logging core
+        boost::optional<logging::DebugLogger> debug_log {};
+        if (debug_log_) debug_log = logging::DebugLogger {};
+        auto batch_reads = fetch_batch(batch, region, batch_report, debug_log);
+        auto reads = make_mappable_map(std::move(batch_reads));
+        if (downsampler_) {
+            auto downsample_reports = downsample(reads, *downsampler_);
+            if (debug_log) stream(*debug_log) << "Downsampling removed " << count_downsampled_reads(downsample_reports) << " reads from " << region;
+            if (batch_report) move_insert(downsample_reports, batch_report->downsample_report);
         }
-        if (debug_log_) {
-            stream(*debug_log_) << "There are " << count_reads(batch_reads) << " reads in " << region
-                            << " after filtering";
+        return reads;
+    };
+    if (workers_ && batches.size() > 1) {
+        std::vector<Report> batch_reports(report ? batches.size() : 0);
+        std::vector<std::future<ReadMap>> batch_futures {};
+        batch_futures.reserve(batches.size());
+        for (std::size_t i {0}; i < batches.size(); ++i) {
+            boost::optional<Report&> batch_report {};
+            if (report) batch_report = batch_reports[i];
+            batch_futures.push_back(workers_->push(process_batch, std::cref(batches[i]), batch_report));
         }
-        if (fragment_size_) {
-            fragment(batch_reads, *fragment_size_, region);
-            if (debug_log_) {
-                stream(*debug_log_) << "Fragmented reads from " << region << " into " << count_reads(batch_reads) << " reads";
-                SampleFilterCountMap<SampleName, decltype(filterer_)> filter_counts {};
-                filter_counts.reserve(samples_.size());
-                for (const auto& sample : samples_) {
-                    filter_counts[sample].reserve(filterer_.num_filters());
-                }
-                erase_filtered_reads(batch_reads, filter(batch_reads, filterer_, filter_counts));
-                if (filterer_.num_filters() > 0) {
-                    for (const auto& p : filter_counts) {
-                        stream(*debug_log_) << "In sample " << p.first;
-                        if (!p.second.empty()) {
-                            for (const auto& c : p.second) {
-                                stream(*debug_log_) << c.second << " read fragments failed the " << c.first << " filter";
-                            }
-                        } else {
-                            *debug_log_ << "No read fragments were filtered";
-                        }
-                    }
-                }
-            } else {
-                erase_filtered_reads(batch_reads, filter(batch_reads, filterer_));
-            }
+        // Every batch must finish before anything is rethrown as the tasks reference this frame
+        for (auto& f : batch_futures) f.wait();
+        // Collect in batch order so the result does not depend on scheduling
+        for (std::size_t i {0}; i < batches.size(); ++i) {
+            insert_each(batch_futures[i].get(), result);
+            if (report) merge(std::move(batch_reports[i]), *report);
         }
-        if (downsampler_) {
-            auto reads = make_mappable_map(std::move(batch_reads));
-            auto downsample_reports = downsample(reads, *downsampler_);
-            if (debug_log_) stream(*debug_log_) << "Downsampling removed " << count_downsampled_reads(downsample_reports) << " reads from " << region;
-            if (report) {
-                report->downsample_report = std::move(downsample_reports);
-            }
-            insert_each(std::move(reads), result);
-        } else {
-            insert_each(std::move(batch_reads), result);
+    } else {
+        for (const auto& batch : batches) {
+            insert_each(process_batch(batch, report), result);
         }
     }
     shrink_to_fit(result); // TODO: should we make this conditional on extra capacity?
@@ -8,6 +8,7 @@
 #include <unordered_map>
 #include <cstddef>
 #include <functional>
+#include <memory>
 
 #include <boost/optional.hpp>
 
@@ -15,6 +16,7 @@
 #include "basics/genomic_region.hpp"
 #include "io/read/read_manager.hpp"
 #include "utils/coverage_tracker.hpp"
+#include "utils/thread_pool.hpp"
 #include "logging/logging.hpp"
 #include "filtering/read_filterer.hpp"
 #include "transformers/read_transformer.hpp"
@@ -31,6 +33,11 @@ namespace octopus {
  decrease average memory consumption (and also increase runtime performance) by minimising the
  number of 'bad' reads in memory. If we are really short on memory we could even compress filtered
  read batches while we process other batches.
+ 
+ When samples are stored in separate files, each sample is its own batch and batches may be fetched
+ and processed concurrently on a bounded pool of workers shared by all callers of the pipe. This is
+ only done when every file can be kept open, as opening readers requires an exclusive lock on the
+ ReadManager, which would serialise the batches.
  */
 class ReadPipe
 {
@@ -85,12 +92,16 @@ public:
     unsigned num_samples() const noexcept;
     const std::vector<SampleName>& samples() const noexcept;
     
+    void set_max_fetch_threads(unsigned n);
+    
     ReadMap fetch_reads(const GenomicRegion& region, boost::optional<Report&> report = boost::none) const;
     ReadMap fetch_reads(const std::vector<GenomicRegion>& regions, boost::optional<Report&> report = boost::none) const;
     
     //Report get_report() const;
     
 private:
+    using SampleBatch = std::vector<SampleName>;
+    
     std::reference_wrapper<const ReadManager> source_;
     ReadTransformer prefilter_transformer_;
     ReadFilterer filterer_;
@@ -98,7 +109,12 @@ private:
     boost::optional<Downsampler> downsampler_;
     std::vector<SampleName> samples_;
     boost::optional<GenomicRegion::Size> fragment_size_;
+    std::unique_ptr<ThreadPool> workers_;
     mutable boost::optional<logging::DebugLogger> debug_log_;
+    
+    std::vector<SampleBatch> batch_samples() const;
+    ReadManager::SampleReadMap fetch_batch(const SampleBatch& samples, const GenomicRegion& region, boost::optional<Report&> report,
+                                           boost::optional<logging::DebugLogger>& debug_log) const;
 };
 
 } // namespace octopus
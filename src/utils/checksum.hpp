@@ -0,0 +1,50 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef checksum_hpp
+#define checksum_hpp
+
+#include <string>
+#include <array>
+#include <cstdint>
+#include <cstddef>
+
+namespace octopus { namespace utils {
+
+// 64-bit FNV-1a; std::hash is not guaranteed to be stable between builds, which would invalidate
+// anything persisted with it
+class Checksum
+{
+public:
+    void update(const char* data, std::size_t n) noexcept
+    {
+        constexpr std::uint64_t prime {1099511628211ull};
+        for (std::size_t i {0}; i < n; ++i) {
+            hash_ ^= static_cast<unsigned char>(data[i]);
+            hash_ *= prime;
+        }
+    }
+    void update(const std::string& str) noexcept
+    {
+        update(str.data(), str.size());
+        update(std::uint64_t {str.size()}); // delimit
+    }
+    void update(std::uint64_t value) noexcept
+    {
+        std::array<char, sizeof(value)> bytes {};
+        for (auto& byte : bytes) {
+            byte = static_cast<char>(value & 0xFF);
+            value >>= 8;
+        }
+        update(bytes.data(), bytes.size());
+    }
+    std::uint64_t value() const noexcept { return hash_; }
+
+private:
+    std::uint64_t hash_ {14695981039346656037ull};
+};
+
+} // namespace utils
+} // namespace octopus
+
+#endif
@@ -10,6 +10,9 @@
 #include <utility>
 #include <cassert>
 #include <iostream>
+#include <iomanip>
+#include <limits>
+#include <string>
 
 #include "mappable_algorithms.hpp"
 #include "maths.hpp"
@@ -18,34 +21,49 @@
 #include "read_stats.hpp"
 #include "coverage_tracker.hpp"
 #include "sequence_utils.hpp"
+#include "thread_pool.hpp"
+#include "parallel_transform.hpp"
+#include "checksum.hpp"
 
 namespace octopus {
 
 namespace {
 
-auto draw_sample(const InputRegionMap& regions, std::discrete_distribution<>& contig_sampling_distribution)
+// Each sample gets its own generator so profiles do not depend on the order (or thread) samples are drawn on.
+using SamplingGenerator = std::mt19937;
+
+// Seeded by the sample name so samples sharing read files do not all draw the same regions
+SamplingGenerator::result_type make_sampling_seed(const SampleName& sample)
+{
+    utils::Checksum checksum {};
+    checksum.update(sample);
+    return static_cast<SamplingGenerator::result_type>(checksum.value());
+}
+
+auto draw_sample(const InputRegionMap& regions, std::discrete_distribution<>& contig_sampling_distribution,
+                 SamplingGenerator& generator)
 {
-    static std::mt19937 generator {42};
     return std::next(std::cbegin(regions), contig_sampling_distribution(generator));
 }
 
-auto choose_sample_window(const GenomicRegion& target)
+auto choose_sample_window(const GenomicRegion& target, SamplingGenerator& generator)
 {
-    static std::mt19937 generator {42};
     std::uniform_int_distribution<GenomicRegion::Position> dist {target.begin(), target.end()};
     return GenomicRegion {target.contig_name(), dist(generator), target.end()};
 }
 
-auto choose_sample_region(const SampleName& sample, const InputRegionMap::mapped_type& regions)
+auto choose_sample_region(const SampleName& sample, const InputRegionMap::mapped_type& regions,
+                          SamplingGenerator& generator)
 {
     assert(!regions.empty());
-    return choose_sample_window(*random_select(std::cbegin(regions), std::cend(regions)));
+    return choose_sample_window(*random_select(std::cbegin(regions), std::cend(regions), generator), generator);
 }
 
 auto choose_sample_region(const SampleName& sample, const InputRegionMap& regions,
-                          std::discrete_distribution<>& contig_sampling_distribution)
+                          std::discrete_distribution<>& contig_sampling_distribution,
+                          SamplingGenerator& generator)
 {
-    return choose_sample_region(sample, draw_sample(regions, contig_sampling_distribution)->second);
+    return choose_sample_region(sample, draw_sample(regions, contig_sampling_distribution, generator)->second, generator);
 }
 
 struct SamplingSummary
@@ -59,17 +77,18 @@ choose_next_sample_region(const SampleName& sample,
                           const InputRegionMap& regions,
                           const ReadSetProfileConfig& config,
                           std::discrete_distribution<>& contig_sampling_distribution,
-                          SamplingSummary& sampling_summary)
+                          SamplingSummary& sampling_summary,
+                          SamplingGenerator& generator)
 {
     if (!regions.empty() && sampling_summary.num_samples < std::max(config.max_draws_per_sample, regions.size() * config.min_draws_per_contig)) {
         for (const auto& p : regions) {
             if (!p.second.empty() && sampling_summary.sampled_regions[p.first].size() < config.min_draws_per_contig) {
-                auto sample_region = choose_sample_region(sample, p.second);
+                auto sample_region = choose_sample_region(sample, p.second, generator);
                 sampling_summary.sampled_regions[sample_region.contig_name()].insert(sample_region);
                 return sample_region;
             }
         }
-        return choose_sample_region(sample, regions, contig_sampling_distribution);
+        return choose_sample_region(sample, regions, contig_sampling_distribution, generator);
     } else {
         return boost::none;
     }
@@ -179,6 +198,126 @@ void erase_non_dna_or_rna_positions(std::vector<DepthType>& depths,
     depths.erase(std::remove_if(std::begin(depths), std::end(depths), not_dna_or_rna), std::end(depths));
 }
 
+template <typename DepthType>
+struct SampleProfileData
+{
+    using ContigDepthMap = std::unordered_map<GenomicRegion::ContigName, std::vector<DepthType>>;
+    ReadSetProfile::GenomeContigDepthStatsPair depth_stats;
+    ContigDepthMap contig_depths;
+    std::deque<MemoryFootprint> memory_footprints, fragmented_memory_footprints;
+    std::deque<unsigned> read_lengths;
+    std::deque<AlignedRead::MappingQuality> mapping_qualities;
+};
+
+template <typename DepthType>
+SampleProfileData<DepthType>
+profile_sample(const SampleName& sample,
+               const ReferenceGenome& reference,
+               const InputRegionMap& regions,
+               const ReadManager& source,
+               const ReadSetProfileConfig& config)
+{
+    SampleProfileData<DepthType> result {};
+    SamplingGenerator generator {make_sampling_seed(sample)};
+    std::vector<DepthType> sample_depths {};
+    std::unordered_map<GenomicRegion::ContigName, std::vector<DepthType>> sample_contig_depths {};
+    SamplingSummary sampling_summary {};
+    auto remaining_sampling_regions = regions;
+    auto sample_contig_sampling_distribution = make_contig_sampling_distribution(regions);
+    auto& read_lengths = result.read_lengths;
+    while (true) {
+        const auto target_sampling_region = choose_next_sample_region(sample, remaining_sampling_regions, config, sample_contig_sampling_distribution,
+                                                                      sampling_summary, generator);
+        if (!target_sampling_region) break;
+        CoverageTracker<GenomicRegion, DepthType> depth_tracker {true};
+        auto remaining_reads = static_cast<int>(config.target_reads_per_draw);
+        boost::optional<GenomicRegion> critical_region {};
+        const auto read_visitor = [&] (const SampleName& sample, AlignedRead read) {
+            read_lengths.push_back(sequence_size(read));
+            result.mapping_qualities.push_back(read.mapping_quality());
+            result.memory_footprints.push_back(footprint(read));
+            if (config.fragment_size) {
+                result.fragmented_memory_footprints.push_back(fragmented_footprint(read, *config.fragment_size));
+            }
+            depth_tracker.add(read);
+            if (!critical_region) {
+                critical_region = mapped_region(read);
+                if (config.min_read_lengths > 1) {
+                    critical_region = expand_rhs(*critical_region, (config.min_read_lengths - 1) * size(*critical_region));
+                }
+            }
+            if (remaining_reads > 0) --remaining_reads;
+            return remaining_reads > 0 || overlaps(read, *critical_region);
+        };
+        source.iterate(sample, *target_sampling_region, read_visitor);
+        auto sampled_region = *target_sampling_region;
+        if (depth_tracker.any()) {
+            auto sampled_reads_region = *depth_tracker.encompassing_region();
+            assert(!read_lengths.empty());
+            if (remaining_reads > 0) {
+                sampled_region = *target_sampling_region;
+            } else {
+                assert(!is_before(sampled_reads_region, *target_sampling_region));
+                sampled_region = closed_region(*target_sampling_region, sampled_reads_region);
+                if (size(sampled_region) > read_lengths.back()) {
+                    // Ignore the last half read length bases to avoid adding positions undersampled because
+                    // the sampled read limit was hit.
+                    const auto read_length = static_cast<GenomicRegion::Distance>(read_lengths.back());
+                    sampled_region = expand_rhs(sampled_region, -read_length / 2);
+                } else {
+                    sampled_region = expand_rhs(head_region(*target_sampling_region), read_lengths.back() / 2);
+                }
+            }
+        }
+        auto read_depths = depth_tracker.get(sampled_region);
+        erase_non_dna_or_rna_positions(read_depths, sampled_region, reference);
+        utils::append(read_depths, sample_contig_depths[sampled_region.contig_name()]);
+        utils::append(std::move(read_depths), sample_depths);
+        ++sampling_summary.num_samples;
+        auto removal_region = sampled_region;
+        if (depth_tracker.any()) {
+            removal_region = encompassing_region(removal_region, *depth_tracker.encompassing_region());
+        }
+        cut(removal_region, remaining_sampling_regions.at(sampled_region.contig_name()));
+        if (remaining_sampling_regions.at(sampled_region.contig_name()).empty()) {
+            remaining_sampling_regions.erase(sampled_region.contig_name());
+            sample_contig_sampling_distribution = make_contig_sampling_distribution(remaining_sampling_regions);
+        }
+    }
+    if (!sample_depths.empty()) {
+        std::sort(std::begin(sample_depths), std::end(sample_depths)); // sorting means no copying from stats calculations
+        fill_depth_stats(sample_depths, result.depth_stats.genome);
+        sample_depths.clear();
+        sample_depths.shrink_to_fit();
+        for (auto& p : sample_contig_depths) {
+            std::sort(std::begin(p.second), std::end(p.second)); // sorting means no copying from stats calculations
+            result.depth_stats.contig.emplace(p.first, make_depth_stats(p.second));
+        }
+        result.contig_depths = std::move(sample_contig_depths);
+    }
+    return result;
+}
+
+template <typename DepthType>
+std::vector<SampleProfileData<DepthType>>
+profile_samples(const std::vector<SampleName>& samples,
+                const ReferenceGenome& reference,
+                const InputRegionMap& regions,
+                const ReadManager& source,
+                const ReadSetProfileConfig& config)
+{
+    std::vector<SampleProfileData<DepthType>> result {};
+    result.reserve(samples.size());
+    const auto profile = [&] (const SampleName& sample) { return profile_sample<DepthType>(sample, reference, regions, source, config); };
+    if (config.max_threads > 1 && samples.size() > 1) {
+        ThreadPool workers {std::min(static_cast<std::size_t>(config.max_threads), samples.size())};
+        transform(std::cbegin(samples), std::cend(samples), std::back_inserter(result), profile, workers);
+    } else {
+        std::transform(std::cbegin(samples), std::cend(samples), std::back_inserter(result), profile);
+    }
+    return result;
+}
+
 template <typename DepthType>
 boost::optional<ReadSetProfile>
 profile_reads_helper(const std::vector<SampleName>& samples,
@@ -192,87 +331,23 @@ profile_reads_helper(const std::vector<SampleName>& samples,
     std::unordered_map<GenomicRegion::ContigName, std::vector<DepthType>> contig_depths {};
     std::deque<unsigned> read_lengths {};
     std::deque<AlignedRead::MappingQuality> mapping_qualities {};
-    const auto contig_sampling_distribution = make_contig_sampling_distribution(regions);
-    for (const auto& sample : samples) {
-        std::vector<DepthType> sample_depths {};
-        std::unordered_map<GenomicRegion::ContigName, std::vector<DepthType>> sample_contig_depths {};
-        SamplingSummary sampling_summary {};
-        auto remaining_sampling_regions = regions;
-        auto sample_contig_sampling_distribution = contig_sampling_distribution;
-        while (true) {
-            const auto target_sampling_region = choose_next_sample_region(sample, remaining_sampling_regions, config, sample_contig_sampling_distribution, sampling_summary);
-            if (!target_sampling_region) break;
-            CoverageTracker<GenomicRegion, DepthType> depth_tracker {true};
-            auto remaining_reads = static_cast<int>(config.target_reads_per_draw);
-            boost::optional<GenomicRegion> critical_region {};
-            const auto read_visitor = [&] (const SampleName& sample, AlignedRead read) {
-                read_lengths.push_back(sequence_size(read));
-                mapping_qualities.push_back(read.mapping_quality());
-                memory_footprints.push_back(footprint(read));
-                if (config.fragment_size) {
-                    fragmented_memory_footprints.push_back(fragmented_footprint(read, *config.fragment_size));
-                }
-                depth_tracker.add(read);
-                if (!critical_region) {
-                    critical_region = mapped_region(read);
-                    if (config.min_read_lengths > 1) {
-                        critical_region = expand_rhs(*critical_region, (config.min_read_lengths - 1) * size(*critical_region));
-                    }
-                }
-                if (remaining_reads > 0) --remaining_reads;
-                return remaining_reads > 0 || overlaps(read, *critical_region);
-            };
-            source.iterate(sample, *target_sampling_region, read_visitor);
-            auto sampled_region = *target_sampling_region;
-            if (depth_tracker.any()) {
-                auto sampled_reads_region = *depth_tracker.encompassing_region();
-                assert(!read_lengths.empty());
-                if (remaining_reads > 0) {
-                    sampled_region = *target_sampling_region;
-                } else {
-                    assert(!is_before(sampled_reads_region, *target_sampling_region));
-                    sampled_region = closed_region(*target_sampling_region, sampled_reads_region);
-                    if (size(sampled_region) > read_lengths.back()) {
-                        // Ignore the last half read length bases to avoid adding positions undersampled because
-                        // the sampled read limit was hit.
-                        const auto read_length = static_cast<GenomicRegion::Distance>(read_lengths.back());
-                        sampled_region = expand_rhs(sampled_region, -read_length / 2);
-                    } else {
-                        sampled_region = expand_rhs(head_region(*target_sampling_region), read_lengths.back() / 2);
-                    }
-                }
-            }
-            auto read_depths = depth_tracker.get(sampled_region);
-            erase_non_dna_or_rna_positions(read_depths, sampled_region, reference);
-            utils::append(read_depths, sample_contig_depths[sampled_region.contig_name()]);
-            utils::append(std::move(read_depths), sample_depths);
-            ++sampling_summary.num_samples;
-            auto removal_region = sampled_region;
-            if (depth_tracker.any()) {
-                removal_region = encompassing_region(removal_region, *depth_tracker.encompassing_region());
-            }
-            cut(removal_region, remaining_sampling_regions.at(sampled_region.contig_name()));
-            if (remaining_sampling_regions.at(sampled_region.contig_name()).empty()) {
-                remaining_sampling_regions.erase(sampled_region.contig_name());
-                sample_contig_sampling_distribution = make_contig_sampling_distribution(remaining_sampling_regions);
-            }
-        }
-        ReadSetProfile::GenomeContigDepthStatsPair sample_depth_stats {};
-        if (!sample_depths.empty()) {
-            std::sort(std::begin(sample_depths), std::end(sample_depths)); // sorting means no copying from stats calculations
-            fill_depth_stats(sample_depths, sample_depth_stats.genome);
-            sample_depths.clear();
-            sample_depths.shrink_to_fit();
-            for (auto& p : sample_contig_depths) {
-                std::sort(std::begin(p.second), std::end(p.second)); // sorting means no copying from stats calculations
-                sample_depth_stats.contig.emplace(p.first, make_depth_stats(p.second));
-                utils::append(std::move(p.second), contig_depths[p.first]);
-                p.second.clear();
-                p.second.shrink_to_fit();
-            }
+    auto sample_profiles = profile_samples<DepthType>(samples, reference, regions, source, config);
+    // Merge in sample order so the combined profile is independent of scheduling
+    for (std::size_t s {0}; s < samples.size(); ++s) {
+        auto& sample_profile = sample_profiles[s];
+        utils::append(std::move(sample_profile.memory_footprints), memory_footprints);
+        utils::append(std::move(sample_profile.fragmented_memory_footprints), fragmented_memory_footprints);
+        utils::append(std::move(sample_profile.read_lengths), read_lengths);
+        utils::append(std::move(sample_profile.mapping_qualities), mapping_qualities);
+        for (auto& p : sample_profile.contig_depths) {
+            utils::append(std::move(p.second), contig_depths[p.first]);
+            p.second.clear();
+            p.second.shrink_to_fit();
         }
-        result.depth_stats.sample.emplace(sample, std::move(sample_depth_stats));
+        result.depth_stats.sample.emplace(samples[s], std::move(sample_profile.depth_stats));
     }
+    sample_profiles.clear();
+    sample_profiles.shrink_to_fit();
     if (memory_footprints.empty()) return boost::none;
     fill_summary_stats(memory_footprints, result.memory_stats);
     if (config.fragment_size) {
@@ -374,4 +449,136 @@ std::ostream& operator<<(std::ostream& os, const ReadSetProfile& profile)
     return os;
 }
 
+namespace {
+
+static const std::string profile_format_tag {"octopus-read-profile"};
+static constexpr unsigned profile_format_version {1};
+
+template <typename T>
+auto to_io_value(const T& value) noexcept { return +value; } // promotes small integers so they are not written as chars
+
+std::size_t to_io_value(const MemoryFootprint& value) noexcept { return value.bytes(); }
+
+template <typename T>
+void from_io_value(std::istream& is, T& result)
+{
+    decltype(to_io_value(result)) value {};
+    is >> value;
+    result = static_cast<T>(value);
+}
+
+void from_io_value(std::istream& is, MemoryFootprint& result)
+{
+    std::size_t bytes {};
+    is >> bytes;
+    result = MemoryFootprint {bytes};
+}
+
+template <typename T>
+void write(const ReadSetProfile::SummaryStats<T>& stats, std::ostream& os)
+{
+    os << to_io_value(stats.min) << ' ' << to_io_value(stats.max) << ' ' << to_io_value(stats.mean) << ' '
+       << to_io_value(stats.median) << ' ' << to_io_value(stats.stdev) << '\n';
+}
+
+template <typename T>
+void read(std::istream& is, ReadSetProfile::SummaryStats<T>& stats)
+{
+    from_io_value(is, stats.min);
+    from_io_value(is, stats.max);
+    from_io_value(is, stats.mean);
+    from_io_value(is, stats.median);
+    from_io_value(is, stats.stdev);
+}
+
+void write(const ReadSetProfile::DepthStats& stats, std::ostream& os)
+{
+    os << stats.distribution.size();
+    for (auto frequency : stats.distribution) os << ' ' << frequency;
+    os << '\n';
+    write(stats.all, os);
+    write(stats.positive, os);
+}
+
+void read(std::istream& is, ReadSetProfile::DepthStats& stats)
+{
+    std::size_t num_depths {};
+    is >> num_depths;
+    if (!is) return;
+    stats.distribution.resize(num_depths);
+    for (auto& frequency : stats.distribution) is >> frequency;
+    read(is, stats.all);
+    read(is, stats.positive);
+}
+
+void write(const ReadSetProfile::GenomeContigDepthStatsPair& stats, std::ostream& os)
+{
+    write(stats.genome, os);
+    os << stats.contig.size() << '\n';
+    for (const auto& p : stats.contig) {
+        os << std::quoted(p.first) << '\n';
+        write(p.second, os);
+    }
+}
+
+void read(std::istream& is, ReadSetProfile::GenomeContigDepthStatsPair& stats)
+{
+    read(is, stats.genome);
+    std::size_t num_contigs {};
+    is >> num_contigs;
+    for (std::size_t i {0}; i < num_contigs && is; ++i) {
+        GenomicRegion::ContigName contig {};
+        is >> std::quoted(contig);
+        read(is, stats.contig[contig]);
+    }
+}
+
+} // namespace
+
+void write(const ReadSetProfile& profile, std::ostream& os)
+{
+    const auto old_precision = os.precision(std::numeric_limits<double>::max_digits10);
+    os << profile_format_tag << ' ' << profile_format_version << '\n';
+    write(profile.memory_stats, os);
+    os << static_cast<bool>(profile.fragmented_memory_stats) << '\n';
+    if (profile.fragmented_memory_stats) write(*profile.fragmented_memory_stats, os);
+    write(profile.length_stats, os);
+    write(profile.mapping_quality_stats, os);
+    write(profile.depth_stats.combined, os);
+    os << profile.depth_stats.sample.size() << '\n';
+    for (const auto& p : profile.depth_stats.sample) {
+        os << std::quoted(p.first) << '\n';
+        write(p.second, os);
+    }
+    os.precision(old_precision);
+}
+
+boost::optional<ReadSetProfile> read_profile(std::istream& is)
+{
+    std::string tag {};
+    unsigned version {};
+    is >> tag >> version;
+    if (!is || tag != profile_format_tag || version != profile_format_version) return boost::none;
+    ReadSetProfile result {};
+    read(is, result.memory_stats);
+    bool has_fragmented_memory_stats {};
+    is >> has_fragmented_memory_stats;
+    if (has_fragmented_memory_stats) {
+        result.fragmented_memory_stats = ReadSetProfile::ReadMemoryStats {};
+        read(is, *result.fragmented_memory_stats);
+    }
+    read(is, result.length_stats);
+    read(is, result.mapping_quality_stats);
+    read(is, result.depth_stats.combined);
+    std::size_t num_samples {};
+    is >> num_samples;
+    for (std::size_t i {0}; i < num_samples && is; ++i) {
+        SampleName sample {};
+        is >> std::quoted(sample);
+        read(is, result.depth_stats.sample[sample]);
+    }
+    if (!is) return boost::none;
+    return result;
+}
+
 } // namespace octopus
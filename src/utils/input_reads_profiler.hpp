@@ -24,6 +24,7 @@ struct ReadSetProfileConfig
     std::size_t min_draws_per_contig = 10;
     boost::optional<AlignedRead::NucleotideSequence::size_type> fragment_size = boost::none;
     unsigned min_read_lengths = 20;
+    unsigned max_threads = 1; // samples are profiled concurrently if > 1
 };
 
 struct ReadSetProfile
@@ -72,6 +73,10 @@ profile_reads(const std::vector<SampleName>& samples,
 
 std::ostream& operator<<(std::ostream& os, const ReadSetProfile& profile);
 
+// Lossless serialisation, used for caching profiles between runs
+void write(const ReadSetProfile& profile, std::ostream& os);
+boost::optional<ReadSetProfile> read_profile(std::istream& is);
+
 } // namespace octopus
 
 #endif
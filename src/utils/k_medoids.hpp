@@ -14,6 +14,11 @@
 #include <utility>
 #include <cassert>
 
+#include <boost/optional.hpp>
+
+#include "thread_pool.hpp"
+#include "parallel_transform.hpp"
+
 namespace octopus {
 
 struct KMediodsParameters
@@ -22,6 +27,16 @@ struct KMediodsParameters
     std::size_t max_iterations = 100;
 };
 
+// For data too large for a full distance matrix. Distances are computed as needed, medoids are seeded
+// k-means++ style, and each cluster's medoid is chosen from a sample of its points.
+struct LargeKMediodsParameters
+{
+    std::size_t num_restarts = 5; // the first is seeded farthest-first, the rest k-means++ style
+    std::size_t max_medoid_candidates = 50;
+    std::size_t max_iterations = 100;
+    boost::optional<ThreadPool&> workers = boost::none; // restarts run on workers if given, otherwise sequentially
+};
+
 using Cluster = std::vector<std::size_t>;
 using ClusterVector = std::vector<Cluster>;
 using MediodVector = std::vector<std::size_t>;
@@ -302,6 +317,153 @@ void print(const DistanceMatrix<D>& distances)
     }
 }
 
+// Seeds medoids with probability proportional to squared distance from the nearest medoid chosen so far
+template <typename RandomIterator, typename BinaryFunction>
+auto initialise_mediods_plus_plus(const RandomIterator first_data_itr, const std::size_t N, const std::size_t k,
+                                  const BinaryFunction& distance, std::mt19937& generator)
+{
+    MediodVector result {};
+    result.reserve(k);
+    std::uniform_int_distribution<std::size_t> point_dist {0, N - 1};
+    result.push_back(point_dist(generator));
+    std::vector<double> min_distances(N), weights(N);
+    for (std::size_t i {0}; i < N; ++i) {
+        min_distances[i] = distance(first_data_itr[i], first_data_itr[result.front()]);
+    }
+    while (result.size() < k) {
+        std::transform(std::cbegin(min_distances), std::cend(min_distances), std::begin(weights), [] (auto d) { return d * d; });
+        const auto total = std::accumulate(std::cbegin(weights), std::cend(weights), 0.0);
+        std::size_t medoid;
+        if (total > 0) {
+            std::discrete_distribution<std::size_t> medoid_dist {std::cbegin(weights), std::cend(weights)};
+            medoid = medoid_dist(generator);
+        } else {
+            // All points coincide with a medoid, so any point not already chosen will do
+            do { medoid = point_dist(generator); } while (std::find(std::cbegin(result), std::cend(result), medoid) != std::cend(result));
+        }
+        result.push_back(medoid);
+        for (std::size_t i {0}; i < N; ++i) {
+            min_distances[i] = std::min(min_distances[i], static_cast<double>(distance(first_data_itr[i], first_data_itr[medoid])));
+        }
+        min_distances[medoid] = 0;
+    }
+    return result;
+}
+
+// Farthest-first traversal, as initialise_mediods_max_distance but starting from an approximately farthest
+// pair found by two linear sweeps rather than from the exact farthest pair
+template <typename RandomIterator, typename BinaryFunction>
+auto initialise_mediods_max_min(const RandomIterator first_data_itr, const std::size_t N, const std::size_t k,
+                                const BinaryFunction& distance)
+{
+    std::vector<double> min_distances(N);
+    const auto update_min_distances = [&] (const std::size_t medoid, const bool first) {
+        for (std::size_t i {0}; i < N; ++i) {
+            const auto d = static_cast<double>(distance(first_data_itr[i], first_data_itr[medoid]));
+            min_distances[i] = first ? d : std::min(min_distances[i], d);
+        }
+        min_distances[medoid] = 0;
+        return static_cast<std::size_t>(std::distance(std::cbegin(min_distances), std::max_element(std::cbegin(min_distances), std::cend(min_distances))));
+    };
+    MediodVector result {};
+    result.reserve(k);
+    result.push_back(update_min_distances(0, true));
+    auto farthest = update_min_distances(result.front(), true);
+    while (result.size() < k) {
+        result.push_back(farthest);
+        farthest = update_min_distances(farthest, false);
+    }
+    return result;
+}
+
+template <typename RandomIterator, typename BinaryFunction>
+auto assign_to_medoids(const RandomIterator first_data_itr, const std::size_t N,
+                       const MediodVector& medoids, ClusterVector& clusters,
+                       const BinaryFunction& distance)
+{
+    using DistanceResultType = decltype(distance(*first_data_itr, *first_data_itr));
+    clusters.assign(medoids.size(), Cluster {});
+    DistanceResultType result {};
+    for (std::size_t point_idx {0}; point_idx < N; ++point_idx) {
+        const auto& point = first_data_itr[point_idx];
+        std::size_t best_cluster_idx {0};
+        DistanceResultType min_distance {};
+        for (std::size_t cluster_idx {0}; cluster_idx < medoids.size(); ++cluster_idx) {
+            if (medoids[cluster_idx] == point_idx) {
+                best_cluster_idx = cluster_idx;
+                min_distance = DistanceResultType {};
+                break;
+            }
+            auto d = distance(point, first_data_itr[medoids[cluster_idx]]);
+            if (cluster_idx == 0 || d < min_distance) {
+                best_cluster_idx = cluster_idx;
+                min_distance = std::move(d);
+            }
+        }
+        clusters[best_cluster_idx].push_back(point_idx);
+        result += min_distance;
+    }
+    return result;
+}
+
+// Replaces each medoid with the point closest to the rest of its cluster, out of a sample of the cluster
+template <typename RandomIterator, typename BinaryFunction>
+bool update_mediods(MediodVector& medoids, const ClusterVector& clusters,
+                    const RandomIterator first_data_itr, const BinaryFunction& distance,
+                    const std::size_t max_candidates, std::mt19937& generator)
+{
+    using DistanceResultType = decltype(distance(*first_data_itr, *first_data_itr));
+    const auto sum_distances = [&] (const Cluster& cluster, const std::size_t medoid) {
+        DistanceResultType result {};
+        for (const auto point : cluster) {
+            if (point != medoid) result += distance(first_data_itr[point], first_data_itr[medoid]);
+        }
+        return result;
+    };
+    bool medoids_changed {false};
+    Cluster candidates {};
+    for (std::size_t cluster_idx {0}; cluster_idx < clusters.size(); ++cluster_idx) {
+        const auto& cluster = clusters[cluster_idx];
+        candidates = cluster;
+        if (candidates.size() > max_candidates) {
+            for (std::size_t i {0}; i < max_candidates; ++i) {
+                std::uniform_int_distribution<std::size_t> dist {i, candidates.size() - 1};
+                std::swap(candidates[i], candidates[dist(generator)]);
+            }
+            candidates.resize(max_candidates);
+        }
+        auto min_distance_sum = sum_distances(cluster, medoids[cluster_idx]);
+        for (const auto point : candidates) {
+            if (point != medoids[cluster_idx]) {
+                auto distance_sum = sum_distances(cluster, point);
+                if (distance_sum < min_distance_sum) {
+                    medoids[cluster_idx] = point;
+                    min_distance_sum = std::move(distance_sum);
+                    medoids_changed = true;
+                }
+            }
+        }
+    }
+    return medoids_changed;
+}
+
+template <typename RandomIterator, typename BinaryFunction>
+auto large_k_medoids_run(const RandomIterator first_data_itr, const std::size_t N, const std::size_t k,
+                         const BinaryFunction& distance, const LargeKMediodsParameters& params,
+                         const std::size_t seed)
+{
+    std::mt19937 generator {seed};
+    auto medoids = seed == 0 ? initialise_mediods_max_min(first_data_itr, N, k, distance)
+                             : initialise_mediods_plus_plus(first_data_itr, N, k, distance, generator);
+    ClusterVector clusters {};
+    auto fit = assign_to_medoids(first_data_itr, N, medoids, clusters, distance);
+    for (std::size_t n {0}; n < params.max_iterations; ++n) {
+        if (!update_mediods(medoids, clusters, first_data_itr, distance, params.max_medoid_candidates, generator)) break;
+        fit = assign_to_medoids(first_data_itr, N, medoids, clusters, distance);
+    }
+    return std::make_tuple(std::move(medoids), std::move(clusters), std::move(fit));
+}
+
 } // namespace detail
 
 template <typename ForwardIterator, typename BinaryFunction>
@@ -391,6 +553,48 @@ k_medoids(const Range& values, const std::size_t k,
     return k_medoids(std::cbegin(values), std::cend(values), k, clusters, std::move(distance), params);
 }
 
+template <typename RandomIterator, typename BinaryFunction>
+auto
+large_k_medoids(const RandomIterator first_data_itr, const RandomIterator last_data_itr,
+                const std::size_t k,
+                ClusterVector& clusters,
+                BinaryFunction distance,
+                const LargeKMediodsParameters params = LargeKMediodsParameters {})
+{
+    const auto N = static_cast<std::size_t>(std::distance(first_data_itr, last_data_itr));
+    if (N <= k || params.num_restarts == 0) {
+        return k_medoids(first_data_itr, last_data_itr, k, clusters, std::move(distance));
+    }
+    using RunResult = decltype(detail::large_k_medoids_run(first_data_itr, N, k, distance, params, 0));
+    std::vector<RunResult> runs(params.num_restarts);
+    if (params.workers && params.workers->size() > 1) {
+        // Runs inline if called from one of the workers
+        parallel_for_each_partition(params.num_restarts, 1, [&] (std::size_t restart, const std::size_t last) {
+            for (; restart < last; ++restart) {
+                runs[restart] = detail::large_k_medoids_run(first_data_itr, N, k, distance, params, restart);
+            }
+        }, *params.workers);
+    } else {
+        for (std::size_t restart {0}; restart < params.num_restarts; ++restart) {
+            runs[restart] = detail::large_k_medoids_run(first_data_itr, N, k, distance, params, restart);
+        }
+    }
+    const auto best_run = std::min_element(std::begin(runs), std::end(runs),
+                                           [] (const auto& lhs, const auto& rhs) { return std::get<2>(lhs) < std::get<2>(rhs); });
+    clusters = std::move(std::get<1>(*best_run));
+    return std::make_pair(std::move(std::get<0>(*best_run)), std::move(std::get<2>(*best_run)));
+}
+
+template <typename Range, typename BinaryFunction>
+auto
+large_k_medoids(const Range& values, const std::size_t k,
+                ClusterVector& clusters,
+                BinaryFunction distance,
+                const LargeKMediodsParameters params = LargeKMediodsParameters {})
+{
+    return large_k_medoids(std::cbegin(values), std::cend(values), k, clusters, std::move(distance), params);
+}
+
 } // namespace octopus
 
 #endif
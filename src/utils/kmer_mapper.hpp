@@ -13,6 +13,7 @@
 #include <algorithm>
 #include <numeric>
 #include <limits>
+#include <functional>
 
 namespace octopus {
 
@@ -40,61 +41,82 @@ constexpr auto perfect_hash(const char base) noexcept
 
 using KmerHashType = std::uint_fast32_t;
 
+// The hash of a k-mer is its 2-bit base encoding with the first base least significant
 template <unsigned char K, typename InputIt>
 constexpr auto perfect_kmer_hash(InputIt first)
 {
-    unsigned k {1};
-    return std::accumulate(first, std::next(first, K), KmerHashType {0},
-                           [&k] (const unsigned curr, const char base) {
-                               const auto result = curr + k * perfect_hash(base);
-                               k *= 4;
-                               return result;
-                           });
+    KmerHashType result {0};
+    for (unsigned i {0}; i < K; ++i, ++first) {
+        result |= static_cast<KmerHashType>(perfect_hash(*first)) << (2 * i);
+    }
+    return result;
 }
 
 using KmerPerfectHashes = std::vector<KmerHashType>;
 
+// Rolls the hash along the sequence, so each position costs a shift and a table lookup
 template <unsigned char K>
-auto compute_kmer_hashes(const std::string& sequence)
+void compute_kmer_hashes(const std::string& sequence, KmerPerfectHashes& result)
 {
-    if (sequence.size() < K) {
-        return KmerPerfectHashes {};
-    }
-    KmerPerfectHashes result(sequence.size() - K + 1);
-    auto result_it = std::begin(result);
-    for (auto it = std::cbegin(sequence); it != std::prev(std::cend(sequence), K - 1); ++it, ++result_it) {
-        *result_it = perfect_kmer_hash<K>(it);
+    static_assert(K > 0 && 2 * K <= 8 * sizeof(KmerHashType), "K too large for KmerHashType");
+    result.clear();
+    if (sequence.size() < K) return;
+    result.resize(sequence.size() - K + 1);
+    constexpr auto last_base_shift = 2 * (K - 1);
+    auto hash = perfect_kmer_hash<K>(std::cbegin(sequence));
+    result.front() = hash;
+    auto result_itr = std::next(std::begin(result));
+    for (auto base_itr = std::next(std::cbegin(sequence), K); base_itr != std::cend(sequence); ++base_itr, ++result_itr) {
+        hash = (hash >> 2) | (static_cast<KmerHashType>(perfect_hash(*base_itr)) << last_base_shift);
+        *result_itr = hash;
     }
+}
+
+template <unsigned char K>
+auto compute_kmer_hashes(const std::string& sequence)
+{
+    KmerPerfectHashes result {};
+    compute_kmer_hashes<K>(sequence, result);
     return result;
 }
 
-using KmerHashTable = std::pair<std::vector<std::vector<std::size_t>>, std::size_t>;
+// A CSR table of the positions of each k-mer in a target sequence: the positions of k-mer h are
+// positions[bin_offsets[h]] to positions[bin_offsets[h + 1]], in increasing order. Populating
+// reuses the existing buffers so a table can be rebuilt for many targets without allocating.
+struct KmerHashTable
+{
+    std::vector<std::uint32_t> bin_offsets;
+    std::vector<std::uint32_t> positions;
+    KmerPerfectHashes hashes; // scratch
+};
 
 template <unsigned char K>
 KmerHashTable init_kmer_hash_table()
 {
-    return std::make_pair(std::vector<std::vector<std::size_t>> {num_kmers(K), std::vector<std::size_t> {}}, 0);
+    return KmerHashTable {std::vector<std::uint32_t>(num_kmers(K) + 1, 0), {}, {}};
 }
 
 inline void clear_kmer_hash_table(KmerHashTable& table)
 {
-    for (auto& bin : table.first) bin.clear();
-    table.second = 0;
+    std::fill(std::begin(table.bin_offsets), std::end(table.bin_offsets), 0);
+    table.positions.clear();
 }
 
 template <unsigned char K>
 void populate_kmer_hash_table(const std::string& sequence, KmerHashTable& result)
 {
-    if (sequence.size() < K) {
-        return;
+    compute_kmer_hashes<K>(sequence, result.hashes);
+    auto& offsets = result.bin_offsets;
+    std::fill(std::begin(offsets), std::end(offsets), 0);
+    for (const auto hash : result.hashes) ++offsets[hash + 1];
+    std::partial_sum(std::begin(offsets), std::end(offsets), std::begin(offsets));
+    result.positions.resize(result.hashes.size());
+    // Scattering advances each bin offset to the start of the next bin, so shift them back afterwards
+    for (std::size_t index {0}; index < result.hashes.size(); ++index) {
+        result.positions[offsets[result.hashes[index]]++] = static_cast<std::uint32_t>(index);
     }
-    const auto last_index = sequence.size() - K;
-    auto it = std::cbegin(sequence);
-    for (std::size_t index {0}; index <= last_index; ++index, ++it) {
-        result.first[perfect_kmer_hash<K>(it)].push_back(index);
-    }
-    for (auto& bin : result.first) bin.shrink_to_fit();
-    result.second = sequence.size() - K + 1;
+    std::copy_backward(std::begin(offsets), std::prev(std::end(offsets)), std::end(offsets));
+    offsets.front() = 0;
 }
 
 template <unsigned char K>
@@ -109,7 +131,7 @@ using MappedIndexCounts = std::vector<unsigned>;
 
 inline MappedIndexCounts init_mapping_counts(const KmerHashTable& target)
 {
-    return MappedIndexCounts(target.second, 0);
+    return MappedIndexCounts(target.positions.size(), 0);
 }
 
 inline void reset_mapping_counts(MappedIndexCounts& mapping_counts)
@@ -126,7 +148,11 @@ OutputIt map_query_to_target(const KmerPerfectHashes& query, const KmerHashTable
     std::size_t first_max_hit_index {0};
     unsigned num_max_hits {0};
     for (std::size_t query_index {0}; query_index < query.size(); ++query_index) {
-        for (const auto target_index : target.first[query[query_index]]) {
+        const auto hash = query[query_index];
+        const auto bin_begin = std::next(std::cbegin(target.positions), target.bin_offsets[hash]);
+        const auto bin_end   = std::next(std::cbegin(target.positions), target.bin_offsets[hash + 1]);
+        for (auto bin_itr = bin_begin; bin_itr != bin_end; ++bin_itr) {
+            const std::size_t target_index {*bin_itr};
             if (target_index >= query_index) {
                 const auto mapping_begin = target_index - query_index;
                 if (++mapping_counts[mapping_begin] > max_hit_count) {
@@ -168,6 +194,198 @@ map_query_to_target(const KmerPerfectHashes& query, const KmerHashTable& target,
 std::vector<std::size_t>
 map_query_to_target(const KmerPerfectHashes& query, const KmerHashTable& target);
 
+// A k-mer index over several target sequences at once. Each distinct (k-mer, position) pair is stored
+// once as an entry with a bitset of the targets containing that k-mer at that position, so targets
+// that are mostly identical (e.g. the haplotypes of a block) share nearly all of their entries.
+// Entries present in every target are flagged as shared so mapping can count them once for all, and
+// entries present in most targets are inverted to store the targets that do not contain them.
+struct MultiKmerHashTable
+{
+    using MembershipWord = std::uint64_t;
+    static constexpr std::size_t membershipWordBits {8 * sizeof(MembershipWord)};
+    
+    std::size_t num_targets, num_membership_words;
+    std::vector<std::uint32_t> target_num_positions;
+    std::vector<std::uint32_t> bin_offsets; // into entries
+    std::vector<std::uint32_t> positions; // of each entry
+    std::vector<std::uint8_t> is_shared, is_inverted; // of each entry
+    std::vector<MembershipWord> members; // num_membership_words per entry
+    KmerPerfectHashes hashes; // scratch
+    std::vector<std::uint64_t> occurrences; // scratch, (position << 32) | target
+};
+
+template <unsigned char K>
+MultiKmerHashTable init_multi_kmer_hash_table()
+{
+    MultiKmerHashTable result {};
+    result.bin_offsets.assign(num_kmers(K) + 1, 0);
+    return result;
+}
+
+using TargetSequenceRefs = std::vector<std::reference_wrapper<const std::string>>;
+
+template <unsigned char K>
+void populate_kmer_hash_table(const TargetSequenceRefs& targets, MultiKmerHashTable& result)
+{
+    using Word = MultiKmerHashTable::MembershipWord;
+    constexpr auto word_bits = MultiKmerHashTable::membershipWordBits;
+    result.num_targets = targets.size();
+    result.num_membership_words = (targets.size() + word_bits - 1) / word_bits;
+    result.target_num_positions.resize(targets.size());
+    auto& offsets = result.bin_offsets;
+    offsets.assign(num_kmers(K) + 1, 0);
+    KmerPerfectHashes target_hashes {};
+    result.hashes.clear();
+    for (std::size_t target {0}; target < targets.size(); ++target) {
+        compute_kmer_hashes<K>(targets[target].get(), target_hashes);
+        result.target_num_positions[target] = static_cast<std::uint32_t>(target_hashes.size());
+        result.hashes.insert(std::end(result.hashes), std::cbegin(target_hashes), std::cend(target_hashes));
+    }
+    for (const auto hash : result.hashes) ++offsets[hash + 1];
+    std::partial_sum(std::begin(offsets), std::end(offsets), std::begin(offsets));
+    result.occurrences.resize(result.hashes.size());
+    for (std::size_t target {0}, index {0}; target < targets.size(); ++target) {
+        for (std::uint64_t position {0}; position < result.target_num_positions[target]; ++position, ++index) {
+            result.occurrences[offsets[result.hashes[index]]++] = (position << 32) | target;
+        }
+    }
+    std::copy_backward(std::begin(offsets), std::prev(std::end(offsets)), std::end(offsets));
+    offsets.front() = 0;
+    // Each bin is ordered by target; reorder by position then merge equal positions into one entry
+    result.positions.clear();
+    result.is_shared.clear();
+    result.is_inverted.clear();
+    result.members.clear();
+    std::uint32_t occurrence_begin {0};
+    for (std::size_t hash {0}; hash + 1 < offsets.size(); ++hash) {
+        const auto occurrence_end = offsets[hash + 1];
+        offsets[hash] = static_cast<std::uint32_t>(result.positions.size());
+        const auto bin_begin = std::next(std::begin(result.occurrences), occurrence_begin);
+        const auto bin_end = std::next(std::begin(result.occurrences), occurrence_end);
+        std::sort(bin_begin, bin_end);
+        for (auto entry_begin = bin_begin; entry_begin != bin_end;) {
+            const auto position = static_cast<std::uint32_t>(*entry_begin >> 32);
+            const auto entry_end = std::find_if(entry_begin, bin_end, [=] (auto occurrence) { return (occurrence >> 32) != position; });
+            const auto num_members = static_cast<std::size_t>(std::distance(entry_begin, entry_end));
+            const bool inverted {2 * num_members > targets.size()};
+            result.positions.push_back(position);
+            result.is_shared.push_back(num_members == targets.size());
+            result.is_inverted.push_back(inverted);
+            const auto first_word = result.members.size();
+            result.members.resize(first_word + result.num_membership_words, 0);
+            std::for_each(entry_begin, entry_end, [&] (auto occurrence) {
+                const auto target = occurrence & 0xFFFFFFFF;
+                result.members[first_word + target / word_bits] |= Word {1} << (target % word_bits);
+            });
+            if (inverted) {
+                for (std::size_t w {0}; w < result.num_membership_words; ++w) {
+                    const auto word_targets = std::min(targets.size() - w * word_bits, word_bits);
+                    const auto word_mask = word_targets == word_bits ? ~Word {0} : (Word {1} << word_targets) - 1;
+                    result.members[first_word + w] = ~result.members[first_word + w] & word_mask;
+                }
+            }
+            entry_begin = entry_end;
+        }
+        occurrence_begin = occurrence_end;
+    }
+    offsets.back() = static_cast<std::uint32_t>(result.positions.size());
+}
+
+template <unsigned char K>
+MultiKmerHashTable make_kmer_hash_table(const TargetSequenceRefs& targets)
+{
+    auto result = init_multi_kmer_hash_table<K>();
+    populate_kmer_hash_table<K>(targets, result);
+    return result;
+}
+
+// Mapping counts for a MultiKmerHashTable. Counts from shared and inverted entries are kept once for
+// all targets, with target counts correcting them, and only the offsets touched by a query are reset.
+struct MultiMappedIndexCounts
+{
+    std::size_t max_target_positions;
+    std::vector<unsigned> shared_counts; // by mapping offset
+    std::vector<int> target_counts; // by target, then mapping offset
+    std::vector<std::uint8_t> is_touched;
+    std::vector<std::uint32_t> touched_offsets, touched_target_offsets;
+    std::vector<std::size_t> mapping_positions;
+};
+
+inline MultiMappedIndexCounts init_mapping_counts(const MultiKmerHashTable& targets)
+{
+    MultiMappedIndexCounts result {};
+    result.max_target_positions = targets.target_num_positions.empty() ? 0 :
+        *std::max_element(std::cbegin(targets.target_num_positions), std::cend(targets.target_num_positions));
+    result.shared_counts.assign(result.max_target_positions, 0);
+    result.target_counts.assign(targets.num_targets * result.max_target_positions, 0);
+    result.is_touched.assign(result.max_target_positions, false);
+    return result;
+}
+
+// Maps query to every target in one pass over the query k-mers, then calls
+// f(target_index, first_position, last_position) for each target in order. Each target gets the
+// same positions map_query_to_target would give for that target alone.
+template <typename F>
+void map_query_to_targets(const KmerPerfectHashes& query, const MultiKmerHashTable& targets,
+                          MultiMappedIndexCounts& counts, F&& f,
+                          std::size_t max_mapping_positions = std::numeric_limits<std::size_t>::max())
+{
+    constexpr auto word_bits = MultiKmerHashTable::membershipWordBits;
+    const auto num_offsets = counts.max_target_positions;
+    const auto touch = [&] (const std::size_t offset) {
+        if (!counts.is_touched[offset]) {
+            counts.is_touched[offset] = true;
+            counts.touched_offsets.push_back(static_cast<std::uint32_t>(offset));
+        }
+    };
+    for (std::size_t query_index {0}; query_index < query.size(); ++query_index) {
+        const auto hash = query[query_index];
+        for (auto entry = targets.bin_offsets[hash]; entry < targets.bin_offsets[hash + 1]; ++entry) {
+            const std::size_t target_index {targets.positions[entry]};
+            if (target_index < query_index) continue;
+            const auto offset = target_index - query_index;
+            touch(offset);
+            if (targets.is_inverted[entry]) {
+                ++counts.shared_counts[offset];
+                if (targets.is_shared[entry]) continue;
+            }
+            const int target_increment {targets.is_inverted[entry] ? -1 : 1};
+            for (std::size_t w {0}; w < targets.num_membership_words; ++w) {
+                for (auto word = targets.members[entry * targets.num_membership_words + w]; word != 0; word &= word - 1) {
+                    const auto target = w * word_bits + static_cast<std::size_t>(__builtin_ctzll(word));
+                    const auto target_offset = target * num_offsets + offset;
+                    if (counts.target_counts[target_offset] == 0) {
+                        counts.touched_target_offsets.push_back(static_cast<std::uint32_t>(target_offset));
+                    }
+                    counts.target_counts[target_offset] += target_increment;
+                }
+            }
+        }
+    }
+    std::sort(std::begin(counts.touched_offsets), std::end(counts.touched_offsets));
+    for (std::size_t target {0}; target < targets.num_targets; ++target) {
+        const auto target_counts = std::next(std::cbegin(counts.target_counts), target * num_offsets);
+        const auto count = [&] (const std::size_t offset) -> unsigned { return counts.shared_counts[offset] + target_counts[offset]; };
+        unsigned max_hit_count {0};
+        for (const auto offset : counts.touched_offsets) max_hit_count = std::max(count(offset), max_hit_count);
+        counts.mapping_positions.clear();
+        if (max_hit_count > 0) {
+            for (const auto offset : counts.touched_offsets) {
+                if (counts.mapping_positions.size() == max_mapping_positions) break;
+                if (count(offset) == max_hit_count) counts.mapping_positions.push_back(offset);
+            }
+        }
+        f(target, std::cbegin(counts.mapping_positions), std::cend(counts.mapping_positions));
+    }
+    for (const auto offset : counts.touched_offsets) {
+        counts.shared_counts[offset] = 0;
+        counts.is_touched[offset] = false;
+    }
+    for (const auto target_offset : counts.touched_target_offsets) counts.target_counts[target_offset] = 0;
+    counts.touched_offsets.clear();
+    counts.touched_target_offsets.clear();
+}
+
 template <unsigned char K>
 std::vector<std::size_t> map_query_to_target(const std::string& query, const std::string& target)
 {
@@ -0,0 +1,92 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "mapped_file_format.hpp"
+
+#include <boost/filesystem/operations.hpp>
+
+#include "checksum.hpp"
+
+namespace octopus { namespace utils { namespace mapped_file {
+
+namespace {
+
+constexpr std::size_t table_offset_pos {16};
+
+std::uint64_t compute_checksum(const std::uint64_t table_offset, const char* table, const std::size_t table_size) noexcept
+{
+    Checksum result {};
+    result.update(table_offset);
+    result.update(table, table_size);
+    return result.value();
+}
+
+} // namespace
+
+void write_header(std::ostream& out, const Magic& magic, const std::uint32_t version)
+{
+    out.write(magic.data(), magic.size());
+    write_value(out, version);
+    write_value(out, std::uint32_t {0});
+    write_value(out, std::uint64_t {0}); // table offset, filled in by write_table
+    write_value(out, std::uint64_t {0}); // checksum, filled in by write_table
+}
+
+void write_table(std::ostream& out, const std::string& table)
+{
+    pad_to_alignment(out, 8);
+    const auto table_offset = static_cast<std::uint64_t>(out.tellp());
+    out.write(table.data(), table.size());
+    out.seekp(table_offset_pos);
+    write_value(out, table_offset);
+    write_value(out, compute_checksum(table_offset, table.data(), table.size()));
+    out.seekp(0, std::ios::end);
+}
+
+std::size_t read_header(const char* data, const std::size_t file_size, const Magic& magic, const std::uint32_t version)
+{
+    if (file_size < header_size || !std::equal(std::cbegin(magic), std::cend(magic), data)) {
+        throw std::runtime_error {"unrecognised file format"};
+    }
+    std::size_t offset {magic.size()};
+    if (read_value<std::uint32_t>(data, offset, file_size) != version) {
+        throw std::runtime_error {"unsupported file version"};
+    }
+    offset = table_offset_pos;
+    const auto table_offset = read_value<std::uint64_t>(data, offset, file_size);
+    const auto checksum = read_value<std::uint64_t>(data, offset, file_size);
+    if (table_offset < header_size || table_offset > file_size
+        || compute_checksum(table_offset, data + table_offset, file_size - table_offset) != checksum) {
+        throw std::runtime_error {"checksum mismatch; the file is truncated or corrupt"};
+    }
+    return table_offset;
+}
+
+void write_string(std::ostream& out, const std::string& str)
+{
+    write_value(out, static_cast<std::uint32_t>(str.size()));
+    out.write(str.data(), str.size());
+}
+
+void pad_to_alignment(std::ostream& out, const std::size_t alignment)
+{
+    while (static_cast<std::size_t>(out.tellp()) % alignment != 0) out.put('\0');
+}
+
+std::string read_string(const char* data, std::size_t& offset, const std::size_t file_size)
+{
+    const auto length = read_value<std::uint32_t>(data, offset, file_size);
+    if (length > file_size - offset) throw std::runtime_error {"truncated file"};
+    std::string result {data + offset, data + offset + length};
+    offset += length;
+    return result;
+}
+
+boost::filesystem::path make_temp_path(const boost::filesystem::path& path)
+{
+    return path.parent_path() / boost::filesystem::unique_path(path.filename().string() + ".%%%%-%%%%-%%%%.tmp");
+}
+
+} // namespace mapped_file
+} // namespace utils
+} // namespace octopus
@@ -0,0 +1,120 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef mapped_file_format_hpp
+#define mapped_file_format_hpp
+
+#include <array>
+#include <vector>
+#include <string>
+#include <ostream>
+#include <algorithm>
+#include <iterator>
+#include <stdexcept>
+#include <cstring>
+#include <cstdint>
+#include <cstddef>
+
+#include <boost/filesystem/path.hpp>
+
+/*
+ Helpers shared by the memory-mapped binary files (TandemRepeatIndex, SourceCandidateStore).
+
+ All such files have the layout (native byte order):
+  header: magic[8], u32 version, u32 padding, u64 table offset, u64 checksum
+  payload: format specific arrays, each aligned to 8 bytes
+  table: format specific parameters and description of the payload, at the end of the file
+ The checksum covers the table offset and the table, so a truncated or overwritten table is detected
+ when the file is opened without reading the (possibly very large) payload.
+
+ Per-contig interval records are stored sorted by begin position, along with the running maximum
+ end of every block of records, so the first record that can overlap a position is a binary search
+ away.
+ */
+
+namespace octopus { namespace utils { namespace mapped_file {
+
+using Magic = std::array<char, 8>;
+
+constexpr std::size_t header_size {32};
+
+// Writes a header with placeholder table offset and checksum
+void write_header(std::ostream& out, const Magic& magic, std::uint32_t version);
+
+// Appends table to out and fills in the header's table offset and checksum. out must be seekable.
+void write_table(std::ostream& out, const std::string& table);
+
+// Checks the magic, version, and checksum, and returns the table offset. Throws std::runtime_error
+// describing the problem if any check fails.
+std::size_t read_header(const char* data, std::size_t file_size, const Magic& magic, std::uint32_t version);
+
+template <typename T>
+void write_value(std::ostream& out, const T& value)
+{
+    out.write(reinterpret_cast<const char*>(&value), sizeof(T));
+}
+
+void write_string(std::ostream& out, const std::string& str);
+
+template <typename T>
+void write_array(std::ostream& out, const std::vector<T>& values)
+{
+    out.write(reinterpret_cast<const char*>(values.data()), values.size() * sizeof(T));
+}
+
+void pad_to_alignment(std::ostream& out, std::size_t alignment);
+
+template <typename T>
+T read_value(const char* data, std::size_t& offset, const std::size_t file_size)
+{
+    if (offset + sizeof(T) > file_size) throw std::runtime_error {"truncated file"};
+    T result;
+    std::memcpy(&result, data + offset, sizeof(T));
+    offset += sizeof(T);
+    return result;
+}
+
+std::string read_string(const char* data, std::size_t& offset, std::size_t file_size);
+
+// The array of count Ts at offset, checked to be in bounds and aligned
+template <typename T>
+const T* get_array(const char* data, const std::uint64_t offset, const std::uint64_t count, const std::size_t file_size)
+{
+    if (offset > file_size || count > (file_size - offset) / sizeof(T) || offset % alignof(T) != 0) {
+        throw std::runtime_error {"corrupt table"};
+    }
+    return reinterpret_cast<const T*>(data + offset);
+}
+
+// The running maximum end of each block of block_size records
+template <typename Record, typename GetEnd>
+std::vector<std::uint32_t> make_block_ends(const std::vector<Record>& records, const std::size_t block_size, GetEnd get_end)
+{
+    std::vector<std::uint32_t> result {};
+    result.reserve(records.size() / block_size + 1);
+    std::uint32_t max_end {0};
+    for (std::size_t i {0}; i < records.size(); ++i) {
+        max_end = std::max(max_end, static_cast<std::uint32_t>(get_end(records[i])));
+        if ((i + 1) % block_size == 0 || i + 1 == records.size()) result.push_back(max_end);
+    }
+    return result;
+}
+
+// The index of the first record that may end after pos
+inline std::size_t
+find_first_block_record(const std::uint32_t* block_ends, const std::size_t num_blocks, const std::size_t block_size,
+                        const std::size_t num_records, const std::uint32_t pos) noexcept
+{
+    const auto first_block = std::upper_bound(block_ends, block_ends + num_blocks, pos);
+    return std::min(static_cast<std::size_t>(std::distance(block_ends, first_block)) * block_size, num_records);
+}
+
+// A unique path in the same directory as path, so the finished file can be renamed into place
+// atomically and concurrent writers never share a temporary
+boost::filesystem::path make_temp_path(const boost::filesystem::path& path);
+
+} // namespace mapped_file
+} // namespace utils
+} // namespace octopus
+
+#endif
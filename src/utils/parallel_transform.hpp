@@ -11,6 +11,7 @@
 #include <cstddef>
 #include <utility>
 #include <type_traits>
+#include <exception>
 
 #include "thread_pool.hpp"
 
@@ -174,6 +175,117 @@ OutputIt transform(InputIt1 first1, InputIt1 last1, InputIt2 first2, OutputIt re
                              typename std::iterator_traits<InputIt2>::iterator_category {});
 }
 
+using IndexPartition = std::pair<std::size_t, std::size_t>;
+
+// Splits [0, n) into at most max_partitions contiguous partitions of at least min_partition_size
+inline std::vector<IndexPartition> make_partitions(const std::size_t n, const std::size_t min_partition_size,
+                                                   const std::size_t max_partitions)
+{
+    std::vector<IndexPartition> result {};
+    if (n == 0) return result;
+    const auto num_partitions = std::max(std::min(n / std::max(min_partition_size, std::size_t {1}), max_partitions), std::size_t {1});
+    result.reserve(num_partitions);
+    const auto partition_size = n / num_partitions, remainder = n % num_partitions;
+    for (std::size_t i {0}, first {0}; i < num_partitions; ++i) {
+        const auto last = first + partition_size + (i < remainder ? 1 : 0);
+        result.emplace_back(first, last);
+        first = last;
+    }
+    return result;
+}
+
+namespace detail {
+
+// Partitions are only run on the pool if the calling thread is not one of its workers, as
+// waiting on the pool from a worker could deadlock it
+inline std::size_t max_partitions(const ThreadPool& workers) noexcept
+{
+    return workers.is_worker_thread() ? 1 : std::max(workers.size(), std::size_t {1});
+}
+
+} // namespace detail
+
+// Gets every future, appending values to result, and stores the first exception in error if it is not
+// already set. All futures are waited on, even after an error, as the tasks may reference the caller's stack.
+template <typename T>
+void get_all(std::vector<std::future<T>>& futures, std::vector<T>& result, std::exception_ptr& error)
+{
+    for (auto& future : futures) {
+        try {
+            result.push_back(future.get());
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+}
+
+inline void get_all(std::vector<std::future<void>>& futures, std::exception_ptr& error)
+{
+    for (auto& future : futures) {
+        try {
+            future.get();
+        } catch (...) {
+            if (!error) error = std::current_exception();
+        }
+    }
+}
+
+// Calls op(first, last) on each partition of [0, n) using workers, returning the results in partition
+// order. The first partition is evaluated on the calling thread.
+template <typename BinaryOp>
+auto parallel_transform_partitions(const std::size_t n, const std::size_t min_partition_size, BinaryOp op,
+                                   ThreadPool& workers)
+{
+    using result_type = std::result_of_t<BinaryOp(std::size_t, std::size_t)>;
+    const auto partitions = make_partitions(n, min_partition_size, detail::max_partitions(workers));
+    std::vector<result_type> result {};
+    result.reserve(partitions.size());
+    if (partitions.size() > 1) {
+        std::vector<std::future<result_type>> tasks {};
+        tasks.reserve(partitions.size() - 1);
+        std::for_each(std::next(std::cbegin(partitions)), std::cend(partitions), [&] (const IndexPartition& partition) {
+            tasks.push_back(workers.push([&op, partition] () { return op(partition.first, partition.second); }));
+        });
+        std::exception_ptr error {};
+        try {
+            result.push_back(op(partitions.front().first, partitions.front().second));
+        } catch (...) {
+            error = std::current_exception();
+        }
+        get_all(tasks, result, error);
+        if (error) std::rethrow_exception(error);
+    } else if (!partitions.empty()) {
+        result.push_back(op(partitions.front().first, partitions.front().second));
+    }
+    return result;
+}
+
+// Calls op(first, last) on each partition of [0, n) using workers. The first partition is evaluated
+// on the calling thread.
+template <typename BinaryOp>
+void parallel_for_each_partition(const std::size_t n, const std::size_t min_partition_size, BinaryOp op,
+                                 ThreadPool& workers)
+{
+    const auto partitions = make_partitions(n, min_partition_size, detail::max_partitions(workers));
+    if (partitions.size() > 1) {
+        std::vector<std::future<void>> tasks {};
+        tasks.reserve(partitions.size() - 1);
+        std::for_each(std::next(std::cbegin(partitions)), std::cend(partitions), [&] (const IndexPartition& partition) {
+            tasks.push_back(workers.push([&op, partition] () { op(partition.first, partition.second); }));
+        });
+        std::exception_ptr error {};
+        try {
+            op(partitions.front().first, partitions.front().second);
+        } catch (...) {
+            error = std::current_exception();
+        }
+        get_all(tasks, error);
+        if (error) std::rethrow_exception(error);
+    } else if (!partitions.empty()) {
+        op(partitions.front().first, partitions.front().second);
+    }
+}
+
 } // namespace octopus
 
 #endif
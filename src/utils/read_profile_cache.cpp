@@ -0,0 +1,191 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "read_profile_cache.hpp"
+
+#include <cstdint>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <array>
+#include <algorithm>
+#include <utility>
+
+#include <boost/filesystem.hpp>
+
+#include "utils/checksum.hpp"
+#include "logging/logging.hpp"
+
+namespace octopus {
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+using utils::Checksum;
+
+boost::optional<fs::path> find_index(const fs::path& read_path)
+{
+    const auto extension = read_path.extension().string();
+    std::vector<fs::path> candidates {};
+    if (extension == ".cram") {
+        candidates.push_back(read_path.string() + ".crai");
+        candidates.push_back(fs::path {read_path}.replace_extension(".crai"));
+    } else {
+        candidates.push_back(read_path.string() + ".bai");
+        candidates.push_back(fs::path {read_path}.replace_extension(".bai"));
+    }
+    candidates.push_back(read_path.string() + ".csi");
+    for (const auto& candidate : candidates) {
+        boost::system::error_code ec {};
+        if (fs::is_regular_file(candidate, ec)) return candidate;
+    }
+    return boost::none;
+}
+
+void update_file_checksum(const fs::path& file, Checksum& checksum)
+{
+    std::ifstream in {file.string(), std::ios::binary};
+    std::array<char, 1 << 16> buffer {};
+    while (in) {
+        in.read(buffer.data(), buffer.size());
+        checksum.update(buffer.data(), static_cast<std::size_t>(in.gcount()));
+    }
+}
+
+void update_read_file_checksum(const fs::path& read_path, Checksum& checksum)
+{
+    const auto index_path = find_index(read_path);
+    if (index_path) {
+        update_file_checksum(*index_path, checksum);
+    } else {
+        // Fall back to file metadata; any change to the alignments will invalidate the cache
+        boost::system::error_code ec {};
+        checksum.update(std::uint64_t {fs::file_size(read_path, ec)});
+        checksum.update(static_cast<std::uint64_t>(fs::last_write_time(read_path, ec)));
+    }
+}
+
+// Reference sequences are not read, but a different assembly or build will differ in name or contigs
+void update_checksum(const ReferenceGenome& reference, Checksum& checksum)
+{
+    checksum.update(reference.name());
+    auto contigs = reference.contig_names();
+    std::sort(std::begin(contigs), std::end(contigs));
+    for (const auto& contig : contigs) {
+        checksum.update(contig);
+        checksum.update(std::uint64_t {reference.contig_size(contig)});
+    }
+}
+
+void update_checksum(const ReadSetProfileConfig& config, Checksum& checksum)
+{
+    checksum.update(std::uint64_t {config.max_draws_per_sample});
+    checksum.update(std::uint64_t {config.target_reads_per_draw});
+    checksum.update(std::uint64_t {config.min_draws_per_contig});
+    checksum.update(std::uint64_t {config.fragment_size ? *config.fragment_size + 1 : 0});
+    checksum.update(std::uint64_t {config.min_read_lengths});
+    // max_threads does not change the profile as each sample is drawn independently
+}
+
+std::string to_hex(const std::uint64_t value)
+{
+    std::ostringstream ss {};
+    ss << std::hex << std::setw(16) << std::setfill('0') << value;
+    return ss.str();
+}
+
+} // namespace
+
+ReadProfileCache::ReadProfileCache(Path directory) : directory_ {std::move(directory)} {}
+
+ReadProfileCache::Key
+ReadProfileCache::make_key(const std::vector<SampleName>& samples,
+                           const ReferenceGenome& reference,
+                           const std::vector<Path>& read_paths,
+                           const InputRegionMap& regions,
+                           const ReadSetProfileConfig& config) const
+{
+    Checksum checksum {};
+    update_checksum(reference, checksum);
+    auto sorted_read_paths = read_paths;
+    std::sort(std::begin(sorted_read_paths), std::end(sorted_read_paths));
+    for (const auto& path : sorted_read_paths) {
+        update_read_file_checksum(path, checksum);
+    }
+    checksum.update(std::uint64_t {samples.size()});
+    for (const auto& sample : samples) checksum.update(sample);
+    for (const auto& p : regions) {
+        checksum.update(p.first);
+        for (const auto& region : p.second) {
+            checksum.update(std::uint64_t {region.begin()});
+            checksum.update(std::uint64_t {region.end()});
+        }
+    }
+    update_checksum(config, checksum);
+    return checksum.value();
+}
+
+boost::optional<ReadSetProfile> ReadProfileCache::load(const Key key) const
+{
+    const auto cache_path = make_cache_path(key);
+    boost::system::error_code ec {};
+    if (!fs::is_regular_file(cache_path, ec)) return boost::none;
+    std::ifstream in {cache_path.string()};
+    auto result = read_profile(in);
+    if (!result) {
+        logging::WarningLogger warn_log {};
+        stream(warn_log) << "Ignoring malformed read profile cache file " << cache_path;
+    }
+    return result;
+}
+
+void ReadProfileCache::store(const ReadSetProfile& profile, const Key key) const
+{
+    boost::system::error_code ec {};
+    fs::create_directories(directory_, ec);
+    const auto cache_path = make_cache_path(key);
+    // Write to a unique temporary and rename so concurrent runs never see a partial profile
+    const auto tmp_path = directory_ / fs::unique_path(cache_path.filename().string() + ".%%%%-%%%%.tmp");
+    {
+        std::ofstream out {tmp_path.string()};
+        if (!out) {
+            logging::WarningLogger warn_log {};
+            stream(warn_log) << "Could not write read profile cache to " << directory_;
+            return;
+        }
+        write(profile, out);
+    }
+    fs::rename(tmp_path, cache_path, ec);
+    if (ec) fs::remove(tmp_path, ec);
+}
+
+ReadProfileCache::Path ReadProfileCache::make_cache_path(const Key key) const
+{
+    return directory_ / ("octopus_read_profile." + to_hex(key) + ".txt");
+}
+
+boost::optional<ReadSetProfile>
+profile_reads(const std::vector<SampleName>& samples,
+              const ReferenceGenome& reference,
+              const InputRegionMap& regions,
+              const ReadManager& source,
+              const ReadProfileCache& cache,
+              ReadSetProfileConfig config)
+{
+    const auto key = cache.make_key(samples, reference, source.paths(), regions, config);
+    auto debug_log = logging::get_debug_log();
+    auto result = cache.load(key);
+    if (result) {
+        if (debug_log) stream(*debug_log) << "Loaded cached read profile for " << samples.size() << " samples";
+    } else {
+        result = profile_reads(samples, reference, regions, source, config);
+        if (result) {
+            cache.store(*result, key);
+            if (debug_log) stream(*debug_log) << "Cached read profile for " << samples.size() << " samples";
+        }
+    }
+    return result;
+}
+
+} // namespace octopus
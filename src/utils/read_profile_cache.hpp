@@ -0,0 +1,68 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef read_profile_cache_hpp
+#define read_profile_cache_hpp
+
+#include <vector>
+#include <string>
+#include <cstdint>
+
+#include <boost/optional.hpp>
+#include <boost/filesystem/path.hpp>
+
+#include "config/common.hpp"
+#include "input_reads_profiler.hpp"
+
+namespace octopus {
+
+/*
+ ReadProfileCache persists ReadSetProfiles between runs. Profiles are keyed on the reference, the
+ checksums of the read file indices, the profiled samples, the search regions, and the profile config,
+ so a cached profile is only reused when the sampling would have been identical.
+ */
+class ReadProfileCache
+{
+public:
+    using Path = boost::filesystem::path;
+
+    ReadProfileCache() = delete;
+
+    ReadProfileCache(Path directory);
+
+    ReadProfileCache(const ReadProfileCache&)            = default;
+    ReadProfileCache& operator=(const ReadProfileCache&) = default;
+    ReadProfileCache(ReadProfileCache&&)                 = default;
+    ReadProfileCache& operator=(ReadProfileCache&&)      = default;
+
+    ~ReadProfileCache() = default;
+
+    using Key = std::uint64_t;
+    
+    // Reads the index of every read file, so should be computed once per lookup
+    Key make_key(const std::vector<SampleName>& samples,
+                 const ReferenceGenome& reference,
+                 const std::vector<Path>& read_paths,
+                 const InputRegionMap& regions,
+                 const ReadSetProfileConfig& config) const;
+    
+    boost::optional<ReadSetProfile> load(Key key) const;
+    void store(const ReadSetProfile& profile, Key key) const;
+
+private:
+    Path directory_;
+
+    Path make_cache_path(Key key) const;
+};
+
+boost::optional<ReadSetProfile>
+profile_reads(const std::vector<SampleName>& samples,
+              const ReferenceGenome& reference,
+              const InputRegionMap& regions,
+              const ReadManager& source,
+              const ReadProfileCache& cache,
+              ReadSetProfileConfig config = ReadSetProfileConfig {});
+
+} // namespace octopus
+
+#endif
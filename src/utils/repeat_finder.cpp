@@ -3,12 +3,18 @@
 
 #include "repeat_finder.hpp"
 
+#include "utils/tandem_repeat_index.hpp"
+
 namespace octopus {
 
 std::vector<TandemRepeat>
 find_exact_tandem_repeats(const ReferenceGenome& reference, const GenomicRegion& region, unsigned max_period)
 {
     auto sequence = reference.fetch_sequence(region);
+    const auto repeat_index = reference.repeat_index();
+    if (repeat_index && repeat_index->max_period() >= max_period && repeat_index->has_contig(region.contig_name())) {
+        return repeat_index->find(region, sequence, max_period);
+    }
     return find_exact_tandem_repeats(sequence, region, 1, max_period);
 }
 
@@ -54,8 +60,7 @@ std::vector<GenomicRegion>
 find_repeat_regions(const ReferenceGenome& reference, const GenomicRegion& region,
                     const InexactRepeatDefinition repeat_def)
 {
-    auto sequence = reference.fetch_sequence(region);
-    auto seeds = find_exact_tandem_repeats(sequence, region, 1, repeat_def.max_exact_repeat_seed_period);
+    const auto seeds = find_exact_tandem_repeats(reference, region, repeat_def.max_exact_repeat_seed_period);
     return find_repeat_regions(seeds, region, repeat_def);
 }
 
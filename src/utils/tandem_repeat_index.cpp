@@ -0,0 +1,357 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include "tandem_repeat_index.hpp"
+
+#include <array>
+#include <deque>
+#include <future>
+#include <fstream>
+#include <algorithm>
+#include <iterator>
+#include <sstream>
+#include <limits>
+#include <utility>
+#include <cassert>
+
+#include <boost/filesystem.hpp>
+
+#include "io/reference/reference_genome.hpp"
+#include "utils/thread_pool.hpp"
+#include "utils/mapped_file_format.hpp"
+#include "exceptions/malformed_file_error.hpp"
+#include "exceptions/unwritable_file_error.hpp"
+#include "logging/logging.hpp"
+#include "tandem/tandem.hpp"
+
+namespace octopus {
+
+namespace fs = boost::filesystem;
+namespace mapped_file = utils::mapped_file;
+
+class MalformedRepeatIndex : public MalformedFileError
+{
+    std::string do_where() const override { return "TandemRepeatIndex"; }
+    std::string do_help() const override { return "rebuild the index with --build-repeat-index"; }
+public:
+    MalformedRepeatIndex(boost::filesystem::path file, std::string reason)
+    : MalformedFileError {std::move(file), "tandem repeat index"}
+    {
+        set_reason(std::move(reason));
+    }
+};
+
+class UnwritableRepeatIndex : public UnwritableFileError
+{
+    std::string do_where() const override { return "build_tandem_repeat_index"; }
+public:
+    UnwritableRepeatIndex(boost::filesystem::path file) : UnwritableFileError {std::move(file), "tandem repeat index"} {}
+};
+
+namespace {
+
+// The payload is, per contig, Record[num_records] sorted by begin then u32 block_ends[num_blocks].
+// The table is: u32 max_period, reference name, u64 num_contigs, then per contig: contig name,
+// u64 contig size, u64 record offset, u64 num records, u64 block offset, u64 num blocks.
+// Strings are a u32 length followed by the characters.
+constexpr mapped_file::Magic magic {'O', 'C', 'T', 'T', 'R', 'I', 'X', '\0'};
+constexpr std::uint32_t version {2};
+constexpr std::size_t block_size {64};
+constexpr std::uint32_t max_record_length {(1u << 24) - 1};
+
+using Record = TandemRepeatIndex::Record;
+
+std::uint32_t get_length(const Record& record) noexcept
+{
+    return record.length_and_period >> 8;
+}
+
+unsigned get_period(const Record& record) noexcept
+{
+    return record.length_and_period & 0xFF;
+}
+
+std::uint32_t get_end(const Record& record) noexcept
+{
+    return record.begin + get_length(record);
+}
+
+} // namespace
+
+TandemRepeatIndex::TandemRepeatIndex(Path index_path)
+: path_ {std::move(index_path)}
+, file_ {}
+, reference_name_ {}
+, max_period_ {}
+, contigs_ {}
+{
+    try {
+        file_.open(path_.string());
+    } catch (const std::exception& e) {
+        throw MalformedRepeatIndex {path_, e.what()};
+    }
+    load_contig_table();
+}
+
+TandemRepeatIndex::TandemRepeatIndex(Path index_path, const ReferenceGenome& reference)
+: TandemRepeatIndex {std::move(index_path)}
+{
+    if (reference_name_ != reference.name()) {
+        throw MalformedRepeatIndex {path_, "the index was built for reference " + reference_name_ + " not " + reference.name()};
+    }
+    const auto contigs = reference.contig_names();
+    const auto is_indexed = [&] (const GenomicRegion::ContigName& contig) {
+        const auto itr = contigs_.find(contig);
+        return itr != std::cend(contigs_) && itr->second.size == reference.contig_size(contig);
+    };
+    if (contigs.size() != contigs_.size() || !std::all_of(std::cbegin(contigs), std::cend(contigs), is_indexed)) {
+        throw MalformedRepeatIndex {path_, "the indexed contigs or contig lengths differ from those of reference " + reference.name()};
+    }
+}
+
+const TandemRepeatIndex::Path& TandemRepeatIndex::path() const noexcept
+{
+    return path_;
+}
+
+const std::string& TandemRepeatIndex::reference_name() const noexcept
+{
+    return reference_name_;
+}
+
+unsigned TandemRepeatIndex::max_period() const noexcept
+{
+    return max_period_;
+}
+
+bool TandemRepeatIndex::has_contig(const GenomicRegion::ContigName& contig) const noexcept
+{
+    return contigs_.count(contig) == 1;
+}
+
+std::size_t TandemRepeatIndex::count_repeats(const GenomicRegion::ContigName& contig) const noexcept
+{
+    const auto itr = contigs_.find(contig);
+    return itr != std::cend(contigs_) ? itr->second.num_records : 0;
+}
+
+std::vector<TandemRepeat>
+TandemRepeatIndex::find(const GenomicRegion& region, const GeneticSequence& region_sequence, const unsigned max_period) const
+{
+    assert(region_sequence.size() == size(region));
+    std::vector<TandemRepeat> result {};
+    const auto contig_itr = contigs_.find(region.contig_name());
+    if (contig_itr == std::cend(contigs_) || is_empty(region)) return result;
+    const auto& contig = contig_itr->second;
+    const auto first_record_idx = mapped_file::find_first_block_record(contig.block_ends, contig.num_blocks, block_size,
+                                                                        contig.num_records, static_cast<std::uint32_t>(region.begin()));
+    const auto last_record = contig.records + contig.num_records;
+    for (auto record = contig.records + first_record_idx;
+         record != last_record && record->begin < region.end(); ++record) {
+        const auto period = get_period(*record);
+        if (period > max_period || get_end(*record) <= region.begin()) continue;
+        const auto begin = std::max(static_cast<GenomicRegion::Position>(record->begin), region.begin());
+        const auto end   = std::min(static_cast<GenomicRegion::Position>(get_end(*record)), region.end());
+        if (end - begin < 2 * period) continue;
+        const auto motif_begin = std::next(std::cbegin(region_sequence), begin - region.begin());
+        result.emplace_back(GenomicRegion {region.contig_name(), begin, end},
+                            GeneticSequence {motif_begin, std::next(motif_begin, period)});
+    }
+    std::sort(std::begin(result), std::end(result));
+    return result;
+}
+
+void TandemRepeatIndex::load_contig_table()
+{
+    using mapped_file::read_value;
+    const auto data = file_.data();
+    const auto file_size = file_.size();
+    try {
+        auto offset = mapped_file::read_header(data, file_size, magic, version);
+        max_period_ = read_value<std::uint32_t>(data, offset, file_size);
+        reference_name_ = mapped_file::read_string(data, offset, file_size);
+        const auto num_contigs = read_value<std::uint64_t>(data, offset, file_size);
+        contigs_.reserve(num_contigs);
+        for (std::uint64_t i {0}; i < num_contigs; ++i) {
+            auto contig = mapped_file::read_string(data, offset, file_size);
+            ContigEntry entry {};
+            entry.size = read_value<std::uint64_t>(data, offset, file_size);
+            const auto record_offset = read_value<std::uint64_t>(data, offset, file_size);
+            entry.num_records = read_value<std::uint64_t>(data, offset, file_size);
+            const auto block_offset = read_value<std::uint64_t>(data, offset, file_size);
+            entry.num_blocks = read_value<std::uint64_t>(data, offset, file_size);
+            entry.records = mapped_file::get_array<Record>(data, record_offset, entry.num_records, file_size);
+            entry.block_ends = mapped_file::get_array<std::uint32_t>(data, block_offset, entry.num_blocks, file_size);
+            contigs_.emplace(std::move(contig), entry);
+        }
+    } catch (const std::exception& e) {
+        throw MalformedRepeatIndex {path_, e.what()};
+    }
+}
+
+namespace {
+
+// Runs of N are treated as repeat breakers, so each N-free segment is searched separately. This avoids
+// collapsing Ns and mapping positions back, which find_exact_tandem_repeats gets wrong for some runs.
+std::vector<tandem::Repeat>
+find_segment_repeats(const ReferenceGenome::GeneticSequence& sequence, const unsigned max_period)
+{
+    std::vector<tandem::Repeat> result {};
+    const auto is_n_run = [] (const char lhs, const char rhs) noexcept { return lhs == 'N' && rhs == 'N'; };
+    for (auto segment_begin = std::cbegin(sequence); segment_begin != std::cend(sequence); ) {
+        const auto segment_end = std::adjacent_find(segment_begin, std::cend(sequence), is_n_run);
+        if (std::distance(segment_begin, segment_end) > 1) {
+            std::string segment {segment_begin, segment_end};
+            segment.push_back('$');
+            const auto offset = static_cast<std::uint32_t>(std::distance(std::cbegin(sequence), segment_begin));
+            for (auto run : tandem::extract_exact_tandem_repeats(segment, 1, max_period)) {
+                run.pos += offset;
+                result.push_back(run);
+            }
+        }
+        segment_begin = std::find_if_not(segment_end, std::cend(sequence), [] (const char base) noexcept { return base == 'N'; });
+    }
+    return result;
+}
+
+// Finds all repeats in the contig, processing the contig in overlapping windows to bound memory. Repeats
+// touching the end of a window may be truncated, so the next window restarts from the earliest such repeat.
+std::vector<Record>
+find_contig_repeats(const ReferenceGenome& reference, const GenomicRegion::ContigName& contig, const unsigned max_period)
+{
+    const auto contig_size = reference.contig_size(contig);
+    constexpr GenomicRegion::Size window_context {100};
+    GenomicRegion::Size window_size {10'000'000};
+    std::vector<Record> result {};
+    GenomicRegion::Position keep_begin {0};
+    while (keep_begin < contig_size) {
+        // Left context distinguishes repeats truncated by the window from those starting at keep_begin, and
+        // the repeat search is unreliable for repeats touching the sequence ends
+        const auto window_begin = keep_begin - std::min(keep_begin, window_context);
+        const auto window_end = std::min(window_begin + window_size, contig_size);
+        const auto sequence = reference.fetch_sequence(GenomicRegion {contig, window_begin, window_end});
+        const auto window_length = static_cast<std::uint32_t>(sequence.size());
+        const auto runs = find_segment_repeats(sequence, max_period);
+        auto keep_end = window_end;
+        if (window_end < contig_size) {
+            keep_end = window_end - std::min(window_end, window_context);
+            for (const auto& run : runs) {
+                if (run.pos + run.length >= window_length) {
+                    keep_end = std::min(keep_end, static_cast<GenomicRegion::Position>(window_begin + run.pos));
+                }
+            }
+        }
+        if (keep_end <= keep_begin) {
+            window_size *= 2; // a repeat spans the whole window
+            continue;
+        }
+        for (const auto& run : runs) {
+            const auto begin = static_cast<GenomicRegion::Position>(window_begin + run.pos);
+            if (begin >= keep_begin && begin < keep_end) {
+                const auto length = std::min(run.length, max_record_length);
+                result.push_back({static_cast<std::uint32_t>(begin), (length << 8) | run.period});
+            }
+        }
+        keep_begin = keep_end;
+    }
+    std::sort(std::begin(result), std::end(result), [] (const Record& lhs, const Record& rhs) noexcept {
+        return lhs.begin == rhs.begin ? get_length(lhs) > get_length(rhs) : lhs.begin < rhs.begin;
+    });
+    // The repeat search can report runs contained in a longer run of the same period; these are not maximal
+    std::vector<std::uint32_t> max_ends(max_period + 1, 0);
+    result.erase(std::remove_if(std::begin(result), std::end(result), [&] (const Record& record) {
+        auto& max_end = max_ends[get_period(record)];
+        if (get_end(record) <= max_end) return true;
+        max_end = get_end(record);
+        return false;
+    }), std::end(result));
+    return result;
+}
+
+struct ContigTableEntry
+{
+    GenomicRegion::ContigName contig;
+    std::uint64_t size, record_offset, num_records, block_offset, num_blocks;
+};
+
+std::string make_contig_table(const ReferenceGenome& reference, const unsigned max_period,
+                              const std::vector<ContigTableEntry>& entries)
+{
+    using mapped_file::write_value;
+    std::ostringstream result {std::ios::binary};
+    write_value(result, std::uint32_t {max_period});
+    mapped_file::write_string(result, reference.name());
+    write_value(result, std::uint64_t {entries.size()});
+    for (const auto& entry : entries) {
+        mapped_file::write_string(result, entry.contig);
+        write_value(result, entry.size);
+        write_value(result, entry.record_offset);
+        write_value(result, entry.num_records);
+        write_value(result, entry.block_offset);
+        write_value(result, entry.num_blocks);
+    }
+    return result.str();
+}
+
+std::size_t write_tandem_repeat_index(const ReferenceGenome& reference, const TandemRepeatIndex::Path& path,
+                                      const unsigned max_period, const unsigned max_threads)
+{
+    std::ofstream out {path.string(), std::ios::binary};
+    if (!out) throw UnwritableRepeatIndex {path};
+    mapped_file::write_header(out, magic, version);
+    const auto contigs = reference.contig_names();
+    std::vector<ContigTableEntry> table {};
+    table.reserve(contigs.size());
+    ThreadPool workers {std::max(max_threads, 1u)};
+    std::deque<std::future<std::vector<Record>>> pending {};
+    auto next_contig = std::cbegin(contigs);
+    const auto fill_pending = [&] () {
+        // Bound the number of contigs held in memory while waiting to be written in order
+        for (; next_contig != std::cend(contigs) && pending.size() < std::max(max_threads, 1u); ++next_contig) {
+            pending.push_back(workers.push(find_contig_repeats, std::cref(reference), *next_contig, max_period));
+        }
+    };
+    fill_pending();
+    std::size_t result {0};
+    for (const auto& contig : contigs) {
+        const auto records = pending.front().get();
+        pending.pop_front();
+        fill_pending();
+        const auto block_ends = mapped_file::make_block_ends(records, block_size, get_end);
+        mapped_file::pad_to_alignment(out, 8);
+        ContigTableEntry entry {contig, reference.contig_size(contig), static_cast<std::uint64_t>(out.tellp()),
+                                records.size(), 0, block_ends.size()};
+        mapped_file::write_array(out, records);
+        entry.block_offset = static_cast<std::uint64_t>(out.tellp());
+        mapped_file::write_array(out, block_ends);
+        result += records.size();
+        table.push_back(std::move(entry));
+    }
+    mapped_file::write_table(out, make_contig_table(reference, max_period, table));
+    out.close();
+    if (!out) throw UnwritableRepeatIndex {path};
+    return result;
+}
+
+} // namespace
+
+void build_tandem_repeat_index(const ReferenceGenome& reference, const TandemRepeatIndex::Path& index_path,
+                               const unsigned max_period, const unsigned max_threads)
+{
+    if (max_period == 0 || max_period > 0xFF) throw std::invalid_argument {"build_tandem_repeat_index: bad max_period"};
+    // Write to a unique temporary and rename so concurrent builds never interleave or expose a partial index
+    const auto tmp_path = mapped_file::make_temp_path(index_path);
+    std::size_t num_repeats {};
+    try {
+        num_repeats = write_tandem_repeat_index(reference, tmp_path, max_period, max_threads);
+        fs::rename(tmp_path, index_path);
+    } catch (...) {
+        boost::system::error_code ec {};
+        fs::remove(tmp_path, ec);
+        throw;
+    }
+    logging::InfoLogger info_log {};
+    stream(info_log) << "Indexed " << num_repeats << " tandem repeats with period <= " << max_period << " in " << index_path;
+}
+
+} // namespace octopus
@@ -0,0 +1,99 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#ifndef tandem_repeat_index_hpp
+#define tandem_repeat_index_hpp
+
+#include <vector>
+#include <string>
+#include <unordered_map>
+#include <cstdint>
+#include <cstddef>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/iostreams/device/mapped_file.hpp>
+
+#include "basics/genomic_region.hpp"
+#include "basics/tandem_repeat.hpp"
+
+namespace octopus {
+
+class ReferenceGenome;
+
+/*
+ TandemRepeatIndex is a memory-mapped catalogue of all exact tandem repeats in a reference genome
+ up to some maximum period. Repeats are stored per contig sorted by begin position, along with the
+ running maximum end position of every block of repeats, so overlap queries are a binary search
+ followed by a short scan.
+
+ Queries clip indexed repeats to the query region, discarding any that no longer span two periods.
+ As repeats are found with the whole contig as context, repeats crossing the query region boundaries
+ are reported where find_exact_tandem_repeats on the region sequence alone may miss or shorten them.
+ The index is immutable once opened so queries can be made concurrently without locking.
+
+ The index records the name and contig lengths of the reference it was built from; opening it with
+ a reference checks these match.
+ */
+class TandemRepeatIndex
+{
+public:
+    using Path = boost::filesystem::path;
+    using GeneticSequence = std::string;
+
+    TandemRepeatIndex() = delete;
+
+    TandemRepeatIndex(Path index_path);
+    TandemRepeatIndex(Path index_path, const ReferenceGenome& reference);
+
+    TandemRepeatIndex(const TandemRepeatIndex&)            = delete;
+    TandemRepeatIndex& operator=(const TandemRepeatIndex&) = delete;
+    TandemRepeatIndex(TandemRepeatIndex&&)                 = default;
+    TandemRepeatIndex& operator=(TandemRepeatIndex&&)      = default;
+
+    ~TandemRepeatIndex() = default;
+
+    const Path& path() const noexcept;
+
+    const std::string& reference_name() const noexcept;
+
+    unsigned max_period() const noexcept;
+
+    bool has_contig(const GenomicRegion::ContigName& contig) const noexcept;
+
+    std::size_t count_repeats(const GenomicRegion::ContigName& contig) const noexcept;
+
+    // region_sequence must be the reference sequence of region; it is used for the repeat motifs
+    std::vector<TandemRepeat>
+    find(const GenomicRegion& region, const GeneticSequence& region_sequence, unsigned max_period) const;
+
+    struct Record
+    {
+        std::uint32_t begin, length_and_period;
+    };
+
+private:
+    struct ContigEntry
+    {
+        std::uint64_t size;
+        const Record* records;
+        std::size_t num_records;
+        const std::uint32_t* block_ends;
+        std::size_t num_blocks;
+    };
+
+    Path path_;
+    boost::iostreams::mapped_file_source file_;
+    std::string reference_name_;
+    unsigned max_period_;
+    std::unordered_map<GenomicRegion::ContigName, ContigEntry> contigs_;
+
+    void load_contig_table();
+};
+
+// The index is written to a temporary file in the same directory and renamed into place when complete
+void build_tandem_repeat_index(const ReferenceGenome& reference, const TandemRepeatIndex::Path& index_path,
+                               unsigned max_period = 20, unsigned max_threads = 1);
+
+} // namespace octopus
+
+#endif
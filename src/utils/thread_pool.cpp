@@ -3,6 +3,9 @@
 
 #include "thread_pool.hpp"
 
+#include <algorithm>
+#include <iterator>
+
 namespace octopus {
 
 ThreadPool::ThreadPool() : ThreadPool {0} {}
@@ -58,6 +61,12 @@ std::size_t ThreadPool::n_idle() const noexcept
     return n_idle_;
 }
 
+bool ThreadPool::is_worker_thread() const noexcept
+{
+    const auto id = std::this_thread::get_id();
+    return std::any_of(std::cbegin(workers_), std::cend(workers_), [id] (const auto& worker) { return worker.get_id() == id; });
+}
+
 void ThreadPool::clear() noexcept
 {
     std::lock_guard<std::mutex> lk {mutex_};
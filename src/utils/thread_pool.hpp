@@ -38,6 +38,8 @@ public:
     std::size_t size() const noexcept;
     bool empty() const noexcept;
     std::size_t n_idle() const noexcept;
+    // True if called from one of this pool's worker threads
+    bool is_worker_thread() const noexcept;
     
     void clear() noexcept;
     
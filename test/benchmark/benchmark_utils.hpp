@@ -11,14 +11,14 @@ D benchmark(F f, unsigned num_tests)
 {
     D total {0};
     
-    for (; num_tests > 0; --num_tests) {
-        const auto start = std::chrono::system_clock::now();
+    for (unsigned i {0}; i < num_tests; ++i) {
+        const auto start = std::chrono::steady_clock::now();
         f();
-        const auto end = std::chrono::system_clock::now();
+        const auto end = std::chrono::steady_clock::now();
         total += std::chrono::duration_cast<D>(end - start);
     }
     
-    return D {total / num_tests};
+    return D {num_tests > 0 ? total / num_tests : total};
 }
 
 #endif
@@ -0,0 +1,51 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+// Measures the per-task cost of setting up a Caller, either by building a new one for every task
+// (CallerFactory::make) or by checking a warm one out of a CallerCache.
+//
+// Usage: caller_setup_benchmark <num_tasks> <octopus options...>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+#include "config/option_parser.hpp"
+#include "config/option_collation.hpp"
+#include "core/calling_components.hpp"
+#include "core/callers/caller_factory.hpp"
+#include "core/callers/caller_cache.hpp"
+
+#include "benchmark/benchmark_utils.hpp"
+
+using namespace octopus;
+
+int main(const int argc, const char** argv)
+{
+    if (argc < 3) {
+        std::cerr << "Usage: " << argv[0] << " <num_tasks> <octopus options...>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const auto num_tasks = static_cast<unsigned>(std::stoul(argv[1]));
+    std::vector<const char*> octopus_argv {argv[0]};
+    octopus_argv.insert(std::cend(octopus_argv), argv + 2, argv + argc);
+    const auto options = options::parse_options(static_cast<int>(octopus_argv.size()), octopus_argv.data());
+    auto components = collate_genome_calling_components(options);
+    if (components.contigs().empty()) {
+        std::cerr << "No contigs to call" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const auto& contig = components.contigs().front();
+    const auto& factory = components.caller_factory();
+    const auto rebuild_duration = benchmark<std::chrono::microseconds>([&] () { factory.make(contig); }, num_tasks);
+    CallerCache callers {factory, 1};
+    const auto reuse_duration = benchmark<std::chrono::microseconds>([&] () {
+        callers.release(contig, callers.acquire(contig));
+    }, num_tasks);
+    std::cout << "setup\tmean_task_setup_us" << std::endl;
+    std::cout << "rebuild\t" << rebuild_duration.count() << std::endl;
+    std::cout << "reuse\t" << reuse_duration.count() << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,186 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+// Measures k-mer hashing, haplotype table population, and read mapping with the kmer_mapper
+// utilities against the previous per-window hashing and vector-of-bins table, on random
+// haplotypes and reads sampled from them with substitution errors. Read mapping is measured both
+// per haplotype and with a single multi-haplotype table.
+//
+// Usage: kmer_mapper_benchmark <num_haplotypes> <haplotype_length> <num_reads> <read_length>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <numeric>
+#include <cstdlib>
+
+#include "utils/kmer_mapper.hpp"
+
+#include "benchmark/benchmark_utils.hpp"
+
+using namespace octopus;
+
+namespace {
+
+constexpr unsigned char K {6};
+
+namespace legacy {
+
+template <unsigned char K, typename InputIt>
+auto kmer_hash(InputIt first)
+{
+    unsigned k {1};
+    return std::accumulate(first, std::next(first, K), KmerHashType {0},
+                           [&k] (const unsigned curr, const char base) {
+                               const auto result = curr + k * perfect_hash(base);
+                               k *= 4;
+                               return result;
+                           });
+}
+
+template <unsigned char K>
+auto compute_kmer_hashes(const std::string& sequence)
+{
+    if (sequence.size() < K) return KmerPerfectHashes {};
+    KmerPerfectHashes result(sequence.size() - K + 1);
+    auto result_it = std::begin(result);
+    for (auto it = std::cbegin(sequence); it != std::prev(std::cend(sequence), K - 1); ++it, ++result_it) {
+        *result_it = kmer_hash<K>(it);
+    }
+    return result;
+}
+
+using Table = std::vector<std::vector<std::size_t>>;
+
+template <unsigned char K>
+void populate(const std::string& sequence, Table& result)
+{
+    for (auto& bin : result) bin.clear();
+    auto it = std::cbegin(sequence);
+    for (std::size_t index {0}; index + K <= sequence.size(); ++index, ++it) {
+        result[kmer_hash<K>(it)].push_back(index);
+    }
+    for (auto& bin : result) bin.shrink_to_fit();
+}
+
+} // namespace legacy
+
+auto make_haplotypes(const unsigned n, const std::size_t length, std::mt19937& generator)
+{
+    static const std::string bases {"ACGT"};
+    std::uniform_int_distribution<std::size_t> base_dist {0, 3};
+    std::vector<std::string> result(n, std::string(length, 'A'));
+    for (auto& base : result.front()) base = bases[base_dist(generator)];
+    std::uniform_int_distribution<std::size_t> pos_dist {0, length - 1};
+    for (unsigned i {1}; i < n; ++i) {
+        result[i] = result.front();
+        for (int j {0}; j < 5; ++j) result[i][pos_dist(generator)] = bases[base_dist(generator)];
+    }
+    return result;
+}
+
+auto make_reads(const std::vector<std::string>& haplotypes, const unsigned n, const std::size_t length, std::mt19937& generator)
+{
+    static const std::string bases {"ACGT"};
+    std::uniform_int_distribution<std::size_t> haplotype_dist {0, haplotypes.size() - 1}, base_dist {0, 3};
+    std::uniform_int_distribution<std::size_t> offset_dist {0, haplotypes.front().size() - length}, error_dist {0, 99};
+    std::vector<std::string> result {};
+    result.reserve(n);
+    for (unsigned i {0}; i < n; ++i) {
+        auto read = haplotypes[haplotype_dist(generator)].substr(offset_dist(generator), length);
+        for (auto& base : read) if (error_dist(generator) == 0) base = bases[base_dist(generator)];
+        result.push_back(std::move(read));
+    }
+    return result;
+}
+
+} // namespace
+
+int main(const int argc, const char** argv)
+{
+    if (argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <num_haplotypes> <haplotype_length> <num_reads> <read_length>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const auto num_haplotypes = static_cast<unsigned>(std::stoul(argv[1]));
+    const auto haplotype_length = std::stoul(argv[2]);
+    const auto num_reads = static_cast<unsigned>(std::stoul(argv[3]));
+    const auto read_length = std::stoul(argv[4]);
+    if (num_haplotypes == 0 || read_length < K || read_length > haplotype_length) {
+        std::cerr << "Reads must be at least " << int {K} << " and at most the haplotype length" << std::endl;
+        return EXIT_FAILURE;
+    }
+    std::mt19937 generator {42};
+    const auto haplotypes = make_haplotypes(num_haplotypes, haplotype_length, generator);
+    const auto reads = make_reads(haplotypes, num_reads, read_length, generator);
+    constexpr unsigned num_repeats {5};
+    std::size_t sink {0};
+    
+    const auto legacy_hash_time = benchmark<std::chrono::microseconds>([&] () {
+        for (const auto& read : reads) sink += legacy::compute_kmer_hashes<K>(read).back();
+    }, num_repeats);
+    KmerPerfectHashes hashes {};
+    const auto hash_time = benchmark<std::chrono::microseconds>([&] () {
+        for (const auto& read : reads) {
+            compute_kmer_hashes<K>(read, hashes);
+            sink += hashes.back();
+        }
+    }, num_repeats);
+    
+    legacy::Table legacy_table(num_kmers(K));
+    const auto legacy_populate_time = benchmark<std::chrono::microseconds>([&] () {
+        for (const auto& haplotype : haplotypes) legacy::populate<K>(haplotype, legacy_table);
+    }, num_repeats);
+    auto table = init_kmer_hash_table<K>();
+    const auto populate_time = benchmark<std::chrono::microseconds>([&] () {
+        for (const auto& haplotype : haplotypes) populate_kmer_hash_table<K>(haplotype, table);
+    }, num_repeats);
+    
+    std::vector<KmerPerfectHashes> read_hashes {};
+    read_hashes.reserve(reads.size());
+    for (const auto& read : reads) {
+        read_hashes.push_back(compute_kmer_hashes<K>(read));
+        if (read_hashes.back() != legacy::compute_kmer_hashes<K>(read)) {
+            std::cerr << "Hash mismatch for read " << read << std::endl;
+            return EXIT_FAILURE;
+        }
+    }
+    std::vector<std::size_t> mapping_positions {};
+    std::size_t num_mapped {0};
+    const auto map_time = benchmark<std::chrono::microseconds>([&] () {
+        for (const auto& haplotype : haplotypes) {
+            populate_kmer_hash_table<K>(haplotype, table);
+            auto mapping_counts = init_mapping_counts(table);
+            for (const auto& read_hash : read_hashes) {
+                mapping_positions.clear();
+                map_query_to_target(read_hash, table, mapping_counts, mapping_positions);
+                reset_mapping_counts(mapping_counts);
+                num_mapped += mapping_positions.size();
+            }
+        }
+    }, num_repeats);
+    
+    TargetSequenceRefs haplotype_refs {std::cbegin(haplotypes), std::cend(haplotypes)};
+    auto multi_table = init_multi_kmer_hash_table<K>();
+    std::size_t num_multi_mapped {0};
+    const auto multi_map_time = benchmark<std::chrono::microseconds>([&] () {
+        populate_kmer_hash_table<K>(haplotype_refs, multi_table);
+        auto mapping_counts = init_mapping_counts(multi_table);
+        for (const auto& read_hash : read_hashes) {
+            map_query_to_targets(read_hash, multi_table, mapping_counts,
+                                 [&] (std::size_t, auto first, auto last) { num_multi_mapped += std::distance(first, last); });
+        }
+    }, num_repeats);
+    if (num_multi_mapped != num_mapped) {
+        std::cerr << "Mapping mismatch: " << num_mapped << " positions per haplotype, " << num_multi_mapped << " jointly" << std::endl;
+        return EXIT_FAILURE;
+    }
+    
+    std::cout << "stage\tlegacy_us\tcurrent_us" << std::endl;
+    std::cout << "hash_reads\t" << legacy_hash_time.count() << '\t' << hash_time.count() << std::endl;
+    std::cout << "populate_haplotypes\t" << legacy_populate_time.count() << '\t' << populate_time.count() << std::endl;
+    std::cout << "map_reads\t" << map_time.count() << '\t' << multi_map_time.count() << std::endl;
+    return sink == 0 ? EXIT_FAILURE : EXIT_SUCCESS;
+}
@@ -0,0 +1,184 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+// Measures the Hardy-Weinberg EM used by PopulationModel to approximate genotype marginal
+// posteriors, comparing the flat sample x genotype kernels with the previous vector-of-vectors
+// implementation (per-haplotype inverse genotype table and per-genotype multinomial evaluation).
+// Synthetic cohorts of increasing size are simulated by sampling genotypes from random haplotype
+// frequencies and giving each sample log likelihoods that penalise haplotypes not in its genotype.
+//
+// Usage: population_em_benchmark <num_haplotypes> <ploidy> <max_samples>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <random>
+#include <chrono>
+#include <numeric>
+#include <algorithm>
+#include <limits>
+#include <cmath>
+#include <cstdlib>
+#include <thread>
+
+#include "core/types/genotype_space.hpp"
+#include "core/models/genotype/population_em.hpp"
+#include "utils/maths.hpp"
+#include "utils/thread_pool.hpp"
+
+#include "benchmark/benchmark_utils.hpp"
+
+using namespace octopus;
+using namespace octopus::model;
+
+namespace {
+
+using GenotypeList = std::vector<GenotypeSpace::ElementIndexVector>;
+using Matrix = std::vector<std::vector<double>>;
+
+namespace legacy {
+
+using InverseGenotypeTable = std::vector<std::vector<std::size_t>>;
+
+auto make_inverse_genotype_table(const GenotypeList& genotypes, const std::size_t num_haplotypes)
+{
+    InverseGenotypeTable result(num_haplotypes);
+    for (std::size_t genotype_idx {0}; genotype_idx < genotypes.size(); ++genotype_idx) {
+        for (const auto haplotype : genotypes[genotype_idx]) result[haplotype].push_back(genotype_idx);
+    }
+    for (auto& indices : result) {
+        indices.erase(std::unique(std::begin(indices), std::end(indices)), std::end(indices));
+    }
+    return result;
+}
+
+double evaluate(const GenotypeSpace::ElementIndexVector& genotype, const std::vector<double>& frequencies)
+{
+    std::vector<unsigned> counts(frequencies.size());
+    for (const auto haplotype : genotype) ++counts[haplotype];
+    return maths::log_multinomial_pdf<>(counts, frequencies);
+}
+
+Matrix compute_approx_genotype_marginal_posteriors(const GenotypeList& genotypes, const std::size_t num_haplotypes,
+                                                   const Matrix& genotype_log_likelihoods, const double frequency_update_norm,
+                                                   const PopulationEMOptions& options)
+{
+    const auto inverse_genotypes = make_inverse_genotype_table(genotypes, num_haplotypes);
+    std::vector<double> frequencies(num_haplotypes, 1.0 / num_haplotypes), log_marginals(genotypes.size());
+    const auto update_posteriors = [&] (Matrix& posteriors) {
+        for (std::size_t g {0}; g < genotypes.size(); ++g) log_marginals[g] = evaluate(genotypes[g], frequencies);
+        for (std::size_t s {0}; s < posteriors.size(); ++s) {
+            std::transform(std::cbegin(log_marginals), std::cend(log_marginals), std::cbegin(genotype_log_likelihoods[s]),
+                           std::begin(posteriors[s]), std::plus<> {});
+            maths::normalise_exp(posteriors[s]);
+        }
+    };
+    Matrix result(genotype_log_likelihoods.size(), std::vector<double>(genotypes.size()));
+    update_posteriors(result);
+    for (unsigned n {1}; n <= options.max_iterations; ++n) {
+        std::vector<double> collapsed(genotypes.size());
+        for (const auto& posteriors : result) {
+            std::transform(std::cbegin(collapsed), std::cend(collapsed), std::cbegin(posteriors), std::begin(collapsed), std::plus<> {});
+        }
+        double max_change {0};
+        for (std::size_t h {0}; h < num_haplotypes; ++h) {
+            double new_frequency {0};
+            for (const auto g : inverse_genotypes[h]) new_frequency += collapsed[g];
+            new_frequency /= frequency_update_norm;
+            max_change = std::max(std::abs(frequencies[h] - new_frequency), max_change);
+            frequencies[h] = std::max(new_frequency, std::numeric_limits<double>::min());
+        }
+        update_posteriors(result);
+        if (max_change <= options.epsilon) break;
+    }
+    return result;
+}
+
+} // namespace legacy
+
+auto simulate_log_likelihoods(const GenotypeList& genotypes, const std::size_t num_haplotypes,
+                              const std::size_t num_samples, std::mt19937& generator)
+{
+    std::vector<double> frequencies(num_haplotypes);
+    std::gamma_distribution<double> frequency_dist {0.5, 1.0};
+    std::generate(std::begin(frequencies), std::end(frequencies), [&] () { return frequency_dist(generator); });
+    std::discrete_distribution<unsigned> haplotype_dist {std::cbegin(frequencies), std::cend(frequencies)};
+    std::normal_distribution<double> noise_dist {0.0, 2.0};
+    const auto ploidy = genotypes.front().size();
+    Matrix result(num_samples, std::vector<double>(genotypes.size()));
+    std::vector<unsigned> true_genotype(ploidy), true_counts(num_haplotypes);
+    for (auto& log_likelihoods : result) {
+        std::generate(std::begin(true_genotype), std::end(true_genotype), [&] () { return haplotype_dist(generator); });
+        std::fill(std::begin(true_counts), std::end(true_counts), 0u);
+        for (const auto haplotype : true_genotype) ++true_counts[haplotype];
+        for (std::size_t g {0}; g < genotypes.size(); ++g) {
+            double mismatches {0};
+            for (const auto haplotype : genotypes[g]) mismatches += true_counts[haplotype] == 0;
+            log_likelihoods[g] = -10.0 * mismatches + noise_dist(generator);
+        }
+    }
+    return result;
+}
+
+auto to_sample_genotype_matrix(const Matrix& values)
+{
+    SampleGenotypeMatrix result {values.size(), values.front().size()};
+    for (std::size_t s {0}; s < values.size(); ++s) std::copy(std::cbegin(values[s]), std::cend(values[s]), result[s]);
+    return result;
+}
+
+double max_absolute_difference(const Matrix& lhs, const SampleGenotypeMatrix& rhs)
+{
+    double result {0};
+    for (std::size_t s {0}; s < lhs.size(); ++s) {
+        for (std::size_t g {0}; g < lhs[s].size(); ++g) result = std::max(std::abs(lhs[s][g] - rhs[s][g]), result);
+    }
+    return result;
+}
+
+} // namespace
+
+int main(const int argc, const char** argv)
+{
+    if (argc != 4) {
+        std::cerr << "Usage: " << argv[0] << " <num_haplotypes> <ploidy> <max_samples>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const auto num_haplotypes = static_cast<unsigned>(std::stoul(argv[1]));
+    const auto ploidy = static_cast<unsigned>(std::stoul(argv[2]));
+    const auto max_samples = std::stoul(argv[3]);
+    if (num_haplotypes < 2 || ploidy == 0 || max_samples == 0) {
+        std::cerr << "There must be at least two haplotypes, and a positive ploidy and number of samples" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const GenotypeSpace space {num_haplotypes, ploidy};
+    const GenotypeList genotypes(std::cbegin(space), std::cend(space));
+    const GenotypeHaplotypeIncidence incidence {space};
+    std::mt19937 generator {42};
+    constexpr unsigned num_repeats {3};
+    PopulationEMOptions options {};
+    ThreadPool workers {std::max(std::thread::hardware_concurrency(), 2u)};
+    std::cout << "num_samples\tnum_genotypes\tlegacy_us\tflat_us\tflat_parallel_us\tmax_difference" << std::endl;
+    for (std::size_t num_samples {10}; num_samples <= max_samples; num_samples *= 2) {
+        const auto log_likelihoods = simulate_log_likelihoods(genotypes, num_haplotypes, num_samples, generator);
+        const auto flat_log_likelihoods = to_sample_genotype_matrix(log_likelihoods);
+        const auto frequency_update_norm = static_cast<double>(num_samples) * ploidy;
+        Matrix legacy_posteriors {};
+        SampleGenotypeMatrix posteriors {};
+        options.workers = boost::none;
+        const auto legacy_time = benchmark<std::chrono::microseconds>([&] () {
+            legacy_posteriors = legacy::compute_approx_genotype_marginal_posteriors(genotypes, num_haplotypes, log_likelihoods,
+                                                                                    frequency_update_norm, options);
+        }, num_repeats);
+        const auto flat_time = benchmark<std::chrono::microseconds>([&] () {
+            posteriors = compute_approx_genotype_marginal_posteriors(incidence, flat_log_likelihoods, frequency_update_norm, options);
+        }, num_repeats);
+        options.workers = workers;
+        const auto parallel_time = benchmark<std::chrono::microseconds>([&] () {
+            posteriors = compute_approx_genotype_marginal_posteriors(incidence, flat_log_likelihoods, frequency_update_norm, options);
+        }, num_repeats);
+        std::cout << num_samples << '\t' << genotypes.size() << '\t' << legacy_time.count() << '\t' << flat_time.count()
+                  << '\t' << parallel_time.count() << '\t' << max_absolute_difference(legacy_posteriors, posteriors) << std::endl;
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,51 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+// Measures ReadPipe::fetch_reads latency as the number of samples (one per read file) increases,
+// with and without concurrent batch fetching.
+//
+// Usage: read_pipe_benchmark <reference.fa> <region> <num_threads> <reads1.bam> [reads2.bam ...]
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <cstdlib>
+
+#include <boost/filesystem/path.hpp>
+
+#include "io/reference/reference_genome.hpp"
+#include "io/region/region_parser.hpp"
+#include "io/read/read_manager.hpp"
+#include "readpipe/read_pipe.hpp"
+
+#include "benchmark/benchmark_utils.hpp"
+
+using namespace octopus;
+
+int main(const int argc, const char** argv)
+{
+    if (argc < 5) {
+        std::cerr << "Usage: " << argv[0] << " <reference.fa> <region> <num_threads> <reads1.bam> [reads2.bam ...]" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const auto reference = make_reference(argv[1], 0, true);
+    const auto region = io::parse_region(argv[2], reference);
+    const auto max_threads = static_cast<unsigned>(std::stoul(argv[3]));
+    const std::vector<boost::filesystem::path> read_paths(argv + 4, argv + argc);
+    constexpr unsigned num_repeats {5};
+    std::cout << "num_samples\tthreads\tmean_fetch_ms" << std::endl;
+    for (std::size_t num_files {1}; num_files <= read_paths.size(); ++num_files) {
+        const std::vector<boost::filesystem::path> paths(read_paths.cbegin(), std::next(read_paths.cbegin(), num_files));
+        ReadManager source {paths, static_cast<unsigned>(num_files)};
+        for (const unsigned num_threads : {1u, max_threads}) {
+            ReadPipe pipe {source, source.samples()};
+            pipe.set_max_fetch_threads(num_threads);
+            pipe.fetch_reads(region); // warm file caches
+            const auto duration = benchmark<std::chrono::milliseconds>([&] () { pipe.fetch_reads(region); }, num_repeats);
+            std::cout << source.num_samples() << '\t' << num_threads << '\t' << duration.count() << std::endl;
+            if (max_threads == 1) break;
+        }
+    }
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,81 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+// Measures source candidate lookup throughput over consecutive calling windows of a region, fetching
+// candidates from the indexed VCF/BCF directly and from a SourceCandidateStore built from it.
+//
+// Usage: source_candidate_benchmark <reference.fa> <candidates.vcf.gz> <region> <window_size>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <cstdlib>
+
+#include <boost/filesystem/path.hpp>
+
+#include "io/reference/reference_genome.hpp"
+#include "io/region/region_parser.hpp"
+#include "io/variant/vcf_reader.hpp"
+#include "io/variant/source_candidate_store.hpp"
+#include "core/tools/vargen/variant_generator.hpp"
+#include "core/tools/vargen/vcf_extractor.hpp"
+
+#include "benchmark/benchmark_utils.hpp"
+
+using namespace octopus;
+
+namespace {
+
+auto make_windows(const GenomicRegion& region, const GenomicRegion::Size window_size)
+{
+    std::vector<GenomicRegion> result {};
+    for (auto begin = region.begin(); begin < region.end(); begin += window_size) {
+        result.emplace_back(region.contig_name(), begin, std::min(begin + window_size, region.end()));
+    }
+    return result;
+}
+
+std::size_t fetch_candidates(const VariantGenerator& generator, const std::vector<GenomicRegion>& windows)
+{
+    std::size_t result {0};
+    for (const auto& window : windows) {
+        result += generator.generate(window).size();
+    }
+    return result;
+}
+
+} // namespace
+
+int main(const int argc, const char** argv)
+{
+    if (argc != 5) {
+        std::cerr << "Usage: " << argv[0] << " <reference.fa> <candidates.vcf.gz> <region> <window_size>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    const auto reference = make_reference(argv[1], 0, true);
+    const boost::filesystem::path vcf_path {argv[2]};
+    const auto region = io::parse_region(argv[3], reference);
+    const auto windows = make_windows(region, std::stoul(argv[4]));
+    const auto store_path = make_source_candidate_store_path(vcf_path);
+    const auto build_time = benchmark<std::chrono::milliseconds>([&] () { build_source_candidate_store(vcf_path, store_path); }, 1);
+    VariantGenerator vcf_generator {}, store_generator {};
+    vcf_generator.add(std::make_unique<coretools::VcfExtractor>(std::make_unique<VcfReader>(vcf_path), coretools::VcfExtractor::Options {}));
+    store_generator.add(std::make_unique<coretools::VcfExtractor>(std::make_shared<const SourceCandidateStore>(store_path),
+                                                                  coretools::VcfExtractor::Options {}));
+    const auto num_vcf_candidates = fetch_candidates(vcf_generator, windows);
+    const auto num_store_candidates = fetch_candidates(store_generator, windows);
+    if (num_vcf_candidates != num_store_candidates) {
+        std::cerr << "Candidate mismatch: " << num_vcf_candidates << " from VCF, " << num_store_candidates << " from store" << std::endl;
+        return EXIT_FAILURE;
+    }
+    constexpr unsigned num_repeats {5};
+    const auto vcf_time = benchmark<std::chrono::milliseconds>([&] () { fetch_candidates(vcf_generator, windows); }, num_repeats);
+    const auto store_time = benchmark<std::chrono::milliseconds>([&] () { fetch_candidates(store_generator, windows); }, num_repeats);
+    std::cout << "source\twindows\tcandidates\tmean_lookup_ms" << std::endl;
+    std::cout << "vcf\t" << windows.size() << '\t' << num_vcf_candidates << '\t' << vcf_time.count() << std::endl;
+    std::cout << "store\t" << windows.size() << '\t' << num_store_candidates << '\t' << store_time.count() << std::endl;
+    std::cout << "store build time: " << build_time.count() << "ms" << std::endl;
+    return EXIT_SUCCESS;
+}
@@ -0,0 +1,168 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+// Measures VCF/BCF read throughput when every field of every record is decoded, as was done for all
+// records before fields were decoded lazily, against reading only the fields a threshold filter
+// (QUAL, GQ, DP) or VcfExtractor (QUAL, FILTER) use, and sites-only reads that also read INFO DP.
+// Also measures copying the records to a temporary BCF, writing the read records as they are
+// against decoding and re-encoding them first. Most useful on files with thousands of samples, which
+// can be simulated (with GT, GQ and DP for every sample) if no such file is to hand.
+//
+// Usage: vcf_read_benchmark <calls.vcf.gz> [contig]
+//        vcf_read_benchmark --simulate <num_samples> <num_records>
+
+#include <iostream>
+#include <vector>
+#include <string>
+#include <chrono>
+#include <random>
+#include <cstdlib>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "io/variant/vcf_reader.hpp"
+#include "io/variant/vcf_writer.hpp"
+#include "io/variant/vcf_header.hpp"
+#include "io/variant/vcf_record.hpp"
+#include "io/variant/vcf_spec.hpp"
+
+#include "benchmark/benchmark_utils.hpp"
+
+using namespace octopus;
+
+namespace {
+
+template <typename F>
+std::size_t read_records(const VcfReader& reader, const std::string& contig, const VcfReader::UnpackPolicy level, F f)
+{
+    std::size_t result {0};
+    auto p = contig.empty() ? reader.iterate(level) : reader.iterate(contig, level);
+    for (; p.first != p.second; ++p.first) {
+        f(*p.first);
+        ++result;
+    }
+    return result;
+}
+
+auto make_temp_path()
+{
+    return boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("%%%%-%%%%-%%%%.bcf");
+}
+
+void remove_bcf(const boost::filesystem::path& path)
+{
+    boost::system::error_code ec {};
+    boost::filesystem::remove(path, ec);
+    boost::filesystem::remove(path.string() + ".csi", ec);
+}
+
+void simulate_calls(const boost::filesystem::path& path, const unsigned num_samples, const unsigned num_records)
+{
+    using namespace vcfspec;
+    VcfHeader::Builder header {};
+    header.add_contig("1");
+    header.add_info(info::combinedReadDepth, "1", "Integer", "Combined depth across samples");
+    header.add_format(format::genotype, "1", "String", "Genotype");
+    header.add_format(format::conditionalQuality, "1", "Integer", "Conditional genotype quality");
+    header.add_format(format::combinedReadDepth, "1", "Integer", "Read depth");
+    std::vector<std::string> samples(num_samples);
+    for (unsigned s {0}; s < num_samples; ++s) samples[s] = "S" + std::to_string(s);
+    header.set_samples(samples);
+    VcfWriter writer {path, header.build_once()};
+    std::mt19937 generator {42};
+    std::uniform_int_distribution<int> alt_count_dist {0, 2}, gq_dist {0, 99}, dp_dist {0, 60};
+    for (unsigned i {0}; i < num_records; ++i) {
+        VcfRecord::Builder record {};
+        record.set_chrom("1").set_pos(100 + 10 * i).set_ref("A").set_alt("C").set_qual(gq_dist(generator)).set_passed();
+        record.set_format({format::genotype, format::conditionalQuality, format::combinedReadDepth});
+        int total_depth {0};
+        for (const auto& sample : samples) {
+            const auto alt_count = alt_count_dist(generator);
+            const std::vector<std::string> alleles {alt_count == 2 ? "C" : "A", alt_count > 0 ? "C" : "A"};
+            const auto depth = dp_dist(generator);
+            record.set_genotype(sample, alleles, VcfRecord::Builder::Phasing::unphased);
+            record.set_format(sample, format::conditionalQuality, gq_dist(generator));
+            record.set_format(sample, format::combinedReadDepth, depth);
+            total_depth += depth;
+        }
+        record.set_info(info::combinedReadDepth, total_depth);
+        writer << record.build_once();
+    }
+}
+
+} // namespace
+
+int main(const int argc, const char** argv)
+{
+    const bool simulate {argc == 4 && std::string {argv[1]} == "--simulate"};
+    if (!simulate && (argc < 2 || argc > 3)) {
+        std::cerr << "Usage: " << argv[0] << " <calls.vcf.gz> [contig]" << std::endl;
+        std::cerr << "       " << argv[0] << " --simulate <num_samples> <num_records>" << std::endl;
+        return EXIT_FAILURE;
+    }
+    boost::filesystem::path calls_path {argv[1]};
+    if (simulate) {
+        calls_path = make_temp_path();
+        simulate_calls(calls_path, std::stoul(argv[2]), std::stoul(argv[3]));
+    }
+    const VcfReader reader {calls_path};
+    const std::string contig {!simulate && argc == 3 ? argv[2] : ""};
+    const auto samples = reader.fetch_header().samples();
+    std::size_t num_records {0};
+    double checksum {0};
+    const auto decode_all = [&] (const VcfRecord& record) {
+        const auto decoded = VcfRecord::Builder {record}.build_once();
+        checksum += decoded.num_samples();
+    };
+    const auto filter_fields = [&] (const VcfRecord& record) {
+        if (record.qual()) checksum += *record.qual();
+        for (const auto& sample : samples) {
+            const auto gq = record.sample_number(sample, vcfspec::format::conditionalQuality);
+            const auto dp = record.sample_number(sample, vcfspec::format::combinedReadDepth);
+            if (gq) checksum += *gq;
+            if (dp) checksum += *dp;
+        }
+    };
+    const auto site_fields = [&] (const VcfRecord& record) {
+        if (!is_filtered(record) && record.qual()) checksum += *record.qual();
+    };
+    const auto site_info_fields = [&] (const VcfRecord& record) {
+        const auto dp = record.info_number(vcfspec::info::combinedReadDepth);
+        if (dp) checksum += *dp;
+    };
+    const auto header = reader.fetch_header();
+    const auto copy_path = make_temp_path();
+    const auto copy_records = [&] (const bool decode) {
+        VcfWriter writer {copy_path, header};
+        read_records(reader, contig, VcfReader::UnpackPolicy::all, [&] (const VcfRecord& record) {
+            if (decode) {
+                writer << VcfRecord::Builder {record}.build_once();
+            } else {
+                writer << record;
+            }
+        });
+    };
+    constexpr unsigned num_repeats {3};
+    const auto all_time = benchmark<std::chrono::milliseconds>([&] () {
+        num_records = read_records(reader, contig, VcfReader::UnpackPolicy::all, decode_all); }, num_repeats);
+    const auto filter_time = benchmark<std::chrono::milliseconds>([&] () {
+        read_records(reader, contig, VcfReader::UnpackPolicy::all, filter_fields); }, num_repeats);
+    const auto sites_time = benchmark<std::chrono::milliseconds>([&] () {
+        read_records(reader, contig, VcfReader::UnpackPolicy::sites, site_fields); }, num_repeats);
+    const auto sites_info_time = benchmark<std::chrono::milliseconds>([&] () {
+        read_records(reader, contig, VcfReader::UnpackPolicy::sites, site_info_fields); }, num_repeats);
+    const auto copy_time = benchmark<std::chrono::milliseconds>([&] () { copy_records(false); }, num_repeats);
+    const auto decoded_copy_time = benchmark<std::chrono::milliseconds>([&] () { copy_records(true); }, num_repeats);
+    remove_bcf(copy_path);
+    if (simulate) remove_bcf(calls_path);
+    std::cout << "records: " << num_records << ", samples: " << samples.size() << " (checksum " << checksum << ")" << std::endl;
+    std::cout << "fields\tmean_read_ms" << std::endl;
+    std::cout << "all\t" << all_time.count() << std::endl;
+    std::cout << "QUAL,GQ,DP\t" << filter_time.count() << std::endl;
+    std::cout << "QUAL,FILTER\t" << sites_time.count() << std::endl;
+    std::cout << "INFO/DP\t" << sites_info_time.count() << std::endl;
+    std::cout << "copy\t" << copy_time.count() << std::endl;
+    std::cout << "decoded_copy\t" << decoded_copy_time.count() << std::endl;
+    return EXIT_SUCCESS;
+}
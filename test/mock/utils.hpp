@@ -6,6 +6,9 @@
 
 #include <string>
 
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+
 #include "io/reference/reference_genome.hpp"
 #include "core/types/allele.hpp"
 #include "core/types/variant.hpp"
@@ -33,6 +36,57 @@ Genotype<Haplotype> make_genotype(const std::string& str, const GenomicRegion& r
 Genotype<Haplotype> make_genotype(const std::string& str, const std::string& region,
                                   const ReferenceGenome& reference);
 
+// A uniquely named path in the system temporary directory. The file, and any index written
+// alongside it, is removed on destruction.
+class TempFile
+{
+public:
+    TempFile(const std::string& extension = "")
+    : path_ {boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("octopus-%%%%-%%%%-%%%%" + extension)}
+    {}
+    
+    TempFile(const TempFile&)            = delete;
+    TempFile& operator=(const TempFile&) = delete;
+    
+    ~TempFile()
+    {
+        boost::system::error_code ec {};
+        boost::filesystem::remove(path_, ec);
+        boost::filesystem::remove(path_.string() + ".csi", ec);
+        boost::filesystem::remove(path_.string() + ".tbi", ec);
+    }
+    
+    const boost::filesystem::path& path() const noexcept { return path_; }
+    
+private:
+    boost::filesystem::path path_;
+};
+
+// A uniquely named directory in the system temporary directory, removed with its contents on destruction
+class TempDirectory
+{
+public:
+    TempDirectory()
+    : path_ {boost::filesystem::temp_directory_path() / boost::filesystem::unique_path("octopus-%%%%-%%%%-%%%%")}
+    {
+        boost::filesystem::create_directories(path_);
+    }
+    
+    TempDirectory(const TempDirectory&)            = delete;
+    TempDirectory& operator=(const TempDirectory&) = delete;
+    
+    ~TempDirectory()
+    {
+        boost::system::error_code ec {};
+        boost::filesystem::remove_all(path_, ec);
+    }
+    
+    const boost::filesystem::path& path() const noexcept { return path_; }
+    
+private:
+    boost::filesystem::path path_;
+};
+
 } // namespace debug
 } // namespace octopus
 
@@ -0,0 +1,66 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <unordered_set>
+
+#include "core/contig_completion_tracker.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(contig_completion_tracker)
+
+using ContigSet = std::unordered_set<std::string>;
+using ContigList = std::vector<std::string>;
+
+namespace {
+
+auto pop_finished(ContigCompletionTracker& tracker, const ContigSet& finished)
+{
+    return tracker.pop_finished([&] (const auto& contig) { return finished.count(contig) == 1; });
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(contigs_without_tasks_are_reported_without_any_task_completing)
+{
+    ContigCompletionTracker tracker {{"1", "2", "3"}};
+    // Contig 2 has no tasks so is marked finished by the task maker as soon as it is reached
+    BOOST_CHECK(pop_finished(tracker, {}).empty());
+    BOOST_CHECK(pop_finished(tracker, {"2"}) == ContigList {"2"});
+    BOOST_CHECK(!tracker.all_finished());
+    BOOST_CHECK(pop_finished(tracker, {"1", "2", "3"}) == (ContigList {"1", "3"}));
+    BOOST_CHECK(tracker.all_finished());
+}
+
+BOOST_AUTO_TEST_CASE(contigs_marked_finished_after_their_last_task_completes_are_reported)
+{
+    ContigCompletionTracker tracker {{"1", "2"}};
+    ContigSet finished {};
+    // The last task of contig 1 completes before the task maker marks contig 1 finished
+    BOOST_CHECK(pop_finished(tracker, finished).empty());
+    finished.insert("1");
+    BOOST_CHECK(pop_finished(tracker, finished) == ContigList {"1"});
+    // Contigs are only reported once
+    BOOST_CHECK(pop_finished(tracker, finished).empty());
+    finished.insert("2");
+    BOOST_CHECK(pop_finished(tracker, finished) == ContigList {"2"});
+    BOOST_CHECK(tracker.all_finished());
+}
+
+BOOST_AUTO_TEST_CASE(finished_contigs_are_reported_in_contig_order)
+{
+    ContigCompletionTracker tracker {{"3", "1", "X", "2"}};
+    BOOST_CHECK(pop_finished(tracker, {"2", "X", "3"}) == (ContigList {"3", "X", "2"}));
+    BOOST_CHECK(pop_finished(tracker, {"1"}) == ContigList {"1"});
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -0,0 +1,153 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <random>
+#include <limits>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "core/csr/filters/call_clusterer.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(csr)
+BOOST_AUTO_TEST_SUITE(call_clusterer)
+
+namespace fs = boost::filesystem;
+
+using octopus::csr::CallClusterer;
+
+namespace {
+
+auto make_spill_path()
+{
+    return fs::temp_directory_path() / fs::unique_path("octopus-clustering-%%%%-%%%%-%%%%.dat");
+}
+
+// num_minority rows are outliers, placed after the majority rows
+std::vector<std::vector<double>> make_rows(const std::size_t num_majority, const std::size_t num_minority)
+{
+    std::mt19937 generator {42};
+    std::normal_distribution<double> majority_dist {1000, 10}, minority_dist {100, 10};
+    std::vector<std::vector<double>> result {};
+    for (std::size_t i {0}; i < num_majority; ++i) {
+        result.push_back({majority_dist(generator), majority_dist(generator), majority_dist(generator)});
+    }
+    for (std::size_t i {0}; i < num_minority; ++i) {
+        result.push_back({minority_dist(generator), minority_dist(generator), minority_dist(generator)});
+    }
+    return result;
+}
+
+auto cluster(const std::vector<std::vector<double>>& rows, CallClusterer::Options options, std::size_t& num_spilled)
+{
+    const auto spill_path = make_spill_path();
+    CallClusterer clusterer {rows.front().size(), spill_path, options};
+    for (const auto& row : rows) clusterer.add_row(row);
+    clusterer.cluster();
+    num_spilled = clusterer.num_spilled_rows();
+    BOOST_CHECK(!fs::exists(spill_path));
+    std::vector<CallClusterer::Label> result(rows.size());
+    for (std::size_t i {0}; i < rows.size(); ++i) result[i] = clusterer.label(i);
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(minority_cluster_is_labelled_minority)
+{
+    const auto rows = make_rows(900, 100);
+    CallClusterer clusterer {3, make_spill_path(), {}};
+    for (const auto& row : rows) clusterer.add_row(row);
+    const auto counts = clusterer.cluster();
+    BOOST_CHECK_EQUAL(counts[0], 900);
+    BOOST_CHECK_EQUAL(counts[1], 100);
+    BOOST_CHECK_GE(clusterer.separation(), CallClusterer::Options {}.min_separation);
+    for (std::size_t i {0}; i < rows.size(); ++i) {
+        const auto expected = i < 900 ? CallClusterer::Label::majority : CallClusterer::Label::minority;
+        BOOST_REQUIRE(clusterer.label(i) == expected);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(spilled_rows_are_clustered_the_same_as_buffered_rows)
+{
+    const auto rows = make_rows(900, 100);
+    CallClusterer::Options buffered_options {}, spilled_options {};
+    spilled_options.max_buffered_rows = 2;
+    std::size_t num_buffered_spilled {}, num_spilled {};
+    const auto buffered_labels = cluster(rows, buffered_options, num_buffered_spilled);
+    const auto spilled_labels = cluster(rows, spilled_options, num_spilled);
+    BOOST_CHECK_EQUAL(num_buffered_spilled, 0);
+    BOOST_CHECK_EQUAL(num_spilled, rows.size());
+    BOOST_CHECK(spilled_labels == buffered_labels);
+}
+
+BOOST_AUTO_TEST_CASE(rows_with_missing_values_are_imputed_or_unclustered)
+{
+    const auto nan = std::numeric_limits<double>::quiet_NaN();
+    auto rows = make_rows(900, 100);
+    rows[0] = {nan, nan, nan};
+    rows[1][0] = nan;
+    rows[950] = {100, 100, nan};
+    CallClusterer clusterer {3, make_spill_path(), {}};
+    for (const auto& row : rows) clusterer.add_row(row);
+    const auto counts = clusterer.cluster();
+    BOOST_CHECK_EQUAL(counts[0] + counts[1], rows.size() - 1);
+    BOOST_CHECK(clusterer.label(0) == CallClusterer::Label::unclustered);
+    BOOST_CHECK(clusterer.label(1) == CallClusterer::Label::majority);
+    BOOST_CHECK(clusterer.label(950) == CallClusterer::Label::minority);
+}
+
+BOOST_AUTO_TEST_CASE(a_single_population_is_not_split)
+{
+    std::mt19937 generator {42};
+    std::normal_distribution<double> dist {1000, 10};
+    for (const std::size_t num_features : {1, 3}) {
+        CallClusterer clusterer {num_features, make_spill_path(), {}};
+        std::vector<double> row(num_features);
+        for (int i {0}; i < 1000; ++i) {
+            for (auto& value : row) value = dist(generator);
+            clusterer.add_row(row);
+        }
+        const auto counts = clusterer.cluster();
+        BOOST_CHECK_EQUAL(counts[0], 1000);
+        BOOST_CHECK_EQUAL(counts[1], 0);
+        BOOST_CHECK_LT(clusterer.separation(), CallClusterer::Options {}.min_separation);
+        for (std::size_t i {0}; i < 1000; ++i) {
+            BOOST_REQUIRE(clusterer.label(i) == CallClusterer::Label::majority);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(overlapping_clusters_are_not_split)
+{
+    std::mt19937 generator {42};
+    std::normal_distribution<double> majority_dist {1000, 10}, minority_dist {1020, 10};
+    CallClusterer clusterer {1, make_spill_path(), {}};
+    for (int i {0}; i < 900; ++i) clusterer.add_row({majority_dist(generator)});
+    for (int i {0}; i < 100; ++i) clusterer.add_row({minority_dist(generator)});
+    const auto counts = clusterer.cluster();
+    BOOST_CHECK_EQUAL(counts[1], 0);
+}
+
+BOOST_AUTO_TEST_CASE(constant_features_are_not_clustered)
+{
+    CallClusterer clusterer {2, make_spill_path(), {}};
+    for (int i {0}; i < 100; ++i) clusterer.add_row({1e9, 5});
+    const auto counts = clusterer.cluster();
+    BOOST_CHECK_EQUAL(counts[0], 100);
+    BOOST_CHECK_EQUAL(counts[1], 0);
+    BOOST_CHECK(clusterer.label(0) == CallClusterer::Label::majority);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
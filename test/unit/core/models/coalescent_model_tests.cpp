@@ -1,4 +1,74 @@
 // Copyright (c) 2017 Daniel Cooke
 // Use of this source code is governed by the MIT license that can be found in the LICENSE file.
 
-#include <stdio.h>
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+
+#include "core/models/mutation/coalescent_model.hpp"
+#include "utils/maths.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(models)
+BOOST_AUTO_TEST_SUITE(coalescent_model)
+
+namespace {
+
+constexpr double snpHeterozygosity {0.001};
+
+// Buffered indel heterozygosities differ in the low digits, but are rounded before being used as keys
+const std::vector<double> indelHeterozygosities {0.0001, 0.00010000004, 0.000123456789, 0.00005};
+
+void check_table_matches_direct_computation(detail::SharedCoalescentTable& table)
+{
+    for (unsigned n {2}; n <= 6; ++n) {
+        for (unsigned k_snp {0}; k_snp <= 4; ++k_snp) {
+            for (unsigned k_indel {0}; k_indel <= 2; ++k_indel) {
+                for (const auto theta_indel : indelHeterozygosities) {
+                    const auto rounded_theta_indel = maths::round_sf(theta_indel, 6);
+                    const auto expected = detail::coalescent_log_probability(n, k_snp, k_indel, snpHeterozygosity, rounded_theta_indel);
+                    BOOST_CHECK_EQUAL(table.get(n, k_snp, k_indel, snpHeterozygosity, rounded_theta_indel), expected);
+                }
+            }
+        }
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(shared_coalescent_table_matches_direct_computation)
+{
+    detail::SharedCoalescentTable table {};
+    check_table_matches_direct_computation(table);
+    const auto first_pass_stats = table.stats();
+    // 0.0001 and 0.00010000004 round to the same key
+    BOOST_CHECK_GT(first_pass_stats.hits, 0);
+    BOOST_CHECK_EQUAL(first_pass_stats.misses, first_pass_stats.size);
+    check_table_matches_direct_computation(table);
+    BOOST_CHECK_EQUAL(table.stats().misses, first_pass_stats.misses);
+    BOOST_CHECK_EQUAL(table.stats().size, first_pass_stats.size);
+}
+
+BOOST_AUTO_TEST_CASE(shared_coalescent_table_matches_direct_computation_when_full)
+{
+    constexpr std::size_t maxSize {10};
+    detail::SharedCoalescentTable table {maxSize};
+    check_table_matches_direct_computation(table);
+    const auto first_pass_stats = table.stats();
+    BOOST_CHECK_EQUAL(first_pass_stats.size, maxSize);
+    BOOST_CHECK_GT(first_pass_stats.misses, maxSize);
+    // Terms stored before the table filled up are hits, the rest are recomputed
+    check_table_matches_direct_computation(table);
+    BOOST_CHECK_EQUAL(table.stats().size, maxSize);
+    BOOST_CHECK_GE(table.stats().hits, first_pass_stats.hits + maxSize);
+    BOOST_CHECK_GT(table.stats().misses, first_pass_stats.misses);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -0,0 +1,130 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <cstddef>
+
+#include "basics/genomic_region.hpp"
+#include "basics/cigar_string.hpp"
+#include "basics/aligned_read.hpp"
+#include "containers/mappable_block.hpp"
+#include "core/types/haplotype.hpp"
+#include "core/models/haplotype_likelihood_array.hpp"
+#include "mock/mock_reference.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(models)
+BOOST_AUTO_TEST_SUITE(haplotype_likelihood_array)
+
+namespace {
+
+const SampleName sample {"sample"};
+const GenomicRegion haplotype_region {"1", 20, 480};
+constexpr GenomicRegion::Size readLength {60};
+
+Haplotype make_haplotype(const ReferenceGenome& reference, const std::vector<GenomicRegion::Position>& snv_positions = {})
+{
+    auto sequence = reference.fetch_sequence(haplotype_region);
+    for (const auto position : snv_positions) {
+        auto& base = sequence[position - haplotype_region.begin()];
+        base = base == 'A' ? 'C' : 'A';
+    }
+    return Haplotype {haplotype_region, std::move(sequence), reference};
+}
+
+AlignedRead make_read(const ReferenceGenome& reference, const std::string& name, const GenomicRegion::Position begin,
+                      const GenomicRegion::Position sequence_begin, const bool reverse)
+{
+    AlignedRead::Flags flags {};
+    flags.reverse_mapped = reverse;
+    return AlignedRead {
+        name, GenomicRegion {"1", begin, begin + readLength},
+        reference.fetch_sequence(GenomicRegion {"1", sequence_begin, sequence_begin + readLength}),
+        AlignedRead::BaseQualityVector(readLength, 30), parse_cigar(std::to_string(readLength) + "M"),
+        60, flags, "", ""
+    };
+}
+
+// Reads tiling the haplotypes, optionally renamed or placed at a different position than their sequence
+ReadMap make_reads(const ReferenceGenome& reference, const std::string& name_prefix = "read", const int begin_offset = 0)
+{
+    ReadMap result {};
+    auto& reads = result[sample];
+    unsigned i {0};
+    for (GenomicRegion::Position begin {60}; begin <= 400; begin += 7, ++i) {
+        reads.insert(make_read(reference, name_prefix + std::to_string(i), begin + begin_offset, begin, i % 2 == 1));
+    }
+    return result;
+}
+
+void check_equal_likelihoods(const HaplotypeLikelihoodArray& lhs, const HaplotypeLikelihoodArray& rhs,
+                             const MappableBlock<Haplotype>& haplotypes)
+{
+    for (const auto& haplotype : haplotypes) {
+        const auto& lhs_likelihoods = lhs(sample, haplotype);
+        const auto& rhs_likelihoods = rhs(sample, haplotype);
+        BOOST_REQUIRE_EQUAL(lhs_likelihoods.size(), rhs_likelihoods.size());
+        for (std::size_t i {0}; i < lhs_likelihoods.size(); ++i) {
+            BOOST_CHECK_EQUAL(lhs_likelihoods[i], rhs_likelihoods[i]);
+        }
+    }
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(likelihoods_reused_from_an_overlapping_block_equal_a_cold_populate)
+{
+    const auto reference = mock::make_reference();
+    const auto reads = make_reads(reference);
+    const MappableBlock<Haplotype> first_block {make_haplotype(reference), make_haplotype(reference, {150}), make_haplotype(reference, {260})};
+    const MappableBlock<Haplotype> second_block {make_haplotype(reference), make_haplotype(reference, {260}), make_haplotype(reference, {400})};
+    HaplotypeLikelihoodArray warm {3, {sample}}, cold {3, {sample}};
+    warm.populate(reads, first_block);
+    warm.clear();
+    warm.populate(reads, second_block);
+    cold.populate(reads, second_block);
+    const auto num_evaluations = second_block.size() * reads.at(sample).size();
+    // A cold populate only reuses likelihoods between haplotypes of the block that match around a read,
+    // but a warm one also reuses every likelihood of the haplotypes shared with the first block
+    BOOST_CHECK_GT(warm.likelihood_cache_stats().hits, cold.likelihood_cache_stats().hits);
+    BOOST_CHECK_GE(warm.likelihood_cache_stats().hits, 2 * reads.at(sample).size());
+    BOOST_CHECK_LT(warm.likelihood_cache_stats().hits, num_evaluations);
+    BOOST_CHECK_EQUAL(warm.likelihood_cache_stats().hits + warm.likelihood_cache_stats().misses, num_evaluations);
+    check_equal_likelihoods(warm, cold, second_block);
+}
+
+BOOST_AUTO_TEST_CASE(cached_likelihoods_are_only_reused_for_the_same_read)
+{
+    const auto reference = mock::make_reference();
+    const MappableBlock<Haplotype> haplotypes {make_haplotype(reference), make_haplotype(reference, {150})};
+    const auto reads = make_reads(reference);
+    const auto num_evaluations = haplotypes.size() * reads.at(sample).size();
+    {
+        HaplotypeLikelihoodArray likelihoods {2, {sample}};
+        likelihoods.populate(reads, haplotypes);
+        likelihoods.populate(reads, haplotypes);
+        BOOST_CHECK_EQUAL(likelihoods.likelihood_cache_stats().hits, num_evaluations);
+    }
+    // Same evidence and evaluation keys, but a different read name or mapped position
+    for (const auto& other_reads : {make_reads(reference, "other"), make_reads(reference, "read", 1)}) {
+        HaplotypeLikelihoodArray likelihoods {2, {sample}}, cold {2, {sample}};
+        likelihoods.populate(reads, haplotypes);
+        likelihoods.populate(other_reads, haplotypes);
+        cold.populate(other_reads, haplotypes);
+        BOOST_CHECK_EQUAL(likelihoods.likelihood_cache_stats().hits, cold.likelihood_cache_stats().hits);
+        BOOST_CHECK_LT(likelihoods.likelihood_cache_stats().hits, num_evaluations / 2);
+        check_equal_likelihoods(likelihoods, cold, haplotypes);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
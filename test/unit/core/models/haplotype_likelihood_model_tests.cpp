@@ -1,4 +1,105 @@
 // Copyright (c) 2017 Daniel Cooke
 // Use of this source code is governed by the MIT license that can be found in the LICENSE file.
 
-#include <stdio.h>
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <stdexcept>
+
+#include "basics/genomic_region.hpp"
+#include "basics/cigar_string.hpp"
+#include "basics/aligned_read.hpp"
+#include "core/types/haplotype.hpp"
+#include "core/models/haplotype_likelihood_model.hpp"
+#include "mock/mock_reference.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(models)
+BOOST_AUTO_TEST_SUITE(haplotype_likelihood_model)
+
+namespace {
+
+const GenomicRegion haplotype_region {"1", 20, 480};
+constexpr GenomicRegion::Size readLength {60};
+
+Haplotype make_haplotype(const ReferenceGenome& reference, const std::vector<GenomicRegion::Position>& snv_positions = {})
+{
+    auto sequence = reference.fetch_sequence(haplotype_region);
+    for (const auto position : snv_positions) {
+        auto& base = sequence[position - haplotype_region.begin()];
+        base = base == 'A' ? 'C' : 'A';
+    }
+    return Haplotype {haplotype_region, std::move(sequence), reference};
+}
+
+AlignedRead make_read(const ReferenceGenome& reference, const GenomicRegion::Position begin, const bool reverse = false)
+{
+    AlignedRead::Flags flags {};
+    flags.reverse_mapped = reverse;
+    const GenomicRegion region {"1", begin, begin + readLength};
+    return AlignedRead {
+        "read" + std::to_string(begin), region, reference.fetch_sequence(region),
+        AlignedRead::BaseQualityVector(readLength, 30), parse_cigar(std::to_string(readLength) + "M"),
+        60, flags, "", ""
+    };
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(score_memo_does_not_change_likelihoods)
+{
+    const auto reference = mock::make_reference();
+    // The first two haplotypes only differ outside the read windows, the third inside them
+    const std::vector<Haplotype> haplotypes {make_haplotype(reference), make_haplotype(reference, {400}), make_haplotype(reference, {250})};
+    std::vector<AlignedRead> reads {};
+    for (GenomicRegion::Position begin {200}; begin <= 240; begin += 10) {
+        reads.push_back(make_read(reference, begin, begin % 20 == 0));
+    }
+    HaplotypeLikelihoodModel model {}, memo_model {};
+    const HaplotypeLikelihoodModel::ScoreMemoGuard guard {memo_model};
+    for (const auto& haplotype : haplotypes) {
+        model.reset(haplotype);
+        memo_model.reset(haplotype);
+        for (const auto& read : reads) {
+            BOOST_CHECK_EQUAL(memo_model.evaluate(read), model.evaluate(read));
+        }
+    }
+    BOOST_CHECK_EQUAL(model.score_memo_stats().hits + model.score_memo_stats().evaluations, 0);
+    // Every read is scored once against the reference window and once against the window with the SNV
+    BOOST_CHECK_GE(memo_model.score_memo_stats().hits, reads.size());
+    BOOST_CHECK_GE(memo_model.score_memo_stats().evaluations, 2 * reads.size());
+}
+
+BOOST_AUTO_TEST_CASE(score_memo_is_cleared_when_evaluation_throws)
+{
+    const auto reference = mock::make_reference();
+    const auto haplotype = make_haplotype(reference);
+    HaplotypeLikelihoodModel model {};
+    model.reset(haplotype);
+    auto read = make_read(reference, 200);
+    try {
+        const HaplotypeLikelihoodModel::ScoreMemoGuard guard {model};
+        model.evaluate(read);
+        BOOST_REQUIRE_EQUAL(model.score_memo_stats().evaluations, 1);
+        throw std::runtime_error {"evaluation failed"};
+    } catch (const std::runtime_error&) {}
+    BOOST_CHECK_EQUAL(model.score_memo_stats().hits + model.score_memo_stats().evaluations, 0);
+    model.evaluate(read);
+    BOOST_CHECK_EQUAL(model.score_memo_stats().evaluations, 0); // memo disabled
+    // A different read at the same address must not hit a stale score
+    read = make_read(reference, 250);
+    const auto expected = model.evaluate(read);
+    const HaplotypeLikelihoodModel::ScoreMemoGuard guard {model};
+    BOOST_CHECK_EQUAL(model.evaluate(read), expected);
+    BOOST_CHECK_EQUAL(model.score_memo_stats().hits, 0);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
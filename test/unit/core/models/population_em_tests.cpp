@@ -0,0 +1,94 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <random>
+#include <cmath>
+
+#include "core/types/genotype_space.hpp"
+#include "core/models/genotype/population_em.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(models)
+BOOST_AUTO_TEST_SUITE(population_em)
+
+using namespace model;
+
+BOOST_AUTO_TEST_CASE(GenotypeHaplotypeIncidence_records_distinct_haplotypes_and_copy_numbers)
+{
+    const GenotypeSpace space {3, 3};
+    const GenotypeHaplotypeIncidence incidence {space};
+    BOOST_REQUIRE_EQUAL(incidence.num_genotypes(), space.size());
+    BOOST_CHECK_EQUAL(incidence.num_haplotypes(), 3);
+    std::size_t g {0};
+    for (const auto& genotype : space) {
+        std::vector<unsigned> counts(3, 0);
+        for (const auto haplotype : genotype) ++counts[haplotype];
+        const auto num_distinct = std::count_if(std::cbegin(counts), std::cend(counts), [] (auto c) { return c > 0; });
+        BOOST_REQUIRE_EQUAL(incidence.offset(g + 1) - incidence.offset(g), num_distinct);
+        double expected_coefficient {std::lgamma(4.0)};
+        for (auto k = incidence.offset(g); k < incidence.offset(g + 1); ++k) {
+            BOOST_CHECK_EQUAL(incidence.counts()[k], counts[incidence.haplotypes()[k]]);
+            expected_coefficient -= std::lgamma(incidence.counts()[k] + 1.0);
+        }
+        BOOST_CHECK_CLOSE(incidence.log_multinomial_coefficients()[g] + 1.0, expected_coefficient + 1.0, 1e-9);
+        ++g;
+    }
+}
+
+BOOST_AUTO_TEST_CASE(compute_approx_genotype_marginal_posteriors_matches_hardy_weinberg_posteriors)
+{
+    const GenotypeSpace space {4, 2};
+    const GenotypeHaplotypeIncidence incidence {space};
+    const std::size_t num_samples {5};
+    SampleGenotypeMatrix log_likelihoods {num_samples, space.size()};
+    std::mt19937 generator {42};
+    std::uniform_real_distribution<double> likelihood_dist {-800, 0};
+    for (std::size_t s {0}; s < num_samples; ++s) {
+        std::generate_n(log_likelihoods[s], space.size(), [&] () { return likelihood_dist(generator); });
+    }
+    // With no iterations, the posteriors are under uniform haplotype frequencies
+    PopulationEMOptions options {};
+    options.max_iterations = 0;
+    const auto posteriors = compute_approx_genotype_marginal_posteriors(incidence, log_likelihoods, num_samples * 2, options);
+    BOOST_REQUIRE_EQUAL(posteriors.num_samples(), num_samples);
+    BOOST_REQUIRE_EQUAL(posteriors.num_genotypes(), space.size());
+    for (std::size_t s {0}; s < num_samples; ++s) {
+        std::vector<double> expected(space.size());
+        for (std::size_t g {0}; g < space.size(); ++g) {
+            expected[g] = incidence.log_multinomial_coefficients()[g] + 2 * std::log(0.25) + log_likelihoods[s][g];
+        }
+        const auto max = *std::max_element(std::cbegin(expected), std::cend(expected));
+        double norm {0};
+        for (auto& p : expected) norm += (p = std::exp(p - max));
+        for (std::size_t g {0}; g < space.size(); ++g) {
+            BOOST_CHECK_SMALL(posteriors[s][g] - expected[g] / norm, 1e-12);
+        }
+        BOOST_CHECK_CLOSE(std::accumulate(posteriors[s], posteriors[s] + space.size(), 0.0), 1.0, 1e-9);
+    }
+    options.max_iterations = 100;
+    const auto em_posteriors = compute_approx_genotype_marginal_posteriors(incidence, log_likelihoods, num_samples * 2, options);
+    ThreadPool workers {2};
+    options.workers = workers;
+    const auto parallel_em_posteriors = compute_approx_genotype_marginal_posteriors(incidence, log_likelihoods, num_samples * 2, options);
+    for (std::size_t s {0}; s < num_samples; ++s) {
+        BOOST_CHECK_CLOSE(std::accumulate(em_posteriors[s], em_posteriors[s] + space.size(), 0.0), 1.0, 1e-9);
+        for (std::size_t g {0}; g < space.size(); ++g) {
+            BOOST_CHECK_SMALL(parallel_em_posteriors[s][g] - em_posteriors[s][g], 1e-12);
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
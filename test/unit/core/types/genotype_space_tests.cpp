@@ -0,0 +1,99 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <algorithm>
+#include <numeric>
+#include <iterator>
+#include <random>
+#include <stdexcept>
+
+#include "core/types/genotype_space.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(core)
+BOOST_AUTO_TEST_SUITE(genotype_space)
+
+namespace {
+
+auto enumerate_all(const unsigned num_elements, const unsigned ploidy)
+{
+    std::vector<GenotypeSpace::ElementIndexVector> result {};
+    GenotypeSpace::ElementIndexVector genotype(ploidy, 0);
+    while (true) {
+        result.push_back(genotype);
+        int j = static_cast<int>(ploidy) - 1;
+        while (j >= 0 && genotype[j] + 1 == num_elements) --j;
+        if (j < 0) break;
+        const auto e = ++genotype[j];
+        std::fill(std::next(std::begin(genotype), j), std::end(genotype), e);
+    }
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(GenotypeSpace_ranks_genotypes_in_lexicographical_order)
+{
+    for (unsigned num_elements {1}; num_elements <= 7; ++num_elements) {
+        for (unsigned ploidy {1}; ploidy <= 5; ++ploidy) {
+            const GenotypeSpace space {num_elements, ploidy};
+            const auto genotypes = enumerate_all(num_elements, ploidy);
+            BOOST_REQUIRE_EQUAL(space.size(), genotypes.size());
+            for (std::size_t i {0}; i < genotypes.size(); ++i) {
+                BOOST_CHECK_EQUAL(space.rank(genotypes[i]), i);
+                BOOST_CHECK(space.unrank(i) == genotypes[i]);
+            }
+            std::size_t i {0};
+            for (auto itr = std::cbegin(space); itr != std::cend(space); ++itr, ++i) {
+                BOOST_REQUIRE_LT(i, genotypes.size());
+                BOOST_CHECK_EQUAL(itr.index(), i);
+                BOOST_CHECK(*itr == genotypes[i]);
+            }
+            BOOST_CHECK_EQUAL(i, genotypes.size());
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(GenotypeSpace_throws_when_the_number_of_genotypes_overflows)
+{
+    BOOST_CHECK_THROW((GenotypeSpace {1000, 100}), std::overflow_error);
+    BOOST_CHECK_EQUAL((GenotypeSpace {1000, 2}).size(), 500'500);
+}
+
+BOOST_AUTO_TEST_CASE(select_top_k_genotypes_finds_the_highest_scoring_genotypes)
+{
+    std::mt19937 generator {42};
+    std::uniform_real_distribution<double> score_dist {-10, 0};
+    for (unsigned num_elements {1}; num_elements <= 8; ++num_elements) {
+        for (unsigned ploidy {1}; ploidy <= 4; ++ploidy) {
+            std::vector<double> scores(num_elements);
+            std::generate(std::begin(scores), std::end(scores), [&] () { return score_dist(generator); });
+            const auto score = [&] (const auto& genotype) {
+                return std::accumulate(std::cbegin(genotype), std::cend(genotype), 0.0,
+                                       [&] (double total, auto e) { return total + scores[e]; });
+            };
+            auto genotypes = enumerate_all(num_elements, ploidy);
+            std::sort(std::begin(genotypes), std::end(genotypes),
+                      [&] (const auto& lhs, const auto& rhs) { return score(lhs) > score(rhs); });
+            const GenotypeSpace space {num_elements, ploidy};
+            for (std::size_t k : {1, 5, 20}) {
+                const auto top = select_top_k_genotypes(space, scores, k);
+                BOOST_REQUIRE_EQUAL(top.size(), std::min(k, genotypes.size()));
+                for (std::size_t i {0}; i < top.size(); ++i) {
+                    BOOST_CHECK(std::is_sorted(std::cbegin(top[i]), std::cend(top[i])));
+                    BOOST_CHECK_CLOSE(score(top[i]), score(genotypes[i]), 1e-9);
+                }
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
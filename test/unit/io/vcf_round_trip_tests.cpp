@@ -0,0 +1,330 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <sstream>
+#include <fstream>
+#include <iterator>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "io/variant/vcf_header.hpp"
+#include "io/variant/vcf_record.hpp"
+#include "io/variant/vcf_reader.hpp"
+#include "io/variant/vcf_writer.hpp"
+#include "io/variant/vcf_utils.hpp"
+#include "mock/utils.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(io)
+BOOST_AUTO_TEST_SUITE(vcf)
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+const std::vector<std::string> samples {"NA1", "NA2"};
+
+auto make_header(const bool with_extra_info = false)
+{
+    VcfHeader::Builder result {};
+    result.add_contig("1");
+    // An extra INFO line first gives every other field a different BCF ID
+    if (with_extra_info) result.add_info("EXTRA", "1", "Integer", "Not used by the records");
+    result.add_info("DP", "1", "Integer", "Depth");
+    result.add_info("AF", "A", "Float", "Allele frequency");
+    result.add_info("AA", "1", "String", "Ancestral allele");
+    result.add_format("GT", "1", "String", "Genotype");
+    result.add_format("AD", "R", "Integer", "Allelic depths");
+    result.add_format("XI", ".", "Integer", "Variable length integers");
+    result.add_format("XF", ".", "Float", "Variable length floats");
+    result.add_format("FT", "1", "String", "Sample filter");
+    result.set_samples(samples);
+    return result.build_once();
+}
+
+auto make_records()
+{
+    using Phasing = VcfRecord::Builder::Phasing;
+    std::vector<VcfRecord> result {};
+    VcfRecord::Builder builder {};
+    builder.set_chrom("1").set_pos(100).set_ref("A").set_alt("C").set_qual(30).set_passed();
+    builder.set_info("DP", std::string {"10"}).set_info("AF", std::string {"0.5"}).set_info("AA", std::string {"A"});
+    builder.set_format({"GT", "AD", "XI", "XF", "FT"});
+    builder.set_genotype("NA1", std::vector<std::string> {"A", "C"}, Phasing::unphased);
+    builder.set_genotype("NA2", std::vector<std::string> {"C", "C"}, Phasing::phased);
+    builder.set_format("NA1", "AD", {"5", "5"}).set_format("NA2", "AD", {"0", "10"});
+    // Sample values of different lengths are padded with vector end values
+    builder.set_format("NA1", "XI", {"1", "2", "3"}).set_format("NA2", "XI", {"4"});
+    builder.set_format("NA1", "XF", {"0.25"}).set_format("NA2", "XF", {"0.5", "1.5"});
+    builder.set_format("NA1", "FT", std::string {"PASS"}).set_format("NA2", "FT", std::string {"q10"});
+    result.push_back(builder.build_once());
+    builder = VcfRecord::Builder {};
+    builder.set_chrom("1").set_pos(200).set_ref("G").set_alt(std::vector<std::string> {"T", "GA"});
+    builder.set_info_missing("DP").set_info("AF", {"0.25", "."}).set_info("AA", std::string {"G"});
+    builder.set_format({"GT", "AD", "XI", "XF", "FT"});
+    builder.set_genotype("NA1", std::vector<std::string> {"G", "GA"}, Phasing::unphased);
+    builder.set_genotype("NA2", std::vector<boost::optional<unsigned>> {boost::none, 1u}, Phasing::unphased);
+    builder.set_format("NA1", "AD", {"3", ".", "4"}).set_format_missing("NA2", "AD");
+    builder.set_format("NA1", "XI", {"7"}).set_format_missing("NA2", "XI");
+    builder.set_format("NA1", "XF", {".", "2.5"}).set_format("NA2", "XF", {"3.5"});
+    builder.set_format("NA1", "FT", std::string {"PASS"}).set_format_missing("NA2", "FT");
+    result.push_back(builder.build_once());
+    return result;
+}
+
+// One INFO and FORMAT field of every type, with scalar and variable length values
+auto make_typed_header()
+{
+    VcfHeader::Builder result {};
+    result.add_contig("1");
+    result.add_info("I1", "1", "Integer", "Integer");
+    result.add_info("IV", ".", "Integer", "Integers");
+    result.add_info("F1", "1", "Float", "Float");
+    result.add_info("FV", ".", "Float", "Floats");
+    result.add_info("S1", "1", "String", "String");
+    result.add_info("SV", ".", "String", "Strings");
+    result.add_info("C1", "1", "Character", "Character");
+    result.add_info("FL", "0", "Flag", "Flag");
+    result.add_format("GT", "1", "String", "Genotype");
+    result.add_format("FI", ".", "Integer", "Integers");
+    result.add_format("FF", ".", "Float", "Floats");
+    result.add_format("FS", "1", "String", "String");
+    result.add_format("FC", "1", "Character", "Character");
+    result.set_samples(samples);
+    return result.build_once();
+}
+
+auto make_typed_records()
+{
+    using Phasing = VcfRecord::Builder::Phasing;
+    std::vector<VcfRecord> result {};
+    VcfRecord::Builder builder {};
+    builder.set_chrom("1").set_pos(100).set_ref("A").set_alt("C").set_qual(30).set_passed();
+    builder.set_info("I1", std::string {"3"}).set_info("IV", {"1", ".", "3"});
+    builder.set_info("F1", std::string {"0.5"}).set_info("FV", {".", "1.5"});
+    builder.set_info("S1", std::string {"abc"}).set_info("SV", {"x", "y"});
+    builder.set_info("C1", std::string {"Z"}).set_info_flag("FL");
+    builder.set_format({"GT", "FI", "FF", "FS", "FC"});
+    builder.set_genotype("NA1", std::vector<std::string> {"A", "C"}, Phasing::unphased);
+    builder.set_genotype("NA2", std::vector<std::string> {"A", "A"}, Phasing::unphased);
+    builder.set_format("NA1", "FI", {"1", "2", "3"}).set_format_missing("NA2", "FI");
+    builder.set_format("NA1", "FF", {"0.5"}).set_format("NA2", "FF", {".", "2.5"});
+    builder.set_format("NA1", "FS", std::string {"foo"}).set_format_missing("NA2", "FS");
+    builder.set_format("NA1", "FC", std::string {"a"}).set_format("NA2", "FC", std::string {"b"});
+    result.push_back(builder.build_once());
+    builder = VcfRecord::Builder {};
+    builder.set_chrom("1").set_pos(200).set_ref("G").set_alt("T").set_qual(20).set_passed();
+    builder.set_info_missing("I1").set_info_missing("F1").set_info_missing("S1").set_info("SV", std::string {"z"});
+    builder.set_format({"GT", "FI", "FF", "FS", "FC"});
+    builder.set_genotype("NA1", std::vector<std::string> {"G", "T"}, Phasing::unphased);
+    builder.set_genotype("NA2", std::vector<std::string> {"T", "T"}, Phasing::unphased);
+    builder.set_format_missing("NA1", "FI").set_format("NA2", "FI", {"4", "5"});
+    builder.set_format("NA1", "FF", {"1", "2", "3"}).set_format_missing("NA2", "FF");
+    builder.set_format("NA1", "FS", std::string {"bar"}).set_format("NA2", "FS", std::string {"baz"});
+    builder.set_format_missing("NA1", "FC").set_format("NA2", "FC", std::string {"c"});
+    result.push_back(builder.build_once());
+    return result;
+}
+
+void write(const fs::path& path, const VcfHeader& header, const std::vector<VcfRecord>& records)
+{
+    VcfWriter writer {path, header};
+    for (const auto& record : records) writer << record;
+}
+
+auto read(const fs::path& path, const VcfReader::UnpackPolicy level = VcfReader::UnpackPolicy::all)
+{
+    const VcfReader reader {path};
+    return reader.fetch_records(level);
+}
+
+std::string to_string(const VcfRecord& record)
+{
+    std::ostringstream ss {};
+    ss << record;
+    return ss.str();
+}
+
+void check_same_records(const std::vector<VcfRecord>& lhs, const std::vector<VcfRecord>& rhs)
+{
+    BOOST_REQUIRE_EQUAL(lhs.size(), rhs.size());
+    for (std::size_t i {0}; i < lhs.size(); ++i) {
+        BOOST_CHECK_EQUAL(to_string(lhs[i]), to_string(rhs[i]));
+    }
+}
+
+// Records read from a BCF are written unchanged to BCF and VCF, and again after being fully decoded
+void check_round_trips(const VcfHeader& header, const std::vector<VcfRecord>& source_records)
+{
+    const debug::TempFile source {".bcf"}, bcf_copy {".bcf"}, vcf_copy {".vcf"}, decoded_copy {".bcf"};
+    write(source.path(), header, source_records);
+    const auto records = read(source.path());
+    write(bcf_copy.path(), header, records);
+    check_same_records(records, read(bcf_copy.path()));
+    write(vcf_copy.path(), header, records);
+    check_same_records(records, read(vcf_copy.path()));
+    // Records copied through the Builder are fully decoded and re-encoded
+    std::vector<VcfRecord> decoded_records {};
+    for (const auto& record : records) decoded_records.push_back(VcfRecord::Builder {record}.build_once());
+    write(decoded_copy.path(), header, decoded_records);
+    check_same_records(records, read(decoded_copy.path()));
+}
+
+std::string read_bytes(const fs::path& path)
+{
+    std::ifstream file {path.string(), std::ios::binary};
+    return {std::istreambuf_iterator<char> {file}, std::istreambuf_iterator<char> {}};
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(read_records_decode_typed_missing_and_padded_values)
+{
+    const debug::TempFile file {".bcf"};
+    write(file.path(), make_header(), make_records());
+    const auto records = read(file.path());
+    BOOST_REQUIRE_EQUAL(records.size(), 2);
+
+    const auto& first = records[0];
+    BOOST_CHECK_EQUAL(*first.info_number("DP"), 10);
+    BOOST_CHECK_CLOSE(*first.info_number("AF"), 0.5, 1e-6);
+    BOOST_CHECK_EQUAL(first.info_value("AA").front(), "A");
+    BOOST_CHECK(first.is_heterozygous("NA1"));
+    BOOST_CHECK(first.is_homozygous_non_ref("NA2"));
+    BOOST_CHECK(first.is_sample_phased("NA2"));
+    BOOST_CHECK_EQUAL(*first.sample_number("NA2", "AD", 1), 10);
+    BOOST_CHECK_EQUAL(first.get_sample_value("NA1", "XI").size(), 3);
+    BOOST_CHECK_EQUAL(first.get_sample_value("NA2", "XI").size(), 1);
+    BOOST_CHECK(!first.sample_number("NA2", "XI", 1));
+    BOOST_CHECK_EQUAL(first.get_sample_value("NA1", "XF").size(), 1);
+    BOOST_CHECK_CLOSE(*first.sample_number("NA2", "XF", 1), 1.5, 1e-6);
+    BOOST_CHECK(!first.sample_number("NA1", "XF", 1));
+    BOOST_CHECK_EQUAL(first.get_sample_value("NA2", "FT").front(), "q10");
+
+    const auto& second = records[1];
+    BOOST_CHECK(!second.info_number("DP"));
+    BOOST_CHECK(is_info_missing("DP", second));
+    BOOST_CHECK_CLOSE(*second.info_number("AF", 0), 0.25, 1e-6);
+    BOOST_CHECK(!second.info_number("AF", 1));
+    BOOST_CHECK_EQUAL(second.ploidy("NA2"), 2);
+    BOOST_CHECK(second.has_alt_allele("NA2"));
+    BOOST_CHECK(!second.sample_number("NA1", "AD", 1));
+    BOOST_CHECK_EQUAL(*second.sample_number("NA1", "AD", 2), 4);
+    BOOST_CHECK(!second.sample_number("NA2", "AD", 0));
+    BOOST_CHECK(!second.sample_number("NA2", "XI", 0));
+    BOOST_CHECK(!second.sample_number("NA1", "XF", 0));
+    BOOST_CHECK_CLOSE(*second.sample_number("NA1", "XF", 1), 2.5, 1e-6);
+    BOOST_CHECK_EQUAL(second.get_sample_value("NA2", "FT").front(), ".");
+}
+
+BOOST_AUTO_TEST_CASE(read_records_round_trip_through_bcf_and_vcf)
+{
+    check_round_trips(make_header(), make_records());
+}
+
+BOOST_AUTO_TEST_CASE(every_info_and_format_type_round_trips)
+{
+    const debug::TempFile file {".bcf"};
+    write(file.path(), make_typed_header(), make_typed_records());
+    const auto records = read(file.path());
+    BOOST_REQUIRE_EQUAL(records.size(), 2);
+
+    const auto& first = records[0];
+    BOOST_CHECK_EQUAL(*first.info_number("I1"), 3);
+    BOOST_CHECK_EQUAL(first.info_value("IV").size(), 3);
+    BOOST_CHECK(!first.info_number("IV", 1));
+    BOOST_CHECK_EQUAL(*first.info_number("IV", 2), 3);
+    BOOST_CHECK_CLOSE(*first.info_number("F1"), 0.5, 1e-6);
+    BOOST_CHECK(!first.info_number("FV", 0));
+    BOOST_CHECK_CLOSE(*first.info_number("FV", 1), 1.5, 1e-6);
+    BOOST_CHECK_EQUAL(first.info_value("S1").front(), "abc");
+    BOOST_CHECK(first.info_value("SV") == (std::vector<std::string> {"x", "y"}));
+    BOOST_CHECK_EQUAL(first.info_value("C1").front(), "Z");
+    BOOST_CHECK(first.has_info("FL"));
+    BOOST_CHECK_EQUAL(first.get_sample_value("NA1", "FI").size(), 3);
+    // A missing value is kept, but the vector end values padding it to the longest sample are not
+    BOOST_CHECK_EQUAL(first.get_sample_value("NA2", "FI").size(), 1);
+    BOOST_CHECK(!first.sample_number("NA2", "FI", 0));
+    BOOST_CHECK_EQUAL(first.get_sample_value("NA1", "FF").size(), 1);
+    BOOST_CHECK(!first.sample_number("NA2", "FF", 0));
+    BOOST_CHECK_CLOSE(*first.sample_number("NA2", "FF", 1), 2.5, 1e-6);
+    BOOST_CHECK_EQUAL(first.get_sample_value("NA1", "FS").front(), "foo");
+    BOOST_CHECK_EQUAL(first.get_sample_value("NA2", "FS").front(), ".");
+    BOOST_CHECK_EQUAL(first.get_sample_value("NA1", "FC").front(), "a");
+    BOOST_CHECK_EQUAL(first.get_sample_value("NA2", "FC").front(), "b");
+
+    const auto& second = records[1];
+    BOOST_CHECK(is_info_missing("I1", second));
+    BOOST_CHECK(is_info_missing("F1", second));
+    BOOST_CHECK(is_info_missing("S1", second));
+    BOOST_CHECK(!second.has_info("C1"));
+    BOOST_CHECK(!second.has_info("FL"));
+    BOOST_CHECK(!second.sample_number("NA1", "FI", 0));
+    BOOST_CHECK_EQUAL(*second.sample_number("NA2", "FI", 1), 5);
+    BOOST_CHECK_EQUAL(second.get_sample_value("NA1", "FF").size(), 3);
+    BOOST_CHECK(!second.sample_number("NA2", "FF", 0));
+    BOOST_CHECK_EQUAL(second.get_sample_value("NA2", "FS").front(), "baz");
+    BOOST_CHECK_EQUAL(second.get_sample_value("NA1", "FC").front(), ".");
+
+    check_round_trips(make_typed_header(), make_typed_records());
+}
+
+BOOST_AUTO_TEST_CASE(read_records_are_written_with_the_writers_header_ids)
+{
+    const debug::TempFile source {".bcf"}, copy {".bcf"};
+    write(source.path(), make_header(), make_records());
+    const auto records = read(source.path());
+    write(copy.path(), make_header(true), records);
+    check_same_records(records, read(copy.path()));
+}
+
+BOOST_AUTO_TEST_CASE(sites_only_reads_round_trip_info)
+{
+    const debug::TempFile source {".bcf"}, copy {".bcf"};
+    write(source.path(), make_header(), make_records());
+    const auto records = read(source.path(), VcfReader::UnpackPolicy::sites);
+    BOOST_REQUIRE_EQUAL(records.size(), 2);
+    BOOST_CHECK_EQUAL(records[0].num_samples(), 0);
+    BOOST_CHECK_EQUAL(*records[0].info_number("DP"), 10);
+    BOOST_CHECK(!records[1].info_number("AF", 1));
+    auto sites_header = VcfHeader::Builder {make_header()}.set_samples({}).build_once();
+    write(copy.path(), sites_header, records);
+    check_same_records(records, read(copy.path(), VcfReader::UnpackPolicy::sites));
+}
+
+BOOST_AUTO_TEST_CASE(concatenate_bcf_blocks_appends_source_records)
+{
+    const debug::TempFile first {".bcf"}, second {".bcf"}, dst {".bcf"};
+    const auto header = make_header();
+    const auto records = make_records();
+    write(first.path(), header, {records[0]});
+    write(second.path(), header, {records[1]});
+    write(dst.path(), header, {});
+    BOOST_REQUIRE(concatenate_bcf_blocks({first.path(), second.path()}, dst.path(), 2));
+    check_same_records(read(dst.path()), records);
+}
+
+BOOST_AUTO_TEST_CASE(concatenate_bcf_blocks_leaves_dst_unchanged_for_incompatible_sources)
+{
+    const debug::TempFile first {".bcf"}, second {".bcf"}, dst {".bcf"};
+    const auto records = make_records();
+    write(first.path(), make_header(), {records[0]});
+    write(second.path(), make_header(true), {records[1]});
+    write(dst.path(), make_header(), {});
+    const auto dst_bytes = read_bytes(dst.path());
+    BOOST_CHECK(!concatenate_bcf_blocks({first.path(), second.path()}, dst.path()));
+    BOOST_CHECK(read_bytes(dst.path()) == dst_bytes);
+    BOOST_CHECK(read(dst.path()).empty());
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
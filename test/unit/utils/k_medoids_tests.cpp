@@ -0,0 +1,115 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <vector>
+#include <random>
+#include <cmath>
+#include <algorithm>
+#include <future>
+#include <chrono>
+
+#include "utils/k_medoids.hpp"
+#include "utils/thread_pool.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(utils)
+BOOST_AUTO_TEST_SUITE(k_medoids)
+
+namespace {
+
+auto l1_norm(const std::vector<double>& p, const std::vector<double>& q)
+{
+    double result {0};
+    for (std::size_t i {0}; i < p.size(); ++i) result += std::abs(p[i] - q[i]);
+    return result;
+}
+
+auto make_clustered_points(const std::size_t num_clusters, const std::size_t num_points, const double spread)
+{
+    std::mt19937 generator {42};
+    std::uniform_real_distribution<double> centre_dist {0, 1};
+    std::normal_distribution<double> noise_dist {0, spread};
+    std::vector<std::vector<double>> centres(num_clusters, std::vector<double>(10));
+    for (auto& centre : centres) for (auto& x : centre) x = centre_dist(generator);
+    std::vector<std::vector<double>> result {};
+    for (std::size_t i {0}; i < num_points; ++i) {
+        auto point = centres[i % num_clusters];
+        for (auto& x : point) x += noise_dist(generator);
+        result.push_back(std::move(point));
+    }
+    return result;
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(large_k_medoids_recovers_separated_clusters)
+{
+    const std::size_t num_clusters {6};
+    const auto points = make_clustered_points(num_clusters, 600, 0.01);
+    ClusterVector clusters {};
+    large_k_medoids(points, num_clusters, clusters, l1_norm);
+    BOOST_REQUIRE_EQUAL(clusters.size(), num_clusters);
+    for (const auto& cluster : clusters) {
+        BOOST_REQUIRE(!cluster.empty());
+        BOOST_CHECK(std::all_of(std::cbegin(cluster), std::cend(cluster),
+                                [&] (auto point) { return point % num_clusters == cluster.front() % num_clusters; }));
+    }
+}
+
+BOOST_AUTO_TEST_CASE(large_k_medoids_fit_is_close_to_k_medoids)
+{
+    for (const std::size_t num_clusters : {5, 50}) {
+        const auto points = make_clustered_points(num_clusters, 400, 0.1);
+        ClusterVector exact_clusters {}, large_clusters {};
+        const auto exact_fit = octopus::k_medoids(points, num_clusters, exact_clusters, l1_norm).second;
+        const auto large_fit = large_k_medoids(points, num_clusters, large_clusters, l1_norm).second;
+        BOOST_CHECK_EQUAL(large_clusters.size(), num_clusters);
+        BOOST_CHECK_LE(large_fit, 1.05 * exact_fit);
+    }
+}
+
+BOOST_AUTO_TEST_CASE(large_k_medoids_restarts_on_workers_give_the_same_result)
+{
+    const std::size_t num_clusters {8};
+    const auto points = make_clustered_points(num_clusters, 400, 0.1);
+    ThreadPool workers {3};
+    LargeKMediodsParameters params {};
+    ClusterVector sequential_clusters {}, parallel_clusters {};
+    const auto sequential_fit = large_k_medoids(points, num_clusters, sequential_clusters, l1_norm, params);
+    params.workers = workers;
+    const auto parallel_fit = large_k_medoids(points, num_clusters, parallel_clusters, l1_norm, params);
+    BOOST_CHECK(parallel_fit.first == sequential_fit.first);
+    BOOST_CHECK_EQUAL(parallel_fit.second, sequential_fit.second);
+    BOOST_CHECK(parallel_clusters == sequential_clusters);
+}
+
+BOOST_AUTO_TEST_CASE(large_k_medoids_called_from_every_worker_does_not_deadlock)
+{
+    const std::size_t num_clusters {8};
+    const auto points = make_clustered_points(num_clusters, 400, 0.1);
+    ClusterVector sequential_clusters {};
+    const auto sequential_fit = large_k_medoids(points, num_clusters, sequential_clusters, l1_norm);
+    ThreadPool workers {2};
+    LargeKMediodsParameters params {};
+    params.workers = workers;
+    std::vector<std::future<double>> fits {};
+    for (std::size_t i {0}; i < workers.size(); ++i) {
+        fits.push_back(workers.push([&] () {
+            ClusterVector clusters {};
+            return large_k_medoids(points, num_clusters, clusters, l1_norm, params).second;
+        }));
+    }
+    for (auto& fit : fits) {
+        BOOST_REQUIRE(fit.wait_for(std::chrono::minutes {1}) == std::future_status::ready);
+        BOOST_CHECK_EQUAL(fit.get(), sequential_fit.second);
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
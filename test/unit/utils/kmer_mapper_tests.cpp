@@ -0,0 +1,92 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <iterator>
+#include <random>
+
+#include "utils/kmer_mapper.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(utils)
+BOOST_AUTO_TEST_SUITE(kmer_mapper)
+
+BOOST_AUTO_TEST_CASE(rolling_kmer_hashes_match_window_hashes)
+{
+    const std::string sequence {"ACGTTGCANNACGTACGTGGGCCCTTTAAACG"};
+    const auto hashes = compute_kmer_hashes<6>(sequence);
+    BOOST_REQUIRE_EQUAL(hashes.size(), sequence.size() - 5);
+    for (std::size_t i {0}; i < hashes.size(); ++i) {
+        BOOST_CHECK_EQUAL(hashes[i], perfect_kmer_hash<6>(std::next(std::cbegin(sequence), i)));
+    }
+    BOOST_CHECK(compute_kmer_hashes<6>("ACGTA").empty());
+}
+
+BOOST_AUTO_TEST_CASE(kmer_hash_table_lists_positions_in_order)
+{
+    const std::string target {"AAAAAAACGTACGTAAAAAAA"};
+    const auto table = make_kmer_hash_table<6>(target);
+    BOOST_REQUIRE_EQUAL(table.positions.size(), target.size() - 5);
+    const auto poly_a = perfect_kmer_hash<6>(std::cbegin(target));
+    const std::vector<std::uint32_t> poly_a_positions {
+        std::next(std::cbegin(table.positions), table.bin_offsets[poly_a]),
+        std::next(std::cbegin(table.positions), table.bin_offsets[poly_a + 1])
+    };
+    BOOST_CHECK((poly_a_positions == std::vector<std::uint32_t> {0, 1, 14, 15}));
+    BOOST_CHECK_EQUAL(table.bin_offsets.back(), table.positions.size());
+}
+
+BOOST_AUTO_TEST_CASE(map_query_to_target_finds_best_offset_after_repopulating)
+{
+    auto table = init_kmer_hash_table<6>();
+    populate_kmer_hash_table<6>("TTTTTTTTTTTTTTTTTTTTTTTTTTTTTT", table);
+    const std::string target {"GATTACAGATTACACCGGTTAACCGGTTAAGGCCATGCATGCAT"};
+    clear_kmer_hash_table(table);
+    populate_kmer_hash_table<6>(target, table);
+    const auto query = target.substr(10, 20);
+    const auto positions = map_query_to_target(compute_kmer_hashes<6>(query), table);
+    BOOST_REQUIRE_EQUAL(positions.size(), 1);
+    BOOST_CHECK_EQUAL(positions.front(), 10);
+}
+
+BOOST_AUTO_TEST_CASE(map_query_to_targets_matches_mapping_each_target)
+{
+    std::mt19937 generator {42};
+    std::uniform_int_distribution<int> base_dist {0, 3}, position_dist {0, 199};
+    const std::string bases {"ACGT"};
+    std::string reference(200, 'A');
+    for (auto& base : reference) base = bases[base_dist(generator)];
+    std::vector<std::string> haplotypes(70, reference);
+    for (std::size_t i {1}; i < haplotypes.size(); ++i) {
+        for (int j {0}; j < 3; ++j) haplotypes[i][position_dist(generator)] = bases[base_dist(generator)];
+    }
+    haplotypes[5].erase(50, 10);
+    haplotypes[6].insert(120, "ACGTACGT");
+    TargetSequenceRefs targets {};
+    for (const auto& haplotype : haplotypes) targets.emplace_back(haplotype);
+    const auto table = make_kmer_hash_table<6>(targets);
+    auto counts = init_mapping_counts(table);
+    for (std::size_t begin {0}; begin < 150; begin += 7) {
+        const auto query_hashes = compute_kmer_hashes<6>(haplotypes[begin % haplotypes.size()].substr(begin, 50));
+        std::size_t num_mapped_targets {0};
+        map_query_to_targets(query_hashes, table, counts, [&] (std::size_t target, auto first, auto last) {
+            const auto single_table = make_kmer_hash_table<6>(haplotypes[target]);
+            auto single_counts = init_mapping_counts(single_table);
+            std::vector<std::size_t> expected(3);
+            expected.erase(map_query_to_target(query_hashes, single_table, single_counts, std::begin(expected), 3), std::end(expected));
+            BOOST_CHECK_EQUAL_COLLECTIONS(first, last, std::cbegin(expected), std::cend(expected));
+            ++num_mapped_targets;
+        }, 3);
+        BOOST_CHECK_EQUAL(num_mapped_targets, haplotypes.size());
+    }
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
@@ -0,0 +1,161 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <sstream>
+#include <fstream>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "io/reference/reference_reader.hpp"
+#include "io/reference/reference_genome.hpp"
+#include "utils/read_profile_cache.hpp"
+#include "mock/utils.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(utils)
+BOOST_AUTO_TEST_SUITE(read_profile_cache)
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+class InMemoryReference : public io::ReferenceReader
+{
+public:
+    InMemoryReference(std::string name, std::map<ContigName, GeneticSequence> contigs)
+    : name_ {std::move(name)}
+    , contigs_ {std::move(contigs)}
+    {}
+
+private:
+    std::string name_;
+    std::map<ContigName, GeneticSequence> contigs_;
+
+    std::unique_ptr<ReferenceReader> do_clone() const override { return std::make_unique<InMemoryReference>(*this); }
+    bool do_is_open() const noexcept override { return true; }
+    std::string do_fetch_reference_name() const override { return name_; }
+    std::vector<ContigName> do_fetch_contig_names() const override
+    {
+        std::vector<ContigName> result {};
+        for (const auto& p : contigs_) result.push_back(p.first);
+        return result;
+    }
+    GenomicSize do_fetch_contig_size(const ContigName& contig) const override { return contigs_.at(contig).size(); }
+    GeneticSequence do_fetch_sequence(const GenomicRegion& region) const override
+    {
+        return contigs_.at(region.contig_name()).substr(region.begin(), size(region));
+    }
+};
+
+auto make_reference(const std::string& name, const std::size_t contig_size = 1000)
+{
+    return ReferenceGenome {std::make_unique<InMemoryReference>(name, std::map<std::string, std::string> {{"1", std::string(contig_size, 'A')}})};
+}
+
+void write_file(const fs::path& path, const std::string& contents)
+{
+    std::ofstream file {path.string(), std::ios::binary | std::ios::trunc};
+    file << contents;
+}
+
+auto make_profile(const std::size_t depth)
+{
+    ReadSetProfile result {};
+    result.memory_stats = {1000, 100, 500, 450, 12.5};
+    result.length_stats = {150, 100, 149, 150, 2.5};
+    result.mapping_quality_stats = {60, 0, 55, 60, 10.25};
+    result.depth_stats.combined.genome.distribution = {0.25, 0.5, 0.25};
+    result.depth_stats.combined.genome.all = {depth, 0, depth / 2, depth / 2, 1.5};
+    result.depth_stats.combined.genome.positive = {depth, 1, depth / 2, depth / 2, 1.5};
+    result.depth_stats.sample["NA12878"] = result.depth_stats.combined;
+    return result;
+}
+
+std::string to_string(const ReadSetProfile& profile)
+{
+    std::ostringstream ss {};
+    write(profile, ss);
+    return ss.str();
+}
+
+struct CacheFixture
+{
+    debug::TempDirectory directory {};
+    fs::path read_path {directory.path() / "NA12878.bam"};
+    fs::path index_path {directory.path() / "NA12878.bam.bai"};
+    ReadProfileCache cache {directory.path() / "cache"};
+    std::vector<SampleName> samples {"NA12878"};
+    InputRegionMap regions {{"1", {GenomicRegion {"1", 0, 1000}}}};
+    ReadSetProfileConfig config {};
+
+    CacheFixture()
+    {
+        write_file(read_path, "reads");
+        write_file(index_path, "index");
+    }
+
+    auto make_key(const ReferenceGenome& reference) const
+    {
+        return cache.make_key(samples, reference, {read_path}, regions, config);
+    }
+};
+
+} // namespace
+
+BOOST_FIXTURE_TEST_CASE(stored_profiles_are_loaded_with_the_same_key, CacheFixture)
+{
+    const auto reference = make_reference("test");
+    const auto profile = make_profile(40);
+    cache.store(profile, make_key(reference));
+    const auto loaded = cache.load(make_key(reference));
+    BOOST_REQUIRE(loaded);
+    BOOST_CHECK_EQUAL(to_string(*loaded), to_string(profile));
+}
+
+BOOST_FIXTURE_TEST_CASE(profiles_are_not_loaded_for_different_inputs, CacheFixture)
+{
+    const auto reference = make_reference("test");
+    BOOST_CHECK(!cache.load(make_key(reference)));
+    cache.store(make_profile(40), make_key(reference));
+    BOOST_CHECK(!cache.load(make_key(make_reference("other"))));
+    BOOST_CHECK(!cache.load(make_key(make_reference("test", 2000))));
+    const auto key = make_key(reference);
+    samples = {"NA12891"};
+    BOOST_CHECK(make_key(reference) != key);
+    samples = {"NA12878"};
+    regions["1"] = {GenomicRegion {"1", 0, 500}};
+    BOOST_CHECK(make_key(reference) != key);
+    regions["1"] = {GenomicRegion {"1", 0, 1000}};
+    config.target_reads_per_draw /= 2;
+    BOOST_CHECK(make_key(reference) != key);
+    config.target_reads_per_draw *= 2;
+    BOOST_CHECK(make_key(reference) == key);
+}
+
+BOOST_FIXTURE_TEST_CASE(changing_a_read_index_invalidates_cached_profiles, CacheFixture)
+{
+    const auto reference = make_reference("test");
+    cache.store(make_profile(40), make_key(reference));
+    BOOST_REQUIRE(cache.load(make_key(reference)));
+    write_file(index_path, "reindexed");
+    BOOST_CHECK(!cache.load(make_key(reference)));
+    const auto profile = make_profile(30);
+    cache.store(profile, make_key(reference));
+    const auto loaded = cache.load(make_key(reference));
+    BOOST_REQUIRE(loaded);
+    BOOST_CHECK_EQUAL(to_string(*loaded), to_string(profile));
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus
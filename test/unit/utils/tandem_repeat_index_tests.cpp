@@ -0,0 +1,168 @@
+// Copyright (c) 2015-2020 Daniel Cooke
+// Use of this source code is governed by the MIT license that can be found in the LICENSE file.
+
+#include <boost/test/unit_test.hpp>
+
+#include <string>
+#include <vector>
+#include <map>
+#include <memory>
+#include <random>
+#include <algorithm>
+#include <fstream>
+
+#include <boost/filesystem/path.hpp>
+#include <boost/filesystem/operations.hpp>
+
+#include "io/reference/reference_reader.hpp"
+#include "io/reference/reference_genome.hpp"
+#include "utils/repeat_finder.hpp"
+#include "utils/tandem_repeat_index.hpp"
+#include "exceptions/malformed_file_error.hpp"
+#include "mock/utils.hpp"
+
+namespace octopus { namespace test {
+
+BOOST_AUTO_TEST_SUITE(utils)
+BOOST_AUTO_TEST_SUITE(tandem_repeat_index)
+
+namespace fs = boost::filesystem;
+
+namespace {
+
+class InMemoryReference : public io::ReferenceReader
+{
+public:
+    InMemoryReference(std::string name, std::map<ContigName, GeneticSequence> contigs)
+    : name_ {std::move(name)}
+    , contigs_ {std::move(contigs)}
+    {}
+
+private:
+    std::string name_;
+    std::map<ContigName, GeneticSequence> contigs_;
+
+    std::unique_ptr<ReferenceReader> do_clone() const override { return std::make_unique<InMemoryReference>(*this); }
+    bool do_is_open() const noexcept override { return true; }
+    std::string do_fetch_reference_name() const override { return name_; }
+    std::vector<ContigName> do_fetch_contig_names() const override
+    {
+        std::vector<ContigName> result {};
+        for (const auto& p : contigs_) result.push_back(p.first);
+        return result;
+    }
+    GenomicSize do_fetch_contig_size(const ContigName& contig) const override { return contigs_.at(contig).size(); }
+    GeneticSequence do_fetch_sequence(const GenomicRegion& region) const override
+    {
+        return contigs_.at(region.contig_name()).substr(region.begin(), size(region));
+    }
+};
+
+auto make_repeat_rich_sequence(std::mt19937& generator, const std::size_t length)
+{
+    const std::string bases {"ACGT"};
+    std::uniform_int_distribution<int> base_dist {0, 3}, motif_dist {1, 6}, copies_dist {1, 6}, gap_dist {0, 8};
+    std::string result {};
+    while (result.size() < length) {
+        std::string motif(motif_dist(generator), 'A');
+        for (auto& b : motif) b = bases[base_dist(generator)];
+        for (int i {0}, n {copies_dist(generator)}; i < n; ++i) result += motif;
+        for (int i {0}, n {gap_dist(generator)}; i < n; ++i) result += bases[base_dist(generator)];
+    }
+    result.resize(length);
+    return result;
+}
+
+auto make_reference(const std::string& name, const std::map<std::string, std::string>& contigs)
+{
+    return ReferenceGenome {std::make_unique<InMemoryReference>(name, contigs)};
+}
+
+bool is_contained_in_other_repeat(const std::vector<TandemRepeat>& repeats, const TandemRepeat& repeat)
+{
+    return std::any_of(std::cbegin(repeats), std::cend(repeats), [&] (const auto& other) {
+        return other.period() == repeat.period() && other != repeat && contains(other, repeat);
+    });
+}
+
+bool contains_repeat(const std::vector<TandemRepeat>& repeats, const TandemRepeat& repeat)
+{
+    return std::find(std::cbegin(repeats), std::cend(repeats), repeat) != std::cend(repeats);
+}
+
+} // namespace
+
+BOOST_AUTO_TEST_CASE(indexed_repeats_agree_with_unindexed_search)
+{
+    std::mt19937 generator {42};
+    const std::map<std::string, std::string> contigs {
+        {"1", make_repeat_rich_sequence(generator, 20'000)},
+        {"2", make_repeat_rich_sequence(generator, 5'000)}
+    };
+    const auto reference = make_reference("test", contigs);
+    const debug::TempFile file {".idx"};
+    build_tandem_repeat_index(reference, file.path(), 6);
+    const TandemRepeatIndex index {file.path(), reference};
+    BOOST_CHECK_EQUAL(index.reference_name(), "test");
+    BOOST_CHECK_EQUAL(index.max_period(), 6);
+    const unsigned max_period {5};
+    std::uniform_int_distribution<GenomicRegion::Position> length_dist {50, 1000};
+    for (int trial {0}; trial < 200; ++trial) {
+        const auto& contig = trial % 2 == 0 ? "1" : "2";
+        const auto contig_size = reference.contig_size(contig);
+        const auto length = length_dist(generator);
+        std::uniform_int_distribution<GenomicRegion::Position> begin_dist {0, contig_size - length};
+        const auto begin = begin_dist(generator);
+        const GenomicRegion region {contig, begin, begin + length};
+        const auto sequence = reference.fetch_sequence(region);
+        const auto indexed = index.find(region, sequence, max_period);
+        const auto unindexed = find_exact_tandem_repeats(sequence, region, 1, max_period);
+        // The unindexed search also reports some non-maximal sub-runs, and misses some runs of the
+        // maximum period and runs ending at the region end. All other repeats must agree.
+        for (const auto& repeat : unindexed) {
+            if (repeat.period() < max_period && repeat.mapped_region().end() < region.end()
+                && !is_contained_in_other_repeat(unindexed, repeat)) {
+                BOOST_REQUIRE(contains_repeat(indexed, repeat));
+            }
+        }
+        for (const auto& repeat : indexed) {
+            BOOST_REQUIRE(contains(region, repeat));
+            if (repeat.period() < max_period && repeat.mapped_region().end() < region.end()) {
+                BOOST_REQUIRE(contains_repeat(unindexed, repeat));
+            }
+        }
+    }
+}
+
+BOOST_AUTO_TEST_CASE(opening_an_index_with_a_different_reference_throws)
+{
+    std::mt19937 generator {42};
+    const std::map<std::string, std::string> contigs {{"1", make_repeat_rich_sequence(generator, 1'000)}};
+    const auto reference = make_reference("test", contigs);
+    const debug::TempFile file {".idx"};
+    build_tandem_repeat_index(reference, file.path(), 6);
+    BOOST_CHECK_NO_THROW(TandemRepeatIndex(file.path(), reference));
+    BOOST_CHECK_THROW(TandemRepeatIndex(file.path(), make_reference("other", contigs)), MalformedFileError);
+    auto resized_contigs = contigs;
+    resized_contigs["1"].resize(900);
+    BOOST_CHECK_THROW(TandemRepeatIndex(file.path(), make_reference("test", resized_contigs)), MalformedFileError);
+    auto extra_contigs = contigs;
+    extra_contigs["2"] = contigs.at("1");
+    BOOST_CHECK_THROW(TandemRepeatIndex(file.path(), make_reference("test", extra_contigs)), MalformedFileError);
+}
+
+BOOST_AUTO_TEST_CASE(opening_a_truncated_index_throws)
+{
+    std::mt19937 generator {42};
+    const auto reference = make_reference("test", {{"1", make_repeat_rich_sequence(generator, 1'000)}});
+    const debug::TempFile file {".idx"};
+    build_tandem_repeat_index(reference, file.path(), 6);
+    fs::resize_file(file.path(), fs::file_size(file.path()) - 1);
+    BOOST_CHECK_THROW(TandemRepeatIndex {file.path()}, MalformedFileError);
+}
+
+BOOST_AUTO_TEST_SUITE_END()
+BOOST_AUTO_TEST_SUITE_END()
+
+} // namespace test
+} // namespace octopus